@@ -8,35 +8,46 @@
 #include <stdarg.h>
 #include <ctype.h>
 #include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
 
 #define JA_DEBUG  // Comment out or delete to disable debug
+// #define JA_THREADS  // Uncomment to enable worker threads (requires pthreads, compile with -pthread)
+// #define JA_ZLIB     // Uncomment to read and write gzip files (requires zlib, link with -lz)
+// #define JA_ZSTD     // Uncomment to read and write Zstandard files (requires libzstd, link with -lzstd)
 
-// Logging macros
+// Logging macros, messages are only formatted when a callback is set with ja_set_log_callback()
 #ifdef JA_DEBUG
-    // Error logs, print to stderr.
-    #define JA_LOG_ERROR(msg, ...) fprintf(stderr, "[jaJSON_ERROR] %s:%d: " msg "\n", __FILE__, __LINE__, ##__VA_ARGS__)
+    #define __JA_LOG(level, msg, ...) \
+        (__ja_log_handler ? __ja_log(level, __FILE__, __LINE__, msg, ##__VA_ARGS__) : (void)0)
 
-    // Warning logs, print to stderr, but not as severe as errors
-    #define JA_LOG_WARN(msg, ...)  fprintf(stderr, "[jaJSON_WARN] %s:%d: " msg "\n", __FILE__, __LINE__, ##__VA_ARGS__)
+    // Error logs
+    #define JA_LOG_ERROR(msg, ...) __JA_LOG(JA_LOG_LEVEL_ERROR, msg, ##__VA_ARGS__)
 
-    // Info logs, print to stdout for general information
-    #define JA_LOG_INFO(msg, ...)  fprintf(stdout, "[jaJSON_INFO] %s:%d: " msg "\n", __FILE__, __LINE__, ##__VA_ARGS__)
+    // Warning logs, not as severe as errors
+    #define JA_LOG_WARN(msg, ...)  __JA_LOG(JA_LOG_LEVEL_WARN, msg, ##__VA_ARGS__)
 
-    // Memory allocation error macro 
-    #define JA_MEM_ERROR() JA_LOG_ERROR("Memory allocation failed")
+    // Info logs, general information
+    #define JA_LOG_INFO(msg, ...)  __JA_LOG(JA_LOG_LEVEL_INFO, msg, ##__VA_ARGS__)
 
     // Propagation macro for stack trace
     #define JA_PROPAGATE_ERROR(context) \
-        JA_LOG_ERROR("Error propagated from: %s", context)
+        __JA_LOG(JA_LOG_LEVEL_TRACE, "Error propagated from: %s", context)
     
 #else // When not in debug mode, these macros do nothing
     #define JA_LOG_ERROR(msg, ...)      ((void)0)
     #define JA_LOG_WARN(msg, ...)       ((void)0)
     #define JA_LOG_INFO(msg, ...)       ((void)0)
-    #define JA_MEM_ERROR()              ((void)0)
     #define JA_PROPAGATE_ERROR(context) ((void)0)
 #endif
 
+// Records the error returned by ja_last_error() (even without JA_DEBUG) and logs the message
+#define JA_ERROR(code, msg, ...) (__ja_set_last_error(code, NULL), JA_LOG_ERROR(msg, ##__VA_ARGS__))
+
+// Memory allocation error macro
+#define JA_MEM_ERROR() JA_ERROR(JA_ERROR_MEMORY, "Memory allocation failed")
+
 // Helper types for numbers
 typedef struct ja_num {
     int as_int;
@@ -44,6 +55,9 @@ typedef struct ja_num {
 } ja_num;
 
 typedef struct ja_val ja_val; // Forward declaration of ja_val struct to use it in ja_pair struct.
+typedef struct ja_shape ja_shape; // Forward declaration of the key layout shared by objects
+typedef struct ja_index ja_index; // Forward declaration of the field indexes built over arrays
+typedef struct ja_key_map ja_key_map; // Forward declaration of the key index of big objects without shape
 
 // Key-value pair structure for JSON objects
 typedef struct ja_pair {
@@ -62,30 +76,369 @@ typedef enum {
     JA_TYPE_NULL
 } ja_type;
 
+// Bits of ja_val.flags (internal state, not part of the JSON value)
+#define JA_FLAG_SHAPED     0x0001 // Object stores its values in `values` and its keys in the shape in front of them
+#define JA_FLAG_IN_BLOCK   0x0002 // Node lives in the block of a ja_copy_compact() copy, it isn't freed on its own
+#define JA_FLAG_BLOCK_DATA 0x0004 // String or children buffer lives in the block, it's copied to the heap before growing
+#define JA_FLAG_BLOCK_ROOT 0x0008 // First node of the block, freeing it frees the whole block
+#define JA_FLAG_SNAPSHOT   0x0010 // Block root loaded by ja_load_snapshot(), the block starts one node before it
+#define JA_FLAG_MAPPED     0x0020 // Set on the node before a snapshot root when the file is mapped in memory
+#define JA_FLAG_PACKED     0x0040 // Array of numbers stored in `doubles`, without a node per element
+#define JA_FLAG_PACKED_BOOL 0x0080 // Array of booleans stored in `bools`, without a node per element
+#define JA_FLAG_KEY_MAP    0x0100 // Object without shape indexed by the map in front of its pairs, which may hold tombstones (NULL keys)
+#define JA_FLAG_ELEMENT_VIEW 0x0200 // Node handed out for an element of a packed array, changing it unpacks the array
+#define JA_FLAG_INDEXED    0x0400 // Array with indexes built by ja_index_build(), kept up to date by the array functions
+
 // Main JSON value structure
 typedef struct ja_val {
     ja_type type;
+    uint16_t flags;
+    uint16_t shares; // Other trees sharing this node through ja_copy_cow() (0 = single owner)
     union {
         ja_num number;
         char *string;
         bool boolean;
         struct {
-            struct ja_val** items;
+            union {
+                struct ja_val** items;
+                double *doubles;         // Packed arrays (JA_FLAG_PACKED)
+                bool *bools;             // Packed arrays (JA_FLAG_PACKED_BOOL)
+            };
             size_t size;
         } array;
         struct {
-            ja_pair *pairs;
+            union {
+                ja_pair *pairs;          // Objects without shape, preceded by the key map with JA_FLAG_KEY_MAP
+                struct ja_val **values;  // Shaped objects in the order of the shape keys, preceded by the shape
+                const struct ja_val *source; // Original of a node being filled by ja_copy_compact() (internal)
+            };
             size_t size;
         } object;
     } u;
 } ja_val;
 
+// Key layout shared by parsed objects that have the same keys in the same order
+struct ja_shape {
+    size_t refcount;
+    size_t size;        // Amount of keys
+    uint64_t hash;      // Hash of the key sequence
+    size_t cached;      // Slot of the last key found, compared before hashing the key looked up
+    uint32_t *index;    // Open addressing table of slot + 1 (0 for empty entries)
+    size_t index_mask;  // Capacity of the index - 1
+    char *keys[];       // Interned keys, in object order
+};
+
+// Index of the keys of a big object without shape, built once it reaches JA_OBJ_MAP_MIN pairs.
+// Removing a key leaves a tombstone in its pair, so the other pairs keep their positions.
+// Readers skip the tombstones, only changes to the object drop them.
+struct ja_key_map {
+    size_t capacity;    // Pairs allocated, grown geometrically
+    size_t removed;     // Tombstones among the pairs, dropped once they make up half of them
+    uint32_t *members;  // Position of each member left, built by the first read by index after a removal
+    size_t index_mask;  // Capacity of the index - 1
+    uint32_t index[];   // Open addressing table of position + 1 (0 for empty entries)
+};
+
+// Fewest pairs of an object without shape that get a key map, smaller objects are searched linearly
+#define JA_OBJ_MAP_MIN 64
+
+// Table of the shapes created while parsing a document
+typedef struct ja_shape_table {
+    ja_shape **slots;
+    size_t capacity;
+    size_t count;
+} ja_shape_table;
+
+// Header stored right before the characters of every object key (keys are shared and reference counted)
+typedef struct __ja_key {
+    size_t refcount;
+    uint64_t hash;
+    size_t length;
+} __ja_key;
+
+// Table of interned keys, every distinct key is stored only once
+typedef struct ja_key_table {
+    char **slots;     // Open addressing, NULL for empty slots
+    size_t capacity;  // Always a power of two
+    size_t count;
+} ja_key_table;
+
+// Scope of key interning
+typedef enum {
+    JA_INTERN_DOCUMENT, // Keys are shared inside each parsed document (default)
+    JA_INTERN_GLOBAL    // Keys are shared by every document and object of the program
+} ja_intern_mode;
+
+// Tables shared by the objects of the document being parsed
+typedef struct __ja_parse_scope {
+    ja_key_table keys;
+    ja_shape_table shapes;
+    const char *end;    // End of the text being parsed (NULL if unknown), the string scans read 16 bytes at a time up to it
+} __ja_parse_scope;
+
 // Structure for handling JSON files
 typedef struct ja_json {
     char *json_str;
     ja_val *content;
 } ja_json;
 
+// Smallest array (in bytes of JSON text) that ja_parse_parallel() splits across threads
+#define JA_PARALLEL_MIN_BYTES ((size_t)64 << 10)
+
+// Deepest nesting of arrays and objects accepted by ja_validate()
+#ifndef JA_MAX_DEPTH
+    #define JA_MAX_DEPTH 1024
+#endif
+
+// Kinds of errors found in JSON text
+typedef enum {
+    JA_ERROR_NONE,
+    JA_ERROR_UNEXPECTED_END,        // Input ended inside a value
+    JA_ERROR_UNEXPECTED_CHARACTER,  // Character not allowed at this position
+    JA_ERROR_INVALID_NUMBER,
+    JA_ERROR_INVALID_LITERAL,       // Misspelled true, false or null
+    JA_ERROR_INVALID_STRING,        // Bad escape sequence or unescaped control character
+    JA_ERROR_INVALID_UTF8,
+    JA_ERROR_DEPTH_LIMIT,           // More than JA_MAX_DEPTH nested arrays and objects
+    JA_ERROR_TRAILING_CONTENT,      // Something other than whitespace after the value
+    JA_ERROR_NULL_ARGUMENT,         // NULL passed where a value was required
+    JA_ERROR_TYPE_MISMATCH,         // Function used on a value of the wrong type
+    JA_ERROR_KEY_NOT_FOUND,
+    JA_ERROR_INDEX_OUT_OF_BOUNDS,
+    JA_ERROR_MEMORY,                // Memory allocation failed
+    JA_ERROR_IO,                    // File couldn't be opened, read or written
+    JA_ERROR_INVALID_SNAPSHOT,      // Snapshot file is corrupt, or was saved by an incompatible build
+    JA_ERROR_UNSUPPORTED_TYPE,      // Binary data, extension or other MessagePack/CBOR type without a JSON equivalent
+    JA_ERROR_INVALID_PATCH,         // Malformed JSON Patch operation
+    JA_ERROR_PATCH_TEST_FAILED,     // "test" operation of a JSON Patch found another value
+    JA_ERROR_SHARED_VALUE           // Value shared by ja_copy_cow() modified without ja_edit_arr_at()/ja_edit_obj_at()
+} ja_error_code;
+
+// Size of the path stored in ja_error, longer paths end with "/..."
+#define JA_ERROR_PATH_SIZE 128
+
+// Severity of logged messages
+typedef enum {
+    JA_LOG_LEVEL_ERROR,
+    JA_LOG_LEVEL_WARN,
+    JA_LOG_LEVEL_INFO,
+    JA_LOG_LEVEL_TRACE   // Propagation of errors through the call stack
+} ja_log_level;
+
+// Receives the messages of the library, see ja_set_log_callback()
+typedef void (*ja_log_callback)(ja_log_level level, const char *file, int line, const char *message, void *user_data);
+
+// Callback currently set by ja_set_log_callback() (NULL = logging disabled)
+extern ja_log_callback __ja_log_handler;
+
+// Location and reason of an error (errors in JSON text, or errors of the last failed call, see ja_last_error())
+typedef struct ja_error {
+    ja_error_code code;
+    size_t offset;       // Byte offset of the offending character
+    size_t line;         // 1-based line of the offending character
+    size_t column;       // 1-based column (in bytes) of the offending character
+    const char *reason;  // Static description, never freed
+    char path[JA_ERROR_PATH_SIZE]; // JSON Pointer to the value being read (e.g. "/data/3/name"), empty if unknown
+} ja_error;
+
+// Size of the buffer used by ja_minify_stream() and ja_minify_file()
+#define JA_MINIFY_BUFFER_SIZE ((size_t)64 << 10)
+
+// State of the minifier carried between consecutive buffers of the same text
+typedef struct __ja_minify_state {
+    bool in_string;  // Inside a string, whitespace is kept
+    bool escaped;    // Previous character was a backslash inside a string
+} __ja_minify_state;
+
+// Default amount of bytes read per batch by ja_ndjson_reader
+#define JA_NDJSON_DEFAULT_BATCH_SIZE ((size_t)4 << 20)
+
+// Options for reading newline-delimited JSON (NDJSON / JSON Lines) files
+typedef struct ja_ndjson_options {
+    int thread_count;   // Worker threads used for parsing (0 = one per CPU core, ignored without JA_THREADS)
+    size_t batch_size;  // Bytes read from the file per batch (0 = default)
+    bool ordered;       // Deliver documents in file order
+    bool skip_invalid;  // Skip malformed lines instead of stopping at the first one
+} ja_ndjson_options;
+
+// Location of a malformed line in a NDJSON file
+typedef struct ja_ndjson_error {
+    size_t line;    // 1-based line number
+    size_t offset;  // Byte offset of the start of the line in the file
+} ja_ndjson_error;
+
+// A single line of the batch currently held by a reader
+typedef struct __ja_ndjson_line {
+    char *text;
+    size_t line;
+    size_t offset;
+    ja_val *document;
+    bool invalid;
+} __ja_ndjson_line;
+
+// Structure for reading NDJSON files in parallel batches
+typedef struct ja_ndjson_reader {
+    FILE *file;
+    ja_ndjson_options options;
+    char *buffer;             // Batch buffer, lines are terminated in place
+    size_t buffer_capacity;
+    size_t buffer_used;
+    size_t buffer_offset;     // File offset of buffer[0]
+    size_t consumed;          // Bytes of the buffer that belong to the current batch
+    size_t next_line;         // Line number of the first line in the buffer
+    bool eof;
+    bool stopped;             // Reading ended early (malformed line, read failure or callback request)
+    __ja_ndjson_line *lines;  // Lines of the current batch
+    size_t line_count;
+    size_t line_capacity;
+    size_t cursor;            // Next line to deliver by ja_ndjson_next()
+    ja_ndjson_error *errors;
+    size_t error_count;
+    size_t error_capacity;
+} ja_ndjson_reader;
+
+// Callback receiving each document read from a NDJSON file (takes ownership of the document)
+typedef bool (*ja_ndjson_callback)(ja_val *document, size_t line, void *user_data);
+
+// Callback deciding whether ja_arr_retain_if() keeps an element
+typedef bool (*ja_predicate)(ja_val *value, void *user_data);
+
+// Index of path steps whose token isn't an array index
+#define JA_PATH_NO_INDEX SIZE_MAX
+
+// Index of the "-" token, the position past the last element of an array
+#define JA_PATH_END (SIZE_MAX - 1)
+
+// Reference token of a compiled path, with the inline cache of its last match
+typedef struct ja_path_step {
+    char *key;          // Unescaped token, with a key header holding its hash and length
+    size_t index;       // Array index of the token, JA_PATH_NO_INDEX or JA_PATH_END
+    ja_shape *shape;    // Shape of the last shaped object matched (retained), NULL if none
+    size_t slot;        // Slot of the key in `shape`
+    size_t position;    // Position of the key in the last object without shape matched
+} ja_path_step;
+
+// JSON Pointer (RFC 6901) compiled by ja_path_compile()
+typedef struct ja_path {
+    size_t size;            // Amount of steps, 0 for "" (the whole document)
+    ja_path_step steps[];
+} ja_path;
+
+// Smallest amount of nodes that ja_query_eval_parallel() splits across threads
+#define JA_QUERY_PARALLEL_MIN 4096
+
+// Most removals and additions ja_diff() looks for between two arrays, beyond that elements are compared by position
+#ifndef JA_DIFF_MAX_EDITS
+    #define JA_DIFF_MAX_EDITS 1024
+#endif
+
+// Operand of a filter comparison: a path relative to the current node (@), or a constant
+typedef struct __ja_query_operand {
+    ja_path *field;     // NULL for constants
+    ja_val *literal;    // NULL for fields
+} __ja_query_operand;
+
+// Kinds of nodes of a filter expression
+typedef enum {
+    __JA_QUERY_AND,
+    __JA_QUERY_OR,
+    __JA_QUERY_NOT,
+    __JA_QUERY_EXISTS,      // @.field alone
+    __JA_QUERY_EQUAL,
+    __JA_QUERY_NOT_EQUAL,
+    __JA_QUERY_LESS,
+    __JA_QUERY_LESS_EQUAL,
+    __JA_QUERY_GREATER,
+    __JA_QUERY_GREATER_EQUAL
+} __ja_query_expr_kind;
+
+// Node of a filter expression ([?(...)])
+typedef struct __ja_query_expr {
+    __ja_query_expr_kind kind;
+    struct __ja_query_expr *left;   // Operands of AND, OR and NOT
+    struct __ja_query_expr *right;
+    __ja_query_operand a;           // Operands of EXISTS and the comparisons
+    __ja_query_operand b;
+} __ja_query_expr;
+
+// Kinds of segments of a JSONPath query
+typedef enum {
+    __JA_QUERY_NAME,        // .name or ['name']
+    __JA_QUERY_WILDCARD,    // .* or [*]
+    __JA_QUERY_INDEX,       // [n], negative indexes count from the end
+    __JA_QUERY_SLICE,       // [start:end:step]
+    __JA_QUERY_FILTER       // [?(expression)]
+} __ja_query_kind;
+
+// Segment of a JSONPath query
+typedef struct __ja_query_segment {
+    __ja_query_kind kind;
+    bool descendant;        // Preceded by "..": applied to the node and all its descendants
+    ja_path_step step;      // Key and inline cache of names
+    int64_t start;          // Index, or slice bounds
+    int64_t end;
+    int64_t stride;
+    bool has_start;
+    bool has_end;
+    __ja_query_expr *filter;
+} __ja_query_segment;
+
+// JSONPath query compiled by ja_query_compile()
+typedef struct ja_query {
+    size_t size;
+    __ja_query_segment *segments;
+} ja_query;
+
+// Bytes of a bitmap with one bit per row, as filled by ja_extract_column()
+#define JA_BITMAP_BYTES(rows) (((rows) + 7) / 8)
+
+// Whether the bit of a row is set in a bitmap
+#define JA_BITMAP_TEST(bitmap, row) (((bitmap)[(row) >> 3] >> ((row) & 7)) & 1)
+
+// Statistics computed by ja_arr_reduce()
+typedef enum {
+    JA_REDUCE_SUM,
+    JA_REDUCE_MIN,
+    JA_REDUCE_MAX,
+    JA_REDUCE_MEAN,
+    JA_REDUCE_COUNT     // Amount of numbers
+} ja_reduce_op;
+
+// Key of an element in a ja_index: a number (ints and doubles alike), a string or a boolean
+typedef struct __ja_index_entry {
+    size_t position;        // Of the element in the array
+    uint64_t hash;
+    ja_type type;           // JA_TYPE_DOUBLE for every number
+    union {
+        double number;
+        const char *string; // Points into the element
+        bool boolean;
+    };
+} __ja_index_entry;
+
+// Index of the elements of an array by the value of a field, built by ja_index_build()
+struct ja_index {
+    ja_val *array;              // NULL once the array is freed
+    ja_path *path;
+    __ja_index_entry *entries;  // In array order, elements without a scalar key are left out
+    size_t size;
+    size_t capacity;
+    size_t rows;                // Elements of the array already indexed
+    size_t *table;              // Open addressing table of entry + 1 (0 for empty slots)
+    size_t table_mask;          // Capacity of the table - 1
+    __ja_index_entry *sorted;   // Copy of the entries ordered by key for ranges, NULL until one is asked for
+    bool stale;                 // Elements were replaced or removed, rebuilt before the next lookup
+    ja_index *next;             // Next index built, of any array (the arrays only carry JA_FLAG_INDEXED)
+};
+
+// Hashes of arrays and objects computed by ja_hash_cached(), keyed by node address
+typedef struct ja_hash_cache {
+    const ja_val **nodes;       // Open addressing table, NULL for empty slots
+    uint64_t *hashes;           // Hash of the node in the same slot
+    size_t count;
+    size_t capacity;            // Power of two, 0 until the first hash is stored
+} ja_hash_cache;
+
 /**
  * @brief Creates a new ja_val for a number.
  * 
@@ -200,6 +553,42 @@ ja_val *ja_new_set_obj(size_t object_size, ...);
  */
 ja_val *ja_copy(ja_val *original);
 
+/**
+ * @brief Creates a deep copy of a ja_val in a single allocation.
+ * 
+ * The value is measured first, then every node, children buffer and string is laid out in one block:
+ * siblings sit next to each other in breadth-first order, followed by the buffers and the strings.
+ * Copying a long-lived tree that was mutated many times this way also defragments it.
+ * 
+ * @return a new ja_val, freed with ja_free_val() as usual (one call to free() for the block).
+ * 
+ * @param original Value to be copied.
+ * 
+ * @note The copy can be modified like any other value, new children and grown buffers are allocated on their own.
+ *       Memory of replaced or removed nodes of the block is only returned when the whole copy is freed.
+ * @note Children of a compact copy are copied (not shared) by ja_copy_cow().
+ */
+ja_val *ja_copy_compact(ja_val *original);
+
+/**
+ * @brief Creates a copy-on-write copy of a ja_val.
+ * 
+ * Only the top-level value is duplicated: its children are shared with the original and reference counted.
+ * The getters hand shared children out as they are. To change one, walk down from the root of a tree with
+ * ja_edit_arr_at() and ja_edit_obj_at(), which give that tree its own shallow copy of each shared child on
+ * the way, so only the path down to a modified value is ever cloned and changes never reach the other trees.
+ * ja_path_set(), ja_patch_apply() and ja_merge_patch() clone the paths they modify the same way.
+ * 
+ * @return a new ja_val sharing its children with `original`.
+ * 
+ * @param original Value to be copied.
+ * 
+ * @note Values reached through the getters may be shared: modifying them directly changes every tree.
+ * @note Any number of threads can read the trees at the same time, while a tree being edited must not be used
+ *       by other threads.
+ */
+ja_val *ja_copy_cow(ja_val *original);
+
 /**
  * @brief Sets the value inside of the target to be the provide number.
  * 
@@ -347,344 +736,2266 @@ ja_val *ja_get_arr_at(ja_val *origin, size_t index);
 ja_val *ja_get_obj_at(ja_val *origin, const char *key);
 
 /**
- * @brief Appends a new value at the end of the array and takes ownership of the passed pointer.
- * 
- * @param target Array from which content will be inserted.
- * @param content_to_add New value that'll be put at a the end of the array.
- */
-void ja_arr_append(ja_val *target, ja_val *content_to_add);
-
-/**
- * @brief Removes a value from a specific position of the array.
- * 
- * This function frees the value removed, making it unusable.
+ * @brief Checks if an object has a key, without logging or recording errors.
  * 
- * @param target Array from which content will be removed.
- * @param index Position from which the value will be removed
+ * @return true if `origin` is an object containing `key`, false otherwise (including NULL arguments).
  * 
- * @note If the index provided is not a valid position on the array, it will raise an error (when JA_DEBUG is enabled).
+ * @param origin Value to be checked.
+ * @param key Key to be found.
  */
-void ja_arr_remove_at(ja_val *target, size_t index);
-
+bool ja_has_key(ja_val *origin, const char *key);
 
 /**
- * @brief Removes a value from a specific key of the object.
+ * @brief Retrieves the value at a specific key, for optional fields.
  * 
- * This function frees the value removed, making it unusable.
+ * Same as ja_get_obj_at(), but a missing key, a non-object origin or NULL arguments are not treated as errors:
+ * nothing is logged and ja_last_error() is left untouched.
  * 
- * @param target Object from which content will be removed.
- * @param key Key from which the value will be removed
+ * @return ja_val found at the key, or NULL.
  * 
- * @note If the key provided is not valid for the object, it will raise an error (when JA_DEBUG is enabled).
+ * @param origin Value (object) that will have its contents accessed.
+ * @param key Key to be accessed in the object.
  */
-void ja_obj_remove_at(ja_val *target, const char *key);
+ja_val *ja_try_get_obj_at(ja_val *origin, const char *key);
 
 /**
- * @brief Function to convert values between different types.
+ * @brief Retrieves the value at a specific index of the origin (array), to be modified.
  * 
- * It will overwrite the previous value and change the container type.
+ * Same as ja_get_arr_at(), but a child shared with other trees by ja_copy_cow() is replaced by a shallow copy
+ * owned by `origin` first.
  * 
- * @return Returns back the target for easier access or copy.
+ * @return ja_val found in the position indicated by the index, owned by `origin`.
  * 
- * @param target The value which will be converted.
+ * @param origin Value (array) that will have its contents accessed, not shared itself (the root of a tree,
+ *               or a value returned by this function or ja_edit_obj_at()).
+ * @param index Position of array to be accessed.
  * 
- * @note Not all conversions are supported. If a conversion in not supported, the code will throw a warning (JA_DEBUG).
+ * @note Returns NULL with JA_ERROR_SHARED_VALUE if `origin` is shared with other trees.
  */
-ja_val* ja_convert_to(ja_val *target, ja_type new_type);
+ja_val *ja_edit_arr_at(ja_val *origin, size_t index);
 
 /**
- * @brief Creates a string that has the representation of a JSON value.
+ * @brief Retrieves the value at a specific key of the origin (object), to be modified.
  * 
- * @return JSON string with the values interpreted.
+ * Same as ja_get_obj_at(), but a child shared with other trees by ja_copy_cow() is replaced by a shallow copy
+ * owned by `origin` first.
  * 
- * @param value ja_val that will have its string generated.
+ * @return ja_val found in the position indicated by the key, owned by `origin`.
  * 
- * @note This returns an ALLOCATED string (char*), so it's the users responsibility to manage it.
+ * @param origin Value (object) that will have its contents accessed, not shared itself (the root of a tree,
+ *               or a value returned by this function or ja_edit_arr_at()).
+ * @param key Key to be accessed in the object.
+ * 
+ * @note Returns NULL with JA_ERROR_SHARED_VALUE if `origin` is shared with other trees.
  */
-char* ja_stringify(ja_val* value);
+ja_val *ja_edit_obj_at(ja_val *origin, const char *key);
 
 /**
- * @brief Displays on the stdout the string representation of a JSON value.
- * 
- * @param value ja_val that will be displayed.
- * 
- * @note This function uses the ja_stringify internally, but also frees the memory, so it is automatically managed.
+ * @brief Compiles a JSON Pointer (RFC 6901) for ja_path_get() and ja_path_set().
+ *
+ * Tokens are unescaped ("~1" is '/', "~0" is '~'), hashed and parsed as array indexes once. Every step
+ * then caches the slot it matched last, so resolving the same path over records with the same shape
+ * skips the key lookups.
+ *
+ * @return The compiled path (freed with ja_path_free()), or NULL on error (JA_ERROR_UNEXPECTED_CHARACTER
+ *         with the offset of the problem for malformed pointers).
+ *
+ * @param pointer JSON Pointer, "" for the whole document or a sequence of "/token" (e.g. "/data/0/name").
+ *
+ * @note The cache is updated by the lookups, so a path must not be used by two threads at the same time.
  */
-void ja_print(ja_val* value);
+ja_path *ja_path_compile(const char *pointer);
 
 /**
- * @brief Reads a string and generates a JSON value based on that string.
- * 
- * @return A ja_val constructed based of the JSON string.
- * 
- * @param json_str The contents which will be interpreted.
- * 
- * @note When interpreting a string, for example `"hello"`, the parser will only understand it is a string if it's presented with escaped double quotes, as the examples show.
- * 
- * @example
- * ja_val *parsed_val;
- * parsed_val = ja_parse("1234");
- * parsed_val = ja_parse("\"Hello\"");
+ * @brief Retrieves the value a compiled path points to.
+ *
+ * @return The value found, or NULL if a step is missing (without logging or recording errors, like ja_try_get_obj_at()).
+ *
+ * @param path Path returned by ja_path_compile().
+ * @param root Document to be searched.
  */
-ja_val *ja_parse(const char *json_str);
+ja_val *ja_path_get(ja_path *path, ja_val *root);
 
 /**
- * @brief Function to access the type of a value.
- * 
- * @return Integer representation of the type enum. -1 if the type is unknown.
- * 
- * @param value ja_val to have its type analyzed.
+ * @brief Sets the value a compiled path points to, and takes ownership of it.
+ *
+ * Every step but the last must exist. The last one replaces an existing value, adds a key to an object,
+ * or appends to an array when it's the array size or "-".
+ *
+ * @return true on success, false otherwise (the value still belongs to the caller, see ja_last_error()).
+ *
+ * @param path Path returned by ja_path_compile(), with one step at least.
+ * @param root Document to be modified.
+ * @param value New value.
  */
-int ja_enum_type_of(ja_val *value);
+bool ja_path_set(ja_path *path, ja_val *root, ja_val *value);
 
 /**
- * @brief Function to access the type of a value.
- * 
- * @return Non allocated descriptive string of the type.
- * 
- * @param value ja_val to have its type analyzed.
+ * @brief Frees a path compiled by ja_path_compile() and sets the pointer to NULL.
+ *
+ * @param path Pointer to the path (ja_path**).
  */
-const char *ja_str_type_of(ja_val *value);
+void ja_path_free(ja_path **path);
 
 /**
- * @brief Function to access the type of a value.
- * 
- * @return Returns the type as string based on the provided enum value.
- * 
- * @param type Type as enum constant to be retrieved as string.
+ * @brief Compiles a JSONPath query for ja_query_eval().
+ *
+ * Supported syntax: the root `$`, names (`.name`, `['name']`), wildcards (`.*`, `[*]`), indexes (`[2]`, `[-1]`),
+ * slices (`[start:end:step]`), recursive descent (`..name`, `..*`, `..[0]`) and filters over the elements
+ * of arrays and the members of objects: `[?(@.field op value)]` with `==`, `!=`, `<`, `<=`, `>`, `>=`,
+ * existence tests (`[?(@.field)]`), `&&`, `||`, `!` and parentheses. Constants are numbers, 'strings',
+ * "strings", true, false and null.
+ *
+ * @return The compiled query (freed with ja_query_free()), or NULL on error (JA_ERROR_UNEXPECTED_CHARACTER or
+ *         JA_ERROR_UNEXPECTED_END with the offset of the problem in ja_last_error()).
+ *
+ * @param expression JSONPath expression, e.g. "$.data[?(@.active == true && @.profile.settings.language == 'en')]".
+ *
+ * @note Names and string constants are compared with the stored characters of keys and strings.
  */
-const char *__ja_type_enum_to_str(ja_type type);
+ja_query *ja_query_compile(const char *expression);
 
 /**
- * @brief Function to access the size of a value.
- * 
- * @return Value of the length, the amount of inner elements. Returns 0 for numbers, booleans and null.
- * 
- * @param value ja_val to be analyzed
- * 
- * @note Only works for strings, arrays and objects.
+ * @brief Evaluates a compiled query over a document.
+ *
+ * Object lookups go through the inline caches of the query (see ja_path_get()).
+ *
+ * @return Allocated array (freed with free()) of the values selected, in document order. They point into the
+ *         document and are not copies. NULL on error.
+ *
+ * @param query Query returned by ja_query_compile().
+ * @param root Document to be queried.
+ * @param count Receives the amount of values selected.
+ *
+ * @note The caches are updated by the evaluation, so a query must not be evaluated by two threads at the same time.
  */
-size_t ja_size_of(ja_val *value);
+ja_val **ja_query_eval(ja_query *query, ja_val *root, size_t *count);
 
 /**
- * @brief Frees the a ja_val and its contents and sets `*val_ptr = NULL`. Use this to free values you own.
- * 
- * @param val_ptr Pointer to a ja_val pointer (ja_val**) that will be freed.
- * 
- * @note This function recursively frees the memory inside this ja_val, including its children, so be careful.
+ * @brief Evaluates a compiled query, splitting large sets of nodes across threads.
+ *
+ * Once a segment leaves JA_QUERY_PARALLEL_MIN nodes or more (or a filter has that many candidates), the rest
+ * of the query is evaluated over chunks of them concurrently and the results are joined in order, so they
+ * are the same as with ja_query_eval().
+ *
+ * @return Allocated array (freed with free()) of the values selected, in document order. NULL on error.
+ *
+ * @param query Query returned by ja_query_compile().
+ * @param root Document to be queried.
+ * @param count Receives the amount of values selected.
+ * @param thread_count Amount of threads (0 = one per CPU core).
+ *
+ * @note Threads are only used with JA_THREADS, the document must not be modified during the evaluation.
  */
-void ja_free_val(ja_val **val_ptr);
+ja_val **ja_query_eval_parallel(ja_query *query, ja_val *root, size_t *count, int thread_count);
 
 /**
- * @brief Function to initialize a ja_json object, used for files I/O.
- * 
- * @return Allocated pointer to a new ja_json object.
+ * @brief Frees a query compiled by ja_query_compile() and sets the pointer to NULL.
+ *
+ * @param query Pointer to the query (ja_query**).
  */
-ja_json* ja_json_init();
+void ja_query_free(ja_query **query);
 
 /**
- * @brief Reads a file and parse its contents.
- * 
- * @return Boolean value based on the success of the operation. true for success, false for failure (with error on JA_DEBUG).
- * 
- * @param ja_json_object Wrapper that will hold the contents. 
- * @param filename Name of the file to be open.
- * 
- * @note Must contain the file extension too (e.g.: "users_data.json").
+ * @brief Copies one field of every element of an array into a flat C array.
+ *
+ * The field is reached from each element with a JSON Pointer ("" for the element itself), and written as
+ * `int64_t` (JA_TYPE_INT), `double` (JA_TYPE_DOUBLE, ints are converted), `bool` (JA_TYPE_BOOL) or `const char *`
+ * (JA_TYPE_STRING, pointing into the document). Elements are gathered and converted in batches, and the
+ * pointer keeps the inline caches of ja_path_get() across elements.
+ *
+ * @return true on success, false on error (NULL arguments, invalid pointer, `array` not an array or
+ *         unsupported `type`).
+ *
+ * @param array Array of elements (usually objects).
+ * @param pointer JSON Pointer to the field in each element, e.g. "/profile/settings/theme".
+ * @param type Type of the column.
+ * @param out Array of ja_size_of(array) values of the column's C type.
+ * @param valid Optional bitmap of JA_BITMAP_BYTES(ja_size_of(array)) bytes, NULL to skip it. The bit of a row
+ *              is set when its field exists with the column's type (see JA_BITMAP_TEST()).
+ *
+ * @note Rows whose field is missing, null or of another type are written as 0, 0.0, false or NULL.
  */
-bool ja_read_json(ja_json *ja_json_object, const char *filename);
+bool ja_extract_column(ja_val *array, const char *pointer, ja_type type, void *out, uint8_t *valid);
 
 /**
- * @brief Writes JSON content in a file.
- * 
- * @return Boolean value based on the success of the operation. true for success, false for failure (with error on JA_DEBUG).
- * 
- * @param ja_json_object Wrapper that holds the contents.
- * @param filename Name of the file to be written.
- * 
- * @note Automatically syncs the inner string to match the content (using ja_sync_json()).
- * @note This will overwrite files that have the same name. Be careful.
- * @note Must contain the file extension too (e.g.: "users_data.json").
+ * @brief Same as ja_extract_column(), splitting the elements across threads.
+ *
+ * @return true on success, false on error.
+ *
+ * @param array Array of elements.
+ * @param pointer JSON Pointer to the field in each element.
+ * @param type Type of the column.
+ * @param out Array of ja_size_of(array) values of the column's C type.
+ * @param valid Optional bitmap of JA_BITMAP_BYTES(ja_size_of(array)) bytes.
+ * @param thread_count Amount of threads (0 = one per CPU core).
+ *
+ * @note Threads are only used with JA_THREADS, the array must not be modified during the extraction.
  */
-bool ja_write_json(ja_json *ja_json_object, const char *filename);
+bool ja_extract_column_parallel(ja_val *array, const char *pointer, ja_type type, void *out, uint8_t *valid,
+                                int thread_count);
 
 /**
- * @brief Final operation for dealing with a ja_json object. Will free the memory.
- * 
- * @param ja_json_object Content to be handled.
- * 
- * @note This frees both the ja_val and string contained in the object.
+ * @brief Computes a statistic over the numbers of an array.
+ *
+ * Ints and doubles are read as doubles, other elements are skipped. Packed arrays (see ja_arr_as_doubles())
+ * are reduced straight from their buffer, with AVX2 when the compiler targets it.
+ *
+ * @return true on success, false on error (NULL arguments or `array` not an array).
+ *
+ * @param array Array of numbers.
+ * @param op Statistic to compute.
+ * @param result Receives the statistic. Without numbers, the sum and count are 0 and the others NAN.
  */
-void ja_json_end(ja_json *ja_json_object);
+bool ja_arr_reduce(ja_val *array, ja_reduce_op op, double *result);
 
 /**
- * @brief Syncs the string inside the ja_json object to match the ja_val contained.
- * 
- * @param ja_json_object The instance which needs to be updated.
- * 
- * @note This is essential when writing back a modified file, if it is not called, then contents wont change.
+ * @brief Same as ja_arr_reduce(), over a field of each element (see ja_extract_column()).
+ *
+ * @return true on success, false on error (NULL arguments, invalid pointer or `array` not an array).
+ *
+ * @param array Array of elements (usually objects).
+ * @param pointer JSON Pointer to the field in each element, e.g. "/stats/latency".
+ * @param op Statistic to compute.
+ * @param result Receives the statistic.
  */
-void ja_sync_json(ja_json *ja_json_object);
-
-// === Internal Helper Functions (not for public use) ===
+bool ja_arr_reduce_path(ja_val *array, const char *pointer, ja_reduce_op op, double *result);
 
 /**
- * @brief Internal function to create a new generic JSON value
+ * @brief Counts the numbers of an array falling into equal-width bins between `min` and `max`.
  *
- * Creates a new ja_val with uninitialized content.
+ * @return true on success, false on error (NULL arguments, `array` not an array, no bins or `min` not
+ *         below `max`).
  *
- * @return ja_val* Pointer to the newly created ja_val with no type or value set,
- * or NULL on memory allocation failure.
+ * @param array Array of numbers.
+ * @param min Start of the first bin.
+ * @param max End of the last bin, which includes it.
+ * @param bins Amount of bins.
+ * @param counts Array of `bins` counters, overwritten.
  *
- * @note It is not recommended to use this function directly,
- * use the specific jaNew* functions instead.
+ * @note Numbers outside [min, max] and other elements aren't counted.
  */
-ja_val *__ja_new_generic(void);
+bool ja_arr_histogram(ja_val *array, double min, double max, size_t bins, size_t *counts);
 
 /**
- * @brief Helper function to convert a value to number type.
- * 
- * @param target Value to be converted.
- * 
- * @note Not recommended to use directly.
+ * @brief Same as ja_arr_histogram(), over a field of each element.
+ *
+ * @return true on success, false on error.
+ *
+ * @param array Array of elements.
+ * @param pointer JSON Pointer to the field in each element.
+ * @param min Start of the first bin.
+ * @param max End of the last bin, which includes it.
+ * @param bins Amount of bins.
+ * @param counts Array of `bins` counters, overwritten.
  */
-void __ja_convert_to_num(ja_val *target);
+bool ja_arr_histogram_path(ja_val *array, const char *pointer, double min, double max, size_t bins, size_t *counts);
 
 /**
- * @brief Helper function to convert a value to string type.
- * 
- * @param target Value to be converted.
- * 
- * @note Not recommended to use directly.
+ * @brief Builds a hash index of the elements of an array by the value of a field.
+ *
+ * Numbers (ints and doubles alike), strings and booleans are indexed, elements where the field is missing or
+ * holds an array, an object or null are left out. The index is attached to the array: ja_arr_append() adds the
+ * new elements to it, and ja_set_arr_at(), ja_arr_remove_at() and ja_path_set() mark it to be rebuilt before
+ * the next lookup. Freeing the array detaches it.
+ *
+ * @return Index to be freed with ja_index_free(), or NULL on error (NULL arguments, invalid pointer or `array`
+ *         not an array).
+ *
+ * @param array Array of elements (usually objects).
+ * @param pointer JSON Pointer to the field in each element, e.g. "/id" ("" indexes the elements themselves).
+ *
+ * @note Changing the indexed field of an element in place isn't seen by the index, call ja_index_invalidate().
+ * @note Indexes aren't thread-safe, use them on the thread that modifies their array.
  */
-void __ja_convert_to_str(ja_val *target);
+ja_index *ja_index_build(ja_val *array, const char *pointer);
 
 /**
- * @brief Helper function to convert a value to boolean type.
- * 
- * @param target Value to be converted.
- * 
- * @note Not recommended to use directly.
+ * @brief Finds the first element whose field equals a key.
+ *
+ * @return Element of the array, or NULL if none matches (or the array was freed).
+ *
+ * @param index Index built by ja_index_build().
+ * @param key Number, string or boolean to look for.
  */
-void __ja_convert_to_bool(ja_val *target);
+ja_val *ja_index_lookup(ja_index *index, const ja_val *key);
 
 /**
- * @brief Helper function to convert a value to array type.
- * 
- * @param target Value to be converted.
- * 
- * @note Not recommended to use directly.
+ * @brief Same as ja_index_lookup(), with a number as key.
+ *
+ * @return Element of the array, or NULL if none matches.
+ *
+ * @param index Index built by ja_index_build().
+ * @param key Number to look for.
  */
-void __ja_convert_to_arr(ja_val *target);
+ja_val *ja_index_lookup_num(ja_index *index, double key);
 
 /**
- * @brief Helper function to convert a value to array type.
- * 
- * @param target Value to be converted.
- * 
- * @note Not recommended to use directly.
+ * @brief Same as ja_index_lookup(), with a string as key.
+ *
+ * @return Element of the array, or NULL if none matches.
+ *
+ * @param index Index built by ja_index_build().
+ * @param key String to look for.
  */
-void __ja_convert_to_obj(ja_val *target);
+ja_val *ja_index_lookup_str(ja_index *index, const char *key);
 
 /**
- * @brief Helper function to convert a value to null type.
- * 
- * @param target Value to be converted.
- * 
- * @note Not recommended to use directly.
+ * @brief Finds the elements whose field lies between two keys (both included), ordered by field.
+ *
+ * Numbers sort before strings (compared with strcmp()), which sort before booleans. A single bound only finds
+ * keys of its own kind. The first range asked for sorts the index, later ones are binary searches.
+ *
+ * @return Array of `count` elements to be freed with free(), or NULL on error (the array was freed, or the
+ *         keys are of different kinds). Without matches, an empty array (count = 0) is returned.
+ *
+ * @param index Index built by ja_index_build().
+ * @param low Smallest key, NULL for no lower bound.
+ * @param high Largest key, NULL for no upper bound.
+ * @param count Receives the amount of elements found.
  */
-void __ja_convert_to_null(ja_val *target);
+ja_val **ja_index_range(ja_index *index, const ja_val *low, const ja_val *high, size_t *count);
 
 /**
- * @brief Helper function to parse a string.
+ * @brief Marks an index to be rebuilt before the next lookup, after indexed fields were changed in place.
+ *
+ * @param index Index built by ja_index_build().
+ */
+void ja_index_invalidate(ja_index *index);
+
+/**
+ * @brief Frees an index and detaches it from its array.
+ *
+ * @param index Pointer to the index, set to NULL.
+ */
+void ja_index_free(ja_index **index);
+
+/**
+ * @brief Compares two values deeply, ignoring the order of object keys.
+ *
+ * Numbers compare by value (1 equals 1.0), and the comparison stops at the first difference. Subtrees shared by
+ * copy-on-write copies and objects of the same shape are compared without looking up keys.
+ *
+ * @return true if both values hold the same JSON, false otherwise or on error (NULL arguments).
+ *
+ * @param a First value.
+ * @param b Second value.
+ */
+bool ja_equal(ja_val *a, ja_val *b);
+
+/**
+ * @brief Same as ja_equal(), but objects must also list their keys in the same order.
+ *
+ * @return true if both values hold the same JSON with keys in the same order, false otherwise.
+ *
+ * @param a First value.
+ * @param b Second value.
+ */
+bool ja_equal_ordered(ja_val *a, ja_val *b);
+
+/**
+ * @brief Computes a 64-bit structural hash of a value.
+ *
+ * Values that ja_equal() finds equal have the same hash: ints and doubles of equal value hash alike, and the
+ * order of object keys doesn't change the hash. Packed arrays hash like arrays of nodes.
+ *
+ * @return Hash of the value, or 0 on error (NULL value).
+ *
+ * @param value Value to hash.
+ */
+uint64_t ja_hash(ja_val *value);
+
+/**
+ * @brief Creates an empty cache of subtree hashes for ja_hash_cached().
+ *
+ * @return Cache to be freed with ja_hash_cache_free(), or NULL on memory error.
+ */
+ja_hash_cache *ja_hash_cache_new(void);
+
+/**
+ * @brief Same as ja_hash(), remembering the hash of every array and object met in a cache.
+ *
+ * Subtrees already in the cache aren't walked again, which pays off when the same subtrees are hashed many
+ * times (copies sharing nodes through ja_copy_cow(), or memoization keys built from parts of one document).
+ *
+ * @return Hash of the value, or 0 on error (NULL value).
+ *
+ * @param value Value to hash.
+ * @param cache Cache from ja_hash_cache_new(), NULL to hash without caching.
+ *
+ * @note Entries are keyed by node address: clear the cache (ja_hash_cache_clear()) after modifying or freeing
+ *       nodes hashed through it.
+ */
+uint64_t ja_hash_cached(ja_val *value, ja_hash_cache *cache);
+
+/**
+ * @brief Forgets every hash stored in a cache, keeping its memory.
+ *
+ * @param cache Cache from ja_hash_cache_new().
+ */
+void ja_hash_cache_clear(ja_hash_cache *cache);
+
+/**
+ * @brief Frees a cache of subtree hashes.
+ *
+ * @param cache Pointer to the cache, set to NULL.
+ */
+void ja_hash_cache_free(ja_hash_cache **cache);
+
+/**
+ * @brief Computes a JSON Patch (RFC 6902) turning one value into another.
+ *
+ * Objects are compared member by member. Arrays are matched through the shortest edit script between the
+ * hashes of their elements (Myers' algorithm, after skipping their common prefix and suffix), and a removed
+ * element next to an added one is compared with it, so a changed record gives the operations of its changed
+ * fields only. The patch holds "add", "remove" and "replace" operations with copies of the new values.
+ *
+ * @return Array of operations (empty if both values are equal) to be freed with ja_free_val(), or NULL on error.
+ *
+ * @param from Value before the changes.
+ * @param to Value after the changes.
+ *
+ * @note Arrays needing more than JA_DIFF_MAX_EDITS removals and additions are compared element by element.
+ */
+ja_val *ja_diff(ja_val *from, ja_val *to);
+
+/**
+ * @brief Applies a JSON Patch (RFC 6902) to a document, in place.
+ *
+ * Every operation of the RFC is supported ("add", "remove", "replace", "move", "copy" and "test"), with paths
+ * given as JSON Pointers ("-" appends to an array). Values are copied from the patch. If an operation fails,
+ * the ones already applied are undone, leaving the document as it was.
+ *
+ * @return true if the whole patch was applied. On failure, false with the document untouched and the index of
+ *         the failed operation in the `offset` of ja_last_error() (JA_ERROR_INVALID_PATCH for malformed
+ *         operations, JA_ERROR_PATCH_TEST_FAILED for "test" operations, or the error of the missing path).
+ *
+ * @param document Document to modify.
+ * @param patch Array of operations, like the ones of ja_diff().
+ */
+bool ja_patch_apply(ja_val *document, ja_val *patch);
+
+/**
+ * @brief Applies a JSON Merge Patch (RFC 7386) to a value, in place.
+ *
+ * Members of an object patch replace the ones of the target, objects merging into objects, and null members
+ * delete theirs. A patch that isn't an object replaces the whole target, and a target that isn't an object
+ * becomes one before an object patch is merged into it. The values of the patch are shared copy-on-write with
+ * the target (see ja_copy_cow()), so the patch is left untouched.
+ *
+ * @return true on success, false if memory ran out (the members merged so far stay merged).
+ *
+ * @param target Value to modify, keeping its address.
+ * @param patch Merge patch, any value.
+ */
+bool ja_merge_patch(ja_val *target, ja_val *patch);
+
+/**
+ * @brief Applies a JSON Merge Patch (RFC 7386) in place and frees the patch, moving its values into the target.
+ *
+ * Same as ja_merge_patch(), but the subtrees of the patch are handed over to the target instead of shared.
+ * Patches laid out in a block (ja_copy_compact(), ja_load_snapshot()) or shared copy-on-write are copied from.
+ *
+ * @return true on success, false if memory ran out. The patch is freed either way.
+ *
+ * @param target Value to modify, keeping its address.
+ * @param patch Pointer to the merge patch, set to NULL.
+ */
+bool ja_merge_patch_consume(ja_val *target, ja_val **patch);
+
+/**
+ * @brief Computes the result of applying merge patches (RFC 7386) to a document, in a single pass.
+ *
+ * The result is the one of ja_merge_patch() applied on a copy of layers[0] with layers[1] to layers[count - 1]
+ * in order, but each member is merged across all the layers at once, and the subtrees set by a single layer
+ * are shared copy-on-write instead of copied. Members are ordered by their first appearance.
+ *
+ * @return New value to be freed with ja_free_val(), or NULL on error. The layers are left untouched.
+ *
+ * @param layers Base document followed by the patches, from the lowest to the highest priority.
+ * @param count Number of layers, at least 1.
+ *
+ * Example:
+ * @code
+ *     ja_val *layers[] = {defaults, environment, tenant};
+ *     ja_val *config = ja_merge_layers(layers, 3);
+ * @endcode
+ */
+ja_val *ja_merge_layers(ja_val **layers, size_t count);
+
+/**
+ * @brief Retrieves the key at a specific position of the origin (object).
  * 
- * @param json_str String to be interpreted.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * @return Key found at the position, in insertion order. It must not be modified or freed.
  * 
- * @note Not recommended to use directly.
+ * @param origin Value (object) that will have its keys accessed.
+ * @param index Position of the key, from 0 to ja_size_of(origin) - 1.
+ * 
+ * @note Use this instead of `u.object.pairs`, parsed objects may store their keys in a shared shape.
  */
-ja_val *__ja_parse(const char *json_str, int *chars_consumed);
+const char *ja_obj_key_at(ja_val *origin, size_t index);
 
 /**
- * @brief Helper function to parse a string to number.
+ * @brief Retrieves the value at a specific position of the origin (object).
  * 
- * @param json_str String to be interpreted.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * @return ja_val stored with the key returned by ja_obj_key_at() for the same index.
  * 
- * @note Not recommended to use directly.
+ * @param origin Value (object) that will have its values accessed.
+ * @param index Position of the value, from 0 to ja_size_of(origin) - 1.
+ * 
+ * @note If the provided index is invalid, this function will return NULL, and throw a warning (when JA_DEBUG is enabled).
  */
-ja_val *__ja_parse_number(const char *json_str, int *chars_consumed);
+ja_val *ja_obj_val_at(ja_val *origin, size_t index);
 
 /**
- * @brief Helper function to parse a string to string.
- * 
- * @param json_str String to be interpreted.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * @brief Appends a new value at the end of the array and takes ownership of the passed pointer.
  * 
- * @note Not recommended to use directly.
+ * @param target Array from which content will be inserted.
+ * @param content_to_add New value that'll be put at a the end of the array.
  */
-ja_val *__ja_parse_string(const char *json_str, int *chars_consumed);
+void ja_arr_append(ja_val *target, ja_val *content_to_add);
 
 /**
- * @brief Helper function to parse a string to boolean.
+ * @brief Removes a value from a specific position of the array.
  * 
- * @param json_str String to be interpreted.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * This function frees the value removed, making it unusable.
  * 
- * @note Not recommended to use directly.
+ * @param target Array from which content will be removed.
+ * @param index Position from which the value will be removed
+ * 
+ * @note If the index provided is not a valid position on the array, it will raise an error (when JA_DEBUG is enabled).
  */
-ja_val *__ja_parse_bool(const char *json_str, int *chars_consumed);
+void ja_arr_remove_at(ja_val *target, size_t index);
 
 /**
- * @brief Helper function to parse a string to array.
+ * @brief Detaches a value from a specific position of the array without freeing it.
+ *
+ * @return The value removed, now owned by the caller (free it with ja_free_val() or store it elsewhere),
+ *         or NULL on error.
+ *
+ * @param target Array from which the value will be taken.
+ * @param index Position of the value.
+ *
+ * @note Elements of packed arrays get a node of their own. Values inside the block of a compact copy
+ *       (ja_copy_compact(), ja_load_snapshot()) are copied out, since the block goes away with its root.
+ */
+ja_val *ja_arr_take_at(ja_val *target, size_t index);
+
+/**
+ * @brief Moves every element of an array to the end of another one, leaving the source empty.
+ *
+ * Elements are moved as pointers (or as packed numbers and booleans), never copied, with a single
+ * reallocation of the target. An empty target takes over the buffer of the source.
+ *
+ * @return true on success, false on error (both arrays are left as they were).
+ *
+ * @param target Array receiving the elements.
+ * @param source Array giving its elements away. It stays allocated, as an empty array.
+ */
+bool ja_arr_extend(ja_val *target, ja_val *source);
+
+/**
+ * @brief Keeps the elements of an array a predicate accepts, freeing the others, in a single pass.
+ *
+ * Kept elements keep their order and are moved down once, and the buffer is reallocated at most once, so
+ * removing any number of elements costs O(n) instead of O(n) per ja_arr_remove_at().
+ *
+ * @return true on success, false on error.
+ *
+ * @param array Array to filter.
+ * @param predicate Called once per element, in order, returning whether to keep it. It must not modify the
+ *                  array, and elements of packed arrays are handed to it in a temporary node.
+ * @param user_data Passed to the predicate.
+ */
+bool ja_arr_retain_if(ja_val *array, ja_predicate predicate, void *user_data);
+
+/**
+ * @brief Replaces a range of elements of an array with new values.
+ *
+ * Removed elements are freed and the new values are taken over, with a single memmove() of the elements
+ * after the range and at most one reallocation.
+ *
+ * @return true on success. On failure, false with the array untouched and the values still owned by the caller.
+ *
+ * @param array Array to modify.
+ * @param index Position of the first element to remove, or where to insert (up to the size of the array).
+ * @param remove_count Number of elements to remove.
+ * @param values Values to insert at `index`, in order (can be NULL if `count` is 0).
+ * @param count Number of values.
+ */
+bool ja_arr_splice(ja_val *array, size_t index, size_t remove_count, ja_val **values, size_t count);
+
+/**
+ * @brief Inserts values at a position of an array, same as ja_arr_splice() without removing anything.
+ *
+ * @return true on success, false on error (the values stay owned by the caller).
+ *
+ * @param array Array to modify.
+ * @param index Position of the first value, from 0 to the size of the array (which appends them).
+ * @param values Values to insert, in order.
+ * @param count Number of values.
+ */
+bool ja_arr_insert_range(ja_val *array, size_t index, ja_val **values, size_t count);
+
+/**
+ * @brief Appends the elements of an array to another one, leaving the source untouched.
+ *
+ * Elements are shared copy-on-write with the source (see ja_copy_cow()) and packed numbers and booleans are
+ * copied, with a single reallocation of the target. Use ja_arr_extend() to move them instead.
+ *
+ * @return true on success, false on error (the target is left as it was).
+ *
+ * @param target Array receiving the elements.
+ * @param source Array whose elements are appended, possibly the target itself.
+ */
+bool ja_arr_concat(ja_val *target, ja_val *source);
+
+/**
+ * @brief Gives direct access to the numbers of an array, as a contiguous C array.
+ *
+ * Arrays of numbers built by the parser, the binary decoders and ja_new_set_arr() are packed: their elements
+ * are stored as doubles, without a ja_val per element. Other arrays holding only numbers are packed by this
+ * call. Ints are stored exactly (see ja_num).
+ *
+ * @return The numbers of the array (not a copy, valid until the array is modified), or NULL if the array
+ *         holds anything but numbers.
+ *
+ * @param array Array of numbers.
+ * @param size Receives the amount of numbers.
+ *
+ * @note Handing out an element as a ja_val (ja_get_arr_at(), compiled paths, queries) turns the array back
+ *       into an array of nodes, as does storing anything but a number in it.
+ */
+const double *ja_arr_as_doubles(ja_val *array, size_t *size);
+
+/**
+ * @brief Gives direct access to the booleans of an array, as a contiguous C array.
+ *
+ * @return The booleans of the array (not a copy, valid until the array is modified), or NULL if the array
+ *         holds anything but booleans.
+ *
+ * @param array Array of booleans.
+ * @param size Receives the amount of booleans.
+ *
+ * @note Packed the same way as ja_arr_as_doubles().
+ */
+const bool *ja_arr_as_bools(ja_val *array, size_t *size);
+
+
+/**
+ * @brief Removes a value from a specific key of the object.
  * 
- * @param json_str String to be interpreted.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * This function frees the value removed, making it unusable. The other members keep their order.
+ * Objects with a key map (JA_OBJ_MAP_MIN pairs or more) leave a tombstone instead of moving the
+ * pairs after it, so removals take amortized constant time.
  * 
- * @note Not recommended to use directly.
+ * @param target Object from which content will be removed.
+ * @param key Key from which the value will be removed
+ * 
+ * @note If the key provided is not valid for the object, it will raise an error (when JA_DEBUG is enabled).
  */
-ja_val *__ja_parse_array(const char *json_str, int *chars_consumed);
+void ja_obj_remove_at(ja_val *target, const char *key);
 
 /**
- * @brief Helper function to parse a string to object.
+ * @brief Detaches the value of a specific key of the object without freeing it.
+ *
+ * @return The value removed, now owned by the caller, or NULL if the key isn't there or on error.
+ *
+ * @param target Object from which the value will be taken.
+ * @param key Key of the value.
+ *
+ * @note Values inside the block of a compact copy are copied out, as with ja_arr_take_at().
+ */
+ja_val *ja_obj_take_at(ja_val *target, const char *key);
+
+/**
+ * @brief Moves every member of an object into another one, leaving the source empty.
+ *
+ * Values are moved as pointers, never copied. Keys already in the target keep their position and get the
+ * value of the source, the previous one being freed, and new keys are added at the end in their order.
+ *
+ * @return true on success, false on error.
+ *
+ * @param target Object receiving the members.
+ * @param source Object giving its members away. It stays allocated, as an empty object.
+ */
+bool ja_obj_merge_move(ja_val *target, ja_val *source);
+
+/**
+ * @brief Function to convert values between different types.
  * 
- * @param json_str String to be interpreted.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * It will overwrite the previous value and change the container type.
  * 
- * @note Not recommended to use directly.
+ * @return Returns back the target for easier access or copy.
+ * 
+ * @param target The value which will be converted.
+ * 
+ * @note Not all conversions are supported. If a conversion in not supported, the code will throw a warning (JA_DEBUG).
  */
-ja_val *__ja_parse_object(const char *json_str, int *chars_consumed);
+ja_val* ja_convert_to(ja_val *target, ja_type new_type);
 
 /**
- * @brief Helper function to parse a string to null.
+ * @brief Creates a string that has the representation of a JSON value.
  * 
- * @param json_str String to be interpreted.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * @return JSON string with the values interpreted.
  * 
- * @note Not recommended to use directly.
+ * @param value ja_val that will have its string generated.
+ * 
+ * @note This returns an ALLOCATED string (char*), so it's the users responsibility to manage it.
  */
-ja_val *__ja_parse_null(const char *json_str, int *chars_consumed);
+char* ja_stringify(ja_val* value);
 
 /**
- * @brief Skips the whitespace in a string.
+ * @brief Displays on the stdout the string representation of a JSON value.
  * 
- * @param str_ptr Pointer to the string (char**) that will be processed.
- * @param chars_consumed Pointer to integer that tracks read characters.
+ * @param value ja_val that will be displayed.
  * 
- * @note Not recommended to use directly.
- * @note It modifies the value of the passed pointer.
+ * @note This function uses the ja_stringify internally, but also frees the memory, so it is automatically managed.
  */
-void __ja_jump_whitespaces(const char **str_ptr, int *chars_consumed);
+void ja_print(ja_val* value);
 
 /**
- * @brief Helper for freeing a ja_val.
+ * @brief Reads a string and generates a JSON value based on that string.
  * 
- * @param val_ptr Pointer to a ja_val (ja_val*) that will be freed.
+ * @return A ja_val constructed based of the JSON string.
  * 
- * @note This function recursively frees the memory inside this ja_val, including its children, so be careful.
- * @note It only frees the content inside the value, so it is not recommended to use it, unless you know what you are doing.
- * @note This function is used internally in other functions.
+ * @param json_str The contents which will be interpreted.
+ * 
+ * @note When interpreting a string, for example `"hello"`, the parser will only understand it is a string if it's presented with escaped double quotes, as the examples show.
+ * 
+ * @example
+ * ja_val *parsed_val;
+ * parsed_val = ja_parse("1234");
+ * parsed_val = ja_parse("\"Hello\"");
  */
-void __ja_free_val(ja_val *value);
+ja_val *ja_parse(const char *json_str);
+
+/**
+ * @brief Reads a string and generates a JSON value, parsing large arrays on several threads.
+ *
+ * Arrays reached through the top-level objects and arrays are pre-scanned to find the boundaries of their elements.
+ * When an array is big enough (JA_PARALLEL_MIN_BYTES), its elements are parsed concurrently and then
+ * stitched back into the array in order.
+ *
+ * @return A ja_val constructed based of the JSON string, equal to the result of ja_parse().
+ *
+ * @param json_str The contents which will be interpreted.
+ * @param thread_count Amount of threads (0 = one per CPU core).
+ *
+ * @note Worker threads are only used when the library is compiled with JA_THREADS.
+ */
+ja_val *ja_parse_parallel(const char *json_str, int thread_count);
+
+/**
+ * @brief Checks that a buffer holds exactly one valid JSON value, without building anything.
+ *
+ * Follows RFC 8259 strictly: strings must be valid UTF-8 with valid escapes (including surrogate pairs),
+ * numbers must follow the JSON grammar, trailing commas are rejected and nesting is limited to JA_MAX_DEPTH.
+ * No memory is allocated and nothing is logged.
+ *
+ * @return true if the JSON text is valid, false otherwise.
+ *
+ * @param json_str Text to be checked (doesn't need to be null-terminated).
+ * @param length Amount of bytes of the text.
+ * @param error Receives the code, position and reason of the first error (can be NULL).
+ *
+ * @note ja_parse() is more lenient (e.g. it accepts trailing commas), so it can accept text rejected here.
+ *
+ * @example
+ * ja_error error;
+ * if (!ja_validate(body, body_length, &error)) {
+ *     printf("%s at line %zu, column %zu\n", error.reason, error.line, error.column);
+ * }
+ */
+bool ja_validate(const char *json_str, size_t length, ja_error *error);
+
+/**
+ * @brief Function to access the error of the last failed call on the current thread.
+ *
+ * Functions that fail record what went wrong before returning NULL/false: the code, a reason, and for
+ * ja_parse() and ja_read_json() the offset, line, column and path of the error in the JSON text.
+ * Successful calls don't clear it.
+ *
+ * @return Error of the current thread (code JA_ERROR_NONE if nothing failed since the last ja_clear_last_error()).
+ *
+ * @example
+ * ja_val *config = ja_parse(text);
+ * if (!config) {
+ *     const ja_error *error = ja_last_error();
+ *     printf("%s at %s (line %zu)\n", error->reason, error->path, error->line);
+ * }
+ */
+const ja_error *ja_last_error(void);
+
+/**
+ * @brief Resets the error returned by ja_last_error() on the current thread.
+ */
+void ja_clear_last_error(void);
+
+/**
+ * @brief Sets the function receiving the messages of the library (JA_DEBUG builds).
+ *
+ * Nothing is logged by default, and messages are not even formatted while no callback is set.
+ *
+ * @param callback Function called for each message, or NULL to disable logging.
+ * @param user_data Pointer passed to every call of the callback.
+ *
+ * @note The callback may be called from worker threads (see JA_THREADS).
+ *
+ * @example
+ * ja_set_log_callback(ja_log_stderr, NULL); // Print messages like previous versions
+ */
+void ja_set_log_callback(ja_log_callback callback, void *user_data);
+
+/**
+ * @brief Log callback printing errors, warnings and traces to stderr, and information to stdout.
+ */
+void ja_log_stderr(ja_log_level level, const char *file, int line, const char *message, void *user_data);
+
+/**
+ * @brief Function to access the type of a value.
+ * 
+ * @return Integer representation of the type enum. -1 if the type is unknown.
+ * 
+ * @param value ja_val to have its type analyzed.
+ */
+int ja_enum_type_of(ja_val *value);
+
+/**
+ * @brief Function to access the type of a value.
+ * 
+ * @return Non allocated descriptive string of the type.
+ * 
+ * @param value ja_val to have its type analyzed.
+ */
+const char *ja_str_type_of(ja_val *value);
+
+/**
+ * @brief Function to access the type of a value.
+ * 
+ * @return Returns the type as string based on the provided enum value.
+ * 
+ * @param type Type as enum constant to be retrieved as string.
+ */
+const char *__ja_type_enum_to_str(ja_type type);
+
+/**
+ * @brief Function to access the size of a value.
+ * 
+ * @return Value of the length, the amount of inner elements. Returns 0 for numbers, booleans and null.
+ * 
+ * @param value ja_val to be analyzed
+ * 
+ * @note Only works for strings, arrays and objects.
+ */
+size_t ja_size_of(ja_val *value);
+
+/**
+ * @brief Frees the a ja_val and its contents and sets `*val_ptr = NULL`. Use this to free values you own.
+ * 
+ * @param val_ptr Pointer to a ja_val pointer (ja_val**) that will be freed.
+ * 
+ * @note This function recursively frees the memory inside this ja_val, including its children, so be careful.
+ */
+void ja_free_val(ja_val **val_ptr);
+
+/**
+ * @brief Hands a ja_val to a background thread to be freed, and sets `*val_ptr = NULL`.
+ * 
+ * Useful to drop big documents without stalling the calling thread. Scalars are freed right away.
+ * 
+ * @param val_ptr Pointer to a ja_val pointer (ja_val**) that will be freed.
+ * 
+ * @note Without JA_THREADS (or if the thread can't be started) the value is freed before returning.
+ * @note The value must not be shared with other threads anymore, children included.
+ */
+void ja_free_val_deferred(ja_val **val_ptr);
+
+/**
+ * @brief Waits until every value passed to ja_free_val_deferred() has been freed.
+ */
+void ja_wait_deferred_free(void);
+
+/**
+ * @brief Stops the worker threads kept by the parallel functions (parsing, NDJSON, queries, columns).
+ *
+ * The threads are started by the first parallel call that needs them and then wait for the next calls.
+ * A later parallel call starts them again.
+ *
+ * @note Call it once no parallel call is running anymore, e.g. before exiting or unloading the library.
+ * @note Does nothing without JA_THREADS.
+ */
+void ja_stop_worker_threads(void);
+
+/**
+ * @brief Function to initialize a ja_json object, used for files I/O.
+ * 
+ * @return Allocated pointer to a new ja_json object.
+ */
+ja_json* ja_json_init();
+
+/**
+ * @brief Reads a file and parse its contents.
+ * 
+ * @return Boolean value based on the success of the operation. true for success, false for failure (with error on JA_DEBUG).
+ * 
+ * @param ja_json_object Wrapper that will hold the contents. 
+ * @param filename Name of the file to be open.
+ * 
+ * @note Must contain the file extension too (e.g.: "users_data.json").
+ * @note gzip and Zstandard files are detected by their magic bytes (with JA_ZLIB or JA_ZSTD) and parsed
+ *       chunk by chunk while they are decompressed, without ever holding their whole text: json_str stays NULL
+ *       until ja_sync_json().
+ */
+bool ja_read_json(ja_json *ja_json_object, const char *filename);
+
+/**
+ * @brief Reads a file and parse its contents using ja_parse_parallel().
+ *
+ * @return Boolean value based on the success of the operation. true for success, false for failure (with error on JA_DEBUG).
+ *
+ * @param ja_json_object Wrapper that will hold the contents.
+ * @param filename Name of the file to be open.
+ * @param thread_count Amount of threads (0 = one per CPU core).
+ *
+ * @note Must contain the file extension too (e.g.: "users_data.json").
+ * @note Compressed files are parsed on the calling thread while they are decompressed, as by ja_read_json().
+ */
+bool ja_read_json_parallel(ja_json *ja_json_object, const char *filename, int thread_count);
+
+/**
+ * @brief Writes JSON content in a file.
+ * 
+ * @return Boolean value based on the success of the operation. true for success, false for failure (with error on JA_DEBUG).
+ * 
+ * @param ja_json_object Wrapper that holds the contents.
+ * @param filename Name of the file to be written.
+ * 
+ * @note Automatically syncs the inner string to match the content (using ja_sync_json()).
+ * @note This will overwrite files that have the same name. Be careful.
+ * @note Must contain the file extension too (e.g.: "users_data.json"). Names ending in ".gz" or ".zst"
+ *       are compressed while they are written (with JA_ZLIB or JA_ZSTD, see __ja_write_file()).
+ */
+bool ja_write_json(ja_json *ja_json_object, const char *filename);
+
+/**
+ * @brief Final operation for dealing with a ja_json object. Will free the memory.
+ * 
+ * @param ja_json_object Content to be handled.
+ * 
+ * @note This frees both the ja_val and string contained in the object.
+ */
+void ja_json_end(ja_json *ja_json_object);
+
+/**
+ * @brief Syncs the string inside the ja_json object to match the ja_val contained.
+ * 
+ * @param ja_json_object The instance which needs to be updated.
+ * 
+ * @note This is essential when writing back a modified file, if it is not called, then contents wont change.
+ */
+void ja_sync_json(ja_json *ja_json_object);
+
+/**
+ * @brief Removes the whitespace between the tokens of JSON text, in place and without building a tree.
+ *
+ * Whitespace inside strings is kept. The text is not validated, use ja_validate() for that.
+ *
+ * @return New length of the text. If it got shorter, a null terminator is written after it.
+ *
+ * @param json_str Text to be compacted (doesn't need to be null-terminated).
+ * @param length Amount of bytes of the text.
+ *
+ * @example
+ * size_t length = ja_minify(buffer, strlen(buffer));
+ */
+size_t ja_minify(char *json_str, size_t length);
+
+/**
+ * @brief Copies JSON text from one stream to another without the whitespace between tokens.
+ *
+ * Works on a fixed buffer of JA_MINIFY_BUFFER_SIZE bytes, whatever the size of the input.
+ *
+ * @return true on success, false on read, write or memory allocation errors.
+ *
+ * @param input Stream to be read.
+ * @param output Stream that receives the compacted text.
+ */
+bool ja_minify_stream(FILE *input, FILE *output);
+
+/**
+ * @brief Minifies a JSON file into another file, see ja_minify_stream().
+ *
+ * @return true on success, false otherwise.
+ *
+ * @param input_filename File to be read.
+ * @param output_filename File to be written (it must be a different file).
+ */
+bool ja_minify_file(const char *input_filename, const char *output_filename);
+
+/**
+ * @brief Saves a value as a binary snapshot, which ja_load_snapshot() can use without parsing.
+ *
+ * The file holds the nodes laid out as in ja_copy_compact() with offsets instead of pointers, followed by
+ * a pool of distinct strings, the table of object keys and the shapes of parsed objects.
+ *
+ * @return true on success, false otherwise.
+ *
+ * @param value Value to be saved.
+ * @param filename File to be written.
+ *
+ * @note Snapshots can only be loaded by builds with the same ja_val layout, pointer size and byte order.
+ */
+bool ja_save_snapshot(ja_val *value, const char *filename);
+
+/**
+ * @brief Loads a snapshot written by ja_save_snapshot().
+ *
+ * The file is mapped in memory when possible (read into a single block otherwise), and its offsets are
+ * turned back into pointers in place: there is no parsing and no allocation per node. The result is a
+ * regular value, freed with ja_free_val().
+ *
+ * @return The saved value, or NULL on error (see ja_last_error(), JA_ERROR_INVALID_SNAPSHOT for bad files).
+ *
+ * @param filename File to be loaded.
+ *
+ * @note Offsets, node references and counts are checked before loading, but snapshots are meant to be
+ *       trusted files written by this library.
+ */
+ja_val *ja_load_snapshot(const char *filename);
+
+/**
+ * @brief Encodes a value as MessagePack.
+ *
+ * Integers are written in the smallest integer format that holds them and doubles as float 64,
+ * so the decoded value keeps its JA_TYPE_INT or JA_TYPE_DOUBLE type. Strings and keys are written
+ * as they are stored (the same characters ja_get_str() returns).
+ *
+ * @return Allocated buffer with the encoded bytes (to be freed with free()), or NULL on error.
+ *
+ * @param value Value to be encoded.
+ * @param length Receives the amount of bytes of the buffer.
+ */
+unsigned char *ja_to_msgpack(ja_val *value, size_t *length);
+
+/**
+ * @brief Decodes a MessagePack value.
+ *
+ * Integers become JA_TYPE_INT (JA_TYPE_DOUBLE if they don't fit in an int), floats become JA_TYPE_DOUBLE,
+ * and maps become objects, shaped like parsed ones. When a key repeats, the last value is kept.
+ *
+ * @return The decoded value, or NULL on error (see ja_last_error(), whose offset is the offending byte).
+ *
+ * @param data Encoded bytes.
+ * @param length Amount of bytes, which must hold exactly one value.
+ *
+ * @note Binary data, extensions and non-string keys fail with JA_ERROR_UNSUPPORTED_TYPE.
+ */
+ja_val *ja_from_msgpack(const unsigned char *data, size_t length);
+
+/**
+ * @brief Encodes a value as CBOR (RFC 8949), with the same mapping as ja_to_msgpack().
+ *
+ * @return Allocated buffer with the encoded bytes (to be freed with free()), or NULL on error.
+ *
+ * @param value Value to be encoded.
+ * @param length Receives the amount of bytes of the buffer.
+ */
+unsigned char *ja_to_cbor(ja_val *value, size_t *length);
+
+/**
+ * @brief Decodes a CBOR value, with the same mapping as ja_from_msgpack().
+ *
+ * Half, single and double precision floats are read, indefinite-length arrays and maps are accepted,
+ * tags are skipped (the tagged item is decoded) and undefined is read as null.
+ *
+ * @return The decoded value, or NULL on error (see ja_last_error(), whose offset is the offending byte).
+ *
+ * @param data Encoded bytes.
+ * @param length Amount of bytes, which must hold exactly one value.
+ *
+ * @note Byte strings, indefinite-length strings, simple values and non-string keys fail with JA_ERROR_UNSUPPORTED_TYPE.
+ */
+ja_val *ja_from_cbor(const unsigned char *data, size_t length);
+
+/**
+ * @brief Selects how object keys are interned.
+ *
+ * With JA_INTERN_DOCUMENT, equal keys of the same parsed document point to the same string.
+ * With JA_INTERN_GLOBAL, every key created by the parser, ja_set_obj_at() and ja_new_set_obj()
+ * goes through a table shared by the whole program.
+ *
+ * @param mode New interning mode.
+ *
+ * @note Keys are reference counted, so values can be freed in any order regardless of the mode.
+ */
+void ja_set_intern_mode(ja_intern_mode mode);
+
+/**
+ * @brief Empties the global key table used by JA_INTERN_GLOBAL.
+ *
+ * @note Keys still used by objects stay alive until those objects are freed.
+ */
+void ja_clear_interned_keys(void);
+
+/**
+ * @brief Returns the default options for reading NDJSON files.
+ *
+ * @return Options with one thread per CPU core, 4 MB batches, ordered delivery and stop on the first malformed line.
+ */
+ja_ndjson_options ja_ndjson_default_options(void);
+
+/**
+ * @brief Opens a newline-delimited JSON (NDJSON / JSON Lines) file for reading.
+ *
+ * The file is streamed in batches. Every batch is split at newline boundaries and its lines
+ * are parsed on the worker threads, without copying the lines out of the batch buffer.
+ *
+ * @return Allocated reader, or NULL if the file can't be opened (with error on JA_DEBUG).
+ *
+ * @param filename Name of the file to be open.
+ * @param options Reading options, NULL for ja_ndjson_default_options().
+ *
+ * @note Blank lines are ignored, but still counted for line numbers.
+ * @note Worker threads are only used when the library is compiled with JA_THREADS.
+ */
+ja_ndjson_reader *ja_ndjson_open(const char *filename, const ja_ndjson_options *options);
+
+/**
+ * @brief Retrieves the next document of the file, in file order.
+ *
+ * @return The parsed document (owned by the caller), or NULL at the end of the file or on a malformed line
+ * when invalid lines are not skipped.
+ *
+ * @param reader Reader created with ja_ndjson_open().
+ * @param line Optional pointer that receives the line number of the document.
+ */
+ja_val *ja_ndjson_next(ja_ndjson_reader *reader, size_t *line);
+
+/**
+ * @brief Reads the whole file and hands every document to a callback.
+ *
+ * When `options.ordered` is false and the library is compiled with JA_THREADS, the callback is called
+ * from the worker threads as soon as each line is parsed, so it must be thread-safe.
+ *
+ * @return true if the file was read completely, false on a malformed line (when not skipped),
+ * on read failure, or when the callback returned false.
+ *
+ * @param reader Reader created with ja_ndjson_open().
+ * @param callback Function receiving each document, it takes ownership of it. Return false to stop reading.
+ * @param user_data Pointer passed along to the callback.
+ */
+bool ja_ndjson_for_each(ja_ndjson_reader *reader, ja_ndjson_callback callback, void *user_data);
+
+/**
+ * @brief Function to access the malformed lines found so far.
+ *
+ * @return Non allocated array with the location of each malformed line, in file order.
+ *
+ * @param reader Reader to be analyzed.
+ * @param count Pointer that receives the amount of errors.
+ */
+const ja_ndjson_error *ja_ndjson_errors(ja_ndjson_reader *reader, size_t *count);
+
+/**
+ * @brief Closes the file and frees the reader, including documents not delivered yet.
+ *
+ * @param reader Reader to be closed.
+ */
+void ja_ndjson_close(ja_ndjson_reader *reader);
+
+// === Internal Helper Functions (not for public use) ===
+
+/**
+ * @brief Internal function to create a new generic JSON value
+ *
+ * Creates a new ja_val with uninitialized content.
+ *
+ * @return ja_val* Pointer to the newly created ja_val with no type or value set,
+ * or NULL on memory allocation failure.
+ *
+ * @note It is not recommended to use this function directly,
+ * use the specific jaNew* functions instead.
+ */
+ja_val *__ja_new_generic(void);
+
+/**
+ * @brief Adds an owner to a value shared by ja_copy_cow().
+ * 
+ * @return `value`, or a deep copy of it once its share count is saturated (NULL if that copy fails).
+ * 
+ * @param value Value to be shared.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_cow_share(ja_val *value);
+
+/**
+ * @brief Drops an owner of a value shared by ja_copy_cow().
+ * 
+ * @return true if other trees still own the value (it must not be freed), false if the caller is its only owner.
+ * 
+ * @param value Value to be released.
+ * 
+ * @note Not recommended to use directly.
+ */
+bool __ja_cow_release(ja_val *value);
+
+/**
+ * @brief Copies a value, sharing its children instead of copying them.
+ * 
+ * @return a new ja_val, or NULL on memory allocation failure.
+ * 
+ * @param original Value to be copied (scalars are copied as with ja_copy()).
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_copy_shallow(ja_val *original);
+
+/**
+ * @brief Makes sure the value in a slot of an array or object is only owned by that slot.
+ * 
+ * @return The value in the slot, replaced by a shallow copy if it was shared (NULL on memory allocation failure).
+ * 
+ * @param slot Slot of an array or object owned by the caller.
+ * 
+ * @note Not recommended to use directly. Used by ja_edit_arr_at(), ja_edit_obj_at() and the mutators reaching
+ *       a value through its parent, never by the getters.
+ */
+ja_val *__ja_cow_own(ja_val **slot);
+
+/**
+ * @brief Stores the elements of an array of numbers (or of booleans) in a packed buffer, freeing their nodes.
+ *
+ * @return true if the array is packed, false if it holds other types, is empty or on memory allocation failure.
+ *
+ * @param array Array to be packed.
+ *
+ * @note Not recommended to use directly. Only used on arrays whose elements aren't referenced anywhere else.
+ */
+bool __ja_arr_pack(ja_val *array);
+
+/**
+ * @brief Turns a packed array back into an array of nodes.
+ *
+ * The nodes already handed out by __ja_arr_slot() become the elements, so pointers to them stay valid.
+ *
+ * @return true on success (or if the array isn't packed), false on memory allocation failure.
+ *
+ * @param array Array to be unpacked.
+ *
+ * @note Not recommended to use directly. Used before changing the elements of an array in ways packing can't hold.
+ */
+bool __ja_arr_unpack(ja_val *array);
+
+/**
+ * @brief Gets the slot holding an element of an array, without unpacking packed arrays.
+ *
+ * Elements of packed arrays get a node the first time they're asked for (kept by the array, which stays packed),
+ * so several threads can read the same array at once. Changing one of those nodes unpacks the array first.
+ *
+ * @return Slot of the element, or NULL on memory allocation failure.
+ *
+ * @param array Array holding the element.
+ * @param index Position of the element, smaller than the size of the array.
+ *
+ * @note Not recommended to use directly. The slot of a packed array must only be read, never assigned.
+ */
+ja_val **__ja_arr_slot(ja_val *array, size_t index);
+
+/**
+ * @brief Fills a node with an element of a packed array.
+ *
+ * @param array Packed array.
+ * @param index Position of the element.
+ * @param out Node that receives the element (usually a temporary one on the stack).
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_packed_get(const ja_val *array, size_t index, ja_val *out);
+
+/**
+ * @brief Tells the indexes of an array that it changed.
+ *
+ * @param array Array with indexes attached.
+ * @param appended true when elements were only appended (they're indexed right away), false to rebuild the
+ *                 indexes before their next lookup.
+ *
+ * @note Not recommended to use directly. Called by the array functions when `array` has JA_FLAG_INDEXED.
+ */
+void __ja_index_changed(ja_val *array, bool appended);
+
+/**
+ * @brief Detaches the indexes of an array that is being freed or replaced.
+ *
+ * @param array Array with indexes attached.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_index_detach(ja_val *array);
+
+// Amount of memory a value needs to be copied by ja_copy_compact()
+typedef struct __ja_compact_size {
+    size_t nodes;         // ja_val structs
+    size_t slots;         // Pointers of arrays and shaped objects
+    size_t pairs;         // Pairs of objects without shape
+    size_t string_bytes;  // Characters of the strings, terminators included
+} __ja_compact_size;
+
+/**
+ * @brief Measures a value and its children for ja_copy_compact().
+ * 
+ * @return false on memory allocation failure (of the work stack).
+ * 
+ * @param original Value to be measured.
+ * @param size Receives the totals.
+ * 
+ * @note Not recommended to use directly.
+ */
+bool __ja_compact_measure(ja_val *original, __ja_compact_size *size);
+
+/**
+ * @brief Writes the copy of a value into a block sized with __ja_compact_measure().
+ * 
+ * @return The copy, which starts the block.
+ * 
+ * @param original Value to be copied.
+ * @param size Totals returned by __ja_compact_measure() for `original`.
+ * @param block Memory of at least __ja_compact_bytes(size) bytes.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_compact_write(ja_val *original, const __ja_compact_size *size, void *block);
+
+/**
+ * @brief Bytes of the block needed for a measured value.
+ * 
+ * @note Not recommended to use directly.
+ */
+size_t __ja_compact_bytes(const __ja_compact_size *size);
+
+/**
+ * @brief Moves the children buffer of an array or object out of a ja_copy_compact() block, before it's resized or freed.
+ * 
+ * @return false on memory allocation failure.
+ * 
+ * @param value Array or object to be modified.
+ * 
+ * @note Not recommended to use directly.
+ */
+bool __ja_block_own_data(ja_val *value);
+
+// Growable byte buffer written by the binary encoders
+typedef struct __ja_buffer {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+    bool failed;          // An allocation failed, later writes are ignored
+} __ja_buffer;
+
+/**
+ * @brief Appends bytes to a buffer, growing it geometrically.
+ * 
+ * @return false if the buffer couldn't grow (or an earlier write failed).
+ * 
+ * @param buffer Buffer to be written, zero-initialized before the first write.
+ * @param bytes Bytes to be appended.
+ * @param length Amount of bytes.
+ * 
+ * @note Not recommended to use directly.
+ */
+bool __ja_buffer_put(__ja_buffer *buffer, const void *bytes, size_t length);
+
+/**
+ * @brief Makes room for at least `extra` more bytes in a buffer, growing it geometrically.
+ * 
+ * @return false if the buffer couldn't grow (or an earlier write failed).
+ * 
+ * @note Not recommended to use directly.
+ */
+bool __ja_buffer_reserve(__ja_buffer *buffer, size_t extra);
+
+/**
+ * @brief Hands the contents of a buffer to the caller.
+ * 
+ * @return The bytes written, shrunk to their length, or NULL (buffer freed) if a write failed.
+ * 
+ * @param buffer Buffer to be finished.
+ * @param length Optional pointer that receives the amount of bytes.
+ * 
+ * @note Not recommended to use directly.
+ */
+unsigned char *__ja_buffer_finish(__ja_buffer *buffer, size_t *length);
+
+/**
+ * @brief Frees the block started by a ja_copy_compact() or ja_load_snapshot() root.
+ *
+ * @param root Node flagged with JA_FLAG_BLOCK_ROOT (its contents must be freed already).
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_block_free(ja_val *root);
+
+/**
+ * @brief Helper function to convert a value to number type.
+ * 
+ * @param target Value to be converted.
+ * 
+ * @note Not recommended to use directly.
+ */
+void __ja_convert_to_num(ja_val *target);
+
+/**
+ * @brief Helper function to convert a value to string type.
+ * 
+ * @param target Value to be converted.
+ * 
+ * @note Not recommended to use directly.
+ */
+void __ja_convert_to_str(ja_val *target);
+
+/**
+ * @brief Helper function to convert a value to boolean type.
+ * 
+ * @param target Value to be converted.
+ * 
+ * @note Not recommended to use directly.
+ */
+void __ja_convert_to_bool(ja_val *target);
+
+/**
+ * @brief Helper function to convert a value to array type.
+ * 
+ * @param target Value to be converted.
+ * 
+ * @note Not recommended to use directly.
+ */
+void __ja_convert_to_arr(ja_val *target);
+
+/**
+ * @brief Helper function to convert a value to array type.
+ * 
+ * @param target Value to be converted.
+ * 
+ * @note Not recommended to use directly.
+ */
+void __ja_convert_to_obj(ja_val *target);
+
+/**
+ * @brief Helper function to convert a value to null type.
+ * 
+ * @param target Value to be converted.
+ * 
+ * @note Not recommended to use directly.
+ */
+void __ja_convert_to_null(ja_val *target);
+
+/**
+ * @brief Helper function to parse a string.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse(const char *json_str, int *chars_consumed);
+
+/**
+ * @brief Helper function to parse a string to number.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_number(const char *json_str, int *chars_consumed);
+
+/**
+ * @brief Helper function to parse a string to a double, without allocating a value.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * @param number Receives the number.
+ * @return true on success, false if the number is malformed.
+ * 
+ * @note Not recommended to use directly.
+ */
+bool __ja_parse_double(const char *json_str, int *chars_consumed, double *number);
+
+/**
+ * @brief Helper function to parse a string to string.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_string(const char *json_str, int *chars_consumed);
+
+/**
+ * @brief Helper function to parse a string to boolean.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_bool(const char *json_str, int *chars_consumed);
+
+/**
+ * @brief Helper function to parse a string to array.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_array(const char *json_str, int *chars_consumed);
+
+/**
+ * @brief Helper function to parse a string to object.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_object(const char *json_str, int *chars_consumed);
+
+/**
+ * @brief Helper function to parse a string to null.
+ * 
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_null(const char *json_str, int *chars_consumed);
+
+/**
+ * @brief Skips the whitespace in a string.
+ * 
+ * @param str_ptr Pointer to the string (char**) that will be processed.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * 
+ * @note Not recommended to use directly.
+ * @note It modifies the value of the passed pointer.
+ */
+void __ja_jump_whitespaces(const char **str_ptr, int *chars_consumed);
+
+/**
+ * @brief Helper function to parse a string, splitting large arrays across threads.
+ *
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * @param thread_count Amount of threads (0 = one per CPU core).
+ *
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_parallel(const char *json_str, size_t *chars_consumed, int thread_count);
+
+/**
+ * @brief Helper function to parse an array, with its elements parsed concurrently when it is big enough.
+ *
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * @param thread_count Amount of threads (0 = one per CPU core).
+ *
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_array_parallel(const char *json_str, size_t *chars_consumed, int thread_count);
+
+/**
+ * @brief Helper function to parse an object, with its values parsed through __ja_parse_parallel().
+ *
+ * @param json_str String to be interpreted.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ * @param thread_count Amount of threads (0 = one per CPU core).
+ *
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_parse_object_parallel(const char *json_str, size_t *chars_consumed, int thread_count);
+
+/**
+ * @brief Structural pre-scan of an array, finds where each of its elements starts and ends.
+ *
+ * Only tracks strings and nesting, the elements themselves are validated when they are parsed.
+ *
+ * @return false if the array is not terminated.
+ *
+ * @param json_str String starting at the '[' of the array.
+ * @param bounds Pointer that receives an allocated array with the start and end offset of each element (2 per element).
+ * @param count Pointer that receives the amount of elements.
+ * @param length Pointer that receives the length of the array text, brackets included.
+ *
+ * @note Not recommended to use directly.
+ */
+bool __ja_scan_array(const char *json_str, size_t **bounds, size_t *count, size_t *length);
+
+/**
+ * @brief Parses a range of elements of an array pre-scanned by __ja_scan_array().
+ *
+ * @param context Pointer to the parsing job of the array.
+ * @param task_index Index of the range of elements to be parsed.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_parse_elements_task(void *context, size_t task_index);
+
+/**
+ * @brief Reads the whole contents of a file.
+ *
+ * gzip and Zstandard files (told apart by their magic bytes) are decompressed chunk by chunk
+ * straight into the returned buffer, without temporary files or a copy of the compressed data.
+ * ja_read_json() parses compressed files without this buffer.
+ *
+ * @return Allocated null-terminated buffer with the contents, or NULL on failure (with error on JA_DEBUG).
+ *
+ * @param filename Name of the file to be read.
+ * @param length Optional pointer that receives the amount of bytes read (decompressed).
+ *
+ * @note Compressed files fail with JA_ERROR_IO when the library is built without JA_ZLIB or JA_ZSTD.
+ * @note Not recommended to use directly.
+ */
+char *__ja_read_file(const char *filename, size_t *length);
+
+/**
+ * @brief Writes a buffer to a file, compressing it with gzip or Zstandard when the name ends in ".gz" or ".zst".
+ *
+ * @return true on success, false otherwise (JA_ERROR_IO).
+ *
+ * @param filename Name of the file to be written.
+ * @param data Bytes to be written, compressed in chunks as they go out.
+ * @param length Amount of bytes.
+ *
+ * @note Compressed names fail with JA_ERROR_IO when the library is built without JA_ZLIB or JA_ZSTD.
+ * @note Not recommended to use directly.
+ */
+bool __ja_write_file(const char *filename, const char *data, size_t length);
+
+/**
+ * @brief Helper for freeing a ja_val.
+ * 
+ * @param val_ptr Pointer to a ja_val (ja_val*) that will be freed.
+ * 
+ * @note This function frees the memory inside this ja_val, including its children, so be careful.
+ *       Nested arrays and objects are freed from a work list linked through their own children
+ *       buffers (the last slot holds the link), so the depth of the tree doesn't matter and nothing is allocated.
+ * @note It only frees the content inside the value, so it is not recommended to use it, unless you know what you are doing.
+ * @note This function is used internally in other functions.
+ */
+void __ja_free_val(ja_val *value);
+
+/**
+ * @brief Frees a work list of arrays and objects, along with everything they contain.
+ * 
+ * @param pending First node of the list, linked through the slot past its last child (shapes and key maps
+ *                already released).
+ * 
+ * @note Not recommended to use directly.
+ */
+void __ja_free_pending(ja_val *pending);
+
+/**
+ * @brief Counts the values passed to ja_free_val_deferred() whose free has completed.
+ * 
+ * @return Number of values freed (or released by a tree sharing them) since the program started.
+ * 
+ * @note Not recommended to use directly. Used by the tests to check that ja_wait_deferred_free() drained the queue.
+ */
+size_t __ja_deferred_freed_count(void);
+
+/**
+ * @brief Hashes a string (64-bit FNV-1a).
+ *
+ * @return Hash of the first `length` characters of the string.
+ *
+ * @param str String to be hashed.
+ * @param length Amount of characters to be hashed.
+ *
+ * @note Not recommended to use directly.
+ */
+uint64_t __ja_hash_str(const char *str, size_t length);
+
+/**
+ * @brief Function to access the header of an object key.
+ *
+ * @return Header stored right before the key characters.
+ *
+ * @param key Key of an object (allocated by __ja_key_new()).
+ *
+ * @note Not recommended to use directly.
+ */
+__ja_key *__ja_key_header(const char *key);
+
+/**
+ * @brief Allocates a new object key with a reference count of 1.
+ *
+ * @return The key characters (null-terminated), or NULL on memory allocation failure.
+ *
+ * @param key Characters of the key.
+ * @param length Amount of characters.
+ *
+ * @note Not recommended to use directly.
+ */
+char *__ja_key_new(const char *key, size_t length);
+
+/**
+ * @brief Adds a reference to an object key.
+ *
+ * @return The same key, for easier assignment.
+ *
+ * @param key Key to be shared.
+ *
+ * @note Not recommended to use directly.
+ */
+char *__ja_key_retain(char *key);
+
+/**
+ * @brief Drops a reference to an object key, freeing it with the last one.
+ *
+ * @param key Key to be released (can be NULL).
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_key_release(char *key);
+
+/**
+ * @brief Compares an object key with a string.
+ *
+ * @return true when both have the same characters. Pointer equality is checked first.
+ *
+ * @param stored Key of an object.
+ * @param key String to be compared.
+ * @param hash Hash of `key` (__ja_hash_str()).
+ * @param length Length of `key`.
+ *
+ * @note Not recommended to use directly.
+ */
+bool __ja_key_equals(const char *stored, const char *key, uint64_t hash, size_t length);
+
+/**
+ * @brief Finds a key in a table, inserting it if needed.
+ *
+ * @return The interned key with a reference owned by the caller, or NULL on memory allocation failure.
+ *
+ * @param table Table of interned keys.
+ * @param key Characters of the key.
+ * @param length Amount of characters.
+ *
+ * @note Not recommended to use directly.
+ */
+char *__ja_key_intern(ja_key_table *table, const char *key, size_t length);
+
+/**
+ * @brief Releases every key held by a table and frees its slots.
+ *
+ * @param table Table to be emptied.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_key_table_clear(ja_key_table *table);
+
+/**
+ * @brief Creates a key for an object, interned according to the current mode.
+ *
+ * Uses the global table with JA_INTERN_GLOBAL, the table of the document being parsed by
+ * the current thread if there is one, or a new key otherwise.
+ *
+ * @return Key with a reference owned by the caller, or NULL on memory allocation failure.
+ *
+ * @param key Characters of the key.
+ * @param length Amount of characters.
+ *
+ * @note Not recommended to use directly.
+ */
+char *__ja_key_make(const char *key, size_t length);
+
+/**
+ * @brief Sets the key and shape tables used by the parser on the current thread.
+ *
+ * @return The scope that was in use before, to be restored with __ja_intern_end().
+ *
+ * @param scope Tables that will receive the keys and shapes of the documents parsed.
+ *
+ * @note Not recommended to use directly.
+ */
+__ja_parse_scope *__ja_intern_begin(__ja_parse_scope *scope);
+
+/**
+ * @brief Restores the previous scope of the current thread and empties `scope`.
+ *
+ * @param scope Scope set by __ja_intern_begin().
+ * @param previous Value returned by __ja_intern_begin().
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_intern_end(__ja_parse_scope *scope, __ja_parse_scope *previous);
+
+/**
+ * @brief Returns the end of the text parsed by the current thread, as recorded in its scope.
+ *
+ * @return `end` of the current scope, or NULL outside of the parser or when the end is unknown.
+ *
+ * @note Not recommended to use directly.
+ */
+const char *__ja_parse_end(void);
+
+/**
+ * @brief Finds the position of a key in an object.
+ *
+ * @return Index of the pair, or the object size if the key is not found.
+ *
+ * @param object Object to be searched.
+ * @param key Key to be found.
+ * @param hash Hash of the key (__ja_hash_str()).
+ * @param length Length of the key.
+ *
+ * @note Not recommended to use directly.
+ */
+size_t __ja_obj_find(ja_val *object, const char *key, uint64_t hash, size_t length);
+
+/**
+ * @brief Finds the position of a key in an object, hashing the key only when needed.
+ *
+ * Shaped objects first compare the key with the slot cached by the last lookup on their shape.
+ *
+ * @return Index of the pair, or the object size if the key is not found.
+ *
+ * @param object Object to be searched.
+ * @param key Key to be found.
+ *
+ * @note Not recommended to use directly.
+ */
+size_t __ja_obj_lookup(ja_val *object, const char *key);
+
+/**
+ * @brief Function to access the key at a position of an object, shaped or not.
+ *
+ * @return The key (no bounds checking).
+ *
+ * @note Not recommended to use directly.
+ */
+char *__ja_obj_key(ja_val *object, size_t index);
+
+/**
+ * @brief Function to access the value slot at a position of an object, shaped or not.
+ *
+ * @return Address of the value pointer (no bounds checking).
+ *
+ * @note Not recommended to use directly.
+ */
+ja_val **__ja_obj_slot(ja_val *object, size_t index);
+
+/**
+ * @brief Function to access the shape of an object, kept in the word in front of its values.
+ *
+ * @return The shape, or NULL if the object isn't shaped.
+ *
+ * @note Not recommended to use directly.
+ */
+ja_shape *__ja_obj_shape_of(const ja_val *object);
+
+/**
+ * @brief Function to access the key map of an object, kept in the word in front of its pairs.
+ *
+ * @return The key map, or NULL if the object has none.
+ *
+ * @note Not recommended to use directly.
+ */
+ja_key_map *__ja_obj_key_map(const ja_val *object);
+
+/**
+ * @brief Gives a parsed object a shared shape, if the parser is interning keys.
+ *
+ * Finds a shape with the same key sequence in the current parse scope (or creates one) and
+ * replaces the pairs of the object by a plain array of values.
+ *
+ * @param object Object to be shaped. It stays unshaped if memory can't be allocated.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_obj_shape(ja_val *object);
+
+/**
+ * @brief Gives a shaped object its own pairs again, so keys can be added or removed.
+ *
+ * @return false on memory allocation failure (the object is left unchanged).
+ *
+ * @param object Object to be unshaped (objects without shape are ignored).
+ *
+ * @note Not recommended to use directly.
+ */
+bool __ja_obj_unshape(ja_val *object);
+
+/**
+ * @brief Finds a shape with the given keys in a table, creating it if needed.
+ *
+ * @return The shape with a reference owned by the caller, or NULL on memory allocation failure.
+ *
+ * @param table Table of the shapes of the document.
+ * @param pairs Pairs of the object, keys in order.
+ * @param size Amount of pairs.
+ *
+ * @note Not recommended to use directly.
+ */
+ja_shape *__ja_shape_intern(ja_shape_table *table, const ja_pair *pairs, size_t size);
+
+/**
+ * @brief Finds the slot of a key in a shape.
+ *
+ * @return Slot of the key, or the shape size if the key is not found.
+ *
+ * @param shape Shape to be searched.
+ * @param key Key to be found.
+ * @param hash Hash of the key (__ja_hash_str()).
+ * @param length Length of the key.
+ *
+ * @note Not recommended to use directly.
+ */
+size_t __ja_shape_find(ja_shape *shape, const char *key, uint64_t hash, size_t length);
+
+/**
+ * @brief Drops a reference to a shape, freeing it (and releasing its keys) with the last one.
+ *
+ * @param shape Shape to be released (can be NULL).
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_shape_release(ja_shape *shape);
+
+/**
+ * @brief Inserts or replaces a key in an object, taking ownership of both key and value.
+ *
+ * @return false on memory allocation failure, in which case the key is released and the value is left to the caller.
+ *
+ * @param object Object to be modified.
+ * @param key Key created by __ja_key_make() or __ja_key_retain().
+ * @param value Value to be set.
+ *
+ * @note Not recommended to use directly.
+ */
+bool __ja_obj_put(ja_val *object, char *key, ja_val *value);
+
+/**
+ * @brief Makes room for one more pair in an object without shape.
+ *
+ * Objects reaching JA_OBJ_MAP_MIN pairs grow geometrically and get a key map, smaller ones grow one pair at a time.
+ *
+ * @return false on memory allocation failure.
+ *
+ * @param object Object about to get a new pair (already unshaped and out of any block).
+ *
+ * @note Not recommended to use directly.
+ */
+bool __ja_obj_reserve(ja_val *object);
+
+/**
+ * @brief Takes the pair at a position out of an object, keeping the order of the others.
+ *
+ * Objects with a key map leave a tombstone in the pair, which is constant time. The tombstones are
+ * dropped at the end of the pairs right away, and everywhere once they make up half of the pairs.
+ *
+ * @return The value of the pair, whose key is handed over through `key`. NULL on memory allocation failure.
+ *
+ * @param object Object to be modified.
+ * @param index Position of the pair (no bounds checking).
+ * @param key Receives the key of the pair, owned by the caller.
+ *
+ * @note Not recommended to use directly.
+ */
+ja_val *__ja_obj_remove(ja_val *object, size_t index, char **key);
+
+/**
+ * @brief Drops the tombstones of an object with a key map, so its pairs can be walked by position.
+ *
+ * Only called by functions changing the object, readers skip the tombstones. Other values are ignored.
+ *
+ * @param object Value to be compacted.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_obj_compact(ja_val *object);
+
+/**
+ * @brief Function to find the position of the pair holding a member of an object, counting members from 0.
+ *
+ * Tombstones are skipped without changing the object, through a table of the members left that the first
+ * call after a removal builds. Several threads can call it at once.
+ *
+ * @param object Object, with more than `index` members.
+ * @param index Index of the member.
+ * @return Position of its pair (or of its value in shaped objects).
+ *
+ * @note Not recommended to use directly.
+ */
+size_t __ja_obj_position(ja_val *object, size_t index);
+
+/**
+ * @brief Indexes the keys of an object with a key map again, after its pairs were moved.
+ *
+ * @param object Object whose pairs changed positions (objects without key map are ignored).
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_obj_reindex(ja_val *object);
+
+/**
+ * @brief Skips the characters of a string that need no special handling.
+ *
+ * Uses SSE2 to look at 16 bytes at a time when available.
+ *
+ * @return First character at or after `p` that is a quote, a backslash, a control character
+ *         (including the terminating null) or a non-ASCII byte, or `end` if there is none.
+ *
+ * @param p Position inside a string.
+ * @param end End of the text, or NULL for null-terminated text (scanned one byte at a time, never past the null).
+ *
+ * @note Not recommended to use directly.
+ */
+const char *__ja_string_scan(const char *p, const char *end);
+
+/**
+ * @brief Checks a string token of the JSON text (escapes, control characters and UTF-8).
+ *
+ * @return Code of the error found, JA_ERROR_NONE if the string is valid.
+ *
+ * @param p Position of the opening quote. Moved after the closing quote, or to the offending character.
+ * @param end End of the text.
+ * @param reason Receives the description of the error.
+ *
+ * @note Not recommended to use directly.
+ */
+ja_error_code __ja_validate_string(const char **p, const char *end, const char **reason);
+
+/**
+ * @brief Checks a number token of the JSON text.
+ *
+ * @return Code of the error found, JA_ERROR_NONE if the number is valid.
+ *
+ * @param p Position of the first character. Moved after the number, or to the offending character.
+ * @param end End of the text.
+ * @param reason Receives the description of the error.
+ *
+ * @note Not recommended to use directly.
+ */
+ja_error_code __ja_validate_number(const char **p, const char *end, const char **reason);
+
+/**
+ * @brief Skips the whitespace allowed between tokens by RFC 8259 (space, tab, line feed and carriage return).
+ *
+ * @return First character that is not whitespace, or `end`.
+ *
+ * @note Not recommended to use directly.
+ */
+const char *__ja_skip_json_whitespace(const char *p, const char *end);
+
+/**
+ * @brief Reads the 4 hexadecimal digits of a \u escape.
+ *
+ * @return Value of the digits, or -1 if they are invalid or cut by the end of the text.
+ *
+ * @note Not recommended to use directly.
+ */
+long __ja_hex4(const char *p, const char *end);
+
+/**
+ * @brief Checks a multi-byte UTF-8 sequence (overlong forms, surrogates and code points above U+10FFFF are rejected).
+ *
+ * @return Length of the sequence, or 0 if it's invalid.
+ *
+ * @param p First byte of the sequence (non-ASCII).
+ * @param end End of the text.
+ *
+ * @note Not recommended to use directly.
+ */
+size_t __ja_utf8_sequence(const unsigned char *p, const unsigned char *end);
+
+/**
+ * @brief Formats a message and hands it to the log callback.
+ *
+ * @note Not recommended to use directly, use the JA_LOG_* macros.
+ */
+void __ja_log(ja_log_level level, const char *file, int line, const char *format, ...);
+
+/**
+ * @brief Records the error returned by ja_last_error() on the current thread.
+ *
+ * @param code Kind of error.
+ * @param path JSON Pointer to the value involved (can be NULL).
+ *
+ * @note Not recommended to use directly, use JA_ERROR().
+ */
+void __ja_set_last_error(ja_error_code code, const char *path);
+
+/**
+ * @brief Function to access the static description of an error code.
+ *
+ * @return Description of the code.
+ *
+ * @note Not recommended to use directly.
+ */
+const char *__ja_error_reason(ja_error_code code);
+
+/**
+ * @brief Appends a segment to a JSON Pointer, escaping '~' and '/'.
+ *
+ * @return false if the segment didn't fit (the path then ends with "/...").
+ *
+ * @param path Path to be extended (null-terminated).
+ * @param size Size of the path buffer.
+ * @param segment Key or index to be appended.
+ * @param length Length of the segment.
+ *
+ * @note Not recommended to use directly.
+ */
+bool __ja_error_path_append(char *path, size_t size, const char *segment, size_t length);
+
+/**
+ * @brief Builds the JSON Pointer to the value containing a position of JSON text.
+ *
+ * @param json_str Start of the text (valid up to `at`).
+ * @param at Position of the error.
+ * @param path Receives the path.
+ * @param size Size of the path buffer.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_error_path(const char *json_str, const char *at, char *path, size_t size);
+
+/**
+ * @brief Fills an error with its code, reason and position (offset, line, column and path).
+ *
+ * @param error Error to be filled (can be NULL).
+ * @param json_str Start of the text.
+ * @param at Offending character.
+ * @param code Kind of error.
+ * @param reason Static description.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_set_error(ja_error *error, const char *json_str, const char *at, ja_error_code code, const char *reason);
+
+/**
+ * @brief Records the error of a failed parse as the last error of the thread, with its position and path.
+ *
+ * @param json_str Text that failed to parse.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_locate_parse_error(const char *json_str);
+
+/**
+ * @brief Compacts a buffer of JSON text in place, continuing from the state left by the previous buffer.
+ *
+ * @return New length of the buffer.
+ *
+ * @param json_str Buffer to be compacted.
+ * @param length Amount of bytes of the buffer.
+ * @param state Whether the previous buffer ended inside a string (zeroed for the first buffer).
+ *
+ * @note Not recommended to use directly.
+ */
+size_t __ja_minify_buffer(char *json_str, size_t length, __ja_minify_state *state);
+
+/**
+ * @brief Measures a run of characters outside of strings, 16 bytes at a time with SSE2.
+ *
+ * @return Length of the leading run of whitespace (`whitespace` true), or of characters that are
+ *         neither whitespace nor quotes (`whitespace` false).
+ *
+ * @param p Start of the run.
+ * @param length Amount of bytes available.
+ * @param whitespace Kind of run to be measured.
+ *
+ * @note Not recommended to use directly.
+ */
+size_t __ja_minify_span(const char *p, size_t length, bool whitespace);
+
+/**
+ * @brief Finds the closing quote of a JSON string.
+ *
+ * @return Pointer to the closing quote, or NULL if the string is not terminated.
+ *
+ * @param json_str String starting at the opening quote.
+ * @param end End of the text if known, or NULL. The string is read 16 bytes at a time up to `end` and one byte at
+ *            a time after it, so `end` only needs to be at or before the null terminator.
+ *
+ * @note Not recommended to use directly.
+ */
+const char *__ja_string_end(const char *json_str, const char *end);
+
+/**
+ * @brief Helper function to parse an object key.
+ *
+ * @return The key, interned according to the current mode, or NULL on failure.
+ *
+ * @param json_str String starting at the opening quote of the key.
+ * @param chars_consumed Pointer to integer that tracks read characters.
+ *
+ * @note Not recommended to use directly.
+ */
+char *__ja_parse_key(const char *json_str, int *chars_consumed);
+
+// Task executed by __ja_parallel_for(), receives the shared context and the index of the task
+typedef void (*__ja_task_fn)(void *context, size_t task_index);
+
+/**
+ * @brief Resolves how many worker threads should be used.
+ *
+ * @return The requested amount, the amount of CPU cores when `requested` is 0, or 1 without JA_THREADS.
+ *
+ * @param requested Amount of threads asked by the user.
+ *
+ * @note Not recommended to use directly.
+ */
+int __ja_thread_count(int requested);
+
+/**
+ * @brief Runs `task` once for every index in [0, task_count), spread across worker threads.
+ *
+ * @param task_count Amount of tasks.
+ * @param thread_count Amount of threads (0 = one per CPU core), the calling thread is one of them.
+ * @param task Function to be executed for each index.
+ * @param context Pointer passed along to every task.
+ *
+ * @note Not recommended to use directly.
+ * @note Returns after all tasks are done. Without JA_THREADS the tasks run in order on the calling thread.
+ * @note The worker threads are kept for the next calls, see ja_stop_worker_threads().
+ */
+void __ja_parallel_for(size_t task_count, int thread_count, __ja_task_fn task, void *context);
+
+/**
+ * @brief Reads the next batch of lines of a NDJSON reader and parses it.
+ *
+ * @return false when there is nothing left to read or on failure.
+ *
+ * @param reader Reader to be processed.
+ * @param callback Callback for out of order delivery, NULL to keep the documents in the batch.
+ * @param user_data Pointer passed along to the callback.
+ *
+ * @note Not recommended to use directly.
+ */
+bool __ja_ndjson_load_batch(ja_ndjson_reader *reader, ja_ndjson_callback callback, void *user_data);
+
+/**
+ * @brief Parses a range of lines of the current batch of a NDJSON reader.
+ *
+ * @param context Pointer to the parsing job of the batch.
+ * @param task_index Index of the range of lines to be parsed.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_ndjson_parse_task(void *context, size_t task_index);
+
+/**
+ * @brief Records a malformed line in the reader.
+ *
+ * @param reader Reader which found the error.
+ * @param line Line that couldn't be parsed.
+ *
+ * @note Not recommended to use directly.
+ */
+void __ja_ndjson_add_error(ja_ndjson_reader *reader, const __ja_ndjson_line *line);
 
 #endif //JAJSON_H 
\ No newline at end of file
@@ -37,6 +37,23 @@ for %%F in ("%TEST_DIR%\test_*.c") do (
     echo ------------------------------------------
 )
 
+REM === SAME FILES WITH WORKER THREADS (parallel readers and parsers) ===
+for %%F in ("%TEST_DIR%\test_*.c") do (
+    echo Running test: %%~nxF ^(threads^)
+    call "%RUN_TEST%" "%%F" -DJA_THREADS -pthread
+    if !errorlevel! equ 0 (
+        set /a PASSED+=1
+    ) else (
+        set /a FAILED+=1
+        if !STOP_ON_FAIL! equ 1 (
+            echo.
+            echo Test failed. Stopping early due to STOP_ON_FAIL=1.
+            goto :summary
+        )
+    )
+    echo ------------------------------------------
+)
+
 :summary
 echo.
 echo ==========================================
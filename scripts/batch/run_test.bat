@@ -1,10 +1,10 @@
 @echo off
 setlocal enabledelayedexpansion
-REM Usage: run_test.bat <test_file_name.c>
+REM Usage: run_test.bat <test_file_name.c> [extra gcc flags...]
 
 REM === CHECKS USAGE ===
 if "%~1"=="" (
-    echo Usage: %~nx0 ^<test_file_name.c^>
+    echo Usage: %~nx0 ^<test_file_name.c^> [extra gcc flags...]
     exit /b 1
 )
 
@@ -21,12 +21,21 @@ REM === CONFIGURATION ===
 set SRC=%~1
 set BASENAME=%~n1
 set OUT=build\tests\%BASENAME%.out
+
+REM The rest are extra flags, e.g. -DJA_THREADS -pthread
+set FLAGS=
+:flags
+shift
+if not "%~1"=="" (
+    set FLAGS=!FLAGS! %1
+    goto :flags
+)
 set OK=[32m OK[0m
 set FAIL=[31m FAIL[0m
 
 REM === COMPILING ===
 echo Compiling %SRC% -^> %OUT%
-gcc -Wall -Wextra -Iinclude -Isrc src\jajson.c "%SRC%" -o "%OUT%" -lm -D__USE_MINGW_ANSI_STDIO
+gcc -Wall -Wextra -Iinclude -Isrc src\jajson.c "%SRC%" -o "%OUT%" -lm -D__USE_MINGW_ANSI_STDIO !FLAGS!
 
 REM === EXECUTING ===
 if !errorlevel! equ 0 (
@@ -35,7 +44,9 @@ if !errorlevel! equ 0 (
         echo Test batch completed successfully. %OK%
     ) else (
         echo Test batch failed. %FAIL%
+        exit /b 1
     )
 ) else (
     echo Compilation failed.
+    exit /b 1
 )
@@ -25,28 +25,93 @@ if [ ! -f "$RUN_TEST" ]; then
     exit 1
 fi
 
-# === FIND ALL test_*.c FILES ===
-for FILE in "$TEST_DIR"/test_*.c; do
-    [ -f "$FILE" ] || continue
+# === CHECKS THAT A SNIPPET BUILDS AND RUNS WITH SOME FLAGS (sanitizers, optional libraries) ===
+# Usage: probe <c source> [gcc flags...]
+probe() {
+    mkdir -p build/out
+    printf '%s\n' "$1" > build/out/probe.c
+    shift
+    gcc build/out/probe.c -o build/out/probe.out "$@" >/dev/null 2>&1 && ./build/out/probe.out >/dev/null 2>&1
+}
 
-    echo "Running test: $(basename "$FILE")"
-    "$RUN_TEST" "$FILE"
-    STATUS=$?
+# === RUNS THE test_*.c FILES WITH EXTRA FLAGS ===
+# Usage: run_build <name> <pattern> [extra gcc flags...]
+# Only the files containing <pattern> are run, all of them when it's empty.
+run_build() {
+    NAME="$1"
+    PATTERN="$2"
+    shift 2
 
-    if [ $STATUS -eq 0 ]; then
-        PASSED=$((PASSED + 1))
-    else
-        FAILED=$((FAILED + 1))
-        if [ $STOP_ON_FAIL -eq 1 ]; then
-            echo
-            echo "Test failed. Stopping early due to STOP_ON_FAIL=1."
-            break
+    echo "=== Build: $NAME ==="
+    for FILE in "$TEST_DIR"/test_*.c; do
+        [ -f "$FILE" ] || continue
+        if [ -n "$PATTERN" ] && ! grep -q "$PATTERN" "$FILE"; then
+            continue
         fi
+
+        echo "Running test: $(basename "$FILE") ($NAME)"
+        sh "$RUN_TEST" "$FILE" "$@"
+        STATUS=$?
+
+        if [ $STATUS -eq 0 ]; then
+            PASSED=$((PASSED + 1))
+        else
+            FAILED=$((FAILED + 1))
+            if [ $STOP_ON_FAIL -eq 1 ]; then
+                echo
+                echo "Test failed. Stopping early due to STOP_ON_FAIL=1."
+                return 1
+            fi
+        fi
+
+        echo "------------------------------------------"
+    done
+    return 0
+}
+
+# === BUILDS ===
+run_build "default" ""
+
+# Worker threads, so the parallel readers and parsers run instead of their single-threaded fallbacks
+if [ $FAILED -eq 0 ] || [ $STOP_ON_FAIL -eq 0 ]; then
+    if probe "#include <pthread.h>
+int main(void) { pthread_t self = pthread_self(); (void)self; return 0; }" -pthread; then
+        run_build "threads" "" -DJA_THREADS -pthread
+    else
+        echo "pthreads not available, skipping the threads build."
+        echo
+    fi
+fi
+
+# Compressed files, with the decompressors found on this system (the default build only checks that they are refused)
+if [ $FAILED -eq 0 ] || [ $STOP_ON_FAIL -eq 0 ]; then
+    COMPRESSION_FLAGS=""
+    if probe "#include <zlib.h>
+int main(void) { return zlibVersion()[0] == 0; }" -lz; then
+        COMPRESSION_FLAGS="-DJA_ZLIB -lz"
+    fi
+    if probe "#include <zstd.h>
+int main(void) { return ZSTD_versionNumber() == 0; }" -lzstd; then
+        COMPRESSION_FLAGS="$COMPRESSION_FLAGS -DJA_ZSTD -lzstd"
     fi
 
-    echo "------------------------------------------"
-done
+    if [ -n "$COMPRESSION_FLAGS" ]; then
+        run_build "compressed" "JA_ZLIB" $COMPRESSION_FLAGS # Left unquoted to pass each flag on its own
+    else
+        echo "Neither zlib nor zstd available, skipping the compressed build."
+        echo
+    fi
+fi
 
+# Worker threads under ThreadSanitizer, so concurrent readers and parsers are checked for data races
+if [ $FAILED -eq 0 ] || [ $STOP_ON_FAIL -eq 0 ]; then
+    if probe "int main(void) { return 0; }" -fsanitize=thread; then
+        run_build "threads + tsan" "" -DJA_THREADS -pthread -fsanitize=thread -g -O1
+    else
+        echo "ThreadSanitizer not available, skipping the tsan build."
+        echo
+    fi
+fi
 
 # === SUMMARY ===
 echo
@@ -1,9 +1,9 @@
 #!/bin/sh
-# Usage: run_test.sh <test_file_name.c>
+# Usage: run_test.sh <test_file_name.c> [extra gcc flags...]
 
 # === CHECKS USAGE ===
 if [ -z "$1" ]; then
-    echo "Usage: $0 <test_file_name.c>"
+    echo "Usage: $0 <test_file_name.c> [extra gcc flags...]"
     exit 1
 fi
 
@@ -18,6 +18,7 @@ fi
 
 # === CONFIGURATION ===
 SRC="$1"
+shift # The rest are extra flags, e.g. -DJA_THREADS -pthread
 BASENAME=$(basename "$SRC" .c)
 OUT="build/tests/$BASENAME.out"
 if [ -t 1 ]; then
@@ -32,7 +33,7 @@ fi
 
 # === COMPILING ===
 echo "Compiling $SRC -> $OUT"
-gcc -Wall -Wextra -Iinclude -Isrc src/jajson.c "$SRC" -o "$OUT" -lm -D__USE_MINGW_ANSI_STDIO
+gcc -Wall -Wextra -Iinclude -Isrc src/jajson.c "$SRC" -o "$OUT" -lm -D__USE_MINGW_ANSI_STDIO "$@"
 
 # === EXECUTING ===
 if [ $? -eq 0 ]; then
@@ -41,7 +42,9 @@ if [ $? -eq 0 ]; then
         printf 'Test batch completed successfully. %sOK%s\n' "$GREEN" "$RESET"
     else
         printf 'Test batch failed. %sFAIL%s\n' "$RED" "$RESET"
+        exit 1
     fi
 else
     echo "Compilation failed."
+    exit 1
 fi
@@ -1,5 +1,50 @@
 #include "jajson.h"
 
+#ifdef JA_THREADS
+    #include <pthread.h>
+    #ifdef _WIN32
+        #include <windows.h>
+    #else
+        #include <unistd.h>
+    #endif
+#endif
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+    #include <immintrin.h>
+#endif
+
+#ifdef JA_ZLIB
+    #include <zlib.h>
+#endif
+
+#ifdef JA_ZSTD
+    #include <zstd.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define JA_HAS_MMAP // Snapshots are mapped instead of read
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define JA_THREAD_LOCAL _Thread_local
+#else
+    #define JA_THREAD_LOCAL __thread
+#endif
+
+// Error of the last failed call on this thread, see ja_last_error()
+static JA_THREAD_LOCAL ja_error __ja_last_error_value;
+
+ja_log_callback __ja_log_handler = NULL;
+static void *__ja_log_user_data = NULL;
+
 ja_val *__ja_new_generic(void) {
     ja_val *jav = malloc(sizeof(ja_val));
 
@@ -8,10 +53,286 @@ ja_val *__ja_new_generic(void) {
         return NULL;
     }
 
+    jav->flags = 0;
+    jav->shares = 0;
     memset(&jav->u, 0, sizeof(jav->u));
     return jav;
 }
 
+// Type ja_new_num() gives a number, without casting numbers out of the int range
+static inline ja_type __ja_num_type(double number) {
+    return number >= INT_MIN && number <= INT_MAX && number == (double)(int)number ? JA_TYPE_INT : JA_TYPE_DOUBLE;
+}
+
+static inline bool __ja_is_packed(const ja_val *value) {
+    return value->type == JA_TYPE_ARRAY && (value->flags & (JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL));
+}
+
+// Word in front of the children of a shaped object (its shape) or of an object with a key map (the map),
+// so nodes keep two words for their contents
+typedef union __ja_children_head {
+    ja_shape *shape;
+    ja_key_map *map;
+    ja_val *slot;       // As big as the slots that follow it in the block of a compact copy
+} __ja_children_head;
+
+#define __JA_CHILDREN_HEAD(children) ((__ja_children_head *)(void *)(children) - 1)
+#define __JA_OBJ_SHAPE(node) (__JA_CHILDREN_HEAD((node)->u.object.values)->shape) // Only with JA_FLAG_SHAPED
+#define __JA_OBJ_MAP(node) (__JA_CHILDREN_HEAD((node)->u.object.pairs)->map)      // Only with JA_FLAG_KEY_MAP
+
+// Whether the children buffer of a value has a head in front of it
+static inline bool __ja_has_head(const ja_val *value) {
+    return value->type == JA_TYPE_OBJECT && (value->flags & (JA_FLAG_SHAPED | JA_FLAG_KEY_MAP));
+}
+
+// Start of the allocation holding the children of an array or object
+static inline void *__ja_children_base(const ja_val *value) {
+    return __ja_has_head(value) ? (void *)__JA_CHILDREN_HEAD(value->u.object.pairs) : (void *)value->u.object.pairs;
+}
+
+// Allocates the values of a shaped object with `shape` in front of them (the reference is the caller's), NULL on failure
+static ja_val **__ja_shaped_alloc(ja_shape *shape, size_t size) {
+    __ja_children_head *head = malloc(sizeof(__ja_children_head) + sizeof(ja_val*) * size);
+    if (!head) return NULL;
+
+    head->shape = shape;
+    return (ja_val **)(void *)(head + 1);
+}
+
+// Members of an object, without the tombstones left by removals
+static inline size_t __ja_obj_live(const ja_val *object) {
+    return object->u.object.size - ((object->flags & JA_FLAG_KEY_MAP) ? __JA_OBJ_MAP(object)->removed : 0);
+}
+
+// Whether the pair at a position of an object is a tombstone, which readers skip
+static inline bool __ja_obj_tombstone(const ja_val *object, size_t position) {
+    return !(object->flags & JA_FLAG_SHAPED) && !object->u.object.pairs[position].key;
+}
+
+// Frees the key map of an object
+static inline void __ja_key_map_free(ja_key_map *map) {
+    if (map) free(map->members);
+    free(map);
+}
+
+// Bytes of each element of a packed array
+static inline size_t __ja_packed_width(const ja_val *array) {
+    return (array->flags & JA_FLAG_PACKED_BOOL) ? sizeof(bool) : sizeof(double);
+}
+
+// Header in front of the values of a packed array, as big as max_align_t so the values stay aligned like malloc()'s
+typedef union __ja_packed_head {
+    ja_val **view;      // Nodes handed out for the elements by __ja_arr_slot(), NULL until the first one
+    max_align_t align;
+} __ja_packed_head;
+
+#define __JA_PACKED_HEAD(data) ((__ja_packed_head *)(void *)(data) - 1)
+
+// Node handed out for an element of a packed array (JA_FLAG_ELEMENT_VIEW), with the array it belongs to
+typedef struct __ja_element_view {
+    ja_val node;
+    ja_val *array;
+} __ja_element_view;
+
+// Allocates (`data` NULL) or resizes the values of a packed array, NULL on failure with `data` left as it was
+static void *__ja_packed_realloc(void *data, size_t bytes) {
+    __ja_packed_head *head = realloc(data ? __JA_PACKED_HEAD(data) : NULL, sizeof(__ja_packed_head) + bytes);
+    if (!head) return NULL;
+    if (!data) head->view = NULL;
+    return head + 1;
+}
+
+// Frees the values of a packed array of `size` elements, with the nodes handed out for them
+static void __ja_packed_free(void *data, size_t size) {
+    if (!data) return;
+
+    ja_val **view = __JA_PACKED_HEAD(data)->view;
+    if (view) {
+        for (size_t i = 0; i < size; i++) free(view[i]);
+        free(view);
+    }
+    free(__JA_PACKED_HEAD(data));
+}
+
+// Whether nodes were handed out for the elements of a packed array
+static inline bool __ja_packed_viewed(const ja_val *array) {
+    return __ja_is_packed(array) && __JA_PACKED_HEAD(array->u.array.doubles)->view;
+}
+
+// Before a packed array changes: nodes handed out for its elements must stay its elements, so it's unpacked
+static inline bool __ja_packed_settle(ja_val *array) {
+    return !__ja_packed_viewed(array) || __ja_arr_unpack(array);
+}
+
+// Whether a value is stored in a packed array of booleans (or of numbers) without changing when it's read back
+static bool __ja_packable(const ja_val *value, bool booleans) {
+    if (booleans) return value->type == JA_TYPE_BOOL;
+    if (value->type != JA_TYPE_INT && value->type != JA_TYPE_DOUBLE) return false;
+
+    double number = value->u.number.as_double;
+    return __ja_num_type(number) == value->type && (value->type != JA_TYPE_INT || value->u.number.as_int == (int)number);
+}
+
+void __ja_packed_get(const ja_val *array, size_t index, ja_val *out) {
+    out->flags = 0;
+    out->shares = 0;
+    memset(&out->u, 0, sizeof(out->u));
+
+    if (array->flags & JA_FLAG_PACKED_BOOL) {
+        out->type = JA_TYPE_BOOL;
+        out->u.boolean = array->u.array.bools[index];
+        return;
+    }
+
+    double number = array->u.array.doubles[index];
+    out->type = __ja_num_type(number);
+    out->u.number.as_int = number >= INT_MIN && number <= INT_MAX ? (int)number : 0;
+    out->u.number.as_double = number;
+}
+
+// Element of an array to be read: elements of packed arrays are filled into `scratch`
+static inline ja_val *__ja_arr_peek(ja_val *array, size_t index, ja_val *scratch) {
+    if (!__ja_is_packed(array)) return array->u.array.items[index];
+
+    __ja_packed_get(array, index, scratch);
+    return scratch;
+}
+
+bool __ja_arr_pack(ja_val *array) {
+    if (array->type != JA_TYPE_ARRAY || __ja_is_packed(array) || array->u.array.size == 0) return false;
+
+    size_t size = array->u.array.size;
+    ja_val **items = array->u.array.items;
+    bool booleans = items[0]->type == JA_TYPE_BOOL;
+    for (size_t i = 0; i < size; i++) {
+        if (!__ja_packable(items[i], booleans)) return false;
+    }
+
+    void *packed = __ja_packed_realloc(NULL, size * (booleans ? sizeof(bool) : sizeof(double)));
+    if (!packed) {
+        JA_MEM_ERROR();
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        if (booleans) ((bool *)packed)[i] = items[i]->u.boolean;
+        else ((double *)packed)[i] = items[i]->u.number.as_double;
+        ja_free_val(&items[i]);
+    }
+
+    if (!(array->flags & JA_FLAG_BLOCK_DATA)) free(items);
+    array->flags = (uint16_t)((array->flags & ~JA_FLAG_BLOCK_DATA) | (booleans ? JA_FLAG_PACKED_BOOL : JA_FLAG_PACKED));
+    array->u.array.doubles = packed; // Same word as u.array.bools
+    return true;
+}
+
+bool __ja_arr_unpack(ja_val *array) {
+    if (!__ja_is_packed(array)) return true;
+
+    size_t size = array->u.array.size;
+    ja_val **view = __JA_PACKED_HEAD(array->u.array.doubles)->view;
+    ja_val **items = size ? malloc(sizeof(ja_val*) * size) : NULL;
+    if (size && !items) {
+        JA_MEM_ERROR();
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        items[i] = view ? view[i] : NULL;
+        if (items[i]) continue; // Handed out already, it becomes the element
+
+        items[i] = __ja_new_generic();
+        if (!items[i]) {
+            while (i-- > 0) {
+                if (!view || view[i] != items[i]) free(items[i]);
+            }
+            free(items);
+            return false;
+        }
+        __ja_packed_get(array, i, items[i]);
+    }
+
+    for (size_t i = 0; view && i < size; i++) {
+        if (view[i]) view[i]->flags &= (uint16_t)~JA_FLAG_ELEMENT_VIEW;
+    }
+    free(view);
+    __JA_PACKED_HEAD(array->u.array.doubles)->view = NULL;
+
+    __ja_packed_free(array->u.array.doubles, size);
+    array->u.array.items = items;
+    array->flags &= (uint16_t)~(JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL);
+    return true;
+}
+
+ja_val **__ja_arr_slot(ja_val *array, size_t index) {
+    if (!__ja_is_packed(array)) return &array->u.array.items[index];
+
+    // Readers may get here at the same time: the view and its nodes are installed atomically, the losers free theirs
+    __ja_packed_head *head = __JA_PACKED_HEAD(array->u.array.doubles);
+    ja_val **view = __atomic_load_n(&head->view, __ATOMIC_ACQUIRE);
+    if (!view) {
+        ja_val **fresh = calloc(array->u.array.size, sizeof(ja_val*));
+        if (!fresh) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+        if (__atomic_compare_exchange_n(&head->view, &view, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            view = fresh;
+        } else {
+            free(fresh);
+        }
+    }
+
+    ja_val *node = __atomic_load_n(&view[index], __ATOMIC_ACQUIRE);
+    if (!node) {
+        __ja_element_view *element = malloc(sizeof(__ja_element_view));
+        if (!element) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+        __ja_packed_get(array, index, &element->node);
+        element->node.flags = JA_FLAG_ELEMENT_VIEW;
+        element->array = array;
+
+        ja_val *fresh = &element->node;
+        if (__atomic_compare_exchange_n(&view[index], &node, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            node = fresh;
+        } else {
+            free(element);
+        }
+    }
+
+    return &view[index];
+}
+
+// Before a node handed out for an element of a packed array changes: the array goes back to nodes, this one included
+static void __ja_element_settle(ja_val *node) {
+    if (!(node->flags & JA_FLAG_ELEMENT_VIEW)) return;
+    if (!__ja_arr_unpack(((__ja_element_view *)(void *)node)->array)) JA_PROPAGATE_ERROR("__ja_element_settle");
+}
+
+// Copies a packed array, which has no children to copy or share
+static ja_val *__ja_packed_copy(const ja_val *original) {
+    ja_val *copy = ja_new_arr();
+    if (!copy) return NULL;
+
+    size_t bytes = original->u.array.size * __ja_packed_width(original);
+    if (bytes > 0) {
+        void *data = __ja_packed_realloc(NULL, bytes);
+        if (!data) {
+            JA_MEM_ERROR();
+            free(copy);
+            return NULL;
+        }
+        memcpy(data, original->u.array.doubles, bytes);
+        copy->u.array.doubles = data;
+    }
+
+    copy->u.array.size = original->u.array.size;
+    copy->flags = original->flags & (JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL);
+    return copy;
+}
+
 ja_val *ja_new_num(double number_value) {
     ja_val* jav = __ja_new_generic();
     if (!jav) {
@@ -31,7 +352,7 @@ ja_val *ja_new_num(double number_value) {
 
 ja_val *ja_new_str(const char *string) {
     if (!string) {
-        JA_LOG_ERROR("Can't create ja_val from NULL string.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't create ja_val from NULL string.");
         return NULL;
     }
 
@@ -126,7 +447,7 @@ ja_val *ja_new_set_arr(size_t array_size, ...) {
     for (size_t i = 0; i < array_size; i++) {
         ja_val* value_arg = va_arg(array_list, ja_val*);
         if (!value_arg) {
-            JA_LOG_ERROR("Can't read ja_val at index %zu to create array.", i);
+            JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't read ja_val at index %zu to create array.", i);
             ja_free_val(&jav);
             return NULL;
         }
@@ -136,6 +457,7 @@ ja_val *ja_new_set_arr(size_t array_size, ...) {
     va_end(array_list);
     jav->u.array.size = array_size;
 
+    __ja_arr_pack(jav); // Numbers and booleans are stored in place of their nodes
     return jav;
 }
 
@@ -161,10 +483,10 @@ ja_val *ja_new_set_obj(size_t object_size, ...) {
         ja_val *value_arg = va_arg(object_list, ja_val*);
 
         if (!key_arg || !value_arg) {
-            JA_LOG_ERROR("Invalid key or value at index %zu", i);
+            JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Invalid key or value at index %zu", i);
 
             for (size_t j = 0; j < i; j++) {
-                free(jav->u.object.pairs[j].key);
+                __ja_key_release(jav->u.object.pairs[j].key);
                 ja_free_val(&(jav->u.object.pairs[j].value_ptr));
             }
             free(jav->u.object.pairs);
@@ -173,12 +495,12 @@ ja_val *ja_new_set_obj(size_t object_size, ...) {
             return NULL;
         }
 
-        jav->u.object.pairs[i].key = strdup(key_arg);
+        jav->u.object.pairs[i].key = __ja_key_make(key_arg, strlen(key_arg));
         if (!jav->u.object.pairs[i].key) {
             JA_MEM_ERROR();
 
             for (size_t j = 0; j < i; j++) {
-                free(jav->u.object.pairs[j].key);
+                __ja_key_release(jav->u.object.pairs[j].key);
                 ja_free_val(&(jav->u.object.pairs[j].value_ptr));
             }
             free(jav->u.object.pairs);
@@ -198,7 +520,7 @@ ja_val *ja_new_set_obj(size_t object_size, ...) {
 
 ja_val *ja_copy(ja_val *original) {
     if (!original) {
-        JA_LOG_ERROR("ja_copy() received NULL pointer");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_copy() received NULL pointer");
         return NULL;
     }
 
@@ -225,8 +547,24 @@ ja_val *ja_copy(ja_val *original) {
         return copy;
     }
     case JA_TYPE_ARRAY: {
+        if (__ja_is_packed(original)) {
+            copy = __ja_packed_copy(original);
+            if (!copy) break;
+
+            return copy;
+        }
+
         copy = ja_new_arr();
         if (!copy) break;
+
+        if (original->u.array.size > 0) {
+            copy->u.array.items = malloc(sizeof(ja_val*) * original->u.array.size);
+            if (!copy->u.array.items) {
+                JA_MEM_ERROR();
+                ja_free_val(&copy);
+                return NULL;
+            }
+        }
         
         for (size_t i = 0; i < original->u.array.size; i++) {
             ja_val *item_copy = ja_copy(original->u.array.items[i]);
@@ -235,7 +573,8 @@ ja_val *ja_copy(ja_val *original) {
                 JA_PROPAGATE_ERROR("ja_copy");
                 return NULL;
             }
-            ja_arr_append(copy, item_copy);
+            copy->u.array.items[i] = item_copy;
+            copy->u.array.size = i + 1;
         }
         
         return copy;
@@ -243,8 +582,43 @@ ja_val *ja_copy(ja_val *original) {
     case JA_TYPE_OBJECT: {
         copy = ja_new_obj();
         if (!copy) break;
+
+        if (original->flags & JA_FLAG_SHAPED) {
+            // Shapes are immutable too, only the values are copied
+            copy->u.object.values = __ja_shaped_alloc(__JA_OBJ_SHAPE(original), original->u.object.size);
+            if (!copy->u.object.values) {
+                JA_MEM_ERROR();
+                ja_free_val(&copy);
+                return NULL;
+            }
+            copy->flags |= JA_FLAG_SHAPED;
+            __atomic_add_fetch(&__JA_OBJ_SHAPE(copy)->refcount, 1, __ATOMIC_RELAXED);
+
+            for (size_t i = 0; i < original->u.object.size; i++) {
+                copy->u.object.values[i] = ja_copy(original->u.object.values[i]);
+                if (!copy->u.object.values[i]) {
+                    ja_free_val(&copy);
+                    JA_PROPAGATE_ERROR("ja_copy");
+                    return NULL;
+                }
+                copy->u.object.size = i + 1;
+            }
+            return copy;
+        }
+
+        size_t members = __ja_obj_live(original);
+        if (members > 0) {
+            copy->u.object.pairs = malloc(sizeof(ja_pair) * members);
+            if (!copy->u.object.pairs) {
+                JA_MEM_ERROR();
+                ja_free_val(&copy);
+                return NULL;
+            }
+        }
         
         for (size_t i = 0; i < original->u.object.size; i++) {
+            if (__ja_obj_tombstone(original, i)) continue;
+
             ja_val *inner_value_copy = ja_copy(original->u.object.pairs[i].value_ptr);
             if (!inner_value_copy) {
                 ja_free_val(&copy);
@@ -252,11 +626,11 @@ ja_val *ja_copy(ja_val *original) {
                 return NULL;
             }
             
-            ja_set_obj_at(
-                copy,
-                original->u.object.pairs[i].key, // No need to use strdup since ja_set_obj_at() already does that
-                inner_value_copy
-            );   
+            // Keys are immutable, the copy shares them with the original
+            size_t size = copy->u.object.size;
+            copy->u.object.pairs[size].key = __ja_key_retain(original->u.object.pairs[i].key);
+            copy->u.object.pairs[size].value_ptr = inner_value_copy;
+            copy->u.object.size = size + 1;
         }
         return copy;
     }
@@ -267,7 +641,7 @@ ja_val *ja_copy(ja_val *original) {
         return copy;
     }
     default:
-        JA_LOG_ERROR("Can't copy this type.");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't copy this type.");
         return NULL;
     }
     
@@ -275,9 +649,331 @@ ja_val *ja_copy(ja_val *original) {
     return NULL;
 }
 
+ja_val *ja_copy_compact(ja_val *original) {
+    if (!original) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_copy_compact() received NULL pointer");
+        return NULL;
+    }
+
+    __ja_compact_size size;
+    if (!__ja_compact_measure(original, &size)) {
+        JA_PROPAGATE_ERROR("ja_copy_compact");
+        return NULL;
+    }
+
+    void *block = malloc(__ja_compact_bytes(&size));
+    if (!block) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    return __ja_compact_write(original, &size, block);
+}
+
+bool __ja_compact_measure(ja_val *original, __ja_compact_size *size) {
+    *size = (__ja_compact_size){ 0 };
+
+    // Explicit stack of containers left to visit, so deep values don't recurse
+    size_t capacity = 64;
+    size_t count = 0;
+    ja_val **stack = malloc(sizeof(ja_val*) * capacity);
+    if (!stack) {
+        JA_MEM_ERROR();
+        return false;
+    }
+
+    stack[count++] = original;
+    size->nodes = 1;
+
+    while (count > 0) {
+        ja_val *value = stack[--count];
+
+        if (value->type == JA_TYPE_STRING) {
+            size->string_bytes += strlen(value->u.string) + 1;
+            continue;
+        }
+        if (value->type != JA_TYPE_ARRAY && value->type != JA_TYPE_OBJECT) continue;
+
+        size_t children = value->type == JA_TYPE_ARRAY ? value->u.array.size : __ja_obj_live(value);
+        if (value->type == JA_TYPE_OBJECT && !(value->flags & JA_FLAG_SHAPED)) {
+            size->pairs += children;
+        } else {
+            size->slots += children + (value->type == JA_TYPE_OBJECT); // Shaped objects keep their shape in a slot too
+        }
+        size->nodes += children;
+        if (__ja_is_packed(value)) continue; // Its elements get nodes in the copy, but have nothing to visit
+
+        if (count + children > capacity) {
+            while (count + children > capacity) capacity *= 2;
+
+            ja_val **new_stack = realloc(stack, sizeof(ja_val*) * capacity);
+            if (!new_stack) {
+                JA_MEM_ERROR();
+                free(stack);
+                return false;
+            }
+            stack = new_stack;
+        }
+
+        for (size_t i = 0; i < value->u.object.size; i++) { // Same word as u.array.size, tombstones included
+            ja_val *child = value->type == JA_TYPE_ARRAY ? value->u.array.items[i] : *__ja_obj_slot(value, i);
+            if (child) stack[count++] = child;
+        }
+    }
+
+    free(stack);
+    return true;
+}
+
+size_t __ja_compact_bytes(const __ja_compact_size *size) {
+    return size->nodes * sizeof(ja_val) + size->slots * sizeof(ja_val*) + size->pairs * sizeof(ja_pair) + size->string_bytes;
+}
+
+// Points a node of a block (or snapshot) at the child it will copy. Elements of packed arrays have no node
+// to copy, so they hold the array and their index instead
+static void __ja_compact_child(ja_val *node, const ja_val *parent, size_t index) {
+    node->flags = 0;
+    if (__ja_is_packed(parent)) {
+        node->flags = JA_FLAG_PACKED;
+        node->u.object.size = index;
+        node->u.object.source = parent;
+    } else if (parent->type == JA_TYPE_ARRAY) {
+        node->u.object.source = parent->u.array.items[index];
+    } else if (parent->flags & JA_FLAG_SHAPED) {
+        node->u.object.source = parent->u.object.values[index];
+    } else {
+        node->u.object.source = parent->u.object.pairs[index].value_ptr;
+    }
+}
+
+ja_val *__ja_compact_write(ja_val *original, const __ja_compact_size *size, void *block) {
+    ja_val *nodes = block;
+    ja_val **slots = (ja_val **)(nodes + size->nodes);
+    ja_pair *pairs = (ja_pair *)(slots + size->slots);
+    char *strings = (char *)(pairs + size->pairs);
+    size_t next_node = 1;
+
+    // Nodes are filled in breadth-first order, each one holds its original until it's reached
+    nodes[0].u.object.source = original;
+    nodes[0].flags = 0;
+
+    for (size_t i = 0; i < next_node; i++) {
+        ja_val *copy = &nodes[i];
+        const ja_val *source = copy->u.object.source;
+
+        if (copy->flags & JA_FLAG_PACKED) { // Element of a packed array: it holds the array and its index
+            __ja_packed_get(source, copy->u.object.size, copy);
+            copy->flags = JA_FLAG_IN_BLOCK;
+            continue;
+        }
+
+        copy->type = source->type;
+        copy->flags = JA_FLAG_IN_BLOCK | (i == 0 ? JA_FLAG_BLOCK_ROOT : 0);
+        copy->shares = 0;
+
+        switch (source->type) {
+        case JA_TYPE_STRING: {
+            size_t length = strlen(source->u.string) + 1;
+            memcpy(strings, source->u.string, length);
+            copy->u.string = strings;
+            copy->flags |= JA_FLAG_BLOCK_DATA;
+            strings += length;
+            break;
+        }
+        case JA_TYPE_ARRAY:
+        case JA_TYPE_OBJECT: {
+            bool shaped = source->type == JA_TYPE_OBJECT && (source->flags & JA_FLAG_SHAPED);
+            size_t children = source->type == JA_TYPE_ARRAY ? source->u.array.size : __ja_obj_live(source);
+
+            copy->u.object.pairs = NULL;
+            copy->u.object.size = children; // Same word as u.array.size
+            if (children == 0) break;
+
+            copy->flags |= JA_FLAG_BLOCK_DATA;
+            if (shaped) {
+                ((__ja_children_head *)(void *)slots++)->shape = __JA_OBJ_SHAPE(source);
+                __atomic_add_fetch(&__JA_OBJ_SHAPE(source)->refcount, 1, __ATOMIC_RELAXED);
+                copy->flags |= JA_FLAG_SHAPED;
+            }
+
+            if (source->type == JA_TYPE_ARRAY || shaped) {
+                copy->u.object.values = slots;
+                for (size_t j = 0; j < children; j++) {
+                    __ja_compact_child(&nodes[next_node], source, j);
+                    slots[j] = &nodes[next_node++];
+                }
+                slots += children;
+            } else {
+                copy->u.object.pairs = pairs;
+                for (size_t j = 0; j < source->u.object.size; j++) {
+                    if (__ja_obj_tombstone(source, j)) continue;
+                    __ja_compact_child(&nodes[next_node], source, j);
+                    pairs->key = __ja_key_retain(source->u.object.pairs[j].key);
+                    pairs->value_ptr = &nodes[next_node++];
+                    pairs++;
+                }
+            }
+            break;
+        }
+        default:
+            copy->u = source->u;
+            break;
+        }
+    }
+
+    return nodes;
+}
+
+bool __ja_block_own_data(ja_val *value) {
+    if (!(value->flags & JA_FLAG_BLOCK_DATA)) return true;
+
+    bool has_pairs = value->type == JA_TYPE_OBJECT && !(value->flags & JA_FLAG_SHAPED);
+    size_t head = __ja_has_head(value) ? sizeof(__ja_children_head) : 0; // Shaped objects take their shape along
+    size_t bytes = head + value->u.object.size * (has_pairs ? sizeof(ja_pair) : sizeof(ja_val*));
+
+    char *buffer = malloc(bytes);
+    if (!buffer) {
+        JA_MEM_ERROR();
+        return false;
+    }
+
+    memcpy(buffer, __ja_children_base(value), bytes);
+    value->u.object.pairs = (ja_pair *)(void *)(buffer + head); // Same word as u.array.items and u.object.values
+    value->flags &= ~JA_FLAG_BLOCK_DATA;
+    return true;
+}
+
+ja_val *ja_copy_cow(ja_val *original) {
+    if (!original) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_copy_cow() received NULL pointer");
+        return NULL;
+    }
+
+    ja_val *copy = __ja_copy_shallow(original);
+    if (!copy) {
+        JA_PROPAGATE_ERROR("ja_copy_cow");
+        return NULL;
+    }
+    return copy;
+}
+
+ja_val *__ja_cow_share(ja_val *value) {
+    if (value->flags & JA_FLAG_IN_BLOCK) return ja_copy(value); // The block goes away with its root
+
+    uint16_t shares = __atomic_load_n(&value->shares, __ATOMIC_RELAXED);
+
+    while (shares < UINT16_MAX) {
+        if (__atomic_compare_exchange_n(&value->shares, &shares, (uint16_t)(shares + 1), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return value;
+        }
+    }
+    return ja_copy(value); // Too many owners, this one gets its own copy
+}
+
+bool __ja_cow_release(ja_val *value) {
+    uint16_t shares = __atomic_load_n(&value->shares, __ATOMIC_ACQUIRE);
+
+    while (shares > 0) {
+        if (__atomic_compare_exchange_n(&value->shares, &shares, (uint16_t)(shares - 1), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ja_val *__ja_copy_shallow(ja_val *original) {
+    if (original->type != JA_TYPE_ARRAY && original->type != JA_TYPE_OBJECT) {
+        return ja_copy(original);
+    }
+    if (__ja_is_packed(original)) return __ja_packed_copy(original);
+
+    ja_val *copy = __ja_new_generic();
+    if (!copy) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    size_t size = original->type == JA_TYPE_ARRAY ? original->u.array.size : __ja_obj_live(original);
+    bool shaped = original->type == JA_TYPE_OBJECT && (original->flags & JA_FLAG_SHAPED);
+
+    copy->type = original->type;
+    copy->u.object.pairs = NULL;
+    copy->u.object.size = 0;
+
+    if (size > 0) {
+        // Arrays and shaped objects store value pointers, other objects store pairs
+        void *children = shaped ? (void *)__ja_shaped_alloc(__JA_OBJ_SHAPE(original), size)
+                       : malloc(original->type == JA_TYPE_OBJECT ? sizeof(ja_pair) * size : sizeof(ja_val*) * size);
+        if (!children) {
+            JA_MEM_ERROR();
+            free(copy);
+            return NULL;
+        }
+        copy->u.object.pairs = children;
+    }
+
+    if (shaped) {
+        copy->flags |= JA_FLAG_SHAPED;
+        __atomic_add_fetch(&__JA_OBJ_SHAPE(copy)->refcount, 1, __ATOMIC_RELAXED);
+    }
+
+    for (size_t i = 0; i < original->u.object.size; i++) { // Same word as u.array.size, tombstones included
+        ja_val *child = original->type == JA_TYPE_ARRAY ? original->u.array.items[i] : *__ja_obj_slot(original, i);
+        if (!child) continue;
+
+        ja_val *shared = __ja_cow_share(child);
+        if (!shared) {
+            ja_free_val(&copy);
+            JA_PROPAGATE_ERROR("__ja_copy_shallow");
+            return NULL;
+        }
+
+        size_t next = copy->u.object.size;
+        if (original->type == JA_TYPE_ARRAY || shaped) {
+            copy->u.object.values[next] = shared;
+        } else {
+            copy->u.object.pairs[next].key = __ja_key_retain(original->u.object.pairs[i].key);
+            copy->u.object.pairs[next].value_ptr = shared;
+        }
+        copy->u.object.size = next + 1;
+    }
+
+    return copy;
+}
+
+// Value in a slot of an array or object, for readers: shared children are handed out as they are
+static inline ja_val *__ja_cow_load(ja_val **slot) {
+    return __atomic_load_n(slot, __ATOMIC_ACQUIRE); // Element views of packed arrays are installed concurrently
+}
+
+// Whether a value can be modified by a caller, which shared values (and elements of shared packed arrays) can't
+static bool __ja_cow_editable(const ja_val *value, const char *caller) {
+    const ja_val *owner = (value->flags & JA_FLAG_ELEMENT_VIEW) ? ((const __ja_element_view *)(const void *)value)->array : value;
+    if (__atomic_load_n(&owner->shares, __ATOMIC_ACQUIRE) == 0) return true;
+
+    JA_ERROR(JA_ERROR_SHARED_VALUE, "%s() can't modify a value shared with other trees, reach it through ja_edit_arr_at() "
+        "or ja_edit_obj_at() from the root.", caller);
+    return false;
+}
+
+ja_val *__ja_cow_own(ja_val **slot) {
+    ja_val *value = __ja_cow_load(slot);
+    if (!value || __atomic_load_n(&value->shares, __ATOMIC_ACQUIRE) == 0) return value;
+
+    ja_val *copy = __ja_copy_shallow(value);
+    if (!copy) {
+        JA_PROPAGATE_ERROR("__ja_cow_own");
+        return NULL;
+    }
+
+    ja_free_val(slot); // Only drops this tree's share, unless the others are gone by now
+    *slot = copy;
+    return copy;
+}
+
 void ja_set_num(ja_val *target, double number_value) {
     if (!target) {
-        JA_LOG_ERROR("Can't set value on NULL ja_val.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't set value on NULL ja_val.");
         return;
     }
 
@@ -301,12 +997,12 @@ void ja_set_num(ja_val *target, double number_value) {
 
 void ja_set_str(ja_val *target, const char *string) {
     if (!target) {
-        JA_LOG_ERROR("Can't set value on NULL ja_val.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't set value on NULL ja_val.");
         return;
     }
     
     if (!string) {
-       JA_LOG_ERROR("Can't set NULL string on ja_val.");
+       JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't set NULL string on ja_val.");
         return;
     }
 
@@ -326,7 +1022,7 @@ void ja_set_str(ja_val *target, const char *string) {
 
 void ja_set_bool(ja_val *target, bool boolean_value) {
     if (!target) {
-        JA_LOG_ERROR("Can't set value on NULL ja_val.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't set value on NULL ja_val.");
         return;
     }
     
@@ -344,7 +1040,7 @@ void ja_set_bool(ja_val *target, bool boolean_value) {
 
 void ja_set_null(ja_val *target) {
     if (!target) {
-        JA_LOG_ERROR("Can't set value on NULL ja_val.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't set value on NULL ja_val.");
         return;
     }
     
@@ -360,67 +1056,74 @@ void ja_set_null(ja_val *target) {
 
 void ja_set_arr_at(ja_val *target, size_t index, ja_val *value) {
     if (!target || !value) {
-        JA_LOG_ERROR("NULL pointers passed to ja_set_arr_at().");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_set_arr_at().");
         return;
     }
     
     if (target->type != JA_TYPE_ARRAY) {
-        JA_LOG_ERROR("Can't use jaSetArrayAt() on non-array value");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use jaSetArrayAt() on non-array value");
         return;
     }
 
     if (index >= target->u.array.size) {
-        JA_LOG_ERROR("Index out of bounds (index=%zu, size=%zu).", index, target->u.array.size);
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Index out of bounds (index=%zu, size=%zu).", index, target->u.array.size);
         return;
     }
     
-    __ja_free_val(target->u.array.items[index]);
+    if (!__ja_packed_settle(target)) return;
+    if (__ja_is_packed(target)) {
+        bool booleans = target->flags & JA_FLAG_PACKED_BOOL;
+        if (__ja_packable(value, booleans)) {
+            if (booleans) target->u.array.bools[index] = value->u.boolean;
+            else target->u.array.doubles[index] = value->u.number.as_double;
+            ja_free_val(&value);
+            if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, false);
+            return;
+        }
+        if (!__ja_arr_unpack(target)) return;
+    }
+
+    ja_free_val(&target->u.array.items[index]);
     target->u.array.items[index] = value;
+    if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, false);
 }
 
 void ja_set_obj_at(ja_val *target, const char *key, ja_val *value) {
-    if (!target || !value) {
-        JA_LOG_ERROR("NULL pointers passed to ja_set_arr_at().");
+    if (!target || !key || !value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_set_obj_at().");
         return;
     }
 
     if (target->type != JA_TYPE_OBJECT) {
-        JA_LOG_ERROR("Can't use ja_set_obj_at() on non-object value");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_set_obj_at() on non-object value");
         return;
     }
 
-    for (size_t i = 0; i < target->u.object.size; i++) {
-        if (strcmp(target->u.object.pairs[i].key, key) == 0) {
-            ja_free_val(&target->u.object.pairs[i].value_ptr);
-            target->u.object.pairs[i].value_ptr = value;
-            return;
-        }
+    size_t index = __ja_obj_lookup(target, key);
+    if (index < target->u.object.size) {
+        ja_val **slot = __ja_obj_slot(target, index);
+        ja_free_val(slot);
+        *slot = value;
+        return;
     }
 
-    size_t new_size = target->u.object.size + 1;
-    
-    ja_pair *new_pairs = realloc(target->u.object.pairs, new_size * sizeof(ja_pair));
-    if (!new_pairs) {
+    char *stored_key = __ja_key_make(key, strlen(key));
+    if (!stored_key) {
         JA_MEM_ERROR();
         return;
     }
 
-    target->u.object.pairs = new_pairs;
-    
-    target->u.object.pairs[target->u.object.size].key = strdup(key);
-    target->u.object.pairs[target->u.object.size].value_ptr = value;
-
-    target->u.object.size = new_size;
+    __ja_obj_put(target, stored_key, value);
 }
 
 int ja_get_int(ja_val *origin) {
     if (!origin) {
-        JA_LOG_ERROR("Can't retrieve number from NULL pointer.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve number from NULL pointer.");
         return 0;
     }
 
     if (origin->type != JA_TYPE_DOUBLE && origin->type != JA_TYPE_INT) {
-        JA_LOG_ERROR("Can't use ja_get_int() in non-number value.");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_get_int() in non-number value.");
         return 0;
     }
 
@@ -429,12 +1132,12 @@ int ja_get_int(ja_val *origin) {
 
 double ja_get_double(ja_val *origin) {
     if (!origin) {
-        JA_LOG_ERROR("Can't retrieve number from NULL pointer.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve number from NULL pointer.");
         return 0;
     }
 
     if (origin->type != JA_TYPE_DOUBLE && origin->type != JA_TYPE_INT) {
-        JA_LOG_ERROR("Can't use ja_get_double() in non-number value.");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_get_double() in non-number value.");
         return 0;
     }
 
@@ -443,12 +1146,12 @@ double ja_get_double(ja_val *origin) {
 
 char* ja_get_str(ja_val *origin) {
     if (!origin) {
-        JA_LOG_ERROR("Can't retrieve string from NULL pointer.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve string from NULL pointer.");
         return NULL;
     }
 
     if (origin->type != JA_TYPE_STRING) {
-        JA_LOG_ERROR("Can't use ja_get_str() in non-string value.");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_get_str() in non-string value.");
         return NULL;
     }
 
@@ -457,12 +1160,12 @@ char* ja_get_str(ja_val *origin) {
 
 bool ja_get_bool(ja_val *origin) {
     if (!origin) {
-        JA_LOG_ERROR("Can't retrieve boolean from NULL pointer.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve boolean from NULL pointer.");
         return false;
     }
     
     if (origin->type != JA_TYPE_BOOL) {
-        JA_LOG_ERROR("Can't use ja_get_bool() in non-boolean value.");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_get_bool() in non-boolean value.");
         return 0;
     }
 
@@ -477,1239 +1180,9133 @@ bool ja_is_null(ja_val *origin) {
     return origin->type == JA_TYPE_NULL;
 }
 
-ja_val *ja_get_arr_at(ja_val *origin, size_t index) {
+// Slot of an element for ja_get_arr_at() and ja_edit_arr_at(), NULL with the error recorded if there's none
+static ja_val **__ja_arr_slot_at(ja_val *origin, size_t index, const char *caller) {
     if (!origin) {
-        JA_LOG_ERROR("Can't retrieve value from NULL pointer.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve value from NULL pointer.");
         return NULL;
     }
 
     if (origin->type != JA_TYPE_ARRAY) {
-        JA_LOG_ERROR("Can't use ja_get_arr_at() in non-array value");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use %s() in non-array value", caller);
         return NULL;
     }
 
     if (index >= origin->u.array.size) {
-        JA_LOG_ERROR("Index out of bounds (index=%zu, size=%zu).", index, origin->u.array.size);
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Index out of bounds (index=%zu, size=%zu).", index, origin->u.array.size);
         return NULL;
     }
 
-    return origin->u.array.items[index];
+    return __ja_arr_slot(origin, index); // Packed arrays stay packed, see __ja_arr_slot()
 }
 
-ja_val *ja_get_obj_at(ja_val *origin, const char *key) {
+// Slot of a member for ja_get_obj_at() and ja_edit_obj_at(), NULL with the error recorded if there's none
+static ja_val **__ja_obj_slot_at(ja_val *origin, const char *key, const char *caller) {
     if (!origin) {
-        JA_LOG_ERROR("Can't retrieve value from NULL pointer.");
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve value from NULL pointer.");
         return NULL;
     }
 
     if (origin->type != JA_TYPE_OBJECT) {
-        JA_LOG_ERROR("Can't use ja_get_obj_at() in non-object value.");
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use %s() in non-object value.", caller);
         return NULL;
     }
     
-    for (size_t i = 0; i < origin->u.object.size; i++) {
-        if (strcmp(origin->u.object.pairs[i].key, key) == 0) {
-            return origin->u.object.pairs[i].value_ptr;
-        }
+    size_t index = __ja_obj_lookup(origin, key);
+    if (index < origin->u.object.size) {
+        return __ja_obj_slot(origin, index);
     }
     
-    JA_LOG_ERROR("Key \"%s\" not found.", key);
+    char path[JA_ERROR_PATH_SIZE] = "";
+    __ja_error_path_append(path, sizeof(path), key, strlen(key));
+    __ja_set_last_error(JA_ERROR_KEY_NOT_FOUND, path);
+    JA_LOG_WARN("Key \"%s\" not found.", key); // Routine for optional fields, see ja_try_get_obj_at()
     return NULL;
 }
 
-void ja_arr_append(ja_val *target, ja_val *content_to_add) {
-    if (!target) {
-        JA_LOG_ERROR("ja_arr_append() called with NULL target.");
-        return;
-    }
-    
-    if (!content_to_add) {
-        JA_LOG_ERROR("ja_arr_append() called with NULL content_to_add.");
-        return;
-    }
+ja_val *ja_get_arr_at(ja_val *origin, size_t index) {
+    ja_val **slot = __ja_arr_slot_at(origin, index, "ja_get_arr_at");
+    return slot ? __ja_cow_load(slot) : NULL;
+}
 
-    if (target->type != JA_TYPE_ARRAY) {
-        JA_LOG_ERROR("Can't use ja_arr_append() on non-array value.");
-        return;
-    }
+ja_val *ja_get_obj_at(ja_val *origin, const char *key) {
+    ja_val **slot = __ja_obj_slot_at(origin, key, "ja_get_obj_at");
+    return slot ? __ja_cow_load(slot) : NULL;
+}
 
-    size_t new_size = target->u.array.size + 1;
+ja_val *ja_edit_arr_at(ja_val *origin, size_t index) {
+    ja_val **slot = __ja_arr_slot_at(origin, index, "ja_edit_arr_at");
+    return slot && __ja_cow_editable(origin, "ja_edit_arr_at") ? __ja_cow_own(slot) : NULL;
+}
 
-    ja_val **new_items = realloc(target->u.array.items, sizeof(ja_val*) * new_size);
-    if (!new_items) {
-        JA_MEM_ERROR();
-        return;
-    }
+ja_val *ja_edit_obj_at(ja_val *origin, const char *key) {
+    ja_val **slot = __ja_obj_slot_at(origin, key, "ja_edit_obj_at");
+    return slot && __ja_cow_editable(origin, "ja_edit_obj_at") ? __ja_cow_own(slot) : NULL;
+}
 
-    target->u.array.items = new_items;
-    target->u.array.items[target->u.array.size] = content_to_add;
-    target->u.array.size = new_size;
+ja_val *ja_try_get_obj_at(ja_val *origin, const char *key) {
+    if (!origin || !key || origin->type != JA_TYPE_OBJECT) return NULL;
+
+    size_t index = __ja_obj_lookup(origin, key);
+    return index < origin->u.object.size ? __ja_cow_load(__ja_obj_slot(origin, index)) : NULL;
 }
 
-void ja_arr_remove_at(ja_val *target, size_t index) {
-    if (!target) {
-        JA_LOG_ERROR("Can't use ja_arr_remove_at() on NULL pointer.");
-        return;
+bool ja_has_key(ja_val *origin, const char *key) {
+    if (!origin || !key || origin->type != JA_TYPE_OBJECT) return false;
+
+    return __ja_obj_lookup(origin, key) < origin->u.object.size;
+}
+
+// Fills a step with an unescaped token, with empty caches
+static bool __ja_path_step_init(ja_path_step *step, const char *token, size_t length) {
+    memset(step, 0, sizeof(*step));
+    step->key = __ja_key_make(token, length);
+    if (!step->key) return false;
+
+    // Array indexes are "0" or digits without leading zeros
+    step->index = JA_PATH_NO_INDEX;
+    if (length == 1 && token[0] == '-') {
+        step->index = JA_PATH_END;
+    } else if (length > 0 && (length == 1 || token[0] != '0')) {
+        size_t index = 0;
+        size_t i = 0;
+        for (; i < length && isdigit((unsigned char)token[i]); i++) {
+            if (index > (JA_PATH_END - 1 - (size_t)(token[i] - '0')) / 10) break; // Too big to be an index
+            index = index * 10 + (size_t)(token[i] - '0');
+        }
+        if (i == length) step->index = index;
     }
+    return true;
+}
 
-    if (target->type != JA_TYPE_ARRAY) {
-        JA_LOG_ERROR("Can't use ja_arr_remove_at() on non-array value.");
-        return;
+ja_path *ja_path_compile(const char *pointer) {
+    if (!pointer) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointer passed to ja_path_compile().");
+        return NULL;
     }
 
-    if (index >= target->u.array.size) {
-        JA_LOG_ERROR("Index out of bounds (index=%zu, size=%zu).", index, target->u.array.size);
-        return;
+    if (*pointer && *pointer != '/') {
+        JA_ERROR(JA_ERROR_UNEXPECTED_CHARACTER, "JSON Pointer must be empty or start with '/': %s", pointer);
+        return NULL;
     }
 
-    ja_free_val(&target->u.array.items[index]);
-    target->u.array.items[index] = NULL;
+    size_t size = 0;
+    for (const char *p = pointer; *p; p++) size += *p == '/';
 
-    if (index < target->u.array.size - 1) {
-        memmove(&target->u.array.items[index],
-                &target->u.array.items[index + 1],
-                (target->u.array.size - index - 1) * sizeof(ja_val*));
+    ja_path *path = calloc(1, sizeof(ja_path) + size * sizeof(ja_path_step));
+    char *token = malloc(strlen(pointer) + 1);
+    if (!path || !token) {
+        JA_MEM_ERROR();
+        free(path);
+        free(token);
+        return NULL;
     }
 
-    size_t new_size = target->u.array.size - 1;
+    const char *p = pointer;
+    while (*p == '/') {
+        p++;
 
-    if (new_size > 0) {
-        ja_val **new_items = realloc(target->u.array.items, sizeof(ja_val*) * new_size);
-        if (!new_items) {
-            JA_MEM_ERROR();
-            return;
+        size_t length = 0;
+        for (; *p && *p != '/'; p++) {
+            if (*p == '~') {
+                if (p[1] != '0' && p[1] != '1') {
+                    JA_ERROR(JA_ERROR_UNEXPECTED_CHARACTER, "Invalid escape in JSON Pointer: %s", pointer);
+                    __ja_last_error_value.offset = (size_t)(p - pointer);
+                    free(token);
+                    ja_path_free(&path);
+                    return NULL;
+                }
+                token[length++] = *++p == '0' ? '~' : '/';
+            } else {
+                token[length++] = *p;
+            }
         }
-        target->u.array.items = new_items;
-    } else {
-        free(target->u.array.items);
-        target->u.array.items = NULL;
+
+        if (!__ja_path_step_init(&path->steps[path->size], token, length)) {
+            free(token);
+            ja_path_free(&path);
+            return NULL;
+        }
+        path->size++;
     }
 
-    target->u.array.size = new_size;
+    free(token);
+    return path;
 }
 
-void ja_obj_remove_at(ja_val *target, const char *key) {
-    if (!target) {
-        JA_LOG_ERROR("ja_obj_remove_at() called with NULL target.");
-    }
-    
-    if (!key) {
-        JA_LOG_ERROR("ja_obj_remove_at() called with NULL key.");
-        return;
-    }
-    
-    if (target->type != JA_TYPE_OBJECT) {
-        JA_LOG_ERROR("Can't use ja_obj_remove_at() in non-object value.");
-        return;
-    }
-
-    size_t index = target->u.object.size;
-    for (size_t i = 0; i < target->u.object.size; i++) {
-        if (strcmp(target->u.object.pairs[i].key, key) == 0) {
-            free(target->u.object.pairs[i].key);
-            __ja_free_val(target->u.object.pairs[i].value_ptr);
-            index = i;
-            break;
+// Finds the slot of a step in an object, through the inline cache of the step
+static ja_val **__ja_path_obj_slot(ja_path_step *step, ja_val *object) {
+    size_t size = object->u.object.size;
+
+    if (object->flags & JA_FLAG_SHAPED) {
+        ja_shape *shape = __JA_OBJ_SHAPE(object);
+        if (shape != step->shape) {
+            const __ja_key *header = __ja_key_header(step->key);
+            size_t slot = __ja_shape_find(shape, step->key, header->hash, header->length);
+            if (slot >= size) return NULL;
+
+            // The cache keeps the shape alive, so its address can't be reused by another shape
+            __atomic_add_fetch(&shape->refcount, 1, __ATOMIC_RELAXED);
+            __ja_shape_release(step->shape);
+            step->shape = shape;
+            step->slot = slot;
         }
+        return &object->u.object.values[step->slot];
     }
 
-    if (index == target->u.object.size) {
-        JA_LOG_ERROR("Key not found: %s", key);
-        return;
-    }
-    
-    for (size_t i = index; i < target->u.object.size - 1; i++) {
-        target->u.object.pairs[i] = target->u.object.pairs[i + 1];
+    const __ja_key *header = __ja_key_header(step->key);
+    ja_pair *pairs = object->u.object.pairs;
+    if (step->position >= size || !pairs[step->position].key ||
+        !__ja_key_equals(pairs[step->position].key, step->key, header->hash, header->length)) {
+        size_t position = __ja_obj_find(object, step->key, header->hash, header->length);
+        if (position >= size) return NULL;
+        step->position = position;
     }
+    return &pairs[step->position].value_ptr;
+}
 
-    target->u.object.size--;
-
-    ja_pair *new_pairs = realloc(target->u.object.pairs, sizeof(ja_pair) * target->u.object.size);
-    if (new_pairs || target->u.object.size == 0) {  
-        target->u.object.pairs = new_pairs;
-    }
+// Finds the slot of a step in an array or object, NULL if it's missing
+static ja_val **__ja_path_slot(ja_path_step *step, ja_val *value) {
+    if (value->type == JA_TYPE_OBJECT) return __ja_path_obj_slot(step, value);
+    if (value->type == JA_TYPE_ARRAY && step->index < value->u.array.size) return __ja_arr_slot(value, step->index);
+    return NULL;
 }
 
-ja_val* ja_convert_to(ja_val *target, ja_type new_type) {
-    if (!target) {
-        JA_LOG_ERROR("NULL pointer passed to ja_convert_to().");
-        return target;
+// Records why the step after the first `count` steps of a path couldn't be followed in `value`
+static void __ja_path_error(const ja_path *path, size_t count, ja_val *value) {
+    char pointer[JA_ERROR_PATH_SIZE] = "";
+    for (size_t i = 0; i <= count && i < path->size; i++) {
+        const __ja_key *header = __ja_key_header(path->steps[i].key);
+        __ja_error_path_append(pointer, sizeof(pointer), path->steps[i].key, header->length);
     }
-    if (target->type != new_type)
-        switch (new_type) { 
-        case JA_TYPE_INT:
-        case JA_TYPE_DOUBLE:
-            __ja_convert_to_num(target);
-            break;
-        case JA_TYPE_STRING:
-            __ja_convert_to_str(target);
-            break;
-        case JA_TYPE_BOOL:
-            __ja_convert_to_bool(target);
-            break;
-        case JA_TYPE_ARRAY:
-            __ja_convert_to_arr(target);
-            break;
-        case JA_TYPE_OBJECT:
-            __ja_convert_to_obj(target);
-            break;
-        case JA_TYPE_NULL:
-            __ja_convert_to_null(target);
-            break;
-        default:
-            JA_LOG_ERROR("Invalid type conversion.");
-            break;
-        }
-    else 
-        JA_LOG_WARN("Convertion with no effect: (%s -> %s)", __ja_type_enum_to_str(target->type), __ja_type_enum_to_str(new_type));
-    return target;
-}
 
-void __ja_convert_to_num(ja_val *target) {
-    if (!target) return;
+    ja_error_code code = JA_ERROR_TYPE_MISMATCH;
+    if (value->type == JA_TYPE_OBJECT) code = JA_ERROR_KEY_NOT_FOUND;
+    if (value->type == JA_TYPE_ARRAY) code = JA_ERROR_INDEX_OUT_OF_BOUNDS;
 
-    switch (target->type) {
-    case JA_TYPE_INT: 
-    case JA_TYPE_DOUBLE: 
-        break;
+    __ja_set_last_error(code, pointer);
+    JA_LOG_ERROR("Can't follow path %s: %s", pointer, __ja_error_reason(code));
+}
 
-    case JA_TYPE_STRING: {
-        char *end_ptr;
-        double number_value = strtold(target->u.string, &end_ptr);
+ja_val *ja_path_get(ja_path *path, ja_val *root) {
+    if (!path) return NULL;
 
-        if (end_ptr == target->u.string) {
-            JA_LOG_ERROR("Invalid number string: \"%s\"", target->u.string);
-            return;
+    ja_val *current = root;
+    for (size_t i = 0; i < path->size && current; i++) {
+        ja_val **slot = __ja_path_slot(&path->steps[i], current);
+        current = slot ? __ja_cow_load(slot) : NULL;
+    }
+    return current;
+}
+
+// Follows the first `count` steps of a path, unsharing the values met so they can be modified
+static ja_val *__ja_path_walk(ja_path *path, ja_val *root, size_t count) {
+    ja_val *current = root;
+    for (size_t i = 0; i < count; i++) {
+        ja_val **slot = __ja_path_slot(&path->steps[i], current);
+        if (!slot) {
+            __ja_path_error(path, i, current);
+            return NULL;
         }
+        current = __ja_cow_own(slot);
+        if (!current) return NULL;
+    }
+    return current;
+}
 
-        while (isspace((unsigned char)*end_ptr)) end_ptr++;
+bool ja_path_set(ja_path *path, ja_val *root, ja_val *value) {
+    if (!path || !root || !value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_path_set().");
+        return false;
+    }
 
-        if (*end_ptr != '\0') {
-            JA_LOG_ERROR("Partial conversion: \"%s\" is not a pure number.", target->u.string);
-            return;
-        }
+    if (!__ja_cow_editable(root, "ja_path_set")) return false;
 
-        free(target->u.string);
+    if (path->size == 0) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "ja_path_set() can't replace the whole document.");
+        return false;
+    }
 
-        target->u.number.as_int = (int)number_value;
-        target->u.number.as_double = number_value;
+    ja_val *parent = __ja_path_walk(path, root, path->size - 1);
+    if (!parent) return false;
 
-        double diff = fabs(number_value - (double)((int)number_value));
-        target->type = (diff < 1e-9) ? JA_TYPE_INT : JA_TYPE_DOUBLE;
+    ja_path_step *step = &path->steps[path->size - 1];
+    if (parent->type == JA_TYPE_ARRAY && step->index < parent->u.array.size && !__ja_arr_unpack(parent)) return false;
 
-        break;
+    ja_val **slot = __ja_path_slot(step, parent);
+    if (slot) {
+        ja_free_val(slot);
+        *slot = value;
+        if (parent->type == JA_TYPE_ARRAY && (parent->flags & JA_FLAG_INDEXED)) __ja_index_changed(parent, false);
+        return true;
     }
 
-    case JA_TYPE_BOOL: {
-        target->u.number.as_int = target->u.boolean ? 1 : 0;
-        target->u.number.as_double = target->u.boolean ? 1.0 : 0.0;
-        target->type = JA_TYPE_INT;
-        break;
+    if (parent->type == JA_TYPE_OBJECT) {
+        return __ja_obj_put(parent, __ja_key_retain(step->key), value);
     }
 
-    case JA_TYPE_ARRAY:
-    case JA_TYPE_OBJECT: {
-        size_t temp = ja_size_of(target);
-        __ja_free_val(target);
-        target->u.number.as_int = (int) temp;
-        target->u.number.as_double = (double) temp;
-        target->type = JA_TYPE_INT;
-        break;
-    }
-    
-    case JA_TYPE_NULL: {
-        target->u.number.as_int = 0;
-        target->u.number.as_double = 0.0;
-        target->type = JA_TYPE_INT;
-        break;
+    if (parent->type == JA_TYPE_ARRAY && (step->index == JA_PATH_END || step->index == parent->u.array.size)) {
+        size_t size = parent->u.array.size;
+        ja_arr_append(parent, value);
+        return parent->u.array.size > size;
     }
 
-    default: {
-        JA_LOG_ERROR("Invalid type for conversion to number.");
-        break;
-    }
-    }
+    __ja_path_error(path, path->size - 1, parent);
+    return false;
 }
 
-void __ja_convert_to_str(ja_val *target) {
-    if (!target) return;
+void ja_path_free(ja_path **path) {
+    if (!path || !*path) return;
 
-    ja_val temp = *target;
-    char* str = NULL;
+    for (size_t i = 0; i < (*path)->size; i++) {
+        __ja_key_release((*path)->steps[i].key);
+        __ja_shape_release((*path)->steps[i].shape);
+    }
+    free(*path);
+    *path = NULL;
+}
 
-    switch (temp.type) {
-    case JA_TYPE_INT:
-    case JA_TYPE_DOUBLE:
-        str = ja_stringify(&temp);
-        break;
-    case JA_TYPE_BOOL:
-        str = strdup(temp.u.boolean ? "true" : "false");
-        break;
-    case JA_TYPE_ARRAY:
-    case JA_TYPE_OBJECT:
-        str = ja_stringify(&temp);
-        break;
-    case JA_TYPE_NULL:
-        str = strdup("null");
-        break;
-    case JA_TYPE_STRING:
-        return;
-    default:
-        JA_LOG_ERROR("Invalid type for conversion to string.");
-        return;
+// Parser state of ja_query_compile()
+typedef struct __ja_query_parser {
+    const char *expression;
+    const char *p;
+} __ja_query_parser;
+
+// Records a syntax error at the current position of the parser
+static void __ja_query_syntax_error(__ja_query_parser *parser) {
+    size_t offset = (size_t)(parser->p - parser->expression);
+    if (*parser->p) {
+        JA_ERROR(JA_ERROR_UNEXPECTED_CHARACTER, "Unexpected '%c' at offset %zu of JSONPath: %s", *parser->p, offset, parser->expression);
+    } else {
+        JA_ERROR(JA_ERROR_UNEXPECTED_END, "Unexpected end of JSONPath: %s", parser->expression);
     }
+    __ja_last_error_value.offset = offset;
+}
 
-    if (!str) return;
+static void __ja_query_skip_spaces(__ja_query_parser *parser) {
+    while (isspace((unsigned char)*parser->p)) parser->p++;
+}
 
-    if (target->type == JA_TYPE_STRING && target->u.string)
-        free(target->u.string);
+// Consumes `c` (after spaces), recording an error if it isn't there
+static bool __ja_query_expect(__ja_query_parser *parser, char c) {
+    __ja_query_skip_spaces(parser);
+    if (*parser->p != c) {
+        __ja_query_syntax_error(parser);
+        return false;
+    }
+    parser->p++;
+    return true;
+}
 
-    target->u.string = str;
-    target->type = JA_TYPE_STRING;
+// Characters of names written after a dot
+static bool __ja_query_name_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '-' || (unsigned char)c >= 0x80;
 }
 
-void __ja_convert_to_bool(ja_val *target) {
-    if (!target) return;
+// Reads a name written after a dot
+static void __ja_query_name(__ja_query_parser *parser, const char **start, size_t *length) {
+    *start = parser->p;
+    while (__ja_query_name_char(*parser->p)) parser->p++;
+    *length = (size_t)(parser->p - *start);
+}
 
-    switch (target->type) {
-    case JA_TYPE_INT:
-    case JA_TYPE_DOUBLE: {
-        target->u.boolean = target->u.number.as_int != 0;
-        target->type = JA_TYPE_BOOL;
-        break;
+// Reads a quoted string into a new buffer (freed by the caller), decoding its escapes.
+// Unicode escapes aren't supported and are rejected like any unknown escape.
+static char *__ja_query_quoted(__ja_query_parser *parser, size_t *length) {
+    char quote = *parser->p;
+    const char *end = parser->p + 1;
+    while (*end && *end != quote) {
+        if (*end == '\\' && end[1]) end++;
+        end++;
+    }
+    if (!*end) {
+        parser->p = end;
+        __ja_query_syntax_error(parser);
+        return NULL;
     }
 
-    case JA_TYPE_STRING: {
-        bool temp = (bool)strlen(target->u.string) > 0;
-        __ja_free_val(target);
-        target->u.boolean = temp;
-        target->type = JA_TYPE_BOOL;
-        break;
+    char *text = malloc((size_t)(end - parser->p));
+    if (!text) {
+        JA_MEM_ERROR();
+        return NULL;
     }
 
-    case JA_TYPE_BOOL:
-        break;
+    size_t size = 0;
+    for (const char *p = parser->p + 1; p < end; p++) {
+        if (*p != '\\') {
+            text[size++] = *p;
+            continue;
+        }
 
-    case JA_TYPE_ARRAY:
-    case JA_TYPE_OBJECT: {
-        target->u.boolean = target->u.array.size > 0 || target->u.object.size > 0;
-        target->type = JA_TYPE_BOOL;
-        __ja_free_val(target);
-        break;
+        p++;
+        switch (*p) {
+        case '\'': case '"': case '\\': case '/': text[size++] = *p; break;
+        case 'b': text[size++] = '\b'; break;
+        case 'f': text[size++] = '\f'; break;
+        case 'n': text[size++] = '\n'; break;
+        case 'r': text[size++] = '\r'; break;
+        case 't': text[size++] = '\t'; break;
+        default:
+            parser->p = p;
+            __ja_query_syntax_error(parser);
+            free(text);
+            return NULL;
+        }
     }
+    text[size] = '\0';
 
-    case JA_TYPE_NULL: {
-        target->u.boolean = false;
-        target->type = JA_TYPE_BOOL;
-        break;
-    }
+    *length = size;
+    parser->p = end + 1;
+    return text;
+}
 
-    default:
-        JA_LOG_ERROR("Invalid type for conversion to boolean.");
-        break;
+// Reads an optionally negative integer, false (without error) if there isn't one
+static bool __ja_query_int(__ja_query_parser *parser, int64_t *value) {
+    const char *p = parser->p;
+    bool negative = *p == '-';
+    if (negative) p++;
+    if (!isdigit((unsigned char)*p)) return false;
+
+    int64_t magnitude = 0;
+    for (; isdigit((unsigned char)*p); p++) {
+        if (magnitude < INT64_MAX / 10) magnitude = magnitude * 10 + (*p - '0'); // Saturates far past any size
     }
+    *value = negative ? -magnitude : magnitude;
+    parser->p = p;
+    return true;
 }
 
-void __ja_convert_to_arr(ja_val *target) {
-    if (!target) return;
+// Reads a relative path (@.name, @['name'], @[0]...) as a JSON Pointer
+static ja_path *__ja_query_field(__ja_query_parser *parser) {
+    parser->p++; // '@'
 
-    switch (target->type) {
+    ja_path *path = calloc(1, sizeof(ja_path));
+    if (!path) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    char *name = NULL; // The last quoted name, decoded
+    for (;;) {
+        const char *token = NULL;
+        size_t length = 0;
+
+        if (*parser->p == '.' && __ja_query_name_char(parser->p[1])) {
+            parser->p++;
+            __ja_query_name(parser, &token, &length);
+        } else if (*parser->p == '[') {
+            parser->p++;
+            __ja_query_skip_spaces(parser);
+            if (*parser->p == '\'' || *parser->p == '"') {
+                if (!(name = __ja_query_quoted(parser, &length))) break;
+                token = name;
+            } else if (isdigit((unsigned char)*parser->p)) {
+                token = parser->p;
+                while (isdigit((unsigned char)*parser->p)) parser->p++;
+                length = (size_t)(parser->p - token);
+            } else {
+                __ja_query_syntax_error(parser);
+                break;
+            }
+            if (!__ja_query_expect(parser, ']')) break;
+        } else {
+            return path;
+        }
+
+        ja_path *grown = realloc(path, sizeof(ja_path) + (path->size + 1) * sizeof(ja_path_step));
+        if (!grown) {
+            JA_MEM_ERROR();
+            break;
+        }
+        path = grown;
+        if (!__ja_path_step_init(&path->steps[path->size], token, length)) break;
+        path->size++;
+        free(name);
+        name = NULL;
+    }
+
+    free(name);
+    ja_path_free(&path);
+    return NULL;
+}
+
+// Reads a constant: number, quoted string, true, false or null
+static ja_val *__ja_query_literal(__ja_query_parser *parser) {
+    const char *p = parser->p;
+
+    if (*p == '\'' || *p == '"') {
+        size_t length = 0;
+        char *string = __ja_query_quoted(parser, &length);
+        if (!string) return NULL;
+
+        ja_val *value = __ja_new_generic();
+        if (!value) {
+            free(string);
+            return NULL;
+        }
+        value->type = JA_TYPE_STRING;
+        value->u.string = string;
+        return value;
+    }
+
+    if (*p == '-' || isdigit((unsigned char)*p)) {
+        char *end = NULL;
+        double number = strtod(p, &end);
+        if (end != p) {
+            parser->p = end;
+            return ja_new_num(number);
+        }
+    }
+
+    static const char *const words[] = {"true", "false", "null"};
+    for (int i = 0; i < 3; i++) {
+        size_t length = strlen(words[i]);
+        if (strncmp(p, words[i], length) == 0 && !__ja_query_name_char(p[length])) {
+            parser->p += length;
+            return i == 2 ? ja_new_null() : ja_new_bool(i == 0);
+        }
+    }
+
+    __ja_query_syntax_error(parser);
+    return NULL;
+}
+
+static bool __ja_query_operand_parse(__ja_query_parser *parser, __ja_query_operand *operand) {
+    __ja_query_skip_spaces(parser);
+    if (*parser->p == '@') {
+        operand->field = __ja_query_field(parser);
+        return operand->field != NULL;
+    }
+    operand->literal = __ja_query_literal(parser);
+    return operand->literal != NULL;
+}
+
+static void __ja_query_expr_free(__ja_query_expr *expr) {
+    if (!expr) return;
+
+    __ja_query_expr_free(expr->left);
+    __ja_query_expr_free(expr->right);
+    ja_path_free(&expr->a.field);
+    ja_path_free(&expr->b.field);
+    ja_free_val(&expr->a.literal);
+    ja_free_val(&expr->b.literal);
+    free(expr);
+}
+
+static __ja_query_expr *__ja_query_expr_new(__ja_query_expr_kind kind) {
+    __ja_query_expr *expr = calloc(1, sizeof(__ja_query_expr));
+    if (!expr) JA_MEM_ERROR();
+    else expr->kind = kind;
+    return expr;
+}
+
+static __ja_query_expr *__ja_query_or(__ja_query_parser *parser);
+
+// Reads `!expression`, `(expression)`, `@.field` or `operand op operand`
+static __ja_query_expr *__ja_query_unary(__ja_query_parser *parser) {
+    __ja_query_skip_spaces(parser);
+
+    if (*parser->p == '!' && parser->p[1] != '=') {
+        parser->p++;
+        __ja_query_expr *operand = __ja_query_unary(parser);
+        __ja_query_expr *expr = operand ? __ja_query_expr_new(__JA_QUERY_NOT) : NULL;
+        if (!expr) {
+            __ja_query_expr_free(operand);
+            return NULL;
+        }
+        expr->left = operand;
+        return expr;
+    }
+
+    if (*parser->p == '(') {
+        parser->p++;
+        __ja_query_expr *expr = __ja_query_or(parser);
+        if (expr && !__ja_query_expect(parser, ')')) {
+            __ja_query_expr_free(expr);
+            return NULL;
+        }
+        return expr;
+    }
+
+    __ja_query_expr *expr = __ja_query_expr_new(__JA_QUERY_EXISTS);
+    if (!expr) return NULL;
+    if (!__ja_query_operand_parse(parser, &expr->a)) {
+        __ja_query_expr_free(expr);
+        return NULL;
+    }
+
+    static const struct { const char *text; __ja_query_expr_kind kind; } operators[] = {
+        {"==", __JA_QUERY_EQUAL}, {"!=", __JA_QUERY_NOT_EQUAL}, {"<=", __JA_QUERY_LESS_EQUAL},
+        {">=", __JA_QUERY_GREATER_EQUAL}, {"<", __JA_QUERY_LESS}, {">", __JA_QUERY_GREATER}
+    };
+
+    __ja_query_skip_spaces(parser);
+    for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
+        size_t length = strlen(operators[i].text);
+        if (strncmp(parser->p, operators[i].text, length) == 0) {
+            parser->p += length;
+            expr->kind = operators[i].kind;
+            if (!__ja_query_operand_parse(parser, &expr->b)) {
+                __ja_query_expr_free(expr);
+                return NULL;
+            }
+            return expr;
+        }
+    }
+
+    // Alone, an operand is an existence test, which only makes sense for fields
+    if (!expr->a.field) {
+        __ja_query_syntax_error(parser);
+        __ja_query_expr_free(expr);
+        return NULL;
+    }
+    return expr;
+}
+
+// Reads operands joined by `&&` (`and` = true) or `||`
+static __ja_query_expr *__ja_query_binary(__ja_query_parser *parser, bool and) {
+    __ja_query_expr *expr = and ? __ja_query_unary(parser) : __ja_query_binary(parser, true);
+    const char *operator = and ? "&&" : "||";
+
+    while (expr) {
+        __ja_query_skip_spaces(parser);
+        if (strncmp(parser->p, operator, 2) != 0) break;
+        parser->p += 2;
+
+        __ja_query_expr *right = and ? __ja_query_unary(parser) : __ja_query_binary(parser, true);
+        __ja_query_expr *joined = right ? __ja_query_expr_new(and ? __JA_QUERY_AND : __JA_QUERY_OR) : NULL;
+        if (!joined) {
+            __ja_query_expr_free(right);
+            __ja_query_expr_free(expr);
+            return NULL;
+        }
+        joined->left = expr;
+        joined->right = right;
+        expr = joined;
+    }
+    return expr;
+}
+
+static __ja_query_expr *__ja_query_or(__ja_query_parser *parser) {
+    return __ja_query_binary(parser, false);
+}
+
+// Reads the contents of [...], after the '['
+static bool __ja_query_bracket(__ja_query_parser *parser, __ja_query_segment *segment) {
+    __ja_query_skip_spaces(parser);
+    char c = *parser->p;
+
+    if (c == '*') {
+        parser->p++;
+        segment->kind = __JA_QUERY_WILDCARD;
+    } else if (c == '\'' || c == '"') {
+        size_t length = 0;
+        char *name = __ja_query_quoted(parser, &length);
+        if (!name) return false;
+        segment->kind = __JA_QUERY_NAME;
+        bool initialized = __ja_path_step_init(&segment->step, name, length);
+        free(name);
+        if (!initialized) return false;
+    } else if (c == '?') {
+        parser->p++;
+        segment->kind = __JA_QUERY_FILTER;
+        segment->filter = __ja_query_or(parser);
+        if (!segment->filter) return false;
+    } else {
+        segment->has_start = __ja_query_int(parser, &segment->start);
+        __ja_query_skip_spaces(parser);
+
+        if (*parser->p == ':') {
+            parser->p++;
+            segment->kind = __JA_QUERY_SLICE;
+            __ja_query_skip_spaces(parser);
+            segment->has_end = __ja_query_int(parser, &segment->end);
+            __ja_query_skip_spaces(parser);
+            segment->stride = 1;
+            if (*parser->p == ':') {
+                parser->p++;
+                __ja_query_skip_spaces(parser);
+                __ja_query_int(parser, &segment->stride);
+            }
+        } else if (segment->has_start) {
+            segment->kind = __JA_QUERY_INDEX;
+        } else {
+            __ja_query_syntax_error(parser);
+            return false;
+        }
+    }
+
+    return __ja_query_expect(parser, ']');
+}
+
+// Reads the segment at the current position
+static bool __ja_query_segment_parse(__ja_query_parser *parser, __ja_query_segment *segment) {
+    const char *p = parser->p;
+
+    if (p[0] == '.' && p[1] == '.') {
+        segment->descendant = true;
+        parser->p += 2;
+        if (*parser->p == '[') {
+            parser->p++;
+            return __ja_query_bracket(parser, segment);
+        }
+    } else if (*p == '.') {
+        parser->p++;
+    } else if (*p == '[') {
+        parser->p++;
+        return __ja_query_bracket(parser, segment);
+    } else {
+        __ja_query_syntax_error(parser);
+        return false;
+    }
+
+    if (*parser->p == '*') {
+        parser->p++;
+        segment->kind = __JA_QUERY_WILDCARD;
+        return true;
+    }
+
+    const char *name = NULL;
+    size_t length = 0;
+    __ja_query_name(parser, &name, &length);
+    if (length == 0) {
+        __ja_query_syntax_error(parser);
+        return false;
+    }
+    segment->kind = __JA_QUERY_NAME;
+    return __ja_path_step_init(&segment->step, name, length);
+}
+
+ja_query *ja_query_compile(const char *expression) {
+    if (!expression) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL expression passed to ja_query_compile().");
+        return NULL;
+    }
+
+    ja_query *query = calloc(1, sizeof(ja_query));
+    if (!query) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    __ja_query_parser parser = {expression, expression};
+    __ja_query_skip_spaces(&parser);
+    if (*parser.p != '$') {
+        __ja_query_syntax_error(&parser);
+        ja_query_free(&query);
+        return NULL;
+    }
+    parser.p++;
+
+    size_t capacity = 0;
+    for (;;) {
+        __ja_query_skip_spaces(&parser);
+        if (!*parser.p) return query;
+
+        if (query->size == capacity) {
+            capacity = capacity ? capacity * 2 : 4;
+            __ja_query_segment *segments = realloc(query->segments, capacity * sizeof(__ja_query_segment));
+            if (!segments) {
+                JA_MEM_ERROR();
+                break;
+            }
+            query->segments = segments;
+        }
+
+        // Counted before parsing, so ja_query_free() releases what a failed segment holds
+        __ja_query_segment *segment = &query->segments[query->size++];
+        memset(segment, 0, sizeof(*segment));
+        if (!__ja_query_segment_parse(&parser, segment)) break;
+    }
+
+    ja_query_free(&query);
+    return NULL;
+}
+
+// Nodes are collected as pointers in a byte buffer
+static inline bool __ja_query_push(__ja_buffer *nodes, ja_val *value) {
+    return __ja_buffer_put(nodes, &value, sizeof(value));
+}
+
+static inline ja_val **__ja_query_nodes(const __ja_buffer *nodes) {
+    return (ja_val **)(void *)nodes->data;
+}
+
+static inline size_t __ja_query_count(const __ja_buffer *nodes) {
+    return nodes->length / sizeof(ja_val *);
+}
+
+// Finds a member of an object: through the inline cache of the step, or without touching it (`cache` = false)
+static ja_val **__ja_path_member(ja_path_step *step, ja_val *object, bool cache) {
+    if (cache) return __ja_path_obj_slot(step, object);
+
+    const __ja_key *header = __ja_key_header(step->key);
+    size_t index = __ja_obj_find(object, step->key, header->hash, header->length);
+    return index < object->u.object.size ? __ja_obj_slot(object, index) : NULL;
+}
+
+// Follows a field of a filter from a node, without unsharing anything. NULL if it's missing.
+// An element of a packed array is filled into `scratch`
+static ja_val *__ja_path_read(ja_path *field, ja_val *node, bool cache, ja_val *scratch) {
+    for (size_t i = 0; i < field->size && node; i++) {
+        ja_path_step *step = &field->steps[i];
+        if (node->type == JA_TYPE_OBJECT) {
+            ja_val **slot = __ja_path_member(step, node, cache);
+            node = slot ? *slot : NULL;
+        } else if (node->type == JA_TYPE_ARRAY && step->index < node->u.array.size) {
+            node = __ja_arr_peek(node, step->index, scratch);
+        } else {
+            node = NULL;
+        }
+    }
+    return node;
+}
+
+static inline bool __ja_query_is_number(const ja_val *value) {
+    return value->type == JA_TYPE_INT || value->type == JA_TYPE_DOUBLE;
+}
+
+static inline double __ja_query_number(const ja_val *value) {
+    return value->type == JA_TYPE_INT ? (double)value->u.number.as_int : value->u.number.as_double;
+}
+
+// Missing fields are only equal to each other, containers only to themselves
+static bool __ja_query_equal(const ja_val *a, const ja_val *b) {
+    if (!a || !b) return a == b;
+
+    if (__ja_query_is_number(a) || __ja_query_is_number(b)) {
+        return __ja_query_is_number(a) && __ja_query_is_number(b) && __ja_query_number(a) == __ja_query_number(b);
+    }
+    if (a->type != b->type) return false;
+
+    switch (a->type) {
+        case JA_TYPE_STRING:
+            return strcmp(a->u.string ? a->u.string : "", b->u.string ? b->u.string : "") == 0;
+        case JA_TYPE_BOOL:
+            return a->u.boolean == b->u.boolean;
+        case JA_TYPE_NULL:
+            return true;
+        default:
+            return a == b;
+    }
+}
+
+// Only numbers and strings are ordered
+static bool __ja_query_less(const ja_val *a, const ja_val *b) {
+    if (!a || !b) return false;
+
+    if (__ja_query_is_number(a) && __ja_query_is_number(b)) return __ja_query_number(a) < __ja_query_number(b);
+    if (a->type == JA_TYPE_STRING && b->type == JA_TYPE_STRING) {
+        return strcmp(a->u.string ? a->u.string : "", b->u.string ? b->u.string : "") < 0;
+    }
+    return false;
+}
+
+static bool __ja_query_test(__ja_query_expr *expr, ja_val *node, bool cache) {
+    switch (expr->kind) {
+        case __JA_QUERY_AND:
+            return __ja_query_test(expr->left, node, cache) && __ja_query_test(expr->right, node, cache);
+        case __JA_QUERY_OR:
+            return __ja_query_test(expr->left, node, cache) || __ja_query_test(expr->right, node, cache);
+        case __JA_QUERY_NOT:
+            return !__ja_query_test(expr->left, node, cache);
+        case __JA_QUERY_EXISTS:
+        {
+            ja_val scratch;
+            return __ja_path_read(expr->a.field, node, cache, &scratch) != NULL;
+        }
+        default:
+            break;
+    }
+
+    ja_val a_scratch, b_scratch;
+    ja_val *a = expr->a.field ? __ja_path_read(expr->a.field, node, cache, &a_scratch) : expr->a.literal;
+    ja_val *b = expr->b.field ? __ja_path_read(expr->b.field, node, cache, &b_scratch) : expr->b.literal;
+
+    switch (expr->kind) {
+        case __JA_QUERY_EQUAL:          return __ja_query_equal(a, b);
+        case __JA_QUERY_NOT_EQUAL:      return !__ja_query_equal(a, b);
+        case __JA_QUERY_LESS:           return __ja_query_less(a, b);
+        case __JA_QUERY_LESS_EQUAL:     return __ja_query_less(a, b) || __ja_query_equal(a, b);
+        case __JA_QUERY_GREATER:        return __ja_query_less(b, a);
+        case __JA_QUERY_GREATER_EQUAL:  return __ja_query_less(b, a) || __ja_query_equal(a, b);
+        default:                        return false;
+    }
+}
+
+// Slot of the child at `index` of an array or object
+static inline ja_val **__ja_query_child(ja_val *node, size_t index) {
+    return node->type == JA_TYPE_ARRAY ? __ja_arr_slot(node, index) : __ja_obj_slot(node, index);
+}
+
+static inline bool __ja_query_push_slot(__ja_buffer *out, ja_val **slot) {
+    ja_val *value = slot ? __ja_cow_load(slot) : NULL;
+    return value && __ja_query_push(out, value);
+}
+
+static inline int64_t __ja_query_clamp(int64_t value, int64_t low, int64_t high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+// Appends the children of a node selected by a segment (RFC 9535 semantics for indexes and slices)
+static bool __ja_query_select(__ja_query_segment *segment, ja_val *node, __ja_buffer *out, bool cache) {
+    bool array = node->type == JA_TYPE_ARRAY;
+    if (!array && node->type != JA_TYPE_OBJECT) return true;
+
+    size_t size = array ? node->u.array.size : node->u.object.size; // Tombstones of objects are skipped
+    int64_t length = (int64_t)size;
+
+    switch (segment->kind) {
+        case __JA_QUERY_NAME: {
+            if (array) return true;
+            ja_val **slot = __ja_path_member(&segment->step, node, cache);
+            return !slot || __ja_query_push_slot(out, slot);
+        }
+
+        case __JA_QUERY_WILDCARD:
+            for (size_t i = 0; i < size; i++) {
+                if (!array && __ja_obj_tombstone(node, i)) continue;
+                if (!__ja_query_push_slot(out, __ja_query_child(node, i))) return false;
+            }
+            return true;
+
+        case __JA_QUERY_INDEX: {
+            if (!array) return true;
+            int64_t index = segment->start < 0 ? segment->start + length : segment->start;
+            return index < 0 || index >= length || __ja_query_push_slot(out, __ja_arr_slot(node, (size_t)index));
+        }
+
+        case __JA_QUERY_SLICE: {
+            int64_t stride = segment->stride;
+            if (!array || stride == 0) return true;
+
+            int64_t start = segment->start < 0 ? segment->start + length : segment->start;
+            int64_t end = segment->end < 0 ? segment->end + length : segment->end;
+            if (stride > 0) {
+                int64_t lower = segment->has_start ? __ja_query_clamp(start, 0, length) : 0;
+                int64_t upper = segment->has_end ? __ja_query_clamp(end, 0, length) : length;
+                for (int64_t i = lower; i < upper; i += stride) {
+                    if (!__ja_query_push_slot(out, __ja_arr_slot(node, (size_t)i))) return false;
+                }
+            } else {
+                int64_t upper = segment->has_start ? __ja_query_clamp(start, -1, length - 1) : length - 1;
+                int64_t lower = segment->has_end ? __ja_query_clamp(end, -1, length - 1) : -1;
+                for (int64_t i = upper; i > lower; i += stride) {
+                    if (!__ja_query_push_slot(out, __ja_arr_slot(node, (size_t)i))) return false;
+                }
+            }
+            return true;
+        }
+
+        case __JA_QUERY_FILTER:
+            for (size_t i = 0; i < size; i++) {
+                if (!array && __ja_obj_tombstone(node, i)) continue;
+                ja_val **slot = __ja_query_child(node, i);
+                if (!slot) return false;
+                if (__ja_query_test(segment->filter, *slot, cache) && !__ja_query_push_slot(out, slot)) return false;
+            }
+            return true;
+    }
+    return true;
+}
+
+// Applies a ".." segment to a node and all its descendants, in document order
+static bool __ja_query_descend(__ja_query_segment *segment, ja_val *node, __ja_buffer *out, bool cache) {
+    __ja_buffer stack = {0};
+    bool ok = __ja_query_push(&stack, node);
+
+    while (ok && stack.length > 0) {
+        stack.length -= sizeof(ja_val *);
+        ja_val *current = __ja_query_nodes(&stack)[__ja_query_count(&stack)];
+        ok = __ja_query_select(segment, current, out, cache);
+        if (!ok || (current->type != JA_TYPE_ARRAY && current->type != JA_TYPE_OBJECT) || __ja_is_packed(current)) continue;
+
+        size_t size = current->type == JA_TYPE_ARRAY ? current->u.array.size : current->u.object.size;
+        for (size_t i = size; i-- > 0 && ok;) {
+            if (current->type == JA_TYPE_OBJECT && __ja_obj_tombstone(current, i)) continue;
+            ja_val *child = __ja_cow_load(__ja_query_child(current, i));
+            ok = child && __ja_query_push(&stack, child);
+        }
+    }
+
+    free(stack.data);
+    return ok;
+}
+
+// Evaluates the segments from `first` over some nodes (kept only if they pass `filter`, when given)
+static bool __ja_query_run(ja_query *query, size_t first, __ja_query_expr *filter, ja_val **nodes, size_t count,
+                           __ja_buffer *out, bool cache) {
+    __ja_buffer current = {0};
+    __ja_buffer next = {0};
+    bool ok = true;
+
+    for (size_t i = 0; i < count && ok; i++) {
+        if (!filter || __ja_query_test(filter, nodes[i], cache)) ok = __ja_query_push(&current, nodes[i]);
+    }
+
+    for (size_t s = first; s < query->size && ok; s++) {
+        __ja_query_segment *segment = &query->segments[s];
+        next.length = 0;
+        for (size_t i = 0; i < __ja_query_count(&current) && ok; i++) {
+            ja_val *node = __ja_query_nodes(&current)[i];
+            ok = segment->descendant ? __ja_query_descend(segment, node, &next, cache)
+                                     : __ja_query_select(segment, node, &next, cache);
+        }
+
+        __ja_buffer swap = current;
+        current = next;
+        next = swap;
+    }
+
+    ok = ok && __ja_buffer_put(out, current.data, current.length);
+    free(current.data);
+    free(next.data);
+    return ok;
+}
+
+// Returns the nodes collected in `out` as the result of an evaluation
+static ja_val **__ja_query_result(__ja_buffer *out, bool ok, size_t *count) {
+    if (!ok) out->failed = true;
+
+    size_t length = 0;
+    ja_val **result = (ja_val **)(void *)__ja_buffer_finish(out, &length);
+    if (!result) {
+        JA_PROPAGATE_ERROR("ja_query_eval");
+        return NULL;
+    }
+    *count = length / sizeof(ja_val *);
+    return result;
+}
+
+ja_val **ja_query_eval(ja_query *query, ja_val *root, size_t *count) {
+    if (!query || !root || !count) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_query_eval().");
+        return NULL;
+    }
+
+    __ja_buffer out = {0};
+    bool ok = __ja_query_run(query, 0, NULL, &root, 1, &out, true);
+    return __ja_query_result(&out, ok, count);
+}
+
+// Amount of nodes handled by each task of ja_query_eval_parallel()
+#define JA_QUERY_CHUNK 1024
+
+// Shared state of the tasks of ja_query_eval_parallel()
+typedef struct __ja_query_job {
+    ja_query *query;
+    size_t first;               // First segment left to evaluate
+    __ja_query_expr *filter;    // Filter the nodes have to pass, NULL if none
+    ja_val **nodes;
+    size_t count;
+    __ja_buffer *results;       // One per task, joined in order
+} __ja_query_job;
+
+static void __ja_query_task(void *context, size_t task_index) {
+    __ja_query_job *job = context;
+    size_t start = task_index * JA_QUERY_CHUNK;
+    size_t count = job->count - start < JA_QUERY_CHUNK ? job->count - start : JA_QUERY_CHUNK;
+
+    // The caches are shared by all the tasks, so they're left alone
+    __ja_buffer *result = &job->results[task_index];
+    if (!__ja_query_run(job->query, job->first, job->filter, job->nodes + start, count, result, false)) {
+        result->failed = true;
+    }
+}
+
+ja_val **ja_query_eval_parallel(ja_query *query, ja_val *root, size_t *count, int thread_count) {
+    if (!query || !root || !count) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_query_eval_parallel().");
+        return NULL;
+    }
+
+    int threads = __ja_thread_count(thread_count);
+    if (threads <= 1) return ja_query_eval(query, root, count);
+
+    // Segments are evaluated here until there are enough nodes to split
+    __ja_buffer current = {0};
+    __ja_buffer next = {0};
+    __ja_query_expr *filter = NULL;
+    size_t first = 0;
+    bool ok = __ja_query_push(&current, root);
+
+    for (; first < query->size && ok && __ja_query_count(&current) < JA_QUERY_PARALLEL_MIN; first++) {
+        __ja_query_segment *segment = &query->segments[first];
+        next.length = 0;
+
+        for (size_t i = 0; i < __ja_query_count(&current) && ok; i++) {
+            ja_val *node = __ja_query_nodes(&current)[i];
+            if (segment->kind == __JA_QUERY_FILTER && !segment->descendant) {
+                // Collects the candidates, tested below
+                if (node->type != JA_TYPE_ARRAY && node->type != JA_TYPE_OBJECT) continue;
+                size_t size = node->type == JA_TYPE_ARRAY ? node->u.array.size : node->u.object.size;
+                for (size_t j = 0; j < size && ok; j++) {
+                    if (node->type == JA_TYPE_OBJECT && __ja_obj_tombstone(node, j)) continue;
+                    ok = __ja_query_push_slot(&next, __ja_query_child(node, j));
+                }
+            } else {
+                ok = segment->descendant ? __ja_query_descend(segment, node, &next, true)
+                                         : __ja_query_select(segment, node, &next, true);
+            }
+        }
+
+        if (ok && segment->kind == __JA_QUERY_FILTER && !segment->descendant) {
+            if (__ja_query_count(&next) >= JA_QUERY_PARALLEL_MIN) {
+                // Enough candidates: the tasks test them
+                filter = segment->filter;
+                first++;
+                __ja_buffer swap = current;
+                current = next;
+                next = swap;
+                break;
+            }
+
+            size_t kept = 0;
+            ja_val **candidates = __ja_query_nodes(&next);
+            for (size_t i = 0; i < __ja_query_count(&next); i++) {
+                if (__ja_query_test(segment->filter, candidates[i], true)) candidates[kept++] = candidates[i];
+            }
+            next.length = kept * sizeof(ja_val *);
+        }
+
+        __ja_buffer swap = current;
+        current = next;
+        next = swap;
+    }
+    free(next.data);
+
+    __ja_buffer out = {0};
+    size_t node_count = __ja_query_count(&current);
+    if (!ok || (first == query->size && !filter) || node_count < JA_QUERY_PARALLEL_MIN) {
+        ok = ok && __ja_query_run(query, first, filter, __ja_query_nodes(&current), node_count, &out, true);
+        free(current.data);
+        return __ja_query_result(&out, ok, count);
+    }
+
+    size_t task_count = (node_count + JA_QUERY_CHUNK - 1) / JA_QUERY_CHUNK;
+    __ja_query_job job = {query, first, filter, __ja_query_nodes(&current), node_count, calloc(task_count, sizeof(__ja_buffer))};
+    if (!job.results) {
+        JA_MEM_ERROR();
+        free(current.data);
+        return NULL;
+    }
+
+    __ja_parallel_for(task_count, threads, __ja_query_task, &job);
+
+    for (size_t i = 0; i < task_count; i++) {
+        ok = ok && !job.results[i].failed && __ja_buffer_put(&out, job.results[i].data, job.results[i].length);
+        free(job.results[i].data);
+    }
+    free(job.results);
+    free(current.data);
+    return __ja_query_result(&out, ok, count);
+}
+
+void ja_query_free(ja_query **query) {
+    if (!query || !*query) return;
+
+    for (size_t i = 0; i < (*query)->size; i++) {
+        __ja_query_segment *segment = &(*query)->segments[i];
+        __ja_key_release(segment->step.key);
+        __ja_shape_release(segment->step.shape);
+        __ja_query_expr_free(segment->filter);
+    }
+    free((*query)->segments);
+    free(*query);
+    *query = NULL;
+}
+
+// Rows gathered by ja_extract_column() before their values are converted
+#define JA_EXTRACT_BATCH 256
+
+// Rows handled by each task of ja_extract_column_parallel(), a multiple of 8 so tasks don't share bitmap bytes
+#define JA_EXTRACT_CHUNK 8192
+
+// Converts a batch of gathered values into rows [first, first + count) of a column
+static void __ja_extract_batch(ja_val **values, size_t count, ja_type type, void *out, size_t first, uint8_t *valid) {
+    bool found[JA_EXTRACT_BATCH];
+
+    switch (type) {
+        case JA_TYPE_INT: {
+            int64_t *column = (int64_t *)out + first;
+            for (size_t i = 0; i < count; i++) {
+                found[i] = values[i] && values[i]->type == JA_TYPE_INT;
+                column[i] = found[i] ? values[i]->u.number.as_int : 0;
+            }
+            break;
+        }
+        case JA_TYPE_DOUBLE: {
+            double *column = (double *)out + first;
+            for (size_t i = 0; i < count; i++) {
+                found[i] = values[i] && (values[i]->type == JA_TYPE_DOUBLE || values[i]->type == JA_TYPE_INT);
+                column[i] = !found[i] ? 0.0 : values[i]->type == JA_TYPE_INT ? (double)values[i]->u.number.as_int
+                                                                             : values[i]->u.number.as_double;
+            }
+            break;
+        }
+        case JA_TYPE_BOOL: {
+            bool *column = (bool *)out + first;
+            for (size_t i = 0; i < count; i++) {
+                found[i] = values[i] && values[i]->type == JA_TYPE_BOOL;
+                column[i] = found[i] && values[i]->u.boolean;
+            }
+            break;
+        }
+        default: {
+            const char **column = (const char **)out + first;
+            for (size_t i = 0; i < count; i++) {
+                found[i] = values[i] && values[i]->type == JA_TYPE_STRING;
+                column[i] = found[i] ? values[i]->u.string : NULL;
+            }
+            break;
+        }
+    }
+
+    if (!valid) return;
+    for (size_t i = 0; i < count; i++) {
+        size_t row = first + i;
+        if (found[i]) valid[row >> 3] |= (uint8_t)(1u << (row & 7));
+        else valid[row >> 3] &= (uint8_t)~(1u << (row & 7));
+    }
+}
+
+// Copies rows [first, first + count) of a packed array itself (the "" pointer) straight from its buffer, when the
+// column has the type of its elements
+static bool __ja_extract_packed(ja_val *array, size_t first, size_t count, ja_type type, void *out, uint8_t *valid) {
+    bool booleans = array->flags & JA_FLAG_PACKED_BOOL;
+    if (type != (booleans ? JA_TYPE_BOOL : JA_TYPE_DOUBLE)) return false;
+
+    size_t width = __ja_packed_width(array);
+    memcpy((char *)out + first * width, (char *)array->u.array.doubles + first * width, count * width);
+
+    for (size_t row = first; valid && row < first + count; row++) valid[row >> 3] |= (uint8_t)(1u << (row & 7));
+    return true;
+}
+
+// Extracts rows [first, first + count) of a column
+static void __ja_extract_rows(ja_val *array, ja_path *path, size_t first, size_t count, ja_type type, void *out,
+                              uint8_t *valid) {
+    if (__ja_is_packed(array) && path->size == 0 && __ja_extract_packed(array, first, count, type, out, valid)) return;
+
+    ja_val *values[JA_EXTRACT_BATCH];
+    ja_val scratch[JA_EXTRACT_BATCH]; // Elements of packed arrays
+
+    for (size_t batch = first; batch < first + count; batch += JA_EXTRACT_BATCH) {
+        size_t size = first + count - batch < JA_EXTRACT_BATCH ? first + count - batch : JA_EXTRACT_BATCH;
+        for (size_t i = 0; i < size; i++) {
+            ja_val *element = __ja_arr_peek(array, batch + i, &scratch[i]);
+            values[i] = __ja_path_read(path, element, true, &scratch[i]);
+        }
+        __ja_extract_batch(values, size, type, out, batch, valid);
+    }
+}
+
+// Checks the arguments of ja_extract_column() and compiles its pointer
+static ja_path *__ja_extract_begin(ja_val *array, const char *pointer, ja_type type, void *out, const char *caller) {
+    if (!array || !pointer || !out) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to %s().", caller);
+        return NULL;
+    }
+
+    if (array->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't extract a column from %s.", ja_str_type_of(array));
+        return NULL;
+    }
+
+    if (type != JA_TYPE_INT && type != JA_TYPE_DOUBLE && type != JA_TYPE_BOOL && type != JA_TYPE_STRING) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Columns can only be ints, doubles, bools or strings.");
+        return NULL;
+    }
+
+    return ja_path_compile(pointer);
+}
+
+bool ja_extract_column(ja_val *array, const char *pointer, ja_type type, void *out, uint8_t *valid) {
+    ja_path *path = __ja_extract_begin(array, pointer, type, out, "ja_extract_column");
+    if (!path) return false;
+
+    __ja_extract_rows(array, path, 0, array->u.array.size, type, out, valid);
+    ja_path_free(&path);
+    return true;
+}
+
+// Shared state of the tasks of ja_extract_column_parallel()
+typedef struct __ja_extract_job {
+    ja_val *array;
+    const char *pointer;
+    ja_type type;
+    void *out;
+    uint8_t *valid;
+    bool failed;
+} __ja_extract_job;
+
+static void __ja_extract_task(void *context, size_t task_index) {
+    __ja_extract_job *job = context;
+
+    // Each task has its own copy of the pointer, so it can use the inline caches
+    ja_path *path = ja_path_compile(job->pointer);
+    if (!path) {
+        __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+        return;
+    }
+
+    size_t first = task_index * JA_EXTRACT_CHUNK;
+    size_t size = job->array->u.array.size;
+    size_t count = size - first < JA_EXTRACT_CHUNK ? size - first : JA_EXTRACT_CHUNK;
+    __ja_extract_rows(job->array, path, first, count, job->type, job->out, job->valid);
+    ja_path_free(&path);
+}
+
+bool ja_extract_column_parallel(ja_val *array, const char *pointer, ja_type type, void *out, uint8_t *valid,
+                                int thread_count) {
+    ja_path *path = __ja_extract_begin(array, pointer, type, out, "ja_extract_column_parallel");
+    if (!path) return false;
+
+    size_t size = array->u.array.size;
+    int threads = __ja_thread_count(thread_count);
+    if (threads <= 1 || size <= JA_EXTRACT_CHUNK) {
+        __ja_extract_rows(array, path, 0, size, type, out, valid);
+        ja_path_free(&path);
+        return true;
+    }
+    ja_path_free(&path);
+
+    __ja_extract_job job = {array, pointer, type, out, valid, false};
+    __ja_parallel_for((size + JA_EXTRACT_CHUNK - 1) / JA_EXTRACT_CHUNK, threads, __ja_extract_task, &job);
+
+    if (job.failed) {
+        JA_PROPAGATE_ERROR("ja_extract_column_parallel");
+        return false;
+    }
+    return true;
+}
+
+// Running statistics of ja_arr_reduce()
+typedef struct __ja_reduce_acc {
+    double sum;
+    double min;
+    double max;
+    size_t count;
+} __ja_reduce_acc;
+
+// Bins of ja_arr_histogram()
+typedef struct __ja_histogram {
+    double min;
+    double max;
+    double scale;   // Bins per unit
+    size_t bins;
+    size_t *counts;
+} __ja_histogram;
+
+// Adds a run of numbers to the running statistics
+static void __ja_reduce_kernel(const double *values, size_t count, void *context) {
+    __ja_reduce_acc *acc = context;
+    double sum = 0.0;
+    double min = acc->min;
+    double max = acc->max;
+    size_t i = 0;
+
+#ifdef __AVX2__
+    if (count >= 8) {
+        // Two accumulators of each kind hide the latency of the additions
+        __m256d sum_a = _mm256_setzero_pd(), sum_b = _mm256_setzero_pd();
+        __m256d min_a = _mm256_set1_pd(min), min_b = min_a;
+        __m256d max_a = _mm256_set1_pd(max), max_b = max_a;
+
+        for (; i + 8 <= count; i += 8) {
+            __m256d a = _mm256_loadu_pd(values + i);
+            __m256d b = _mm256_loadu_pd(values + i + 4);
+            sum_a = _mm256_add_pd(sum_a, a);
+            sum_b = _mm256_add_pd(sum_b, b);
+            min_a = _mm256_min_pd(min_a, a);
+            min_b = _mm256_min_pd(min_b, b);
+            max_a = _mm256_max_pd(max_a, a);
+            max_b = _mm256_max_pd(max_b, b);
+        }
+
+        double lanes[3][4];
+        _mm256_storeu_pd(lanes[0], _mm256_add_pd(sum_a, sum_b));
+        _mm256_storeu_pd(lanes[1], _mm256_min_pd(min_a, min_b));
+        _mm256_storeu_pd(lanes[2], _mm256_max_pd(max_a, max_b));
+        for (int lane = 0; lane < 4; lane++) {
+            sum += lanes[0][lane];
+            min = lanes[1][lane] < min ? lanes[1][lane] : min;
+            max = lanes[2][lane] > max ? lanes[2][lane] : max;
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        sum += values[i];
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+
+    acc->sum += sum;
+    acc->min = min;
+    acc->max = max;
+    acc->count += count;
+}
+
+// Counts a run of numbers into the bins of a histogram
+static void __ja_histogram_kernel(const double *values, size_t count, void *context) {
+    __ja_histogram *histogram = context;
+    size_t last = histogram->bins - 1;
+    size_t i = 0;
+
+#ifdef __AVX2__
+    if (histogram->bins <= INT32_MAX) { // Bin indexes are converted 4 at a time to int32
+        const __m256d low = _mm256_set1_pd(histogram->min);
+        const __m256d high = _mm256_set1_pd(histogram->max);
+        const __m256d scale = _mm256_set1_pd(histogram->scale);
+
+        for (; i + 4 <= count; i += 4) {
+            __m256d v = _mm256_loadu_pd(values + i);
+            int inside = _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(v, low, _CMP_GE_OQ), _mm256_cmp_pd(v, high, _CMP_LE_OQ)));
+            if (!inside) continue;
+
+            int32_t bins[4];
+            _mm_storeu_si128((__m128i *)(void *)bins, _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(v, low), scale)));
+            for (int lane = 0; lane < 4; lane++) {
+                if (inside & (1 << lane)) histogram->counts[(size_t)bins[lane] < last ? (size_t)bins[lane] : last]++;
+            }
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        double v = values[i];
+        if (!(v >= histogram->min && v <= histogram->max)) continue;
+
+        size_t bin = (size_t)((v - histogram->min) * histogram->scale);
+        histogram->counts[bin < last ? bin : last]++;
+    }
+}
+
+// Feeds the numbers at `path` in every element of an array to a kernel, a batch at a time
+static void __ja_reduce_rows(ja_val *array, ja_path *path, void (*kernel)(const double *, size_t, void *), void *context) {
+    size_t size = array->u.array.size;
+
+    if (__ja_is_packed(array) && path->size == 0) {
+        if (!(array->flags & JA_FLAG_PACKED_BOOL)) kernel(array->u.array.doubles, size, context);
+        return;
+    }
+
+    double values[JA_EXTRACT_BATCH];
+    ja_val scratch;
+
+    for (size_t batch = 0; batch < size; batch += JA_EXTRACT_BATCH) {
+        size_t end = size - batch < JA_EXTRACT_BATCH ? size : batch + JA_EXTRACT_BATCH;
+        size_t found = 0;
+
+        for (size_t row = batch; row < end; row++) {
+            ja_val *value = __ja_path_read(path, __ja_arr_peek(array, row, &scratch), true, &scratch);
+            if (!value) continue;
+            if (value->type == JA_TYPE_INT) values[found++] = (double)value->u.number.as_int;
+            else if (value->type == JA_TYPE_DOUBLE) values[found++] = value->u.number.as_double;
+        }
+        if (found > 0) kernel(values, found, context);
+    }
+}
+
+// Checks the arguments shared by the reductions and compiles their pointer
+static ja_path *__ja_reduce_begin(ja_val *array, const char *pointer, void *out, const char *caller) {
+    if (!array || !pointer || !out) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to %s().", caller);
+        return NULL;
+    }
+
+    if (array->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use %s() on %s.", caller, ja_str_type_of(array));
+        return NULL;
+    }
+
+    return ja_path_compile(pointer);
+}
+
+bool ja_arr_reduce_path(ja_val *array, const char *pointer, ja_reduce_op op, double *result) {
+    ja_path *path = __ja_reduce_begin(array, pointer, result, "ja_arr_reduce");
+    if (!path) return false;
+
+    __ja_reduce_acc acc = {0.0, INFINITY, -INFINITY, 0};
+    __ja_reduce_rows(array, path, __ja_reduce_kernel, &acc);
+    ja_path_free(&path);
+
+    switch (op) {
+        case JA_REDUCE_SUM:   *result = acc.sum; break;
+        case JA_REDUCE_MIN:   *result = acc.count ? acc.min : NAN; break;
+        case JA_REDUCE_MAX:   *result = acc.count ? acc.max : NAN; break;
+        case JA_REDUCE_MEAN:  *result = acc.count ? acc.sum / (double)acc.count : NAN; break;
+        case JA_REDUCE_COUNT: *result = (double)acc.count; break;
+    }
+    return true;
+}
+
+bool ja_arr_reduce(ja_val *array, ja_reduce_op op, double *result) {
+    return ja_arr_reduce_path(array, "", op, result);
+}
+
+bool ja_arr_histogram_path(ja_val *array, const char *pointer, double min, double max, size_t bins, size_t *counts) {
+    if (bins == 0 || !(min < max) || isinf(max - min)) {
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Histograms need bins over a finite range (min=%g, max=%g, bins=%zu).",
+                 min, max, bins);
+        return false;
+    }
+
+    ja_path *path = __ja_reduce_begin(array, pointer, counts, "ja_arr_histogram");
+    if (!path) return false;
+
+    memset(counts, 0, bins * sizeof(size_t));
+    __ja_histogram histogram = {min, max, (double)bins / (max - min), bins, counts};
+    __ja_reduce_rows(array, path, __ja_histogram_kernel, &histogram);
+    ja_path_free(&path);
+    return true;
+}
+
+bool ja_arr_histogram(ja_val *array, double min, double max, size_t bins, size_t *counts) {
+    return ja_arr_histogram_path(array, "", min, max, bins, counts);
+}
+
+// Finalizer of MurmurHash3, spreads every bit of the input over the hash
+static inline uint64_t __ja_mix64(uint64_t bits) {
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    bits *= 0xc4ceb9fe1a85ec53ULL;
+    return bits ^ (bits >> 33);
+}
+
+// Hash of a number, the same for ints and doubles of equal value
+static inline uint64_t __ja_hash_number(double number) {
+    uint64_t bits;
+    number = number == 0.0 ? 0.0 : number; // -0.0 is 0.0
+    memcpy(&bits, &number, sizeof(bits));
+    return __ja_mix64(bits);
+}
+
+static inline uint64_t __ja_hash_bool(bool boolean) {
+    return __ja_mix64(0x2545f4914f6cdd1dULL + boolean);
+}
+
+// Reads the key of an element into an entry, false if it has none that can be indexed
+static bool __ja_index_key(const ja_val *value, __ja_index_entry *entry) {
+    if (!value) return false;
+
+    switch (value->type) {
+        case JA_TYPE_INT:
+            entry->type = JA_TYPE_DOUBLE;
+            entry->number = (double)value->u.number.as_int;
+            break;
+        case JA_TYPE_DOUBLE:
+            entry->type = JA_TYPE_DOUBLE;
+            entry->number = value->u.number.as_double;
+            break;
+        case JA_TYPE_STRING:
+            entry->type = JA_TYPE_STRING;
+            entry->string = value->u.string ? value->u.string : "";
+            break;
+        case JA_TYPE_BOOL:
+            entry->type = JA_TYPE_BOOL;
+            entry->boolean = value->u.boolean;
+            break;
+        default:
+            return false;
+    }
+
+    if (entry->type == JA_TYPE_STRING) entry->hash = __ja_hash_str(entry->string, strlen(entry->string));
+    else if (entry->type == JA_TYPE_BOOL) entry->hash = __ja_hash_bool(entry->boolean);
+    else entry->hash = __ja_hash_number(entry->number);
+    return true;
+}
+
+static bool __ja_index_equal(const __ja_index_entry *a, const __ja_index_entry *b) {
+    if (a->type != b->type || a->hash != b->hash) return false;
+
+    switch (a->type) {
+        case JA_TYPE_STRING: return strcmp(a->string, b->string) == 0;
+        case JA_TYPE_BOOL:   return a->boolean == b->boolean;
+        default:             return a->number == b->number;
+    }
+}
+
+// Position of a kind of key in ranges: numbers, then strings, then booleans
+static int __ja_index_rank(ja_type type) {
+    return type == JA_TYPE_DOUBLE ? 0 : type == JA_TYPE_STRING ? 1 : 2;
+}
+
+static int __ja_index_compare(const __ja_index_entry *a, const __ja_index_entry *b) {
+    if (a->type != b->type) return __ja_index_rank(a->type) - __ja_index_rank(b->type);
+
+    switch (a->type) {
+        case JA_TYPE_STRING: return strcmp(a->string, b->string);
+        case JA_TYPE_BOOL:   return (int)a->boolean - (int)b->boolean;
+        default:             return (a->number > b->number) - (a->number < b->number);
+    }
+}
+
+// qsort() comparator of sorted entries, equal keys keep the order of the array
+static int __ja_index_sort_compare(const void *a, const void *b) {
+    const __ja_index_entry *x = a;
+    const __ja_index_entry *y = b;
+    int order = __ja_index_compare(x, y);
+    return order ? order : (x->position > y->position) - (x->position < y->position);
+}
+
+static void __ja_index_insert(ja_index *index, size_t entry) {
+    size_t slot = (size_t)index->entries[entry].hash & index->table_mask;
+    while (index->table[slot]) slot = (slot + 1) & index->table_mask;
+    index->table[slot] = entry + 1;
+}
+
+// Makes room for `size` entries, keeping the hash table at most half full
+static bool __ja_index_reserve(ja_index *index, size_t size) {
+    if (size > index->capacity) {
+        size_t capacity = index->capacity * 2 > size ? index->capacity * 2 : size;
+        __ja_index_entry *entries = realloc(index->entries, capacity * sizeof(__ja_index_entry));
+        if (!entries) {
+            JA_MEM_ERROR();
+            return false;
+        }
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+
+    if (index->table && size * 2 <= index->table_mask + 1) return true;
+
+    size_t slots = 16;
+    while (slots < size * 2) slots *= 2;
+    size_t *table = calloc(slots, sizeof(size_t));
+    if (!table) {
+        JA_MEM_ERROR();
+        return false;
+    }
+
+    free(index->table);
+    index->table = table;
+    index->table_mask = slots - 1;
+    for (size_t i = 0; i < index->size; i++) __ja_index_insert(index, i);
+    return true;
+}
+
+// Indexes the elements appended since the last call
+static bool __ja_index_add_rows(ja_index *index) {
+    ja_val *array = index->array;
+    size_t size = array->u.array.size;
+    if (!__ja_index_reserve(index, index->size + (size - index->rows))) return false;
+
+    ja_val scratch;
+    for (size_t row = index->rows; row < size; row++) {
+        __ja_index_entry *entry = &index->entries[index->size];
+        ja_val *element = __ja_arr_peek(array, row, &scratch);
+        if (!__ja_index_key(__ja_path_read(index->path, element, true, &scratch), entry)) continue;
+
+        entry->position = row;
+        __ja_index_insert(index, index->size++);
+    }
+
+    index->rows = size;
+    free(index->sorted); // Sorted again by the next range
+    index->sorted = NULL;
+    return true;
+}
+
+// Checks that an index can be used, rebuilding it if the array changed
+static bool __ja_index_ready(ja_index *index, const char *caller) {
+    if (!index) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "%s() called with NULL index.", caller);
+        return false;
+    }
+
+    if (!index->array) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "%s() called on an index whose array was freed.", caller);
+        return false;
+    }
+
+    if (index->stale || index->rows > index->array->u.array.size) {
+        index->size = 0;
+        index->rows = 0;
+        if (index->table) memset(index->table, 0, (index->table_mask + 1) * sizeof(size_t));
+        if (!__ja_index_add_rows(index)) return false;
+        index->stale = false;
+    }
+    return true;
+}
+
+// Element of an entry
+static ja_val *__ja_index_element(ja_index *index, const __ja_index_entry *entry) {
+    ja_val **slot = __ja_arr_slot(index->array, entry->position);
+    return slot ? __ja_cow_load(slot) : NULL;
+}
+
+// Indexes built and not freed yet, linked through `next`. Arrays only carry JA_FLAG_INDEXED, so their nodes
+// keep two words for the elements, and their indexes are looked up here when they change or go away.
+static ja_index *__ja_index_list = NULL;
+#ifdef JA_THREADS
+static pthread_mutex_t __ja_index_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+ja_index *ja_index_build(ja_val *array, const char *pointer) {
+    if (!array || !pointer) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_index_build().");
+        return NULL;
+    }
+
+    if (array->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't index %s.", ja_str_type_of(array));
+        return NULL;
+    }
+
+    ja_index *index = calloc(1, sizeof(ja_index));
+    if (!index) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    index->array = array;
+    index->path = ja_path_compile(pointer);
+    if (!index->path || !__ja_index_add_rows(index)) {
+        JA_PROPAGATE_ERROR("ja_index_build");
+        index->array = NULL; // Not attached yet
+        ja_index_free(&index);
+        return NULL;
+    }
+
+#ifdef JA_THREADS
+    pthread_mutex_lock(&__ja_index_lock);
+#endif
+    index->next = __ja_index_list;
+    __ja_index_list = index;
+    array->flags |= JA_FLAG_INDEXED;
+#ifdef JA_THREADS
+    pthread_mutex_unlock(&__ja_index_lock);
+#endif
+    return index;
+}
+
+// Finds the first entry equal to a key
+static ja_val *__ja_index_find(ja_index *index, const __ja_index_entry *key) {
+    for (size_t slot = (size_t)key->hash & index->table_mask; index->table[slot]; slot = (slot + 1) & index->table_mask) {
+        const __ja_index_entry *entry = &index->entries[index->table[slot] - 1];
+        if (__ja_index_equal(entry, key)) return __ja_index_element(index, entry);
+    }
+    return NULL;
+}
+
+ja_val *ja_index_lookup(ja_index *index, const ja_val *key) {
+    if (!key) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_index_lookup() called with NULL key.");
+        return NULL;
+    }
+    if (!__ja_index_ready(index, "ja_index_lookup")) return NULL;
+
+    __ja_index_entry probe;
+    return __ja_index_key(key, &probe) ? __ja_index_find(index, &probe) : NULL;
+}
+
+ja_val *ja_index_lookup_num(ja_index *index, double key) {
+    if (!__ja_index_ready(index, "ja_index_lookup_num")) return NULL;
+
+    ja_val number = {.type = JA_TYPE_DOUBLE, .u.number = {(int)0, key}};
+    __ja_index_entry probe;
+    __ja_index_key(&number, &probe);
+    return __ja_index_find(index, &probe);
+}
+
+ja_val *ja_index_lookup_str(ja_index *index, const char *key) {
+    if (!key) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_index_lookup_str() called with NULL key.");
+        return NULL;
+    }
+    if (!__ja_index_ready(index, "ja_index_lookup_str")) return NULL;
+
+    ja_val string = {.type = JA_TYPE_STRING, .u.string = (char *)key};
+    __ja_index_entry probe;
+    __ja_index_key(&string, &probe);
+    return __ja_index_find(index, &probe);
+}
+
+// First sorted entry not below `key` (above it with `after`), among `count` entries
+static size_t __ja_index_bound(const __ja_index_entry *sorted, size_t count, const __ja_index_entry *key, bool after) {
+    size_t low = 0;
+    size_t high = count;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order = __ja_index_compare(&sorted[middle], key);
+        if (order < 0 || (after && order == 0)) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+// First sorted entry of a kind of key (or of the next kind with `after`)
+static size_t __ja_index_kind_bound(const __ja_index_entry *sorted, size_t count, ja_type type, bool after) {
+    size_t low = 0;
+    size_t high = count;
+    int rank = __ja_index_rank(type) + after;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (__ja_index_rank(sorted[middle].type) < rank) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+ja_val **ja_index_range(ja_index *index, const ja_val *low, const ja_val *high, size_t *count) {
+    if (!count) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_index_range() called with NULL count.");
+        return NULL;
+    }
+    *count = 0;
+    if (!__ja_index_ready(index, "ja_index_range")) return NULL;
+
+    __ja_index_entry low_key;
+    __ja_index_entry high_key;
+    if ((low && !__ja_index_key(low, &low_key)) || (high && !__ja_index_key(high, &high_key)) ||
+        (low && high && low_key.type != high_key.type)) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Range bounds must be numbers, strings or booleans of the same kind.");
+        return NULL;
+    }
+
+    if (!index->sorted && index->size > 0) {
+        index->sorted = malloc(index->size * sizeof(__ja_index_entry));
+        if (!index->sorted) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+        memcpy(index->sorted, index->entries, index->size * sizeof(__ja_index_entry));
+        qsort(index->sorted, index->size, sizeof(__ja_index_entry), __ja_index_sort_compare);
+    }
+
+    // A single bound only reaches keys of its own kind
+    size_t first = low ? __ja_index_bound(index->sorted, index->size, &low_key, false)
+                 : high ? __ja_index_kind_bound(index->sorted, index->size, high_key.type, false) : 0;
+    size_t last = high ? __ja_index_bound(index->sorted, index->size, &high_key, true)
+                : low ? __ja_index_kind_bound(index->sorted, index->size, low_key.type, true) : index->size;
+    size_t found = last > first ? last - first : 0;
+
+    ja_val **results = malloc(found ? found * sizeof(ja_val*) : 1);
+    if (!results) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    for (size_t i = 0; i < found; i++) {
+        results[i] = __ja_index_element(index, &index->sorted[first + i]);
+        if (!results[i]) {
+            free(results);
+            return NULL;
+        }
+    }
+
+    *count = found;
+    return results;
+}
+
+void ja_index_invalidate(ja_index *index) {
+    if (index) index->stale = true;
+}
+
+void ja_index_free(ja_index **index) {
+    if (!index || !*index) return;
+
+    ja_index *target = *index;
+#ifdef JA_THREADS
+    pthread_mutex_lock(&__ja_index_lock);
+#endif
+    ja_index **link = &__ja_index_list;
+    while (*link && *link != target) link = &(*link)->next;
+    if (*link) *link = target->next;
+
+    if (target->array) { // The array keeps its flag while other indexes are attached to it
+        bool attached = false;
+        for (ja_index *other = __ja_index_list; other && !attached; other = other->next) {
+            attached = other->array == target->array;
+        }
+        if (!attached) target->array->flags &= (uint16_t)~JA_FLAG_INDEXED;
+    }
+#ifdef JA_THREADS
+    pthread_mutex_unlock(&__ja_index_lock);
+#endif
+
+    ja_path_free(&target->path);
+    free(target->entries);
+    free(target->table);
+    free(target->sorted);
+    free(target);
+    *index = NULL;
+}
+
+void __ja_index_changed(ja_val *array, bool appended) {
+#ifdef JA_THREADS
+    pthread_mutex_lock(&__ja_index_lock);
+#endif
+    for (ja_index *index = __ja_index_list; index; index = index->next) {
+        if (index->array != array) continue;
+        if (!appended || index->stale || !__ja_index_add_rows(index)) index->stale = true;
+    }
+#ifdef JA_THREADS
+    pthread_mutex_unlock(&__ja_index_lock);
+#endif
+}
+
+void __ja_index_detach(ja_val *array) {
+    if (!(array->flags & JA_FLAG_INDEXED)) return;
+
+#ifdef JA_THREADS
+    pthread_mutex_lock(&__ja_index_lock);
+#endif
+    for (ja_index *index = __ja_index_list; index; index = index->next) {
+        if (index->array == array) index->array = NULL;
+    }
+    array->flags &= (uint16_t)~JA_FLAG_INDEXED;
+#ifdef JA_THREADS
+    pthread_mutex_unlock(&__ja_index_lock);
+#endif
+}
+
+// Deep comparison behind ja_equal() and ja_equal_ordered()
+static bool __ja_equal(ja_val *a, ja_val *b, bool ordered) {
+    if (a == b) return true; // Shared subtrees of copy-on-write copies end here
+
+    if (__ja_query_is_number(a) && __ja_query_is_number(b)) return __ja_query_number(a) == __ja_query_number(b);
+    if (a->type != b->type) return false;
+
+    switch (a->type) {
+    case JA_TYPE_STRING:
+        return strcmp(a->u.string ? a->u.string : "", b->u.string ? b->u.string : "") == 0;
+    case JA_TYPE_BOOL:
+        return a->u.boolean == b->u.boolean;
+    case JA_TYPE_ARRAY: {
+        size_t size = a->u.array.size;
+        if (size != b->u.array.size) return false;
+
+        if ((a->flags & JA_FLAG_PACKED_BOOL) && (b->flags & JA_FLAG_PACKED_BOOL)) {
+            return memcmp(a->u.array.bools, b->u.array.bools, size * sizeof(bool)) == 0;
+        }
+        if ((a->flags & JA_FLAG_PACKED) && (b->flags & JA_FLAG_PACKED)) {
+            for (size_t i = 0; i < size; i++) {
+                if (a->u.array.doubles[i] != b->u.array.doubles[i]) return false;
+            }
+            return true;
+        }
+
+        ja_val scratch_a;
+        ja_val scratch_b;
+        for (size_t i = 0; i < size; i++) {
+            if (!__ja_equal(__ja_arr_peek(a, i, &scratch_a), __ja_arr_peek(b, i, &scratch_b), ordered)) return false;
+        }
+        return true;
+    }
+    case JA_TYPE_OBJECT: {
+        if (__ja_obj_live(a) != __ja_obj_live(b)) return false;
+
+        bool same_shape = (a->flags & JA_FLAG_SHAPED) && (b->flags & JA_FLAG_SHAPED) &&
+            __JA_OBJ_SHAPE(a) == __JA_OBJ_SHAPE(b);
+        size_t next = 0; // Position in b of the member at the same index, tombstones skipped on both sides
+        for (size_t i = 0; i < a->u.object.size; i++) {
+            if (__ja_obj_tombstone(a, i)) continue;
+            while (__ja_obj_tombstone(b, next)) next++;
+
+            size_t j = next++;
+            if (!same_shape) {
+                // Keys in the same order are matched by position, the others are looked up
+                const char *key = __ja_obj_key(a, i);
+                const __ja_key *header = __ja_key_header(key);
+                if (!__ja_key_equals(__ja_obj_key(b, j), key, header->hash, header->length)) {
+                    if (ordered) return false;
+                    j = __ja_obj_find(b, key, header->hash, header->length);
+                    if (j >= b->u.object.size) return false;
+                }
+            }
+            if (!__ja_equal(*__ja_obj_slot(a, i), *__ja_obj_slot(b, j), ordered)) return false;
+        }
+        return true;
+    }
+    default:
+        return true; // Nulls
+    }
+}
+
+bool ja_equal(ja_val *a, ja_val *b) {
+    if (!a || !b) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_equal().");
+        return false;
+    }
+    return __ja_equal(a, b, false);
+}
+
+bool ja_equal_ordered(ja_val *a, ja_val *b) {
+    if (!a || !b) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_equal_ordered().");
+        return false;
+    }
+    return __ja_equal(a, b, true);
+}
+
+// Slot of a node in a hash cache, either holding it or empty
+static size_t __ja_hash_cache_slot(const ja_hash_cache *cache, const ja_val *value) {
+    size_t mask = cache->capacity - 1;
+    size_t slot = (size_t)__ja_mix64((uint64_t)(uintptr_t)value) & mask;
+    while (cache->nodes[slot] && cache->nodes[slot] != value) slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Remembers the hash of a subtree, keeping the table at most half full
+static void __ja_hash_cache_put(ja_hash_cache *cache, const ja_val *value, uint64_t hash) {
+    if ((cache->count + 1) * 2 > cache->capacity) {
+        size_t capacity = cache->capacity ? cache->capacity * 2 : 64;
+        const ja_val **nodes = calloc(capacity, sizeof(ja_val*));
+        uint64_t *hashes = malloc(capacity * sizeof(uint64_t));
+        if (!nodes || !hashes) {
+            JA_MEM_ERROR(); // The hash is still right, only not cached
+            free(nodes);
+            free(hashes);
+            return;
+        }
+
+        ja_hash_cache grown = {nodes, hashes, cache->count, capacity};
+        for (size_t i = 0; i < cache->capacity; i++) {
+            if (!cache->nodes[i]) continue;
+            size_t slot = __ja_hash_cache_slot(&grown, cache->nodes[i]);
+            nodes[slot] = cache->nodes[i];
+            hashes[slot] = cache->hashes[i];
+        }
+        free(cache->nodes);
+        free(cache->hashes);
+        *cache = grown;
+    }
+
+    size_t slot = __ja_hash_cache_slot(cache, value);
+    cache->nodes[slot] = value;
+    cache->hashes[slot] = hash;
+    cache->count++;
+}
+
+// Structural hash behind ja_hash(), equal for values ja_equal() finds equal
+static uint64_t __ja_hash(ja_val *value, ja_hash_cache *cache) {
+    switch (value->type) {
+    case JA_TYPE_INT:
+        return __ja_hash_number((double)value->u.number.as_int);
+    case JA_TYPE_DOUBLE:
+        return __ja_hash_number(value->u.number.as_double);
+    case JA_TYPE_STRING: {
+        const char *string = value->u.string ? value->u.string : "";
+        return __ja_mix64(__ja_hash_str(string, strlen(string)) ^ 0x9e3779b97f4a7c15ULL);
+    }
+    case JA_TYPE_BOOL:
+        return __ja_hash_bool(value->u.boolean);
+    case JA_TYPE_ARRAY:
+    case JA_TYPE_OBJECT:
+        break;
+    default:
+        return __ja_mix64(0x2545f4914f6cdd1dULL + 2); // Nulls, next to the booleans
+    }
+
+    if (cache && cache->count) {
+        size_t slot = __ja_hash_cache_slot(cache, value);
+        if (cache->nodes[slot]) return cache->hashes[slot];
+    }
+
+    uint64_t hash;
+    if (value->type == JA_TYPE_ARRAY) {
+        // Elements are chained in order
+        hash = 0xcbf29ce484222325ULL ^ value->u.array.size;
+        ja_val scratch;
+        for (size_t i = 0; i < value->u.array.size; i++) {
+            hash = (hash ^ __ja_hash(__ja_arr_peek(value, i, &scratch), cache)) * 0x100000001b3ULL;
+            hash ^= hash >> 29;
+        }
+    } else {
+        // Members are summed, so the order of the keys doesn't matter
+        hash = 0x84222325cbf29ce4ULL ^ __ja_obj_live(value);
+        for (size_t i = 0; i < value->u.object.size; i++) {
+            if (__ja_obj_tombstone(value, i)) continue;
+            uint64_t key = __ja_key_header(__ja_obj_key(value, i))->hash;
+            hash += __ja_mix64(key ^ (__ja_hash(*__ja_obj_slot(value, i), cache) * 0x9e3779b97f4a7c15ULL));
+        }
+    }
+
+    hash = __ja_mix64(hash);
+    if (cache) __ja_hash_cache_put(cache, value, hash);
+    return hash;
+}
+
+uint64_t ja_hash(ja_val *value) {
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_hash() called with NULL value.");
+        return 0;
+    }
+    return __ja_hash(value, NULL);
+}
+
+ja_hash_cache *ja_hash_cache_new(void) {
+    ja_hash_cache *cache = calloc(1, sizeof(ja_hash_cache));
+    if (!cache) JA_MEM_ERROR();
+    return cache;
+}
+
+uint64_t ja_hash_cached(ja_val *value, ja_hash_cache *cache) {
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_hash_cached() called with NULL value.");
+        return 0;
+    }
+    return __ja_hash(value, cache);
+}
+
+void ja_hash_cache_clear(ja_hash_cache *cache) {
+    if (!cache || !cache->nodes) return;
+
+    memset(cache->nodes, 0, cache->capacity * sizeof(ja_val*));
+    cache->count = 0;
+}
+
+void ja_hash_cache_free(ja_hash_cache **cache) {
+    if (!cache || !*cache) return;
+
+    free((*cache)->nodes);
+    free((*cache)->hashes);
+    free(*cache);
+    *cache = NULL;
+}
+
+// Takes an element out of an array without freeing it
+static ja_val *__ja_arr_take(ja_val *array, size_t index) {
+    if (!__ja_block_own_data(array) || !__ja_arr_unpack(array)) return NULL;
+
+    ja_val *value = array->u.array.items[index];
+    size_t size = array->u.array.size - 1;
+    memmove(&array->u.array.items[index], &array->u.array.items[index + 1], (size - index) * sizeof(ja_val*));
+    array->u.array.size = size;
+
+    if (size == 0) {
+        free(array->u.array.items);
+        array->u.array.items = NULL;
+    } else {
+        ja_val **items = realloc(array->u.array.items, size * sizeof(ja_val*));
+        if (items) array->u.array.items = items; // Keeping the bigger buffer is fine
+    }
+
+    if (array->flags & JA_FLAG_INDEXED) __ja_index_changed(array, false);
+    return value;
+}
+
+// Inserts an element before `index` (index = size appends it)
+static bool __ja_arr_insert(ja_val *array, size_t index, ja_val *value) {
+    if (!__ja_block_own_data(array) || !__ja_arr_unpack(array)) return false;
+
+    size_t size = array->u.array.size;
+    ja_val **items = realloc(array->u.array.items, (size + 1) * sizeof(ja_val*));
+    if (!items) {
+        JA_MEM_ERROR();
+        return false;
+    }
+
+    memmove(&items[index + 1], &items[index], (size - index) * sizeof(ja_val*));
+    items[index] = value;
+    array->u.array.items = items;
+    array->u.array.size = size + 1;
+
+    if (array->flags & JA_FLAG_INDEXED) __ja_index_changed(array, index == size);
+    return true;
+}
+
+// Takes a member out of an object without freeing it, handing over its key
+static ja_val *__ja_obj_take(ja_val *object, size_t index, char **key) {
+    if (!__ja_obj_unshape(object) || !__ja_block_own_data(object)) return NULL;
+
+    ja_pair *pairs = object->u.object.pairs;
+    ja_val *value = pairs[index].value_ptr;
+    *key = pairs[index].key;
+
+    size_t size = object->u.object.size - 1;
+    memmove(&pairs[index], &pairs[index + 1], (size - index) * sizeof(ja_pair));
+    object->u.object.size = size;
+
+    if (object->flags & JA_FLAG_KEY_MAP) {
+        __ja_obj_reindex(object); // The buffer keeps its capacity
+    } else if (size == 0) {
+        free(pairs);
+        object->u.object.pairs = NULL;
+    } else {
+        pairs = realloc(pairs, size * sizeof(ja_pair));
+        if (pairs) object->u.object.pairs = pairs;
+    }
+    return value;
+}
+
+// Inserts a member before `index`, taking over the key (released on failure)
+static bool __ja_obj_insert(ja_val *object, size_t index, char *key, ja_val *value) {
+    if (!__ja_obj_unshape(object) || !__ja_block_own_data(object)) {
+        __ja_key_release(key);
+        return false;
+    }
+
+    if (!__ja_obj_reserve(object)) {
+        __ja_key_release(key);
+        return false;
+    }
+
+    size_t size = object->u.object.size;
+    ja_pair *pairs = object->u.object.pairs;
+    memmove(&pairs[index + 1], &pairs[index], (size - index) * sizeof(ja_pair));
+    pairs[index].key = key;
+    pairs[index].value_ptr = value;
+    object->u.object.size = size + 1;
+    __ja_obj_reindex(object);
+    return true;
+}
+
+// Position of the key of a step in an object, its size if it's missing.
+// Tombstones are dropped first, so the positions kept for undoing stay valid.
+static size_t __ja_obj_find_step(ja_val *object, const ja_path_step *step) {
+    __ja_obj_compact(object);
+    const __ja_key *header = __ja_key_header(step->key);
+    return __ja_obj_find(object, step->key, header->hash, header->length);
+}
+
+// Swaps the values held by two nodes, each node keeping its place in its block
+static void __ja_swap_contents(ja_val *a, ja_val *b) {
+    const uint16_t node_flags = JA_FLAG_IN_BLOCK | JA_FLAG_BLOCK_ROOT | JA_FLAG_SNAPSHOT | JA_FLAG_MAPPED;
+
+    // Element nodes of packed arrays and the arrays they point to must not move
+    __ja_element_settle(a);
+    __ja_element_settle(b);
+    __ja_packed_settle(a);
+    __ja_packed_settle(b);
+
+    if (a->type == JA_TYPE_ARRAY) __ja_index_detach(a); // Indexes don't follow their elements elsewhere
+    if (b->type == JA_TYPE_ARRAY) __ja_index_detach(b);
+
+    ja_val swap = *a;
+    a->type = b->type;
+    a->u = b->u;
+    a->flags = (uint16_t)((a->flags & node_flags) | (b->flags & ~node_flags));
+    b->type = swap.type;
+    b->u = swap.u;
+    b->flags = (uint16_t)((b->flags & node_flags) | (swap.flags & ~node_flags));
+}
+
+// Changes made by ja_patch_apply(), undone in reverse order if an operation fails
+typedef enum {
+    __JA_UNDO_INSERTED,     // Element added to an array at `index`
+    __JA_UNDO_REMOVED,      // `value` removed from an array at `index`
+    __JA_UNDO_ADDED_KEY,    // Member `key` added to an object
+    __JA_UNDO_REMOVED_KEY,  // Member `key` with `value` removed from an object at `index`
+    __JA_UNDO_REPLACED,     // `value` replaced in an array at `index`, or in an object at `key`
+    __JA_UNDO_DOCUMENT      // Document replaced, `value` holds what it held before
+} __ja_undo_kind;
+
+typedef struct __ja_undo {
+    __ja_undo_kind kind;
+    ja_val *parent;
+    size_t index;
+    char *key;              // Retained
+    ja_val *value;          // Freed when the patch succeeds, unless `moved`
+    bool moved;             // The value now in place (or `value` for removals) was moved within the document
+} __ja_undo;
+
+typedef struct __ja_patch {
+    ja_val *document;
+    __ja_undo *undo;
+    size_t size;
+    size_t capacity;
+} __ja_patch;
+
+// Makes room for the entries of one operation before it changes anything, so logging can't fail
+static bool __ja_patch_reserve(__ja_patch *patch) {
+    if (patch->size + 2 <= patch->capacity) return true;
+
+    size_t capacity = patch->capacity ? patch->capacity * 2 : 16;
+    __ja_undo *undo = realloc(patch->undo, capacity * sizeof(__ja_undo));
+    if (!undo) {
+        JA_MEM_ERROR();
+        return false;
+    }
+    patch->undo = undo;
+    patch->capacity = capacity;
+    return true;
+}
+
+static inline void __ja_patch_log(__ja_patch *patch, __ja_undo entry) {
+    patch->undo[patch->size++] = entry;
+}
+
+// Puts back what an entry changed
+static void __ja_patch_undo_entry(__ja_patch *patch, __ja_undo *entry) {
+    ja_val *parent = entry->parent;
+    ja_val *current = NULL;
+    char *key = NULL;
+
+    switch (entry->kind) {
+    case __JA_UNDO_INSERTED:
+        current = __ja_arr_take(parent, entry->index);
+        break;
+    case __JA_UNDO_REMOVED:
+        __ja_arr_insert(parent, entry->index, entry->value);
+        entry->value = NULL;
+        break;
+    case __JA_UNDO_ADDED_KEY: {
+        const __ja_key *header = __ja_key_header(entry->key);
+        size_t index = __ja_obj_find(parent, entry->key, header->hash, header->length);
+        if (index < parent->u.object.size) current = __ja_obj_take(parent, index, &key);
+        __ja_key_release(key);
+        break;
+    }
+    case __JA_UNDO_REMOVED_KEY:
+        __ja_obj_insert(parent, entry->index, __ja_key_retain(entry->key), entry->value);
+        entry->value = NULL;
+        break;
+    case __JA_UNDO_REPLACED: {
+        ja_val **slot = NULL;
+        if (parent->type == JA_TYPE_ARRAY) {
+            slot = &parent->u.array.items[entry->index];
+        } else {
+            const __ja_key *header = __ja_key_header(entry->key);
+            size_t index = __ja_obj_find(parent, entry->key, header->hash, header->length);
+            if (index < parent->u.object.size) slot = __ja_obj_slot(parent, index);
+        }
+        if (!slot) break;
+
+        current = *slot;
+        *slot = entry->value;
+        entry->value = NULL;
+        if (parent->type == JA_TYPE_ARRAY && (parent->flags & JA_FLAG_INDEXED)) __ja_index_changed(parent, false);
+        break;
+    }
+    case __JA_UNDO_DOCUMENT:
+        __ja_swap_contents(patch->document, entry->value);
+        current = entry->value;
+        entry->value = NULL;
+        break;
+    }
+
+    if (!entry->moved) ja_free_val(&current); // Moved values are put back by the entry of their removal
+}
+
+// Frees the undo log, rolling the document back first if the patch failed
+static void __ja_patch_end(__ja_patch *patch, bool failed) {
+    for (size_t i = patch->size; i-- > 0;) {
+        __ja_undo *entry = &patch->undo[i];
+        if (failed) {
+            __ja_patch_undo_entry(patch, entry);
+        } else if (!(entry->moved && (entry->kind == __JA_UNDO_REMOVED || entry->kind == __JA_UNDO_REMOVED_KEY))) {
+            ja_free_val(&entry->value);
+        }
+        __ja_key_release(entry->key);
+    }
+    free(patch->undo);
+}
+
+// Adds (or replaces) the value at a path, the "add" operation of RFC 6902
+static bool __ja_patch_add(__ja_patch *patch, ja_path *path, ja_val *value, bool moved) {
+    if (path->size == 0) {
+        __ja_swap_contents(patch->document, value);
+        __ja_patch_log(patch, (__ja_undo){__JA_UNDO_DOCUMENT, NULL, 0, NULL, value, moved});
+        return true;
+    }
+
+    ja_val *parent = __ja_path_walk(path, patch->document, path->size - 1);
+    if (!parent) return false;
+
+    ja_path_step *step = &path->steps[path->size - 1];
+    if (parent->type == JA_TYPE_OBJECT) {
+        size_t index = __ja_obj_find_step(parent, step);
+        if (index < parent->u.object.size) {
+            ja_val **slot = __ja_obj_slot(parent, index);
+            ja_val *old = *slot;
+            *slot = value;
+            __ja_patch_log(patch, (__ja_undo){__JA_UNDO_REPLACED, parent, 0, __ja_key_retain(step->key), old, moved});
+            return true;
+        }
+        if (!__ja_obj_put(parent, __ja_key_retain(step->key), value)) return false;
+        __ja_patch_log(patch, (__ja_undo){__JA_UNDO_ADDED_KEY, parent, 0, __ja_key_retain(step->key), NULL, moved});
+        return true;
+    }
+
+    size_t index = step->index == JA_PATH_END && parent->type == JA_TYPE_ARRAY ? parent->u.array.size : step->index;
+    if (parent->type != JA_TYPE_ARRAY || index > parent->u.array.size) {
+        __ja_path_error(path, path->size - 1, parent);
+        return false;
+    }
+
+    if (!__ja_arr_insert(parent, index, value)) return false;
+    __ja_patch_log(patch, (__ja_undo){__JA_UNDO_INSERTED, parent, index, NULL, NULL, moved});
+    return true;
+}
+
+// Takes the value at a path out of the document, the "remove" operation of RFC 6902
+static ja_val *__ja_patch_remove(__ja_patch *patch, ja_path *path, bool moved) {
+    if (path->size == 0) {
+        JA_ERROR(JA_ERROR_INVALID_PATCH, "The whole document can't be removed.");
+        return NULL;
+    }
+
+    ja_val *parent = __ja_path_walk(path, patch->document, path->size - 1);
+    if (!parent) return NULL;
+
+    ja_path_step *step = &path->steps[path->size - 1];
+    __ja_undo entry = {__JA_UNDO_REMOVED, parent, step->index, NULL, NULL, moved};
+    if (parent->type == JA_TYPE_ARRAY && step->index < parent->u.array.size) {
+        entry.value = __ja_arr_take(parent, step->index);
+    } else if (parent->type == JA_TYPE_OBJECT && (entry.index = __ja_obj_find_step(parent, step)) < parent->u.object.size) {
+        entry.kind = __JA_UNDO_REMOVED_KEY;
+        entry.value = __ja_obj_take(parent, entry.index, &entry.key);
+    } else {
+        __ja_path_error(path, path->size - 1, parent);
+        return NULL;
+    }
+
+    if (entry.value) __ja_patch_log(patch, entry);
+    return entry.value;
+}
+
+// Replaces the value at a path, which must exist
+static bool __ja_patch_replace(__ja_patch *patch, ja_path *path, ja_val *value) {
+    if (path->size == 0) return __ja_patch_add(patch, path, value, false);
+
+    ja_val *parent = __ja_path_walk(path, patch->document, path->size - 1);
+    if (!parent) return false;
+
+    ja_path_step *step = &path->steps[path->size - 1];
+    if (parent->type == JA_TYPE_ARRAY && step->index < parent->u.array.size && !__ja_arr_unpack(parent)) return false;
+
+    ja_val **slot = __ja_path_slot(step, parent);
+    if (!slot) {
+        __ja_path_error(path, path->size - 1, parent);
+        return false;
+    }
+
+    __ja_undo entry = {__JA_UNDO_REPLACED, parent, step->index, NULL, *slot, false};
+    if (parent->type == JA_TYPE_OBJECT) entry.key = __ja_key_retain(step->key);
+    *slot = value;
+    if (parent->type == JA_TYPE_ARRAY && (parent->flags & JA_FLAG_INDEXED)) __ja_index_changed(parent, false);
+    __ja_patch_log(patch, entry);
+    return true;
+}
+
+// String member of an operation, NULL if it's missing or of another type
+static const char *__ja_patch_string(ja_val *operation, const char *key) {
+    ja_val *member = ja_try_get_obj_at(operation, key);
+    return member && member->type == JA_TYPE_STRING ? member->u.string : NULL;
+}
+
+// Applies one operation of a patch, logging what it changed
+static bool __ja_patch_operation(__ja_patch *patch, ja_val *operation) {
+    const char *op = operation->type == JA_TYPE_OBJECT ? __ja_patch_string(operation, "op") : NULL;
+    const char *pointer = op ? __ja_patch_string(operation, "path") : NULL;
+    if (!pointer) {
+        JA_ERROR(JA_ERROR_INVALID_PATCH, "Patch operations need \"op\" and \"path\" strings.");
+        return false;
+    }
+
+    bool needs_value = strcmp(op, "add") == 0 || strcmp(op, "replace") == 0 || strcmp(op, "test") == 0;
+    bool needs_from = strcmp(op, "move") == 0 || strcmp(op, "copy") == 0;
+    ja_val *value = needs_value ? ja_try_get_obj_at(operation, "value") : NULL;
+    const char *from = needs_from ? __ja_patch_string(operation, "from") : NULL;
+    if ((needs_value && !value) || (needs_from && !from) || (!needs_value && !needs_from && strcmp(op, "remove") != 0)) {
+        JA_ERROR(JA_ERROR_INVALID_PATCH, "Invalid \"%s\" operation at %s.", op, pointer);
+        return false;
+    }
+
+    if (!__ja_patch_reserve(patch)) return false;
+
+    ja_path *path = ja_path_compile(pointer);
+    ja_path *from_path = from ? ja_path_compile(from) : NULL;
+    if (!path || (from && !from_path)) {
+        ja_path_free(&path);
+        return false;
+    }
+
+    bool ok = false;
+    if (strcmp(op, "test") == 0) {
+        ja_val *current = __ja_path_walk(path, patch->document, path->size);
+        ok = current && __ja_equal(current, value, false);
+        if (current && !ok) JA_ERROR(JA_ERROR_PATCH_TEST_FAILED, "Value at %s isn't the one tested.", pointer);
+    } else if (strcmp(op, "remove") == 0) {
+        ja_val *removed = __ja_patch_remove(patch, path, false);
+        ok = removed != NULL;
+    } else if (strcmp(op, "move") == 0) {
+        size_t length = strlen(from);
+        if (strcmp(from, pointer) == 0) {
+            ok = __ja_path_walk(from_path, patch->document, from_path->size) != NULL;
+        } else if (strncmp(from, pointer, length) == 0 && pointer[length] == '/') {
+            JA_ERROR(JA_ERROR_INVALID_PATCH, "Can't move %s into its own child %s.", from, pointer);
+        } else {
+            ja_val *moved = __ja_patch_remove(patch, from_path, true);
+            ok = moved && __ja_patch_add(patch, path, moved, true);
+        }
+    } else {
+        ja_val *source = from_path ? __ja_path_walk(from_path, patch->document, from_path->size) : value;
+        ja_val *copy = source ? ja_copy(source) : NULL;
+        ok = copy && (strcmp(op, "replace") == 0 ? __ja_patch_replace(patch, path, copy) : __ja_patch_add(patch, path, copy, false));
+        if (!ok) ja_free_val(&copy);
+    }
+
+    ja_path_free(&path);
+    ja_path_free(&from_path);
+    return ok;
+}
+
+bool ja_patch_apply(ja_val *document, ja_val *patch) {
+    if (!document || !patch) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_patch_apply().");
+        return false;
+    }
+
+    if (!__ja_cow_editable(document, "ja_patch_apply")) return false;
+
+    if (patch->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_INVALID_PATCH, "A patch is an array of operations, not %s.", ja_str_type_of(patch));
+        return false;
+    }
+
+    __ja_patch state = {document, NULL, 0, 0};
+    ja_val scratch;
+    for (size_t i = 0; i < patch->u.array.size; i++) {
+        if (!__ja_patch_operation(&state, __ja_arr_peek(patch, i, &scratch))) {
+            __ja_patch_end(&state, true);
+            __ja_last_error_value.offset = i; // Operation that failed
+            return false;
+        }
+    }
+
+    __ja_patch_end(&state, false);
+    return true;
+}
+
+// State of ja_diff(): the patch being built and the pointer of the values compared
+typedef struct __ja_diff {
+    ja_val *patch;
+    char *pointer;
+    size_t length;
+    size_t capacity;
+    ja_hash_cache cache;    // Hashes of the elements of the arrays compared
+    bool failed;
+} __ja_diff;
+
+// Appends "/token" to the pointer, escaping '~' and '/', and returns the length to restore
+static size_t __ja_diff_push(__ja_diff *diff, const char *token, size_t length) {
+    size_t previous = diff->length;
+    if (diff->length + 2 * length + 2 > diff->capacity) {
+        size_t capacity = (diff->length + 2 * length + 2) * 2;
+        char *pointer = realloc(diff->pointer, capacity);
+        if (!pointer) {
+            JA_MEM_ERROR();
+            diff->failed = true;
+            return previous;
+        }
+        diff->pointer = pointer;
+        diff->capacity = capacity;
+    }
+
+    diff->pointer[diff->length++] = '/';
+    for (size_t i = 0; i < length; i++) {
+        if (token[i] == '~' || token[i] == '/') {
+            diff->pointer[diff->length++] = '~';
+            diff->pointer[diff->length++] = token[i] == '~' ? '0' : '1';
+        } else {
+            diff->pointer[diff->length++] = token[i];
+        }
+    }
+    diff->pointer[diff->length] = '\0';
+    return previous;
+}
+
+static size_t __ja_diff_push_index(__ja_diff *diff, size_t index) {
+    char token[24];
+    int length = snprintf(token, sizeof(token), "%zu", index);
+    return __ja_diff_push(diff, token, (size_t)length);
+}
+
+static void __ja_diff_pop(__ja_diff *diff, size_t length) {
+    diff->length = length;
+    if (diff->pointer) diff->pointer[length] = '\0';
+}
+
+// Appends an operation on the current pointer, with a copy of `value` unless it's NULL
+static void __ja_diff_emit(__ja_diff *diff, const char *op, ja_val *value) {
+    if (diff->failed) return;
+
+    ja_val *operation = ja_new_obj();
+    ja_val *copy = value ? ja_copy(value) : NULL;
+    if (!operation || (value && !copy)) {
+        ja_free_val(&operation);
+        ja_free_val(&copy);
+        diff->failed = true;
+        return;
+    }
+
+    ja_set_obj_at(operation, "op", ja_new_str(op));
+    ja_set_obj_at(operation, "path", ja_new_str(diff->pointer ? diff->pointer : ""));
+    if (copy) ja_set_obj_at(operation, "value", copy);
+    ja_arr_append(diff->patch, operation);
+}
+
+static void __ja_diff_values(__ja_diff *diff, ja_val *from, ja_val *to);
+
+// Members missing from `to` are removed, the others compared, then the new ones added
+static void __ja_diff_objects(__ja_diff *diff, ja_val *from, ja_val *to) {
+    for (size_t i = 0; i < from->u.object.size && !diff->failed; i++) {
+        if (__ja_obj_tombstone(from, i)) continue;
+        const char *key = __ja_obj_key(from, i);
+        const __ja_key *header = __ja_key_header(key);
+        size_t index = __ja_obj_find(to, key, header->hash, header->length);
+
+        size_t previous = __ja_diff_push(diff, key, header->length);
+        if (index < to->u.object.size) __ja_diff_values(diff, *__ja_obj_slot(from, i), *__ja_obj_slot(to, index));
+        else __ja_diff_emit(diff, "remove", NULL);
+        __ja_diff_pop(diff, previous);
+    }
+
+    for (size_t i = 0; i < to->u.object.size && !diff->failed; i++) {
+        if (__ja_obj_tombstone(to, i)) continue;
+        const char *key = __ja_obj_key(to, i);
+        const __ja_key *header = __ja_key_header(key);
+        if (__ja_obj_find(from, key, header->hash, header->length) < from->u.object.size) continue;
+
+        size_t previous = __ja_diff_push(diff, key, header->length);
+        __ja_diff_emit(diff, "add", *__ja_obj_slot(to, i));
+        __ja_diff_pop(diff, previous);
+    }
+}
+
+// Steps of the shortest edit script between two ranges of elements
+typedef enum { __JA_EDIT_KEEP, __JA_EDIT_REMOVE, __JA_EDIT_ADD } __ja_edit;
+
+// Finds the shortest edit script between two sequences of element hashes (Myers, "An O(ND) Difference
+// Algorithm"), writing it to `script`. Returns the amount of steps, or 0 if more than JA_DIFF_MAX_EDITS are
+// needed.
+static size_t __ja_diff_myers(const uint64_t *from, size_t n, const uint64_t *to, size_t m, __ja_edit *script) {
+    ptrdiff_t limit = (ptrdiff_t)(n + m < JA_DIFF_MAX_EDITS ? n + m : JA_DIFF_MAX_EDITS);
+    ptrdiff_t *v = calloc((size_t)(2 * limit + 3), sizeof(ptrdiff_t));
+    ptrdiff_t **trace = calloc((size_t)limit + 1, sizeof(ptrdiff_t*)); // v[-d..d] before each round d
+    if (!v || !trace) {
+        JA_MEM_ERROR();
+        free(v);
+        free(trace);
+        return 0;
+    }
+
+    ptrdiff_t *center = v + limit + 1;
+    ptrdiff_t found = -1;
+    for (ptrdiff_t d = 0; d <= limit && found < 0; d++) {
+        trace[d] = malloc((size_t)(2 * d + 1) * sizeof(ptrdiff_t));
+        if (!trace[d]) {
+            JA_MEM_ERROR();
+            break;
+        }
+        memcpy(trace[d], center - d, (size_t)(2 * d + 1) * sizeof(ptrdiff_t));
+
+        for (ptrdiff_t k = -d; k <= d; k += 2) {
+            ptrdiff_t x = k == -d || (k != d && center[k - 1] < center[k + 1]) ? center[k + 1] : center[k - 1] + 1;
+            ptrdiff_t y = x - k;
+            while (x < (ptrdiff_t)n && y < (ptrdiff_t)m && from[x] == to[y]) x++, y++;
+            center[k] = x;
+            if (x >= (ptrdiff_t)n && y >= (ptrdiff_t)m) {
+                found = d;
+                break;
+            }
+        }
+    }
+
+    size_t steps = 0;
+    if (found >= 0) {
+        // Walks back from the end, writing the script backwards
+        ptrdiff_t x = (ptrdiff_t)n;
+        ptrdiff_t y = (ptrdiff_t)m;
+        for (ptrdiff_t d = found; d > 0; d--) {
+            const ptrdiff_t *previous = trace[d] + d; // Centered on k = 0
+            ptrdiff_t k = x - y;
+            ptrdiff_t previous_k = k == -d || (k != d && previous[k - 1] < previous[k + 1]) ? k + 1 : k - 1;
+            ptrdiff_t previous_x = previous[previous_k];
+            ptrdiff_t previous_y = previous_x - previous_k;
+
+            while (x > previous_x && y > previous_y) {
+                script[steps++] = __JA_EDIT_KEEP;
+                x--, y--;
+            }
+            script[steps++] = x == previous_x ? __JA_EDIT_ADD : __JA_EDIT_REMOVE;
+            x = previous_x;
+            y = previous_y;
+        }
+        while (x > 0 && y > 0) {
+            script[steps++] = __JA_EDIT_KEEP;
+            x--, y--;
+        }
+
+        for (size_t i = 0; i < steps / 2; i++) {
+            __ja_edit swap = script[i];
+            script[i] = script[steps - 1 - i];
+            script[steps - 1 - i] = swap;
+        }
+    }
+
+    for (ptrdiff_t d = 0; d <= limit; d++) free(trace[d]);
+    free(trace);
+    free(v);
+    return steps;
+}
+
+// Hashes elements of an array, equal elements hash alike
+static uint64_t *__ja_diff_hashes(__ja_diff *diff, ja_val *array, size_t start, size_t count) {
+    uint64_t *hashes = malloc((count ? count : 1) * sizeof(uint64_t));
+    if (!hashes) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    ja_val scratch;
+    for (size_t i = 0; i < count; i++) hashes[i] = __ja_hash(__ja_arr_peek(array, start + i, &scratch), &diff->cache);
+    return hashes;
+}
+
+// Elements are matched through the shortest edit script between their hashes. Removals and additions next to
+// each other are paired and compared, so a changed record gives the operations of its changed fields only.
+static void __ja_diff_arrays(__ja_diff *diff, ja_val *from, ja_val *to) {
+    size_t n = from->u.array.size;
+    size_t m = to->u.array.size;
+    ja_val scratch_from;
+    ja_val scratch_to;
+
+    // Common prefix and suffix first, most changes leave the rest of the array alone
+    size_t prefix = 0;
+    while (prefix < n && prefix < m &&
+        __ja_equal(__ja_arr_peek(from, prefix, &scratch_from), __ja_arr_peek(to, prefix, &scratch_to), false)) prefix++;
+    size_t suffix = 0;
+    while (suffix < n - prefix && suffix < m - prefix && __ja_equal(__ja_arr_peek(from, n - 1 - suffix, &scratch_from),
+        __ja_arr_peek(to, m - 1 - suffix, &scratch_to), false)) suffix++;
+
+    size_t from_count = n - prefix - suffix;
+    size_t to_count = m - prefix - suffix;
+    if (from_count == 0 && to_count == 0) return;
+
+    uint64_t *from_hashes = __ja_diff_hashes(diff, from, prefix, from_count);
+    uint64_t *to_hashes = __ja_diff_hashes(diff, to, prefix, to_count);
+    __ja_edit *script = malloc((from_count + to_count) * sizeof(__ja_edit));
+    if (!from_hashes || !to_hashes || !script) {
+        free(from_hashes);
+        free(to_hashes);
+        free(script);
+        diff->failed = true;
+        return;
+    }
+
+    size_t steps = __ja_diff_myers(from_hashes, from_count, to_hashes, to_count, script);
+    if (steps == 0) {
+        // Too many changes for an edit script: elements are compared by position
+        for (size_t i = 0; i < from_count; i++) script[steps++] = __JA_EDIT_REMOVE;
+        for (size_t i = 0; i < to_count; i++) script[steps++] = __JA_EDIT_ADD;
+    }
+
+    // Elements before `position` already match `to`, the ones from there on are still those of `from`
+    size_t position = prefix;
+    size_t from_next = prefix;
+    size_t to_next = prefix;
+    for (size_t i = 0; i < steps && !diff->failed;) {
+        if (script[i] == __JA_EDIT_KEEP) { // Equal hashes, compared again in case they collided
+            size_t previous = __ja_diff_push_index(diff, position++);
+            __ja_diff_values(diff, __ja_arr_peek(from, from_next++, &scratch_from), __ja_arr_peek(to, to_next++, &scratch_to));
+            __ja_diff_pop(diff, previous);
+            i++;
+            continue;
+        }
+
+        size_t removed = 0;
+        size_t added = 0;
+        for (; i < steps && script[i] != __JA_EDIT_KEEP; i++) script[i] == __JA_EDIT_REMOVE ? removed++ : added++;
+
+        size_t paired = removed < added ? removed : added;
+        for (size_t j = 0; j < paired && !diff->failed; j++) {
+            size_t previous = __ja_diff_push_index(diff, position++);
+            __ja_diff_values(diff, __ja_arr_peek(from, from_next++, &scratch_from), __ja_arr_peek(to, to_next++, &scratch_to));
+            __ja_diff_pop(diff, previous);
+        }
+        for (size_t j = paired; j < removed && !diff->failed; j++, from_next++) {
+            size_t previous = __ja_diff_push_index(diff, position);
+            __ja_diff_emit(diff, "remove", NULL);
+            __ja_diff_pop(diff, previous);
+        }
+        for (size_t j = paired; j < added && !diff->failed; j++) {
+            size_t previous = __ja_diff_push_index(diff, position++);
+            __ja_diff_emit(diff, "add", __ja_arr_peek(to, to_next++, &scratch_to));
+            __ja_diff_pop(diff, previous);
+        }
+    }
+
+    free(from_hashes);
+    free(to_hashes);
+    free(script);
+}
+
+static void __ja_diff_values(__ja_diff *diff, ja_val *from, ja_val *to) {
+    if (diff->failed || from == to) return;
+
+    if (from->type == to->type && (from->type == JA_TYPE_OBJECT || from->type == JA_TYPE_ARRAY)) {
+        if (from->type == JA_TYPE_OBJECT) __ja_diff_objects(diff, from, to);
+        else __ja_diff_arrays(diff, from, to);
+        return;
+    }
+
+    if (!__ja_equal(from, to, false)) __ja_diff_emit(diff, "replace", to);
+}
+
+ja_val *ja_diff(ja_val *from, ja_val *to) {
+    if (!from || !to) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_diff().");
+        return NULL;
+    }
+
+    __ja_diff diff = {ja_new_arr(), NULL, 0, 0, {NULL, NULL, 0, 0}, false};
+    if (!diff.patch) return NULL;
+
+    __ja_diff_values(&diff, from, to);
+
+    free(diff.pointer);
+    free(diff.cache.nodes);
+    free(diff.cache.hashes);
+    if (diff.failed) {
+        JA_PROPAGATE_ERROR("ja_diff");
+        ja_free_val(&diff.patch);
+    }
+    return diff.patch;
+}
+
+// Hands over a value of a merge patch: moved out of a consumed patch (leaving NULL behind), shared otherwise
+static ja_val *__ja_merge_take(ja_val **slot, bool consume) {
+    if (!consume || ((*slot)->flags & JA_FLAG_IN_BLOCK)) return __ja_cow_share(*slot);
+
+    ja_val *value = *slot;
+    *slot = NULL;
+    return value;
+}
+
+// Applies the members of a merge patch to an object, recursing into the objects of both
+static bool __ja_merge_members(ja_val *target, ja_val *patch, bool consume) {
+    for (size_t i = 0; i < patch->u.object.size; i++) {
+        if (__ja_obj_tombstone(patch, i)) continue;
+        char *key = __ja_obj_key(patch, i);
+        const __ja_key *header = __ja_key_header(key);
+        ja_val **source = __ja_obj_slot(patch, i);
+        size_t index = __ja_obj_find(target, key, header->hash, header->length);
+        bool found = index < target->u.object.size;
+
+        if ((*source)->type == JA_TYPE_NULL) {
+            if (!found) continue;
+
+            char *removed_key = NULL;
+            ja_val *removed = __ja_obj_remove(target, index, &removed_key);
+            if (!removed) return false;
+            ja_free_val(&removed);
+            __ja_key_release(removed_key);
+            continue;
+        }
+
+        if ((*source)->type == JA_TYPE_OBJECT) {
+            // Its nulls delete members, so it's merged into the member (or a new object) instead of taken
+            ja_val *nested = consume ? __ja_cow_own(source) : *source;
+            ja_val *child = found ? __ja_cow_own(__ja_obj_slot(target, index)) : NULL;
+            if (!nested || (found && !child)) return false;
+
+            if (!child || child->type != JA_TYPE_OBJECT) {
+                ja_val *object = ja_new_obj();
+                if (!object) return false;
+
+                if (found) {
+                    ja_val **slot = __ja_obj_slot(target, index);
+                    ja_free_val(slot);
+                    *slot = object;
+                } else if (!__ja_obj_put(target, __ja_key_retain(key), object)) {
+                    ja_free_val(&object);
+                    return false;
+                }
+                child = object;
+            }
+
+            if (!__ja_merge_members(child, nested, consume)) return false;
+            continue;
+        }
+
+        ja_val *value = __ja_merge_take(source, consume);
+        if (!value) return false;
+
+        if (found) {
+            ja_val **slot = __ja_obj_slot(target, index);
+            ja_free_val(slot);
+            *slot = value;
+        } else if (!__ja_obj_put(target, __ja_key_retain(key), value)) {
+            ja_free_val(&value);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Applies a merge patch to the root of a document, which may change type
+static bool __ja_merge_patch(ja_val *target, ja_val *patch, bool consume) {
+    if (!__ja_cow_editable(target, "ja_merge_patch")) return false;
+
+    bool replaces = patch->type != JA_TYPE_OBJECT;
+
+    if (replaces || target->type != JA_TYPE_OBJECT) {
+        // The target takes the contents of a patch that isn't an object, or starts over as an empty object
+        ja_val *value = !replaces ? ja_new_obj() : consume ? patch : __ja_copy_shallow(patch);
+        if (!value) return false;
+
+        __ja_swap_contents(target, value);
+        if (value != patch) ja_free_val(&value); // A consumed patch now holds the old contents, freed with it
+        if (replaces) return true;
+    }
+    return __ja_merge_members(target, patch, consume);
+}
+
+bool ja_merge_patch(ja_val *target, ja_val *patch) {
+    if (!target || !patch) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_merge_patch().");
+        return false;
+    }
+
+    if (!__ja_merge_patch(target, patch, false)) {
+        JA_PROPAGATE_ERROR("ja_merge_patch");
+        return false;
+    }
+    return true;
+}
+
+bool ja_merge_patch_consume(ja_val *target, ja_val **patch) {
+    if (!target || !patch || !*patch) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_merge_patch_consume().");
+        return false;
+    }
+
+    // Patches in a block, or shared with other trees, can't give their nodes away
+    ja_val *source = *patch;
+    bool movable = !(source->flags & JA_FLAG_IN_BLOCK) && __atomic_load_n(&source->shares, __ATOMIC_ACQUIRE) == 0;
+
+    bool merged = __ja_merge_patch(target, source, movable);
+    ja_free_val(patch);
+    if (!merged) {
+        JA_PROPAGATE_ERROR("ja_merge_patch_consume");
+        return false;
+    }
+    return true;
+}
+
+// Merges the values a member takes in successive layers into a new value, sharing the subtrees set by a
+// single layer. The nulls of the first one are values when it's part of the base document, deletions
+// otherwise; `removed` is set when the member ends up deleted.
+static ja_val *__ja_merge_values(ja_val **values, size_t count, bool document, bool *removed) {
+    *removed = false;
+
+    // Objects merge into each other, anything else replaces what the layers before it set
+    size_t start = count;
+    while (start > 0 && values[start - 1]->type == JA_TYPE_OBJECT) start--;
+
+    if (start == count) {
+        ja_val *last = values[count - 1];
+        *removed = last->type == JA_TYPE_NULL && !(document && count == 1);
+        return *removed ? NULL : __ja_cow_share(last);
+    }
+    if (document && count == 1) return __ja_cow_share(values[0]); // An object of the document nothing patches
+
+    ja_val *result = ja_new_obj();
+    ja_val **gathered = malloc(sizeof(ja_val*) * (count - start));
+    if (!result || !gathered) {
+        JA_MEM_ERROR();
+        ja_free_val(&result);
+        free(gathered);
+        return NULL;
+    }
+
+    // Members come in the order they first appear, each merged across the layers that have it at once
+    for (size_t i = start; i < count; i++) {
+        ja_val *layer = values[i];
+
+        for (size_t j = 0; j < layer->u.object.size; j++) {
+            if (__ja_obj_tombstone(layer, j)) continue;
+            char *key = __ja_obj_key(layer, j);
+            const __ja_key *header = __ja_key_header(key);
+            if (__ja_obj_find(result, key, header->hash, header->length) < result->u.object.size) continue;
+
+            size_t size = 0;
+            gathered[size++] = *__ja_obj_slot(layer, j);
+            for (size_t k = i + 1; k < count; k++) {
+                size_t index = __ja_obj_find(values[k], key, header->hash, header->length);
+                if (index < values[k]->u.object.size) gathered[size++] = *__ja_obj_slot(values[k], index);
+            }
+
+            bool deleted = false;
+            ja_val *child = __ja_merge_values(gathered, size, document && i == 0, &deleted);
+            if (deleted) continue; // Seen again in a later layer, it's deleted again
+
+            if (!child || !__ja_obj_put(result, __ja_key_retain(key), child)) {
+                ja_free_val(&child);
+                ja_free_val(&result);
+                free(gathered);
+                return NULL;
+            }
+        }
+    }
+
+    free(gathered);
+    return result;
+}
+
+ja_val *ja_merge_layers(ja_val **layers, size_t count) {
+    if (!layers || count == 0) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_merge_layers() called without layers.");
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!layers[i]) {
+            JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL layer passed to ja_merge_layers().");
+            return NULL;
+        }
+    }
+
+    bool removed = false;
+    ja_val *result = __ja_merge_values(layers, count, true, &removed);
+    if (removed) return ja_new_null();
+    if (!result) {
+        JA_PROPAGATE_ERROR("ja_merge_layers");
+        return NULL;
+    }
+
+    // A layer set the whole document: share its children, not the layer itself
+    for (size_t i = 0; i < count; i++) {
+        if (result != layers[i]) continue;
+
+        __ja_cow_release(result);
+        result = __ja_copy_shallow(result);
+        if (!result) JA_PROPAGATE_ERROR("ja_merge_layers");
+        break;
+    }
+    return result;
+}
+
+const char *ja_obj_key_at(ja_val *origin, size_t index) {
+    if (!origin) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve key from NULL pointer.");
+        return NULL;
+    }
+
+    if (origin->type != JA_TYPE_OBJECT) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_obj_key_at() in non-object value.");
+        return NULL;
+    }
+
+    if (index >= __ja_obj_live(origin)) { // Indexes count the members left
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Index out of bounds.");
+        return NULL;
+    }
+
+    return __ja_obj_key(origin, __ja_obj_position(origin, index));
+}
+
+ja_val *ja_obj_val_at(ja_val *origin, size_t index) {
+    if (!origin) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve value from NULL pointer.");
+        return NULL;
+    }
+
+    if (origin->type != JA_TYPE_OBJECT) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_obj_val_at() in non-object value.");
+        return NULL;
+    }
+
+    if (index >= __ja_obj_live(origin)) { // Indexes count the members left
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Index out of bounds.");
+        return NULL;
+    }
+
+    return __ja_cow_load(__ja_obj_slot(origin, __ja_obj_position(origin, index)));
+}
+
+// Appends a packable value to a packed array, freeing its node
+static void __ja_packed_append(ja_val *target, ja_val *content_to_add) {
+    size_t size = target->u.array.size;
+    size_t width = __ja_packed_width(target);
+
+    char *data = __ja_packed_realloc(target->u.array.doubles, (size + 1) * width);
+    if (!data) {
+        JA_MEM_ERROR();
+        return;
+    }
+
+    target->u.array.doubles = (double *)data;
+    if (target->flags & JA_FLAG_PACKED_BOOL) target->u.array.bools[size] = content_to_add->u.boolean;
+    else target->u.array.doubles[size] = content_to_add->u.number.as_double;
+    target->u.array.size = size + 1;
+    ja_free_val(&content_to_add);
+}
+
+// Removes an element of a packed array. Empty arrays go back to the plain layout, ready for any value
+static void __ja_packed_remove(ja_val *target, size_t index) {
+    size_t size = target->u.array.size;
+    size_t width = __ja_packed_width(target);
+    char *data = (char *)target->u.array.doubles;
+
+    memmove(data + index * width, data + (index + 1) * width, (size - index - 1) * width);
+    target->u.array.size = size - 1;
+
+    if (size == 1) {
+        __ja_packed_free(data, 0);
+        target->u.array.items = NULL;
+        target->flags &= (uint16_t)~(JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL);
+    }
+}
+
+void ja_arr_append(ja_val *target, ja_val *content_to_add) {
+    if (!target) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_arr_append() called with NULL target.");
+        return;
+    }
+    
+    if (!content_to_add) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_arr_append() called with NULL content_to_add.");
+        return;
+    }
+
+    if (target->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_arr_append() on non-array value.");
+        return;
+    }
+
+    if (!__ja_block_own_data(target) || !__ja_packed_settle(target)) return;
+
+    if (__ja_is_packed(target)) {
+        if (__ja_packable(content_to_add, target->flags & JA_FLAG_PACKED_BOOL)) {
+            __ja_packed_append(target, content_to_add);
+            if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, true);
+            return;
+        }
+        if (!__ja_arr_unpack(target)) return; // Anything else makes it a plain array again
+    }
+
+    size_t new_size = target->u.array.size + 1;
+
+    ja_val **new_items = realloc(target->u.array.items, sizeof(ja_val*) * new_size);
+    if (!new_items) {
+        JA_MEM_ERROR();
+        return;
+    }
+
+    target->u.array.items = new_items;
+    target->u.array.items[target->u.array.size] = content_to_add;
+    target->u.array.size = new_size;
+    if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, true);
+}
+
+void ja_arr_remove_at(ja_val *target, size_t index) {
+    if (!target) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't use ja_arr_remove_at() on NULL pointer.");
+        return;
+    }
+
+    if (target->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_arr_remove_at() on non-array value.");
+        return;
+    }
+
+    if (index >= target->u.array.size) {
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Index out of bounds (index=%zu, size=%zu).", index, target->u.array.size);
+        return;
+    }
+
+    if (!__ja_block_own_data(target) || !__ja_packed_settle(target)) return;
+
+    if (__ja_is_packed(target)) {
+        __ja_packed_remove(target, index);
+        if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, false);
+        return;
+    }
+
+    ja_free_val(&target->u.array.items[index]);
+    target->u.array.items[index] = NULL;
+
+    if (index < target->u.array.size - 1) {
+        memmove(&target->u.array.items[index],
+                &target->u.array.items[index + 1],
+                (target->u.array.size - index - 1) * sizeof(ja_val*));
+    }
+
+    size_t new_size = target->u.array.size - 1;
+
+    if (new_size > 0) {
+        ja_val **new_items = realloc(target->u.array.items, sizeof(ja_val*) * new_size);
+        if (!new_items) {
+            JA_MEM_ERROR();
+            return;
+        }
+        target->u.array.items = new_items;
+    } else {
+        free(target->u.array.items);
+        target->u.array.items = NULL;
+    }
+
+    target->u.array.size = new_size;
+    if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, false);
+}
+
+// Node a detached value can live in on its own: nodes inside the block of a compact copy go away with it
+static ja_val *__ja_own_node(ja_val *value) {
+    if ((value->flags & (JA_FLAG_IN_BLOCK | JA_FLAG_BLOCK_ROOT)) != JA_FLAG_IN_BLOCK) return value;
+
+    ja_val *copy = ja_copy(value);
+    if (!copy) JA_PROPAGATE_ERROR("__ja_own_node");
+    return copy;
+}
+
+ja_val *ja_arr_take_at(ja_val *target, size_t index) {
+    if (!target) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't use ja_arr_take_at() on NULL pointer.");
+        return NULL;
+    }
+
+    if (target->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_arr_take_at() on non-array value.");
+        return NULL;
+    }
+
+    if (index >= target->u.array.size) {
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Index out of bounds (index=%zu, size=%zu).", index, target->u.array.size);
+        return NULL;
+    }
+
+    if (!__ja_block_own_data(target) || !__ja_packed_settle(target)) return NULL;
+
+    if (__ja_is_packed(target)) { // The element gets a node of its own, the others stay packed
+        ja_val *value = __ja_new_generic();
+        if (!value) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+        __ja_packed_get(target, index, value);
+        __ja_packed_remove(target, index);
+        if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, false);
+        return value;
+    }
+
+    ja_val *stored = __ja_cow_own(&target->u.array.items[index]);
+    ja_val *value = stored ? __ja_own_node(stored) : NULL;
+    if (!value) return NULL;
+
+    __ja_arr_take(target, index);
+    if (value != stored) ja_free_val(&stored);
+    return value;
+}
+
+bool ja_arr_extend(ja_val *target, ja_val *source) {
+    if (!target || !source) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_arr_extend().");
+        return false;
+    }
+
+    if (target->type != JA_TYPE_ARRAY || source->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_arr_extend() on non-array values.");
+        return false;
+    }
+
+    size_t size = target->u.array.size;
+    size_t count = source->u.array.size;
+    if (target == source || count == 0) return true;
+
+    if (!__ja_block_own_data(target) || !__ja_block_own_data(source)) return false;
+    if (!__ja_packed_settle(target) || !__ja_packed_settle(source)) return false;
+
+    if (source->flags & JA_FLAG_IN_BLOCK && !__ja_is_packed(source)) {
+        for (size_t i = 0; i < count; i++) {
+            ja_val **item = &source->u.array.items[i];
+            ja_val *value = __ja_own_node(*item);
+            if (!value) return false;
+            if (value == *item) continue;
+            ja_free_val(item);
+            *item = value;
+        }
+    }
+
+    const uint16_t packing = JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL;
+
+    if (size == 0) { // Nothing to keep, the buffer of the source changes hands
+        if (__ja_is_packed(target)) __ja_packed_free(target->u.array.doubles, 0);
+        else free(target->u.array.items);
+        target->u.array.items = source->u.array.items; // Same word as u.array.doubles
+        target->flags = (uint16_t)((target->flags & ~packing) | (source->flags & packing));
+    } else if (__ja_is_packed(target) && (target->flags & packing) == (source->flags & packing)) {
+        size_t width = __ja_packed_width(target);
+        char *data = __ja_packed_realloc(target->u.array.doubles, (size + count) * width);
+        if (!data) {
+            JA_MEM_ERROR();
+            return false;
+        }
+        memcpy(data + size * width, source->u.array.doubles, count * width);
+        target->u.array.doubles = (double *)data;
+        __ja_packed_free(source->u.array.doubles, 0);
+    } else {
+        if (!__ja_arr_unpack(target) || !__ja_arr_unpack(source)) return false;
+
+        ja_val **items = realloc(target->u.array.items, (size + count) * sizeof(ja_val*));
+        if (!items) {
+            JA_MEM_ERROR();
+            return false;
+        }
+        memcpy(&items[size], source->u.array.items, count * sizeof(ja_val*));
+        target->u.array.items = items;
+        free(source->u.array.items);
+    }
+
+    target->u.array.size = size + count;
+    source->u.array.items = NULL;
+    source->u.array.size = 0;
+    source->flags &= (uint16_t)~packing;
+
+    if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, true);
+    if (source->flags & JA_FLAG_INDEXED) __ja_index_changed(source, false);
+    return true;
+}
+
+// Gives the buffer of an array its size after removing elements, going back to the plain layout once empty
+static void __ja_arr_shrink(ja_val *array, size_t size) {
+    if (size == 0) {
+        if (__ja_is_packed(array)) __ja_packed_free(array->u.array.doubles, 0);
+        else free(array->u.array.items);
+        array->u.array.items = NULL;
+        array->flags &= (uint16_t)~(JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL);
+    } else if (__ja_is_packed(array)) {
+        void *data = __ja_packed_realloc(array->u.array.doubles, size * __ja_packed_width(array));
+        if (data) array->u.array.doubles = data; // Keeping the bigger buffer is fine
+    } else {
+        void *buffer = realloc(array->u.array.items, size * sizeof(ja_val*));
+        if (buffer) array->u.array.items = buffer;
+    }
+    array->u.array.size = size;
+}
+
+bool ja_arr_retain_if(ja_val *array, ja_predicate predicate, void *user_data) {
+    if (!array || !predicate) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_arr_retain_if().");
+        return false;
+    }
+
+    if (array->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_arr_retain_if() on non-array value.");
+        return false;
+    }
+
+    if (!__ja_block_own_data(array) || !__ja_packed_settle(array)) return false;
+
+    // Kept elements slide down over the removed ones as they're found, in a single pass
+    size_t size = array->u.array.size;
+    size_t kept = 0;
+
+    if (__ja_is_packed(array)) {
+        size_t width = __ja_packed_width(array);
+        char *data = (char *)array->u.array.doubles;
+        ja_val scratch;
+
+        for (size_t i = 0; i < size; i++) {
+            __ja_packed_get(array, i, &scratch);
+            if (!predicate(&scratch, user_data)) continue;
+            if (kept != i) memcpy(data + kept * width, data + i * width, width);
+            kept++;
+        }
+    } else {
+        ja_val **items = array->u.array.items;
+
+        for (size_t i = 0; i < size; i++) {
+            if (predicate(items[i], user_data)) items[kept++] = items[i];
+            else ja_free_val(&items[i]);
+        }
+    }
+
+    if (kept < size) {
+        __ja_arr_shrink(array, kept);
+        if (array->flags & JA_FLAG_INDEXED) __ja_index_changed(array, false);
+    }
+    return true;
+}
+
+// Replaces a range of elements with new values, moving the elements after it once
+static bool __ja_arr_splice(ja_val *array, size_t index, size_t remove_count, ja_val **values, size_t count, const char *caller) {
+    if (!array || (count > 0 && !values)) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to %s().", caller);
+        return false;
+    }
+
+    if (array->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use %s() on non-array value.", caller);
+        return false;
+    }
+
+    size_t size = array->u.array.size;
+    if (index > size || remove_count > size - index) {
+        JA_ERROR(JA_ERROR_INDEX_OUT_OF_BOUNDS, "Range out of bounds (index=%zu, count=%zu, size=%zu).", index, remove_count, size);
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!values[i]) {
+            JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL value passed to %s().", caller);
+            return false;
+        }
+    }
+
+    if (!__ja_block_own_data(array) || !__ja_packed_settle(array)) return false;
+
+    // Values matching a packed array keep it packed, anything else turns it back into an array of nodes
+    bool packed = __ja_is_packed(array);
+    if (packed) {
+        bool booleans = array->flags & JA_FLAG_PACKED_BOOL;
+        for (size_t i = 0; i < count && packed; i++) packed = __ja_packable(values[i], booleans);
+        if (!packed && !__ja_arr_unpack(array)) return false;
+    }
+
+    size_t new_size = size - remove_count + count;
+    size_t width = packed ? __ja_packed_width(array) : sizeof(ja_val*);
+
+    if (new_size > size) {
+        void *buffer = packed ? __ja_packed_realloc(array->u.array.doubles, new_size * width) :
+            realloc(array->u.array.items, new_size * width);
+        if (!buffer) {
+            JA_MEM_ERROR();
+            return false;
+        }
+        array->u.array.items = buffer;
+    }
+
+    if (!packed) {
+        for (size_t i = index; i < index + remove_count; i++) ja_free_val(&array->u.array.items[i]);
+    }
+
+    char *data = (char *)array->u.array.items;
+    size_t tail = size - index - remove_count;
+    if (tail > 0 && count != remove_count) memmove(data + (index + count) * width, data + (index + remove_count) * width, tail * width);
+
+    for (size_t i = 0; i < count; i++) {
+        ja_val *value = values[i];
+        if (!packed) {
+            array->u.array.items[index + i] = value;
+            continue;
+        }
+        if (array->flags & JA_FLAG_PACKED_BOOL) array->u.array.bools[index + i] = value->u.boolean;
+        else array->u.array.doubles[index + i] = value->u.number.as_double;
+        ja_free_val(&value);
+    }
+
+    if (new_size < size) __ja_arr_shrink(array, new_size);
+    else array->u.array.size = new_size;
+
+    if (array->flags & JA_FLAG_INDEXED) __ja_index_changed(array, remove_count == 0 && index == size);
+    return true;
+}
+
+bool ja_arr_splice(ja_val *array, size_t index, size_t remove_count, ja_val **values, size_t count) {
+    return __ja_arr_splice(array, index, remove_count, values, count, "ja_arr_splice");
+}
+
+bool ja_arr_insert_range(ja_val *array, size_t index, ja_val **values, size_t count) {
+    return __ja_arr_splice(array, index, 0, values, count, "ja_arr_insert_range");
+}
+
+bool ja_arr_concat(ja_val *target, ja_val *source) {
+    if (!target || !source) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_arr_concat().");
+        return false;
+    }
+
+    if (target->type != JA_TYPE_ARRAY || source->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_arr_concat() on non-array values.");
+        return false;
+    }
+
+    size_t size = target->u.array.size;
+    size_t count = source->u.array.size; // Read before target grows, it may be the same array
+    if (count == 0) return true;
+
+    if (!__ja_block_own_data(target) || !__ja_packed_settle(target)) return false;
+
+    const uint16_t packing = JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL;
+
+    if (__ja_is_packed(source) && (size == 0 || (target->flags & packing) == (source->flags & packing))) {
+        size_t width = __ja_packed_width(source);
+        char *data = __ja_packed_realloc(__ja_is_packed(target) ? target->u.array.doubles : NULL, (size + count) * width);
+        if (!data) {
+            JA_MEM_ERROR();
+            return false;
+        }
+        memcpy(data + size * width, target == source ? data : (char *)source->u.array.doubles, count * width);
+        if (!__ja_is_packed(target)) free(target->u.array.items);
+        target->u.array.doubles = (double *)data;
+        target->flags = (uint16_t)((target->flags & ~packing) | (source->flags & packing));
+    } else {
+        if (!__ja_arr_unpack(target)) return false;
+
+        ja_val **items = realloc(target->u.array.items, (size + count) * sizeof(ja_val*));
+        if (!items) {
+            JA_MEM_ERROR();
+            return false;
+        }
+        target->u.array.items = items;
+
+        // Elements are shared copy-on-write, packed ones get nodes of their own
+        for (size_t i = 0; i < count; i++) {
+            ja_val *value = __ja_is_packed(source) ? __ja_new_generic() : __ja_cow_share(source->u.array.items[i]);
+            if (!value) {
+                JA_PROPAGATE_ERROR("ja_arr_concat");
+                while (i-- > 0) ja_free_val(&items[size + i]);
+                return false;
+            }
+            if (__ja_is_packed(source)) __ja_packed_get(source, i, value);
+            items[size + i] = value;
+        }
+    }
+
+    target->u.array.size = size + count;
+    if (target->flags & JA_FLAG_INDEXED) __ja_index_changed(target, true);
+    return true;
+}
+
+// Packs an array if it isn't yet, and checks it holds the kind of element asked for
+static const void *__ja_arr_as_packed(ja_val *array, size_t *size, bool booleans, const char *caller) {
+    static const double empty[1] = {0.0};
+
+    if (!array || !size) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "%s() called with NULL pointer.", caller);
+        return NULL;
+    }
+
+    if (array->type != JA_TYPE_ARRAY) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use %s() on non-array value.", caller);
+        return NULL;
+    }
+
+    *size = array->u.array.size;
+    if (*size == 0) return empty;
+
+    if (!__ja_is_packed(array) && !__ja_arr_pack(array)) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "%s() called on array holding other values.", caller);
+        *size = 0;
+        return NULL;
+    }
+
+    if (booleans != !!(array->flags & JA_FLAG_PACKED_BOOL)) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "%s() called on array of %s.", caller, booleans ? "numbers" : "booleans");
+        *size = 0;
+        return NULL;
+    }
+
+    return array->u.array.doubles;
+}
+
+const double *ja_arr_as_doubles(ja_val *array, size_t *size) {
+    return __ja_arr_as_packed(array, size, false, "ja_arr_as_doubles");
+}
+
+const bool *ja_arr_as_bools(ja_val *array, size_t *size) {
+    return __ja_arr_as_packed(array, size, true, "ja_arr_as_bools");
+}
+
+void ja_obj_remove_at(ja_val *target, const char *key) {
+    if (!target) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_obj_remove_at() called with NULL target.");
+        return;
+    }
+    
+    if (!key) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_obj_remove_at() called with NULL key.");
+        return;
+    }
+    
+    if (target->type != JA_TYPE_OBJECT) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_obj_remove_at() in non-object value.");
+        return;
+    }
+
+    size_t index = __ja_obj_lookup(target, key);
+
+    if (index == target->u.object.size) {
+        char path[JA_ERROR_PATH_SIZE] = "";
+        __ja_error_path_append(path, sizeof(path), key, strlen(key));
+        __ja_set_last_error(JA_ERROR_KEY_NOT_FOUND, path);
+        JA_LOG_WARN("Key not found: %s", key);
+        return;
+    }
+
+    char *removed_key = NULL;
+    ja_val *removed = __ja_obj_remove(target, index, &removed_key);
+    if (!removed) {
+        JA_PROPAGATE_ERROR("ja_obj_remove_at");
+        return;
+    }
+
+    __ja_key_release(removed_key);
+    ja_free_val(&removed);
+}
+
+ja_val *ja_obj_take_at(ja_val *target, const char *key) {
+    if (!target || !key) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_obj_take_at().");
+        return NULL;
+    }
+
+    if (target->type != JA_TYPE_OBJECT) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_obj_take_at() in non-object value.");
+        return NULL;
+    }
+
+    size_t index = __ja_obj_lookup(target, key);
+
+    if (index == target->u.object.size) {
+        char path[JA_ERROR_PATH_SIZE] = "";
+        __ja_error_path_append(path, sizeof(path), key, strlen(key));
+        __ja_set_last_error(JA_ERROR_KEY_NOT_FOUND, path);
+        JA_LOG_WARN("Key not found: %s", key);
+        return NULL;
+    }
+
+    ja_val *stored = __ja_cow_own(__ja_obj_slot(target, index));
+    ja_val *value = stored ? __ja_own_node(stored) : NULL;
+    if (!value) return NULL;
+
+    char *taken_key = NULL;
+    if (!__ja_obj_remove(target, index, &taken_key)) {
+        JA_PROPAGATE_ERROR("ja_obj_take_at");
+        if (value != stored) ja_free_val(&value);
+        return NULL;
+    }
+
+    __ja_key_release(taken_key);
+    if (value != stored) ja_free_val(&stored);
+    return value;
+}
+
+bool ja_obj_merge_move(ja_val *target, ja_val *source) {
+    if (!target || !source) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_obj_merge_move().");
+        return false;
+    }
+
+    if (target->type != JA_TYPE_OBJECT || source->type != JA_TYPE_OBJECT) {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_obj_merge_move() on non-object values.");
+        return false;
+    }
+
+    __ja_obj_compact(source);
+    size_t count = source->u.object.size;
+    if (target == source || count == 0) return true;
+
+    if (source->flags & JA_FLAG_IN_BLOCK) {
+        for (size_t i = 0; i < count; i++) {
+            ja_val **slot = __ja_obj_slot(source, i);
+            ja_val *value = __ja_own_node(*slot);
+            if (!value) return false;
+            if (value == *slot) continue;
+            ja_free_val(slot);
+            *slot = value;
+        }
+    }
+
+    if (!__ja_obj_unshape(target) || !__ja_block_own_data(target)) {
+        JA_PROPAGATE_ERROR("ja_obj_merge_move");
+        return false;
+    }
+
+    if (target->flags & JA_FLAG_KEY_MAP) { // Its pairs already grow geometrically, and the map indexes them
+        for (size_t i = 0; i < count; i++) {
+            ja_val **slot = __ja_obj_slot(source, i);
+            if (!__ja_obj_put(target, __ja_key_retain(__ja_obj_key(source, i)), *slot)) {
+                JA_PROPAGATE_ERROR("ja_obj_merge_move");
+                return false;
+            }
+            *slot = NULL;
+        }
+
+        __ja_free_val(source);
+        return true;
+    }
+
+    size_t reserved = target->u.object.size + count;
+    ja_pair *pairs = realloc(target->u.object.pairs, reserved * sizeof(ja_pair));
+    if (!pairs) {
+        JA_MEM_ERROR();
+        return false;
+    }
+    target->u.object.pairs = pairs;
+
+    for (size_t i = 0; i < count; i++) {
+        char *key = __ja_obj_key(source, i);
+        const __ja_key *header = __ja_key_header(key);
+        ja_val **slot = __ja_obj_slot(source, i);
+        size_t index = __ja_obj_find(target, key, header->hash, header->length);
+
+        if (index < target->u.object.size) {
+            ja_free_val(&pairs[index].value_ptr);
+        } else {
+            pairs[index].key = __ja_key_retain(key);
+            target->u.object.size++;
+        }
+        pairs[index].value_ptr = *slot;
+        *slot = NULL;
+    }
+
+    if (target->u.object.size < reserved) { // Some keys were already there
+        pairs = realloc(pairs, target->u.object.size * sizeof(ja_pair));
+        if (pairs) target->u.object.pairs = pairs; // Keeping the bigger buffer is fine
+    }
+
+    __ja_free_val(source); // Its keys and buffers, the values have moved
+    return true;
+}
+
+ja_val* ja_convert_to(ja_val *target, ja_type new_type) {
+    if (!target) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointer passed to ja_convert_to().");
+        return target;
+    }
+    if (target->type != new_type) {
+        __ja_element_settle(target); // Not every conversion frees the old contents
+        switch (new_type) { 
+        case JA_TYPE_INT:
+        case JA_TYPE_DOUBLE:
+            __ja_convert_to_num(target);
+            break;
+        case JA_TYPE_STRING:
+            __ja_convert_to_str(target);
+            break;
+        case JA_TYPE_BOOL:
+            __ja_convert_to_bool(target);
+            break;
+        case JA_TYPE_ARRAY:
+            __ja_convert_to_arr(target);
+            break;
+        case JA_TYPE_OBJECT:
+            __ja_convert_to_obj(target);
+            break;
+        case JA_TYPE_NULL:
+            __ja_convert_to_null(target);
+            break;
+        default:
+            JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Invalid type conversion.");
+            break;
+        }
+    } else 
+        JA_LOG_INFO("Convertion with no effect: (%s -> %s)", __ja_type_enum_to_str(target->type), __ja_type_enum_to_str(new_type));
+    return target;
+}
+
+void __ja_convert_to_num(ja_val *target) {
+    if (!target) return;
+
+    switch (target->type) {
+    case JA_TYPE_INT: 
+    case JA_TYPE_DOUBLE: 
+        break;
+
+    case JA_TYPE_STRING: {
+        char *end_ptr;
+        double number_value = strtold(target->u.string, &end_ptr);
+
+        if (end_ptr == target->u.string) {
+            JA_ERROR(JA_ERROR_INVALID_NUMBER, "Invalid number string: \"%s\"", target->u.string);
+            return;
+        }
+
+        while (isspace((unsigned char)*end_ptr)) end_ptr++;
+
+        if (*end_ptr != '\0') {
+            JA_ERROR(JA_ERROR_INVALID_NUMBER, "Partial conversion: \"%s\" is not a pure number.", target->u.string);
+            return;
+        }
+
+        if (!(target->flags & JA_FLAG_BLOCK_DATA)) free(target->u.string);
+        target->flags &= ~JA_FLAG_BLOCK_DATA;
+
+        target->u.number.as_int = (int)number_value;
+        target->u.number.as_double = number_value;
+
+        double diff = fabs(number_value - (double)((int)number_value));
+        target->type = (diff < 1e-9) ? JA_TYPE_INT : JA_TYPE_DOUBLE;
+
+        break;
+    }
+
+    case JA_TYPE_BOOL: {
+        target->u.number.as_int = target->u.boolean ? 1 : 0;
+        target->u.number.as_double = target->u.boolean ? 1.0 : 0.0;
+        target->type = JA_TYPE_INT;
+        break;
+    }
+
+    case JA_TYPE_ARRAY:
+    case JA_TYPE_OBJECT: {
+        size_t temp = ja_size_of(target);
+        __ja_free_val(target);
+        target->u.number.as_int = (int) temp;
+        target->u.number.as_double = (double) temp;
+        target->type = JA_TYPE_INT;
+        break;
+    }
+    
+    case JA_TYPE_NULL: {
+        target->u.number.as_int = 0;
+        target->u.number.as_double = 0.0;
+        target->type = JA_TYPE_INT;
+        break;
+    }
+
+    default: {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Invalid type for conversion to number.");
+        break;
+    }
+    }
+}
+
+void __ja_convert_to_str(ja_val *target) {
+    if (!target) return;
+
+    ja_val temp = *target;
+    char* str = NULL;
+
+    switch (temp.type) {
+    case JA_TYPE_INT:
+    case JA_TYPE_DOUBLE:
+        str = ja_stringify(&temp);
+        break;
+    case JA_TYPE_BOOL:
+        str = strdup(temp.u.boolean ? "true" : "false");
+        break;
+    case JA_TYPE_ARRAY:
+    case JA_TYPE_OBJECT:
+        str = ja_stringify(&temp);
+        break;
+    case JA_TYPE_NULL:
+        str = strdup("null");
+        break;
+    case JA_TYPE_STRING:
+        return;
+    default:
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Invalid type for conversion to string.");
+        return;
+    }
+
+    if (!str) return;
+
+    if (target->type == JA_TYPE_STRING && target->u.string)
+        free(target->u.string);
+
+    target->u.string = str;
+    target->type = JA_TYPE_STRING;
+}
+
+void __ja_convert_to_bool(ja_val *target) {
+    if (!target) return;
+
+    switch (target->type) {
+    case JA_TYPE_INT:
+    case JA_TYPE_DOUBLE: {
+        target->u.boolean = target->u.number.as_int != 0;
+        target->type = JA_TYPE_BOOL;
+        break;
+    }
+
+    case JA_TYPE_STRING: {
+        bool temp = (bool)strlen(target->u.string) > 0;
+        __ja_free_val(target);
+        target->u.boolean = temp;
+        target->type = JA_TYPE_BOOL;
+        break;
+    }
+
+    case JA_TYPE_BOOL:
+        break;
+
+    case JA_TYPE_ARRAY:
+    case JA_TYPE_OBJECT: {
+        bool temp = target->u.array.size > 0; // Same word as u.object.size
+        __ja_free_val(target);
+        target->u.boolean = temp;
+        target->type = JA_TYPE_BOOL;
+        break;
+    }
+
+    case JA_TYPE_NULL: {
+        target->u.boolean = false;
+        target->type = JA_TYPE_BOOL;
+        break;
+    }
+
+    default:
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Invalid type for conversion to boolean.");
+        break;
+    }
+}
+
+void __ja_convert_to_arr(ja_val *target) {
+    if (!target) return;
+
+    switch (target->type) {
+    case JA_TYPE_INT:
+    case JA_TYPE_DOUBLE: {
+        ja_val *num_cpy = ja_copy(target);
+        ja_val *new_arr = ja_new_arr();
+        if (!new_arr || !num_cpy) {
+            return;
+        }
+
+        __ja_free_val(target);
+        ja_arr_append(new_arr, num_cpy);
+        target->u.array.items = new_arr->u.array.items;
+        target->u.array.size = new_arr->u.array.size;
+        target->type = JA_TYPE_ARRAY;
+        free(new_arr);
+        return;
+    }
+
+    case JA_TYPE_STRING: {
+        ja_val *str_cpy = ja_copy(target);
+        ja_val *new_arr = ja_new_arr();
+        if (!new_arr || !str_cpy) {
+            JA_MEM_ERROR();
+            return;
+        }
+
+        size_t str_length = strlen(target->u.string);
+        for (size_t i = 0; i < str_length; i++) {
+            char sub_str[2] = {0};
+            sub_str[0] = str_cpy->u.string[i];
+            ja_arr_append(new_arr, ja_new_str(sub_str));
+        }
+
+        __ja_free_val(target);
+        target->u.array.items = new_arr->u.array.items;
+        target->u.array.size = new_arr->u.array.size;
+        target->type = JA_TYPE_ARRAY;
+        free(new_arr);
+        return;
+    }
+
+    case JA_TYPE_BOOL: {
+        ja_val *bool_cpy = ja_copy(target);
+        ja_val *new_arr = ja_new_arr();
+        if (!new_arr || !bool_cpy) {
+            return;
+        }
+
+        __ja_free_val(target);
+        ja_arr_append(new_arr, bool_cpy);
+        target->u.array.items = new_arr->u.array.items;
+        target->u.array.size = new_arr->u.array.size;
+        target->type = JA_TYPE_ARRAY;
+        free(new_arr);
+        return;
+    }
+
+    case JA_TYPE_NULL: {
+        ja_val *new_arr = ja_new_arr();
+        if (!new_arr) {
+            return;
+        }
+
+        __ja_free_val(target);
+        target->u.array.items = new_arr->u.array.items;
+        target->u.array.size = new_arr->u.array.size;
+        target->type = JA_TYPE_ARRAY;
+        free(new_arr);
+        return;
+    }
+
+    case JA_TYPE_ARRAY:
+        break;
+
+    case JA_TYPE_OBJECT: {
+        ja_val *new_arr = ja_new_arr();
+        if (!new_arr) {
+            return;
+        }
+
+        __ja_obj_compact(target);
+        for (size_t i = 0; i < target->u.object.size; i++) {
+            ja_arr_append(new_arr, ja_copy(*__ja_obj_slot(target, i)));
+        }
+
+        __ja_free_val(target);
+        target->u.array.items = new_arr->u.array.items;
+        target->u.array.size = new_arr->u.array.size;
+        target->type = JA_TYPE_ARRAY;
+        free(new_arr);
+        break;
+    }
+
+    default: {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Invalid type for conversion to array.");
+        break;
+    }
+    }
+}
+
+void __ja_convert_to_obj(ja_val *target) {
+    if (!target) return;
+
+    switch (target->type) {
     case JA_TYPE_INT:
+    case JA_TYPE_DOUBLE:
+    case JA_TYPE_STRING:
+    case JA_TYPE_BOOL: {
+        ja_val *new_obj = ja_new_obj();
+        ja_val *var_cpy = ja_copy(target);
+        if (!new_obj || !var_cpy) {
+            return;
+        }
+
+        ja_set_obj_at(new_obj, ja_str_type_of(target), var_cpy);
+        __ja_free_val(target);
+        target->u.object.pairs = new_obj->u.object.pairs;
+        target->u.object.size = new_obj->u.object.size;
+        target->type = JA_TYPE_OBJECT;
+        free(new_obj);
+        break;
+    }
+
+    case JA_TYPE_NULL: {
+        ja_val *new_obj = ja_new_obj();
+        if (!new_obj) {
+            return;
+        }
+
+        __ja_free_val(target);
+        target->u.object.pairs = new_obj->u.object.pairs;
+        target->u.object.size = new_obj->u.object.size;
+        target->type = JA_TYPE_OBJECT;
+        free(new_obj);
+        break;
+    }
+
+    case JA_TYPE_ARRAY: {
+        ja_val *new_obj = ja_new_obj();
+        ja_val *arr_cpy = ja_copy(target);
+        if (!new_obj || !arr_cpy) {
+            return;
+        }
+
+        for (size_t i = 0; i < target->u.array.size; i++) {
+            char idx_buffer[32];
+            sprintf(idx_buffer, "%zu", i);
+            ja_set_obj_at(new_obj, idx_buffer, ja_copy(ja_get_arr_at(target, i)));
+        }
+        
+        __ja_free_val(target);
+        target->u.object.pairs = new_obj->u.object.pairs;
+        target->u.object.size = new_obj->u.object.size;
+        target->flags |= new_obj->flags & JA_FLAG_KEY_MAP; // Big arrays give a key map, kept in front of the pairs
+        target->type = JA_TYPE_OBJECT;
+        free(new_obj);
+        break;
+    }
+
+    case JA_TYPE_OBJECT:
+        break;
+
+    default: {
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Invalid type for conversion to array.");
+        break;
+    }
+    }
+}
+
+void __ja_convert_to_null(ja_val *target) {
+    if (!target) return;
+        
+    __ja_free_val(target);
+    memset(&target->u, 0, sizeof(target->u));
+
+    target->type = JA_TYPE_NULL;
+}
+
+char* ja_stringify(ja_val* value) {
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL value. Can't convert to string.");
+        return NULL;
+    }
+
+    switch (value->type) {
+    case JA_TYPE_INT: {
+        int needed = snprintf(NULL, 0, "%d", value->u.number.as_int);
+        char* str = malloc(needed + 1);
+        if (!str) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+        snprintf(str, needed + 1, "%d", value->u.number.as_int);
+        return str;
+    }
+
     case JA_TYPE_DOUBLE: {
-        ja_val *num_cpy = ja_copy(target);
-        ja_val *new_arr = ja_new_arr();
-        if (!new_arr || !num_cpy) {
+        int needed;
+        char* str;
+        double val = value->u.number.as_double;
+
+        if (fabs(val - round(val)) < 1e-12) {
+            needed = snprintf(NULL, 0, "%.0f", val);
+            str = malloc(needed + 1);
+            if (!str) { JA_MEM_ERROR(); return NULL; }
+            snprintf(str, needed + 1, "%.0f", val);
+        } else {
+            needed = snprintf(NULL, 0, "%.15g", val);
+            str = malloc(needed + 1);
+            if (!str) { JA_MEM_ERROR(); return NULL; }
+            snprintf(str, needed + 1, "%.15g", val);
+        }
+        return str;
+    }
+
+    case JA_TYPE_STRING: {
+        if (!value->u.string) return strdup("\"\"");
+        
+        const char *src = value->u.string;
+        size_t len = strlen(src);
+        size_t total = len+3;
+
+        char *out = malloc(total);
+        if (!out) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+
+        out[0] = '"';
+        memcpy(out + 1, src, len);
+        out[len + 1] = '"';
+        out[len + 2] = '\0';
+
+        return out;
+    }
+
+    case JA_TYPE_BOOL: {
+        return strdup(value->u.boolean ? "true" : "false");
+    }
+
+    case JA_TYPE_ARRAY: {
+        if (value->u.array.size == 0) return strdup("[]");
+
+        char** elements = malloc(value->u.array.size * sizeof(char*));
+        if (!elements) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+
+        size_t total_length = 2;
+        ja_val scratch;
+        for (size_t i = 0; i < value->u.array.size; i++) {
+            elements[i] = ja_stringify(__ja_arr_peek(value, i, &scratch));
+            total_length += strlen(elements[i]) + 1;
+        }
+
+        char* str = malloc(total_length * sizeof(char));
+        if (!str) {
+            JA_MEM_ERROR();
+            for (size_t i = 0; i < value->u.array.size; i++) free(elements[i]);
+            free(elements); 
+            return NULL;
+        }
+
+        char* ptr = str;
+        *ptr++ = '[';
+
+        for (size_t i = 0; i < value->u.array.size; i++) {
+            size_t len = strlen(elements[i]);
+            memcpy(ptr, elements[i], len);
+            ptr += len;
+            if (i < value->u.array.size - 1) {
+                *ptr++ = ',';
+            }
+            free(elements[i]);
+        }
+
+        *ptr++ = ']';
+        *ptr = '\0';
+        
+        free(elements);
+        return str;
+    }
+
+    case JA_TYPE_OBJECT: {
+        size_t size = __ja_obj_live(value);
+        if (size == 0) return strdup("{}");
+
+        char** pairs = malloc(size * sizeof(char*));
+        if (!pairs) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+
+        size_t total_length = 2;
+        size_t count = 0;
+        for (size_t i = 0; i < value->u.object.size; i++) {
+            if (__ja_obj_tombstone(value, i)) continue;
+
+            const char *key = __ja_obj_key(value, i);
+            char* value_json = ja_stringify(*__ja_obj_slot(value, i));
+            if (!value_json) {
+                for (size_t k = 0; k < count; k++) free(pairs[k]);
+                free(pairs);
+                return NULL;
+            }
+
+            size_t key_len = strlen(key);
+            size_t val_len = strlen(value_json);
+
+            pairs[count] = malloc(key_len + val_len + 4);
+            if (!pairs[count]) {
+                JA_MEM_ERROR();
+                free(value_json);
+                for (size_t k = 0; k < count; k++) free(pairs[k]);
+                free(pairs);
+                return NULL;
+            }
+
+            sprintf(pairs[count], "\"%s\":%s", key, value_json);
+            total_length += strlen(pairs[count++]) + 1; // +1 for comma
+            free(value_json);
+        }
+
+        char* str = malloc(total_length);
+        if (!str) {
+            JA_MEM_ERROR();
+            for (size_t i = 0; i < size; i++) free(pairs[i]);
+            free(pairs);
+            return NULL;
+        }
+
+        char* ptr = str;
+        *ptr++ = '{';
+
+        for (size_t i = 0; i < size; i++) {
+            size_t len = strlen(pairs[i]);
+            memcpy(ptr, pairs[i], len);
+            ptr += len;
+            if (i < size - 1) {
+                *ptr++ = ',';
+            }
+            free(pairs[i]);
+        }
+
+        *ptr++ = '}';
+        *ptr = '\0';
+
+        free(pairs);
+        return str;
+    }
+
+    case JA_TYPE_NULL:
+        return strdup("null");
+
+    default:
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't retrieve string from this type.");
+        return NULL;
+    }
+}
+
+void ja_print(ja_val* value) {
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL value. Can't print.");
+        return;
+    }
+
+    char* str = ja_stringify(value);
+    if (!str) {
+        JA_PROPAGATE_ERROR("ja_print");
+        return;
+    }
+
+    fprintf(stdout, "%s\n", str);
+    free(str);
+}
+
+ja_val *ja_parse(const char *json_str) {
+    if (!json_str) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL string passed to ja_parse().");
+        return NULL;
+    }
+    ja_error_code previous_code = __ja_last_error_value.code;
+    __ja_last_error_value.code = JA_ERROR_NONE; // Tells memory errors of this call apart
+
+    __ja_parse_scope scope = { .end = json_str + strlen(json_str) };
+    __ja_parse_scope *previous = __ja_intern_begin(&scope);
+    ja_val *value = __ja_parse(json_str, NULL);
+    __ja_intern_end(&scope, previous);
+
+    if (!value) {
+        __ja_locate_parse_error(json_str);
+        JA_PROPAGATE_ERROR("ja_parse");
+        return NULL;
+    }
+
+    __ja_last_error_value.code = previous_code;
+    return value;
+}
+
+ja_val *ja_parse_parallel(const char *json_str, int thread_count) {
+    if (!json_str) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL string passed to ja_parse_parallel().");
+        return NULL;
+    }
+    ja_error_code previous_code = __ja_last_error_value.code;
+    __ja_last_error_value.code = JA_ERROR_NONE; // Tells memory errors of this call apart
+
+    __ja_parse_scope scope = { .end = json_str + strlen(json_str) };
+    __ja_parse_scope *previous = __ja_intern_begin(&scope);
+    ja_val *value = __ja_parse_parallel(json_str, NULL, thread_count);
+    __ja_intern_end(&scope, previous);
+
+    if (!value) {
+        __ja_locate_parse_error(json_str);
+        JA_PROPAGATE_ERROR("ja_parse_parallel");
+        return NULL;
+    }
+
+    __ja_last_error_value.code = previous_code;
+    return value;
+}
+
+bool ja_validate(const char *json_str, size_t length, ja_error *error) {
+    if (!json_str) {
+        __ja_set_error(error, "", "", JA_ERROR_UNEXPECTED_END, "NULL input");
+        return false;
+    }
+
+    enum { EXPECT_VALUE, EXPECT_KEY, AFTER_VALUE } state = EXPECT_VALUE;
+
+    const char *p = json_str;
+    const char *end = json_str + length;
+    unsigned char in_object[(JA_MAX_DEPTH + 7) / 8]; // One bit per open container, set for objects
+    size_t depth = 0;
+    ja_error_code code = JA_ERROR_NONE;
+    const char *reason = NULL;
+
+    for (;;) {
+        p = __ja_skip_json_whitespace(p, end);
+
+        if (state == AFTER_VALUE && depth == 0) {
+            if (p != end) {
+                code = JA_ERROR_TRAILING_CONTENT;
+                reason = "Unexpected content after the value";
+                break;
+            }
+            if (error) *error = (ja_error){ JA_ERROR_NONE, 0, 0, 0, NULL, "" };
+            return true;
+        }
+
+        if (p == end) {
+            code = JA_ERROR_UNEXPECTED_END;
+            reason = length == 0 ? "Empty input" : "Unexpected end of input";
+            break;
+        }
+
+        if (state == EXPECT_KEY) {
+            if (*p != '"') {
+                code = JA_ERROR_UNEXPECTED_CHARACTER;
+                reason = "Expected a string as object key";
+                break;
+            }
+            if ((code = __ja_validate_string(&p, end, &reason)) != JA_ERROR_NONE) break;
+
+            p = __ja_skip_json_whitespace(p, end);
+            if (p == end || *p != ':') {
+                code = p == end ? JA_ERROR_UNEXPECTED_END : JA_ERROR_UNEXPECTED_CHARACTER;
+                reason = "Expected ':' after object key";
+                break;
+            }
+            p++;
+            state = EXPECT_VALUE;
+            continue;
+        }
+
+        if (state == AFTER_VALUE) {
+            bool object = in_object[(depth - 1) / 8] & (1u << ((depth - 1) % 8));
+            if (*p == ',') {
+                p++;
+                state = object ? EXPECT_KEY : EXPECT_VALUE;
+            } else if (*p == (object ? '}' : ']')) {
+                p++;
+                depth--;
+            } else {
+                code = JA_ERROR_UNEXPECTED_CHARACTER;
+                reason = object ? "Expected ',' or '}' after object value" : "Expected ',' or ']' after array element";
+                break;
+            }
+            continue;
+        }
+
+        switch (*p) {
+        case '{':
+        case '[': {
+            if (depth == JA_MAX_DEPTH) {
+                code = JA_ERROR_DEPTH_LIMIT;
+                reason = "Too many nested arrays and objects";
+                break;
+            }
+
+            bool object = *p == '{';
+            if (object) in_object[depth / 8] |= (unsigned char)(1u << (depth % 8));
+            else in_object[depth / 8] &= (unsigned char)~(1u << (depth % 8));
+            depth++;
+
+            p = __ja_skip_json_whitespace(p + 1, end);
+            if (p < end && *p == (object ? '}' : ']')) {
+                p++;
+                depth--;
+                state = AFTER_VALUE;
+            } else {
+                state = object ? EXPECT_KEY : EXPECT_VALUE;
+            }
+            continue;
+        }
+        case '"':
+            code = __ja_validate_string(&p, end, &reason);
+            break;
+        case 't':
+        case 'f':
+        case 'n': {
+            const char *literal = *p == 't' ? "true" : *p == 'f' ? "false" : "null";
+            size_t literal_length = strlen(literal);
+
+            for (size_t i = 0; i < literal_length; i++, p++) {
+                if (p == end) {
+                    code = JA_ERROR_UNEXPECTED_END;
+                    reason = "Unexpected end of input";
+                    break;
+                }
+                if (*p != literal[i]) {
+                    code = JA_ERROR_INVALID_LITERAL;
+                    reason = "Invalid literal, expected true, false or null";
+                    break;
+                }
+            }
+            break;
+        }
+        default:
+            if (*p == '-' || isdigit((unsigned char)*p)) {
+                code = __ja_validate_number(&p, end, &reason);
+            } else {
+                code = JA_ERROR_UNEXPECTED_CHARACTER;
+                reason = "Expected a value";
+            }
+            break;
+        }
+
+        if (code != JA_ERROR_NONE) break;
+        state = AFTER_VALUE;
+    }
+
+    __ja_set_error(error, json_str, p, code, reason);
+    return false;
+}
+
+ja_val *__ja_parse(const char *json_str, int *chars_consumed) {
+    if (!json_str) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't parse NULL string.");
+        return NULL;
+    }
+
+    if (*json_str == '\0') {
+        JA_LOG_ERROR("Empty string.");
+        return NULL;
+    }
+
+    __ja_jump_whitespaces(&json_str, chars_consumed);
+
+    switch (*json_str) {
+    case '{':
+        return __ja_parse_object(json_str, chars_consumed);
+    case '[':
+        return __ja_parse_array(json_str, chars_consumed);
+    case '"':
+        return __ja_parse_string(json_str, chars_consumed);
+    case 't':
+    case 'f':
+        return __ja_parse_bool(json_str, chars_consumed);
+    case 'n':
+        return __ja_parse_null(json_str, chars_consumed);
+    default:
+        if (isdigit(*json_str) || *json_str == '-') {
+            return __ja_parse_number(json_str, chars_consumed);
+        } else {
+            JA_LOG_ERROR("Invalid character: %c", *json_str);
+            return NULL;
+        }
+    }
+}
+
+ja_val *__ja_parse_number(const char *json_str, int *chars_consumed) {
+    double number_value;
+    if (!__ja_parse_double(json_str, chars_consumed, &number_value)) return NULL;
+
+    return ja_new_num(number_value);
+}
+
+bool __ja_parse_double(const char *json_str, int *chars_consumed, double *number) {
+    const char *p = json_str;
+    int dots_count = 0, e_count = 0;
+
+    if (*p == '-' || *p == '+') {
+        p++;
+        if (chars_consumed) (*chars_consumed)++;
+    }
+
+    while (*p && (isdigit((unsigned char)*p) || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) {
+        if (*p == '.') {
+            dots_count++;
+            if (dots_count > 1) {
+                JA_LOG_ERROR("Multiple decimal points in number.");
+                return false;
+            }
+        } else if (*p == 'e' || *p == 'E') {
+            e_count++;
+            if (e_count > 1) {
+                JA_LOG_ERROR("Multiple exponent indicators in number.");
+                return false;
+            }
+        }
+        p++;
+        if (chars_consumed) (*chars_consumed)++;
+    }
+
+    char *end_ptr;
+    *number = strtold(json_str, &end_ptr);
+
+    if (end_ptr == json_str) {
+        JA_LOG_ERROR("Error while parsing number.");
+        return false;
+    }
+
+    return true;
+}
+
+ja_val *__ja_parse_string(const char *json_str, int *chars_consumed) {
+    const char *end = __ja_string_end(json_str, __ja_parse_end());
+    if (!end) {
+        JA_LOG_ERROR("Unmatched quotes in string.");
+        return NULL;
+    }
+
+    size_t length = (size_t)(end - json_str) - 1;
+    char *string = malloc(length + 1);
+    if (!string) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    memcpy(string, json_str + 1, length);
+    string[length] = '\0';
+
+    ja_val *jav = __ja_new_generic();
+    if (!jav) {
+        free(string);
+        return NULL;
+    }
+    jav->type = JA_TYPE_STRING;
+    jav->u.string = string; // Takes the buffer instead of copying it again
+
+    if (chars_consumed) *chars_consumed += (int)(end - json_str) + 1;
+    return jav;
+}
+
+const char *__ja_string_end(const char *json_str, const char *end) {
+    const char *p = json_str + 1; // Skip the opening quote
+
+    for (;;) {
+        if (end && p < end) p = __ja_string_scan(p, end);
+        p = __ja_string_scan(p, NULL); // Past `end`, only up to the null terminator
+
+        switch (*p) {
+        case '"':
+            return p;
+        case '\0':
+            return NULL;
+        case '\\':
+            p++;
+            if (*p == 'u') {
+                p++;
+                for (int i = 0; i < 4 && *p; i++, p++);
+            } else if (*p) {
+                p++;
+            }
+            break;
+        default:
+            p++; // Control characters and UTF-8 are kept as they are by the parser
+            break;
+        }
+    }
+}
+
+// Characters that stop __ja_string_scan()
+#define __JA_STRING_STOP(c) ((c) == '"' || (c) == '\\' || (unsigned char)(c) < 0x20 || (unsigned char)(c) >= 0x80)
+
+const char *__ja_string_scan(const char *p, const char *end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+
+    // Signed comparison: bytes below 0x20 and non-ASCII bytes (negative) are both "less than space"
+    #define __JA_STRING_STOP_MASK(chunk) _mm_movemask_epi8(_mm_or_si128( \
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), \
+        _mm_cmplt_epi8(chunk, space)))
+
+    // Null-terminated text has no known end, the blocks are only read when they fit before `end`
+    while (end && end - p >= 16) {
+        int mask = __JA_STRING_STOP_MASK(_mm_loadu_si128((const __m128i *)(const void *)p));
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+
+    #undef __JA_STRING_STOP_MASK
+#endif
+
+    while ((!end || p < end) && !__JA_STRING_STOP(*p)) p++;
+    return p;
+}
+
+char *__ja_parse_key(const char *json_str, int *chars_consumed) {
+    const char *end = __ja_string_end(json_str, __ja_parse_end());
+    if (!end) {
+        JA_LOG_ERROR("Unmatched quotes in string.");
+        return NULL;
+    }
+
+    char *key = __ja_key_make(json_str + 1, (size_t)(end - json_str) - 1);
+    if (!key) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    if (chars_consumed) *chars_consumed += (int)(end - json_str) + 1;
+    return key;
+}
+
+ja_val *__ja_parse_bool(const char *json_str, int *chars_consumed) {
+    if (strncmp(json_str, "true", 4) == 0) {
+        if (chars_consumed) (*chars_consumed) += 4;
+        return ja_new_bool(true);
+    } else if (strncmp(json_str, "false", 5) == 0) {
+        if (chars_consumed) (*chars_consumed) += 5;
+        return ja_new_bool(false);
+    }
+    JA_LOG_ERROR("Invalid boolean value.");
+    return NULL;
+}
+
+// Parses an element straight into the buffer of an array packed so far (of `capacity` elements). `stored` is
+// false when the element doesn't belong there, to be parsed as a node instead
+static bool __ja_parse_packed(ja_val *array, const char *json_str, int *chars_consumed, size_t *capacity, bool *stored) {
+    bool booleans = *json_str == 't' || *json_str == 'f';
+    *stored = false;
+
+    if (!booleans && *json_str != '-' && !isdigit((unsigned char)*json_str)) return true;
+    if (array->u.array.size > 0 && (!__ja_is_packed(array) || booleans != !!(array->flags & JA_FLAG_PACKED_BOOL))) {
+        return true;
+    }
+
+    double number = 0.0;
+    if (booleans) {
+        if (strncmp(json_str, "true", 4) == 0) {
+            number = 1.0;
+            *chars_consumed += 4;
+        } else if (strncmp(json_str, "false", 5) == 0) {
+            *chars_consumed += 5;
+        } else {
+            JA_LOG_ERROR("Invalid boolean value.");
+            return false;
+        }
+    } else if (!__ja_parse_double(json_str, chars_consumed, &number)) {
+        return false;
+    }
+
+    size_t size = array->u.array.size;
+    if (size == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 8;
+        void *data = __ja_packed_realloc(array->u.array.doubles, new_capacity * (booleans ? sizeof(bool) : sizeof(double)));
+        if (!data) {
+            JA_MEM_ERROR();
+            return false;
+        }
+        array->u.array.doubles = data;
+        *capacity = new_capacity;
+    }
+
+    if (booleans) array->u.array.bools[size] = number != 0.0;
+    else array->u.array.doubles[size] = number;
+    array->u.array.size = size + 1;
+    array->flags |= booleans ? JA_FLAG_PACKED_BOOL : JA_FLAG_PACKED;
+    *stored = true;
+    return true;
+}
+
+ja_val *__ja_parse_array(const char *json_str, int *chars_consumed) {
+    ja_val *jav = ja_new_arr();
+    if (!jav) return NULL;
+
+    size_t capacity = 0; // Of the packed buffer, while every element is a number (or every one a boolean)
+
+    json_str++;
+    if (chars_consumed) (*chars_consumed)++; // Count the '['
+
+    while (*json_str) {
+        __ja_jump_whitespaces(&json_str, chars_consumed);
+
+        if (*json_str == ']') {
+            json_str++;
+            if (chars_consumed) (*chars_consumed)++;
+            if (__ja_is_packed(jav) && capacity > jav->u.array.size) {
+                void *data = __ja_packed_realloc(jav->u.array.doubles, jav->u.array.size * __ja_packed_width(jav));
+                if (data) jav->u.array.doubles = data;
+            }
+            return jav;
+        }
+
+        int inner_chars_consumed = 0;
+        bool stored = false;
+        if (!__ja_parse_packed(jav, json_str, &inner_chars_consumed, &capacity, &stored)) {
+            ja_free_val(&jav);
+            return NULL;
+        }
+
+        if (!stored) {
+            if (!__ja_arr_unpack(jav)) {
+                ja_free_val(&jav);
+                return NULL;
+            }
+
+            ja_val *value = __ja_parse(json_str, &inner_chars_consumed);
+            if (!value) {
+                ja_free_val(&jav);
+                return NULL;
+            }
+            ja_arr_append(jav, value);
+        }
+
+        json_str += inner_chars_consumed;
+        if (chars_consumed) (*chars_consumed) += inner_chars_consumed;
+
+        __ja_jump_whitespaces(&json_str, chars_consumed);
+
+        if (*json_str == ',') {
+            json_str++;
+            if (chars_consumed) (*chars_consumed)++; // Count the ','
+        } else if (*json_str != ']') {
+            JA_LOG_ERROR("Invalid character in array: %c", *json_str);
+            ja_free_val(&jav);
+            return NULL;
+        }
+    } 
+
+    JA_LOG_ERROR("Unmatched brackets in array.");
+    ja_free_val(&jav);
+    return NULL;
+}
+
+ja_val *__ja_parse_object(const char *json_str, int *chars_consumed) {
+    ja_val *jav = ja_new_obj();
+    if (!jav) return NULL;
+
+    json_str++; // Skip '{'
+    if (chars_consumed) (*chars_consumed)++;
+
+    while (*json_str) {
+        __ja_jump_whitespaces(&json_str, chars_consumed);
+
+        if (*json_str == '}') {
+            json_str++;
+            if (chars_consumed) (*chars_consumed)++;
+            __ja_obj_shape(jav);
+            return jav;
+        }
+
+        int inner_chars_consumed = 0;
+        if (*json_str != '"') {
+            if (*json_str == '\0')
+                JA_LOG_ERROR("Unexpected end of file.");
+            else
+                JA_LOG_ERROR("Invalid character in object key: '%c'", *json_str);
+            ja_free_val(&jav);
+            return NULL;
+        }
+
+        char *key = __ja_parse_key(json_str, &inner_chars_consumed);
+        if (!key) {
+            ja_free_val(&jav);
+            return NULL;
+        }
+
+        json_str += inner_chars_consumed;
+        if (chars_consumed) (*chars_consumed) += inner_chars_consumed;
+
+        __ja_jump_whitespaces(&json_str, chars_consumed);
+
+        if (*json_str != ':') {
+            JA_LOG_ERROR("Missing colon after key: %s", key);
+            ja_free_val(&jav);
+            __ja_key_release(key);
+            return NULL;
+        }
+
+        json_str++;
+        if (chars_consumed) (*chars_consumed)++;
+        __ja_jump_whitespaces(&json_str, chars_consumed);
+
+        int value_chars_consumed = 0;
+        ja_val *value = __ja_parse(json_str, &value_chars_consumed);
+        if (!value) {
+            ja_free_val(&jav);
+            __ja_key_release(key);
+            return NULL;
+        }
+
+        json_str += value_chars_consumed;
+        if (chars_consumed) (*chars_consumed) += value_chars_consumed;
+        __ja_jump_whitespaces(&json_str, chars_consumed);
+
+        if (*json_str == ',') {
+            json_str++;
+            if (chars_consumed) (*chars_consumed)++;
+        } else if (*json_str != '}') {
+            JA_LOG_ERROR("Invalid character in object: '%c'", *json_str);
+            ja_free_val(&jav);
+            __ja_key_release(key);
+            ja_free_val(&value);
+            return NULL;
+        }
+
+        if (!__ja_obj_put(jav, key, value)) {
+            ja_free_val(&jav);
+            ja_free_val(&value);
+            return NULL;
+        }
+    }
+
+    JA_LOG_ERROR("Unmatched brackets in object.");
+    ja_free_val(&jav);
+    return NULL;
+}
+
+ja_val *__ja_parse_null(const char *json_str, int *chars_consumed) {
+    if (strncmp(json_str, "null", 4) == 0) {
+        if (chars_consumed) (*chars_consumed) += 4;
+        return ja_new_null();
+    }
+    JA_LOG_ERROR("Invalid null value.");
+    return NULL;
+}
+
+const char *__ja_skip_json_whitespace(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    return p;
+}
+
+long __ja_hex4(const char *p, const char *end) {
+    if (end - p < 4) return -1;
+
+    long value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+size_t __ja_utf8_sequence(const unsigned char *p, const unsigned char *end) {
+    size_t length;
+    uint32_t code_point, minimum;
+
+    if (p[0] >= 0xC2 && p[0] <= 0xDF) {
+        length = 2; code_point = p[0] & 0x1F; minimum = 0x80;
+    } else if (p[0] >= 0xE0 && p[0] <= 0xEF) {
+        length = 3; code_point = p[0] & 0x0F; minimum = 0x800;
+    } else if (p[0] >= 0xF0 && p[0] <= 0xF4) {
+        length = 4; code_point = p[0] & 0x07; minimum = 0x10000;
+    } else {
+        return 0;
+    }
+
+    if ((size_t)(end - p) < length) return 0;
+
+    for (size_t i = 1; i < length; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 0;
+        code_point = (code_point << 6) | (p[i] & 0x3F);
+    }
+
+    if (code_point < minimum || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) return 0;
+    return length;
+}
+
+ja_error_code __ja_validate_string(const char **p, const char *end, const char **reason) {
+    const char *s = *p + 1; // Skip the opening quote
+
+    for (;;) {
+        s = __ja_string_scan(s, end);
+        if (s == end) {
+            *p = s;
+            *reason = "Unterminated string";
+            return JA_ERROR_UNEXPECTED_END;
+        }
+
+        unsigned char c = (unsigned char)*s;
+
+        if (c == '"') {
+            *p = s + 1;
+            return JA_ERROR_NONE;
+        }
+
+        if (c == '\\') {
+            if (end - s < 2) {
+                *p = end;
+                *reason = "Unterminated string";
+                return JA_ERROR_UNEXPECTED_END;
+            }
+
+            switch (s[1]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                s += 2;
+                continue;
+            case 'u': {
+                long code_unit = __ja_hex4(s + 2, end);
+                if (code_unit < 0) {
+                    *p = s;
+                    *reason = "Invalid \\u escape, expected 4 hexadecimal digits";
+                    return JA_ERROR_INVALID_STRING;
+                }
+
+                if (code_unit >= 0xD800 && code_unit <= 0xDBFF) {
+                    // A high surrogate must be followed by an escaped low surrogate
+                    long low = (end - s >= 8 && s[6] == '\\' && s[7] == 'u') ? __ja_hex4(s + 8, end) : -1;
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        *p = s;
+                        *reason = "Unpaired surrogate in \\u escape";
+                        return JA_ERROR_INVALID_STRING;
+                    }
+                    s += 12;
+                } else if (code_unit >= 0xDC00 && code_unit <= 0xDFFF) {
+                    *p = s;
+                    *reason = "Unpaired surrogate in \\u escape";
+                    return JA_ERROR_INVALID_STRING;
+                } else {
+                    s += 6;
+                }
+                continue;
+            }
+            default:
+                *p = s;
+                *reason = "Invalid escape sequence";
+                return JA_ERROR_INVALID_STRING;
+            }
+        }
+
+        if (c < 0x20) {
+            *p = s;
+            *reason = "Unescaped control character in string";
+            return JA_ERROR_INVALID_STRING;
+        }
+
+        size_t length = __ja_utf8_sequence((const unsigned char *)s, (const unsigned char *)end);
+        if (!length) {
+            *p = s;
+            *reason = "Invalid UTF-8 sequence";
+            return JA_ERROR_INVALID_UTF8;
+        }
+        s += length;
+    }
+}
+
+ja_error_code __ja_validate_number(const char **p, const char *end, const char **reason) {
+    const char *s = *p;
+
+    if (*s == '-') s++;
+
+    if (s == end) {
+        *p = s;
+        *reason = "Number without digits";
+        return JA_ERROR_UNEXPECTED_END;
+    }
+
+    if (*s == '0') {
+        s++;
+        if (s < end && isdigit((unsigned char)*s)) {
+            *p = s;
+            *reason = "Leading zeros are not allowed";
+            return JA_ERROR_INVALID_NUMBER;
+        }
+    } else if (*s >= '1' && *s <= '9') {
+        while (s < end && isdigit((unsigned char)*s)) s++;
+    } else {
+        *p = s;
+        *reason = "Expected a digit";
+        return JA_ERROR_INVALID_NUMBER;
+    }
+
+    if (s < end && *s == '.') {
+        s++;
+        if (s == end || !isdigit((unsigned char)*s)) {
+            *p = s;
+            *reason = "Expected a digit after the decimal point";
+            return s == end ? JA_ERROR_UNEXPECTED_END : JA_ERROR_INVALID_NUMBER;
+        }
+        while (s < end && isdigit((unsigned char)*s)) s++;
+    }
+
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        s++;
+        if (s < end && (*s == '+' || *s == '-')) s++;
+        if (s == end || !isdigit((unsigned char)*s)) {
+            *p = s;
+            *reason = "Expected a digit in the exponent";
+            return s == end ? JA_ERROR_UNEXPECTED_END : JA_ERROR_INVALID_NUMBER;
+        }
+        while (s < end && isdigit((unsigned char)*s)) s++;
+    }
+
+    *p = s;
+    return JA_ERROR_NONE;
+}
+
+void __ja_set_error(ja_error *error, const char *json_str, const char *at, ja_error_code code, const char *reason) {
+    if (!error) return;
+
+    error->code = code;
+    error->reason = reason;
+    error->offset = (size_t)(at - json_str);
+    error->line = 1;
+
+    const char *line_start = json_str;
+    for (const char *c = json_str; c < at; c++) {
+        if (*c == '\n') {
+            error->line++;
+            line_start = c + 1;
+        }
+    }
+    error->column = (size_t)(at - line_start) + 1;
+
+    __ja_error_path(json_str, at, error->path, sizeof(error->path));
+}
+
+void __ja_locate_parse_error(const char *json_str) {
+    if (__ja_last_error_value.code == JA_ERROR_MEMORY) return;
+
+    // The parser doesn't track positions, the validator finds the first error again
+    ja_error error;
+    if (!ja_validate(json_str, strlen(json_str), &error)) {
+        __ja_last_error_value = error;
+    } else {
+        __ja_set_last_error(JA_ERROR_UNEXPECTED_CHARACTER, NULL);
+    }
+}
+
+const ja_error *ja_last_error(void) {
+    return &__ja_last_error_value;
+}
+
+void ja_clear_last_error(void) {
+    __ja_set_last_error(JA_ERROR_NONE, NULL);
+}
+
+void __ja_set_last_error(ja_error_code code, const char *path) {
+    ja_error *error = &__ja_last_error_value;
+
+    error->code = code;
+    error->reason = __ja_error_reason(code);
+    error->offset = 0;
+    error->line = 0;
+    error->column = 0;
+    error->path[0] = '\0';
+
+    if (path) {
+        strncpy(error->path, path, sizeof(error->path) - 1);
+        error->path[sizeof(error->path) - 1] = '\0';
+    }
+}
+
+const char *__ja_error_reason(ja_error_code code) {
+    switch (code) {
+    case JA_ERROR_NONE:                 return "No error";
+    case JA_ERROR_UNEXPECTED_END:       return "Unexpected end of input";
+    case JA_ERROR_UNEXPECTED_CHARACTER: return "Unexpected character";
+    case JA_ERROR_INVALID_NUMBER:       return "Invalid number";
+    case JA_ERROR_INVALID_LITERAL:      return "Invalid literal, expected true, false or null";
+    case JA_ERROR_INVALID_STRING:       return "Invalid string";
+    case JA_ERROR_INVALID_UTF8:         return "Invalid UTF-8 sequence";
+    case JA_ERROR_DEPTH_LIMIT:          return "Too many nested arrays and objects";
+    case JA_ERROR_TRAILING_CONTENT:     return "Unexpected content after the value";
+    case JA_ERROR_NULL_ARGUMENT:        return "NULL argument";
+    case JA_ERROR_TYPE_MISMATCH:        return "Value of the wrong type";
+    case JA_ERROR_KEY_NOT_FOUND:        return "Key not found";
+    case JA_ERROR_INDEX_OUT_OF_BOUNDS:  return "Index out of bounds";
+    case JA_ERROR_MEMORY:               return "Memory allocation failed";
+    case JA_ERROR_IO:                   return "Input/output error";
+    case JA_ERROR_INVALID_SNAPSHOT:     return "Invalid or incompatible snapshot";
+    case JA_ERROR_UNSUPPORTED_TYPE:     return "Type without a JSON equivalent";
+    case JA_ERROR_INVALID_PATCH:        return "Invalid JSON Patch";
+    case JA_ERROR_PATCH_TEST_FAILED:    return "JSON Patch test failed";
+    case JA_ERROR_SHARED_VALUE:         return "Value shared by a copy-on-write copy";
+    default:                            return "Unknown error";
+    }
+}
+
+void ja_set_log_callback(ja_log_callback callback, void *user_data) {
+    __ja_log_user_data = user_data;
+    __ja_log_handler = callback;
+}
+
+void ja_log_stderr(ja_log_level level, const char *file, int line, const char *message, void *user_data) {
+    (void)user_data;
+
+    switch (level) {
+    case JA_LOG_LEVEL_ERROR: fprintf(stderr, "[jaJSON_ERROR] %s:%d: %s\n", file, line, message); break;
+    case JA_LOG_LEVEL_WARN:  fprintf(stderr, "[jaJSON_WARN] %s:%d: %s\n", file, line, message);  break;
+    case JA_LOG_LEVEL_INFO:  fprintf(stdout, "[jaJSON_INFO] %s:%d: %s\n", file, line, message);  break;
+    default:                 fprintf(stderr, "[jaJSON_TRACE] %s:%d: %s\n", file, line, message); break;
+    }
+}
+
+void __ja_log(ja_log_level level, const char *file, int line, const char *format, ...) {
+    ja_log_callback callback = __ja_log_handler;
+    if (!callback) return;
+
+    char message[512];
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+
+    callback(level, file, line, message, __ja_log_user_data);
+}
+
+bool __ja_error_path_append(char *path, size_t size, const char *segment, size_t length) {
+    size_t used = strlen(path);
+
+    size_t needed = 1; // '/'
+    for (size_t i = 0; i < length; i++) {
+        needed += (segment[i] == '~' || segment[i] == '/') ? 2 : 1;
+    }
+
+    // Room for "/..." is always kept, to mark segments that don't fit
+    if (used + needed + 5 > size) {
+        if (used + 5 > size) return false;
+        strcpy(path + used, "/...");
+        return true;
+    }
+
+    char *p = path + used;
+    *p++ = '/';
+    for (size_t i = 0; i < length; i++) {
+        if (segment[i] == '~') {
+            *p++ = '~'; *p++ = '0';
+        } else if (segment[i] == '/') {
+            *p++ = '~'; *p++ = '1';
+        } else {
+            *p++ = segment[i];
+        }
+    }
+    *p = '\0';
+    return true;
+}
+
+void __ja_error_path(const char *json_str, const char *at, char *path, size_t size) {
+    unsigned char in_object[(JA_MAX_DEPTH + 7) / 8];
+    size_t depth = 0;
+    size_t hidden = 0;      // Open containers whose segment didn't fit in the path
+    bool expect_key = false;
+    const char *p = json_str;
+    const char *reason;
+
+    path[0] = '\0';
+
+    while (p < at) {
+        switch (*p) {
+        case '"': {
+            const char *start = p;
+            if (__ja_validate_string(&p, at, &reason) != JA_ERROR_NONE) {
+                p = at; // The error is inside this string
+                continue;
+            }
+
+            if (expect_key && !hidden) {
+                *strrchr(path, '/') = '\0';
+                __ja_error_path_append(path, size, start + 1, (size_t)(p - start) - 2);
+            }
+            expect_key = false;
+            continue;
+        }
+        case '[':
+        case '{': {
+            if (depth == JA_MAX_DEPTH) break;
+
+            bool object = *p == '{';
+            if (object) in_object[depth / 8] |= (unsigned char)(1u << (depth % 8));
+            else in_object[depth / 8] &= (unsigned char)~(1u << (depth % 8));
+            depth++;
+
+            // Objects get an empty segment until their first key is read
+            if (hidden || !__ja_error_path_append(path, size, object ? "" : "0", object ? 0 : 1)) hidden++;
+            expect_key = object;
+            break;
+        }
+        case ']':
+        case '}':
+            if (depth == 0) break;
+            depth--;
+            if (hidden) hidden--;
+            else *strrchr(path, '/') = '\0';
+            expect_key = false;
+            break;
+        case ',':
+            if (depth == 0) break;
+            if (in_object[(depth - 1) / 8] & (1u << ((depth - 1) % 8))) {
+                expect_key = true;
+            } else if (!hidden) {
+                char *slash = strrchr(path, '/');
+                char index[24];
+                int index_length = snprintf(index, sizeof(index), "%zu", (size_t)strtoull(slash + 1, NULL, 10) + 1);
+                *slash = '\0';
+                __ja_error_path_append(path, size, index, (size_t)index_length);
+            }
+            break;
+        default:
+            break;
+        }
+
+        p++;
+    }
+
+    // Drop the empty segment of an object whose key wasn't reached
+    size_t length = strlen(path);
+    if (length > 0 && path[length - 1] == '/') path[length - 1] = '\0';
+}
+
+void __ja_jump_whitespaces(const char **str_ptr, int *chars_consumed) {
+    while (**str_ptr && isspace(**str_ptr)) {
+        (*str_ptr)++;
+        if (chars_consumed) (*chars_consumed)++;
+    }
+}
+
+ja_val *__ja_parse_parallel(const char *json_str, size_t *chars_consumed, int thread_count) {
+    if (!json_str) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't parse NULL string.");
+        return NULL;
+    }
+
+    const char *p = json_str;
+    __ja_jump_whitespaces(&p, NULL);
+
+    ja_val *value = NULL;
+    size_t consumed = 0;
+
+    switch (*p) {
+    case '[':
+        value = __ja_parse_array_parallel(p, &consumed, thread_count);
+        break;
+    case '{':
+        value = __ja_parse_object_parallel(p, &consumed, thread_count);
+        break;
+    default: {
+        int inner_chars_consumed = 0;
+        value = __ja_parse(p, &inner_chars_consumed);
+        consumed = (size_t)inner_chars_consumed;
+        break;
+    }
+    }
+
+    if (value && chars_consumed) *chars_consumed += (size_t)(p - json_str) + consumed;
+    return value;
+}
+
+// Shared state for parsing the elements of a pre-scanned array
+typedef struct __ja_elements_job {
+    const char *json_str;
+    const size_t *bounds;
+    ja_val **items;
+    size_t count;
+    size_t elements_per_task;
+    bool failed;
+} __ja_elements_job;
+
+void __ja_parse_elements_task(void *context, size_t task_index) {
+    __ja_elements_job *job = context;
+
+    size_t first = task_index * job->elements_per_task;
+    size_t last = first + job->elements_per_task;
+    if (last > job->count) last = job->count;
+
+    // Workers don't see the scope of the calling thread, each task interns its own keys and shapes
+    __ja_parse_scope scope = { .end = last > first ? job->json_str + job->bounds[2 * last - 1] : NULL };
+    __ja_parse_scope *previous = __ja_intern_begin(&scope);
+
+    for (size_t i = first; i < last; i++) {
+        if (__atomic_load_n(&job->failed, __ATOMIC_RELAXED)) break;
+
+        const char *start = job->json_str + job->bounds[2 * i];
+        int consumed = 0;
+        ja_val *value = __ja_parse(start, &consumed);
+
+        if (value) {
+            // The element must fill its whole range, up to the ',' or ']' found by the pre-scan
+            const char *rest = start + consumed;
+            __ja_jump_whitespaces(&rest, NULL);
+            if (rest != job->json_str + job->bounds[2 * i + 1]) {
+                JA_LOG_ERROR("Invalid character in array: %c", *rest);
+                ja_free_val(&value);
+            }
+        }
+
+        if (!value) {
+            __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+            break;
+        }
+
+        job->items[i] = value;
+    }
+
+    __ja_intern_end(&scope, previous);
+}
+
+ja_val *__ja_parse_array_parallel(const char *json_str, size_t *chars_consumed, int thread_count) {
+    size_t *bounds = NULL;
+    size_t count = 0, length = 0;
+
+    if (!__ja_scan_array(json_str, &bounds, &count, &length) || length < JA_PARALLEL_MIN_BYTES) {
+        // Not worth splitting (or malformed, which the serial parser reports)
+        free(bounds);
+
+        int consumed = 0;
+        ja_val *jav = __ja_parse_array(json_str, &consumed);
+        if (jav && chars_consumed) *chars_consumed += (size_t)consumed;
+        return jav;
+    }
+
+    ja_val *jav = ja_new_arr();
+    ja_val **items = calloc(count, sizeof(ja_val*));
+    if (!jav || !items) {
+        JA_MEM_ERROR();
+        free(bounds);
+        free(items);
+        ja_free_val(&jav);
+        return NULL;
+    }
+
+    __ja_elements_job job;
+    job.json_str = json_str;
+    job.bounds = bounds;
+    job.items = items;
+    job.count = count;
+    job.failed = false;
+
+    if (count == 1) {
+        // A single big element can still hold arrays worth splitting
+        size_t consumed = 0;
+        const char *start = json_str + bounds[0];
+        ja_val *value = __ja_parse_parallel(start, &consumed, thread_count);
+
+        if (value) {
+            const char *rest = start + consumed;
+            __ja_jump_whitespaces(&rest, NULL);
+            if (rest != json_str + bounds[1]) {
+                JA_LOG_ERROR("Invalid character in array: %c", *rest);
+                ja_free_val(&value);
+            }
+        }
+
+        items[0] = value;
+        job.failed = !value;
+    } else {
+        int threads = __ja_thread_count(thread_count);
+        size_t task_count = (size_t)threads * 8; // Smaller tasks balance elements of uneven size
+        if (task_count > count) task_count = count;
+
+        job.elements_per_task = (count + task_count - 1) / task_count;
+        __ja_parallel_for((count + job.elements_per_task - 1) / job.elements_per_task,
+                          threads, __ja_parse_elements_task, &job);
+    }
+
+    free(bounds);
+
+    if (job.failed) {
+        for (size_t i = 0; i < count; i++) ja_free_val(&items[i]);
+        free(items);
+        ja_free_val(&jav);
+        return NULL;
+    }
+
+    jav->u.array.items = items;
+    jav->u.array.size = count;
+    __ja_arr_pack(jav);
+
+    if (chars_consumed) *chars_consumed += length;
+    return jav;
+}
+
+ja_val *__ja_parse_object_parallel(const char *json_str, size_t *chars_consumed, int thread_count) {
+    ja_val *jav = ja_new_obj();
+    if (!jav) return NULL;
+
+    const char *p = json_str + 1; // Skip '{'
+
+    while (*p) {
+        __ja_jump_whitespaces(&p, NULL);
+
+        if (*p == '}') {
+            p++;
+            if (chars_consumed) *chars_consumed += (size_t)(p - json_str);
+            __ja_obj_shape(jav);
+            return jav;
+        }
+
+        if (*p != '"') {
+            if (*p == '\0')
+                JA_LOG_ERROR("Unexpected end of file.");
+            else
+                JA_LOG_ERROR("Invalid character in object key: '%c'", *p);
+            ja_free_val(&jav);
+            return NULL;
+        }
+
+        int key_chars_consumed = 0;
+        char *key = __ja_parse_key(p, &key_chars_consumed);
+        if (!key) {
+            ja_free_val(&jav);
+            return NULL;
+        }
+
+        p += key_chars_consumed;
+        __ja_jump_whitespaces(&p, NULL);
+
+        if (*p != ':') {
+            JA_LOG_ERROR("Missing colon after key: %s", key);
+            ja_free_val(&jav);
+            __ja_key_release(key);
+            return NULL;
+        }
+        p++;
+
+        size_t value_chars_consumed = 0;
+        ja_val *value = __ja_parse_parallel(p, &value_chars_consumed, thread_count);
+        if (!value) {
+            ja_free_val(&jav);
+            __ja_key_release(key);
+            return NULL;
+        }
+
+        p += value_chars_consumed;
+        __ja_jump_whitespaces(&p, NULL);
+
+        if (*p == ',') {
+            p++;
+        } else if (*p != '}') {
+            JA_LOG_ERROR("Invalid character in object: '%c'", *p);
+            ja_free_val(&jav);
+            __ja_key_release(key);
+            ja_free_val(&value);
+            return NULL;
+        }
+
+        if (!__ja_obj_put(jav, key, value)) {
+            ja_free_val(&jav);
+            ja_free_val(&value);
+            return NULL;
+        }
+    }
+
+    JA_LOG_ERROR("Unmatched brackets in object.");
+    ja_free_val(&jav);
+    return NULL;
+}
+
+bool __ja_scan_array(const char *json_str, size_t **bounds, size_t *count, size_t *length) {
+    size_t *list = NULL;
+    size_t found = 0, capacity = 0;
+    size_t depth = 1;
+    size_t element_start = 1; // Right after the '[' or the last ','
+    bool empty = true;        // Only whitespace since element_start
+
+    *bounds = NULL;
+    *count = 0;
+    *length = 0;
+
+    const char *p = json_str + 1;
+    while (*p) {
+        char c = *p;
+        bool element_end = false;
+
+        if (c == '"') {
+            p++;
+            while (*p && *p != '"') {
+                if (*p == '\\' && p[1]) p++;
+                p++;
+            }
+            if (!*p) break;
+        } else if (c == '[' || c == '{') {
+            depth++;
+        } else if (c == ']' || c == '}') {
+            depth--;
+            if (depth == 0 && c != ']') break; // Mismatched bracket, left for the serial parser to report
+            element_end = depth == 0 && !empty;
+            if (depth == 0 && empty) {
+                // Empty array, or a trailing comma which __ja_parse_array() also accepts
+                *bounds = list;
+                *count = found;
+                *length = (size_t)(p - json_str) + 1;
+                return true;
+            }
+        } else if (c == ',' && depth == 1) {
+            element_end = true;
+        }
+
+        if (element_end) {
+            if (found == capacity) {
+                size_t new_capacity = capacity ? capacity * 2 : 256;
+                size_t *new_list = realloc(list, sizeof(size_t) * 2 * new_capacity);
+                if (!new_list) {
+                    JA_MEM_ERROR();
+                    free(list);
+                    return false;
+                }
+                list = new_list;
+                capacity = new_capacity;
+            }
+
+            list[2 * found] = element_start;
+            list[2 * found + 1] = (size_t)(p - json_str);
+            found++;
+
+            if (c != ',') {
+                *bounds = list;
+                *count = found;
+                *length = (size_t)(p - json_str) + 1;
+                return true;
+            }
+
+            element_start = (size_t)(p - json_str) + 1;
+            empty = true;
+            p++;
+            continue;
+        }
+
+        if (!isspace((unsigned char)c)) empty = false;
+        p++;
+    }
+
+    free(list);
+    return false;
+}
+
+int ja_enum_type_of(ja_val *value) {
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve type of a NULL pointer.");
+        return 0;
+    }
+
+    switch (value->type) {
+    case JA_TYPE_INT: 
+    case JA_TYPE_DOUBLE: 
+    case JA_TYPE_STRING: 
+    case JA_TYPE_BOOL: 
+    case JA_TYPE_ARRAY: 
+    case JA_TYPE_OBJECT: 
+    case JA_TYPE_NULL: 
+        return (int)value->type;
+    default:
+        return -1;
+    }
+}
+
+const char *ja_str_type_of(ja_val *value) {
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't retrieve type of a NULL pointer.");
+        return NULL;
+    }
+
+    return __ja_type_enum_to_str(value->type);
+}
+
+const char *__ja_type_enum_to_str(ja_type type) {
+    switch (type) {
+    case JA_TYPE_INT: return "Number";
+    case JA_TYPE_DOUBLE: return "Number";
+    case JA_TYPE_STRING: return "String";
+    case JA_TYPE_BOOL: return "Bool";
+    case JA_TYPE_ARRAY: return "Array";
+    case JA_TYPE_OBJECT: return "Object";
+    case JA_TYPE_NULL: return "Null";
+    default: return "Unknown";
+    }
+}
+
+size_t ja_size_of(ja_val *value) {
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't access size of NULL value.");
+        return 0;
+    }
+
+    switch (value->type) {
+    case JA_TYPE_STRING: return strlen(value->u.string);
+    case JA_TYPE_ARRAY: return value->u.array.size;
+    case JA_TYPE_OBJECT:
+        // Tombstones left by removals don't count
+        return value->u.object.size - ((value->flags & JA_FLAG_KEY_MAP) ? __JA_OBJ_MAP(value)->removed : 0);
+    default:
+        JA_ERROR(JA_ERROR_TYPE_MISMATCH, "Can't use ja_size_of() for this type (%s).", ja_str_type_of(value));
+        return 0;
+    }
+}
+
+// Frees a node, unless it lives in the block of a compact copy (the block goes with its root)
+static inline void __ja_free_node(ja_val *value) {
+    if (value->flags & JA_FLAG_BLOCK_ROOT) __ja_block_free(value);
+    else if (!(value->flags & JA_FLAG_IN_BLOCK)) free(value);
+}
+
+void ja_free_val(ja_val **val_ptr) {
+    if (!val_ptr || !(*val_ptr)) return;
+
+    if (__ja_cow_release(*val_ptr)) { // Still used by other trees
+        *val_ptr = NULL;
+        return;
+    }
+    
+    __ja_free_val(*val_ptr);
+    __ja_free_node(*val_ptr);
+    *val_ptr = NULL;
+}
+
+// Frees the buffer holding the children of an array or object (the elements themselves for packed arrays)
+static void __ja_free_buffer(ja_val *value) {
+    if (__ja_is_packed(value)) __ja_packed_free(value->u.array.doubles, value->u.array.size);
+    else if (!(value->flags & JA_FLAG_BLOCK_DATA)) free(__ja_children_base(value));
+}
+
+// Adds an array or object being torn down to the work list, its shape, key map and indexes already dropped.
+// The link takes the slot of its last child, which is returned to be handled next, so nothing is allocated.
+// Empty and packed ones have nothing left to visit, they are freed right away.
+static ja_val *__ja_free_link(ja_val *value, ja_val **pending) {
+    size_t size = value->u.object.size; // Same word as u.array.size
+    if (size == 0 || __ja_is_packed(value)) {
+        __ja_free_buffer(value);
+        __ja_free_node(value);
+        return NULL;
+    }
+
+    ja_val **slot;
+    if (value->type == JA_TYPE_ARRAY) {
+        slot = &value->u.array.items[size - 1];
+    } else {
+        if (!(value->flags & JA_FLAG_SHAPED)) __ja_key_release(value->u.object.pairs[size - 1].key);
+        slot = __ja_obj_slot(value, size - 1);
+    }
+
+    ja_val *last = *slot;
+    *slot = *pending;
+    value->u.object.size = size - 1;
+    *pending = value;
+    return last;
+}
+
+// Drops what an array or object holds besides its children before it joins the work list
+static void __ja_free_detach(ja_val *value) {
+    if (value->type == JA_TYPE_ARRAY) {
+        __ja_index_detach(value);
+    } else if (value->flags & JA_FLAG_SHAPED) {
+        __ja_shape_release(__JA_OBJ_SHAPE(value)); // Only keys live there, the flag still tells the layout
+    } else if (value->flags & JA_FLAG_KEY_MAP) {
+        __ja_key_map_free(__JA_OBJ_MAP(value)); // Tombstones are skipped like any NULL child
+    }
+}
+
+// Frees a child of a container being torn down: scalars right away, arrays and objects go to the work list
+static void __ja_free_push(ja_val *value, ja_val **pending) {
+    while (value && !__ja_cow_release(value)) {
+        if (value->flags & JA_FLAG_BLOCK_ROOT) { // Its nodes must be reached before the block is freed
+            __ja_free_val(value);
+            __ja_block_free(value);
+            return;
+        }
+
+        switch (value->type) {
+        case JA_TYPE_STRING:
+            if (!(value->flags & JA_FLAG_BLOCK_DATA)) free(value->u.string);
+            __ja_free_node(value);
+            return;
+        case JA_TYPE_ARRAY:
+        case JA_TYPE_OBJECT:
+            __ja_free_detach(value);
+            value = __ja_free_link(value, pending); // Its last child, pushed in turn
+            break;
+        default:
+            __ja_free_node(value);
+            return;
+        }
+    }
+}
+
+// Frees the children buffer of an array or object, handing each child to __ja_free_push()
+static void __ja_free_children(ja_val *value, ja_val **pending) {
+    if (__ja_is_packed(value)) { // Elements live in the buffer itself
+        __ja_free_buffer(value);
+        return;
+    } else if (value->type == JA_TYPE_ARRAY) {
+        for (size_t i = 0; i < value->u.array.size; i++) {
+            __ja_free_push(value->u.array.items[i], pending);
+        }
+    } else if (value->flags & JA_FLAG_SHAPED) {
+        for (size_t i = 0; i < value->u.object.size; i++) {
+            __ja_free_push(value->u.object.values[i], pending);
+        }
+    } else {
+        for (size_t i = 0; i < value->u.object.size; i++) {
+            __ja_key_release(value->u.object.pairs[i].key);
+            __ja_free_push(value->u.object.pairs[i].value_ptr, pending);
+        }
+    }
+
+    __ja_free_buffer(value);
+}
+
+void __ja_free_pending(ja_val *pending) {
+    while (pending) {
+        ja_val *value = pending;
+        size_t size = value->u.object.size; // Same word as u.array.size
+        pending = value->type == JA_TYPE_ARRAY ? value->u.array.items[size] : *__ja_obj_slot(value, size);
+
+        __ja_free_children(value, &pending);
+        __ja_free_node(value); // Block roots never get here, see __ja_free_push()
+    }
+}
+
+void __ja_free_val(ja_val *value) {
+    if (!value) return;
+    __ja_element_settle(value);
+
+    switch (value->type) {
+        case JA_TYPE_STRING:
+            if (!(value->flags & JA_FLAG_BLOCK_DATA)) free(value->u.string);
+            value->u.string = NULL;
+            break;
+        case JA_TYPE_ARRAY:
+        case JA_TYPE_OBJECT: {
+            ja_val *pending = NULL;
+
+            __ja_free_detach(value);
+            __ja_free_children(value, &pending);
+            __ja_free_pending(pending);
+
+            value->u.object.pairs = NULL;
+            value->u.object.size = 0;
+            value->flags &= ~(JA_FLAG_SHAPED | JA_FLAG_KEY_MAP | JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL);
+            break;
+        }
+        default:
+            break;
+    }
+
+    value->flags &= ~JA_FLAG_BLOCK_DATA; // Whatever replaces the contents is allocated on its own
+}
+
+// Values passed to ja_free_val_deferred() that are freed by now, see __ja_deferred_freed_count()
+static size_t __ja_deferred_freed = 0;
+
+size_t __ja_deferred_freed_count(void) {
+    return __atomic_load_n(&__ja_deferred_freed, __ATOMIC_ACQUIRE);
+}
+
+#ifdef JA_THREADS
+// Values handed to ja_free_val_deferred(), a work list of __ja_free_pending()
+static pthread_mutex_t __ja_deferred_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t __ja_deferred_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t __ja_deferred_done = PTHREAD_COND_INITIALIZER;
+static ja_val *__ja_deferred_queue = NULL;
+static size_t __ja_deferred_queued_values = 0; // In __ja_deferred_queue
+static bool __ja_deferred_busy = false;
+static bool __ja_deferred_started = false;
+
+static void *__ja_deferred_worker(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&__ja_deferred_lock);
+    for (;;) {
+        while (!__ja_deferred_queue) {
+            __ja_deferred_busy = false;
+            pthread_cond_broadcast(&__ja_deferred_done);
+            pthread_cond_wait(&__ja_deferred_queued, &__ja_deferred_lock);
+        }
+
+        // Takes the whole queue, it already is a work list for __ja_free_pending()
+        ja_val *pending = __ja_deferred_queue;
+        size_t values = __ja_deferred_queued_values;
+        __ja_deferred_queue = NULL;
+        __ja_deferred_queued_values = 0;
+        __ja_deferred_busy = true;
+        pthread_mutex_unlock(&__ja_deferred_lock);
+
+        __ja_free_pending(pending);
+        __atomic_add_fetch(&__ja_deferred_freed, values, __ATOMIC_RELEASE);
+
+        pthread_mutex_lock(&__ja_deferred_lock);
+    }
+
+    return NULL;
+}
+#endif
+
+void ja_free_val_deferred(ja_val **val_ptr) {
+    if (!val_ptr || !(*val_ptr)) return;
+
+#ifdef JA_THREADS
+    ja_val *value = *val_ptr;
+
+    if (__ja_cow_release(value)) { // Still used by other trees
+        *val_ptr = NULL;
+        __atomic_add_fetch(&__ja_deferred_freed, 1, __ATOMIC_RELEASE); // Only its share had to go
+        return;
+    }
+
+    // Compact copies are freed right away, their nodes must be reached before the block is freed
+    if ((value->type == JA_TYPE_ARRAY || value->type == JA_TYPE_OBJECT) && !(value->flags & JA_FLAG_IN_BLOCK)) {
+        pthread_mutex_lock(&__ja_deferred_lock);
+
+        if (!__ja_deferred_started) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, __ja_deferred_worker, NULL) == 0) {
+                pthread_detach(thread);
+                __ja_deferred_started = true;
+            }
+        }
+
+        if (__ja_deferred_started) {
+            __ja_free_detach(value);
+            __ja_free_push(__ja_free_link(value, &__ja_deferred_queue), &__ja_deferred_queue);
+            __ja_deferred_queued_values++;
+            __ja_deferred_busy = true;
+            pthread_cond_signal(&__ja_deferred_queued);
+            pthread_mutex_unlock(&__ja_deferred_lock);
+
+            *val_ptr = NULL;
             return;
         }
 
-        __ja_free_val(target);
-        ja_arr_append(new_arr, num_cpy);
-        target->u.array.items = new_arr->u.array.items;
-        target->u.array.size = new_arr->u.array.size;
-        target->type = JA_TYPE_ARRAY;
-        free(new_arr);
-        return;
+        pthread_mutex_unlock(&__ja_deferred_lock); // No thread, freed right away
+    }
+#endif
+
+    ja_free_val(val_ptr);
+    __atomic_add_fetch(&__ja_deferred_freed, 1, __ATOMIC_RELEASE);
+}
+
+void ja_wait_deferred_free(void) {
+#ifdef JA_THREADS
+    pthread_mutex_lock(&__ja_deferred_lock);
+    while (__ja_deferred_busy) {
+        pthread_cond_wait(&__ja_deferred_done, &__ja_deferred_lock);
+    }
+    pthread_mutex_unlock(&__ja_deferred_lock);
+#endif
+}
+
+ja_json* ja_json_init() {
+    ja_json *ja_json_object = malloc(sizeof(ja_json));
+    if (!ja_json_object) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    ja_json_object->json_str = NULL;
+    ja_json_object->content = NULL;
+
+    return ja_json_object;
+}
+
+// Bytes read or written at a time by the compressed file helpers
+#define JA_COMPRESSED_CHUNK 65536
+
+// Compression of a file, told by its first bytes
+typedef enum { __JA_COMPRESSION_NONE, __JA_COMPRESSION_GZIP, __JA_COMPRESSION_ZSTD } __ja_compression;
+
+// Reads the magic bytes of a file and rewinds it
+static __ja_compression __ja_file_compression(FILE *file) {
+    unsigned char magic[4] = { 0 };
+    size_t magic_length = fread(magic, 1, sizeof(magic), file);
+    rewind(file);
+
+    if (magic_length >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) return __JA_COMPRESSION_GZIP;
+    if (magic_length == 4 && memcmp(magic, "\x28\xb5\x2f\xfd", 4) == 0) return __JA_COMPRESSION_ZSTD;
+    return __JA_COMPRESSION_NONE;
+}
+
+// Fails with JA_ERROR_IO when the library is built without the decompressor of the file
+static bool __ja_compression_supported(__ja_compression compression, const char *filename) {
+#ifndef JA_ZLIB
+    if (compression == __JA_COMPRESSION_GZIP) {
+        JA_ERROR(JA_ERROR_IO, "%s is compressed with gzip, build with JA_ZLIB to read it.", filename);
+        return false;
+    }
+#endif
+#ifndef JA_ZSTD
+    if (compression == __JA_COMPRESSION_ZSTD) {
+        JA_ERROR(JA_ERROR_IO, "%s is compressed with Zstandard, build with JA_ZSTD to read it.", filename);
+        return false;
+    }
+#endif
+    (void)compression;
+    (void)filename;
+    return true;
+}
+
+#if defined(JA_ZLIB) || defined(JA_ZSTD)
+// Decompressed text of a gzip or Zstandard file, handed out a chunk at a time
+typedef struct __ja_inflow {
+    FILE *file;
+    const char *filename;
+    __ja_compression compression;
+    bool input_over; // The compressed bytes have all been read
+    bool over;       // The decompressed text has all been handed out
+    bool failed;     // Corrupt, truncated or unreadable file (JA_ERROR_IO)
+#ifdef JA_ZLIB
+    z_stream gzip;
+    int status;
+#endif
+#ifdef JA_ZSTD
+    ZSTD_DCtx *context;
+    ZSTD_inBuffer in;
+    size_t remaining; // Bytes still expected, 0 once a frame is complete and flushed
+#endif
+    unsigned char input[JA_COMPRESSED_CHUNK];
+} __ja_inflow;
+
+static bool __ja_inflow_open(__ja_inflow *source, FILE *file, const char *filename, __ja_compression compression) {
+    source->file = file;
+    source->filename = filename;
+    source->compression = compression;
+    source->input_over = false;
+    source->over = false;
+    source->failed = false;
+
+#ifdef JA_ZLIB
+    if (compression == __JA_COMPRESSION_GZIP) {
+        source->gzip = (z_stream){ 0 };
+        source->status = inflateInit2(&source->gzip, 15 + 32); // Detects the gzip or zlib header
+        if (source->status != Z_OK) {
+            JA_MEM_ERROR();
+            return false;
+        }
+    }
+#endif
+#ifdef JA_ZSTD
+    if (compression == __JA_COMPRESSION_ZSTD) {
+        source->context = ZSTD_createDCtx();
+        source->in = (ZSTD_inBuffer){ source->input, 0, 0 };
+        source->remaining = 1;
+        if (!source->context) {
+            JA_MEM_ERROR();
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+// Releases the decompressor and closes the file
+static void __ja_inflow_close(__ja_inflow *source) {
+#ifdef JA_ZLIB
+    if (source->compression == __JA_COMPRESSION_GZIP) inflateEnd(&source->gzip);
+#endif
+#ifdef JA_ZSTD
+    if (source->compression == __JA_COMPRESSION_ZSTD) ZSTD_freeDCtx(source->context);
+#endif
+    fclose(source->file);
+}
+
+// Decompresses up to `room` bytes into `out`. Returns 0 once the text is over or when the file is corrupt,
+// concatenated gzip members and consecutive Zstandard frames are read as one text
+static size_t __ja_inflow_read(__ja_inflow *source, char *out, size_t room) {
+    bool failed = source->failed;
+    size_t produced = 0;
+
+    while (produced == 0 && !source->over && !source->failed) {
+#ifdef JA_ZLIB
+        if (source->compression == __JA_COMPRESSION_GZIP) {
+            z_stream *stream = &source->gzip;
+            if (stream->avail_in == 0) {
+                if (source->input_over) {
+                    source->over = true;
+                    source->failed = source->status != Z_STREAM_END;
+                    break;
+                }
+                stream->avail_in = (uInt)fread(source->input, 1, sizeof(source->input), source->file);
+                stream->next_in = source->input;
+                if (ferror(source->file)) source->failed = true;
+                if (stream->avail_in == 0) source->input_over = true;
+                continue;
+            }
+
+            if (source->status == Z_STREAM_END) inflateReset(stream); // Next member
+            stream->next_out = (Bytef *)out;
+            stream->avail_out = room > UINT_MAX ? UINT_MAX : (uInt)room;
+            source->status = inflate(stream, Z_NO_FLUSH);
+            produced = (size_t)((char *)stream->next_out - out);
+            if (source->status != Z_OK && source->status != Z_STREAM_END) source->failed = true;
+            continue;
+        }
+#endif
+#ifdef JA_ZSTD
+        if (source->in.pos == source->in.size && !source->input_over) {
+            source->in.size = fread(source->input, 1, sizeof(source->input), source->file);
+            source->in.pos = 0;
+            if (ferror(source->file)) source->failed = true;
+            if (source->in.size == 0) source->input_over = true;
+        }
+
+        // Without input left, the calls flush what the decoder still holds
+        ZSTD_outBuffer output = { out, room, 0 };
+        size_t status = ZSTD_decompressStream(source->context, &output, &source->in);
+        if (ZSTD_isError(status)) {
+            source->failed = true;
+            break;
+        }
+        source->remaining = status;
+        produced = output.pos;
+
+        if (produced == 0 && source->input_over && source->in.pos == source->in.size) {
+            source->over = true;
+            source->failed = source->remaining != 0;
+        }
+#endif
+    }
+
+    if (!failed && source->failed) {
+        JA_ERROR(JA_ERROR_IO, "Invalid or truncated %s file: %s",
+                 source->compression == __JA_COMPRESSION_GZIP ? "gzip" : "Zstandard", source->filename);
+    }
+    return produced;
+}
+
+// Decompresses a whole file into a null-terminated buffer
+static char *__ja_read_compressed(FILE *file, const char *filename, __ja_compression compression, size_t *length) {
+    __ja_inflow *source = malloc(sizeof(__ja_inflow));
+    if (!source) {
+        JA_MEM_ERROR();
+        fclose(file);
+        return NULL;
+    }
+    if (!__ja_inflow_open(source, file, filename, compression)) {
+        __ja_inflow_close(source);
+        free(source);
+        return NULL;
+    }
+
+    __ja_buffer text = { 0 };
+    while (__ja_buffer_reserve(&text, JA_COMPRESSED_CHUNK + 1)) {
+        size_t produced = __ja_inflow_read(source, (char *)text.data + text.length, text.capacity - text.length - 1);
+        if (produced == 0) break;
+        text.length += produced;
+    }
+
+    bool failed = text.failed || source->failed;
+    __ja_inflow_close(source);
+    free(source);
+
+    if (!failed && text.length == 0) {
+        JA_ERROR(JA_ERROR_IO, "File is empty or unreadable: %s", filename);
+        failed = true;
+    }
+    if (failed) {
+        free(text.data);
+        return NULL;
+    }
+
+    text.data[text.length] = '\0';
+    if (length) *length = text.length;
+    return (char *)text.data;
+}
+
+// Unparsed end of the decompressed text: holds the token being parsed and the next chunk, never the whole text
+typedef struct __ja_inflow_window {
+    __ja_inflow source;
+    __ja_parse_scope *scope;
+    char *data;        // Null-terminated
+    size_t length;
+    size_t capacity;
+    size_t position;   // Next byte to be parsed
+    size_t offset;     // Bytes of text dropped before `data`
+    size_t line;       // Line of the first byte of `data` (1-based)
+    size_t line_start; // Offset of the first byte of that line
+    bool failed;
+} __ja_inflow_window;
+
+// Drops the parsed bytes and appends the next decompressed chunk, false once the text is over
+static bool __ja_inflow_fill(__ja_inflow_window *window) {
+    if (window->failed) return false;
+
+    if (window->position > 0) {
+        const char *newline = window->data;
+        const char *parsed = window->data + window->position;
+        while ((newline = memchr(newline, '\n', (size_t)(parsed - newline)))) {
+            window->line++;
+            window->line_start = window->offset + (size_t)(++newline - window->data);
+        }
+
+        memmove(window->data, parsed, window->length - window->position);
+        window->offset += window->position;
+        window->length -= window->position;
+        window->position = 0;
+    }
+
+    if (window->capacity - window->length < JA_COMPRESSED_CHUNK + 1) {
+        size_t capacity = window->capacity ? window->capacity * 2 : 2 * JA_COMPRESSED_CHUNK;
+        while (capacity - window->length < JA_COMPRESSED_CHUNK + 1) capacity *= 2;
+
+        char *data = realloc(window->data, capacity);
+        if (!data) {
+            JA_MEM_ERROR();
+            window->failed = true;
+            return false;
+        }
+        window->data = data;
+        window->capacity = capacity;
+    }
+
+    size_t produced = __ja_inflow_read(&window->source, window->data + window->length,
+                                       window->capacity - window->length - 1);
+    window->length += produced;
+    window->data[window->length] = '\0';
+    window->scope->end = window->data + window->length;
+    if (window->source.failed) window->failed = true;
+    return produced > 0;
+}
+
+// Skips whitespace, decompressing more text as needed. Returns the next character, '\0' once the text is over
+static char __ja_inflow_peek(__ja_inflow_window *window) {
+    for (;;) {
+        while (window->position < window->length && isspace((unsigned char)window->data[window->position])) {
+            window->position++;
+        }
+        if (window->position < window->length) return window->data[window->position];
+        if (!__ja_inflow_fill(window)) return '\0';
+    }
+}
+
+// Decompresses until the scalar (or key) at the position is whole in the window, or the text is over.
+// Returns its length
+static size_t __ja_inflow_token(__ja_inflow_window *window) {
+    size_t seen = 1;
+
+    for (;;) {
+        const char *start = window->data + window->position;
+        const char *end = window->data + window->length;
+        const char *p = start + seen;
+
+        if (*start == '"') {
+            for (;;) {
+                p = __ja_string_scan(p, end);
+                if (p == end) break;
+                if (*p == '"') return (size_t)(p + 1 - start);
+                if (*p == '\\') {
+                    size_t escape = p[1] == 'u' ? 6 : 2; // Skipped like __ja_string_end() does
+                    if ((size_t)(end - p) < escape) break;
+                    p += escape;
+                } else {
+                    p++;
+                }
+            }
+        } else {
+            while (p < end && (isalnum((unsigned char)*p) || *p == '.' || *p == '+' || *p == '-')) p++;
+            if (p < end) return (size_t)(p - start);
+        }
+
+        seen = (size_t)(p - start);
+        if (!__ja_inflow_fill(window)) return window->length - window->position;
+    }
+}
+
+// Records a parse error at a byte of the window, with its offset, line and column in the whole text
+static void __ja_inflow_error(__ja_inflow_window *window, size_t at, ja_error_code code, const char *reason) {
+    if (__ja_last_error_value.code == JA_ERROR_MEMORY) return;
+
+    __ja_set_last_error(code, NULL);
+    ja_error *error = &__ja_last_error_value;
+    error->reason = reason;
+    error->offset = window->offset + at;
+    error->line = window->line;
+
+    size_t line_start = window->line_start;
+    for (size_t i = 0; i < at; i++) {
+        if (window->data[i] == '\n') {
+            error->line++;
+            line_start = window->offset + i + 1;
+        }
+    }
+    error->column = error->offset - line_start + 1;
+
+    JA_LOG_ERROR("%s at line %zu, column %zu of %s", reason, error->line, error->column, window->source.filename);
+}
+
+// Reports why the scalar at the position didn't parse, found again by the validator
+static void __ja_inflow_token_error(__ja_inflow_window *window, size_t length) {
+    ja_error error;
+    if (!ja_validate(window->data + window->position, length, &error)) {
+        __ja_inflow_error(window, window->position + error.offset, error.code, error.reason);
+    } else {
+        __ja_inflow_error(window, window->position, JA_ERROR_UNEXPECTED_CHARACTER, "Expected a value");
+    }
+}
+
+// Array or object being filled by __ja_parse_inflow()
+typedef struct __ja_inflow_frame {
+    ja_val *container;
+    char *key;       // Of the member being parsed
+    size_t capacity; // Of the packed buffer, see __ja_parse_packed()
+} __ja_inflow_frame;
+
+// Adds a parsed value to the innermost open container (or makes it the root)
+static bool __ja_inflow_attach(__ja_inflow_frame *frames, size_t depth, ja_val *value, ja_val **root) {
+    if (depth == 0) {
+        *root = value;
+        return true;
+    }
+
+    __ja_inflow_frame *top = &frames[depth - 1];
+    if (top->container->type == JA_TYPE_OBJECT) {
+        char *key = top->key;
+        top->key = NULL;
+        if (__ja_obj_put(top->container, key, value)) return true;
+    } else {
+        size_t size = top->container->u.array.size;
+        ja_arr_append(top->container, value);
+        if (top->container->u.array.size > size) return true;
+    }
+
+    ja_free_val(&value);
+    return false;
+}
+
+// Parses the text as it is decompressed. Containers are built as their brackets go by, like
+// __ja_parse_array() and __ja_parse_object() do, and only scalars have to be whole in the window
+static ja_val *__ja_parse_inflow(__ja_inflow_window *window) {
+    enum { EXPECT_VALUE, EXPECT_KEY, AFTER_VALUE } state = EXPECT_VALUE;
+
+    __ja_inflow_frame *frames = NULL;
+    size_t depth = 0, frames_capacity = 0;
+    ja_val *root = NULL;
+    bool done = false;
+
+    while (!done) {
+        char c = __ja_inflow_peek(window);
+        if (window->failed) break;
+
+        __ja_inflow_frame *top = depth > 0 ? &frames[depth - 1] : NULL;
+        bool object = top && top->container->type == JA_TYPE_OBJECT;
+        char closing = object ? '}' : ']';
+
+        if (c == '\0' && !(state == AFTER_VALUE && !top)) {
+            if (window->offset + window->length == 0) {
+                JA_ERROR(JA_ERROR_IO, "File is empty or unreadable: %s", window->source.filename);
+            } else {
+                __ja_inflow_error(window, window->position, JA_ERROR_UNEXPECTED_END, "Unexpected end of input");
+            }
+            break;
+        }
+
+        if (state == AFTER_VALUE) {
+            if (!top) {
+                // What follows the value is ignored as by ja_parse(), the rest of the file is still checked
+                do window->position = window->length;
+                while (__ja_inflow_fill(window));
+                done = !window->failed;
+                continue;
+            }
+            if (c == ',') {
+                window->position++;
+                state = object ? EXPECT_KEY : EXPECT_VALUE;
+                continue;
+            }
+            if (c != closing) {
+                __ja_inflow_error(window, window->position, JA_ERROR_UNEXPECTED_CHARACTER, object ?
+                                  "Expected ',' or '}' after object value" : "Expected ',' or ']' after array element");
+                break;
+            }
+        }
+
+        // Empty containers and trailing commas are closed too, as by the recursive parser
+        if (top && c == closing && (state != EXPECT_VALUE || !object)) {
+            window->position++;
+            ja_val *container = top->container;
+            if (object) {
+                __ja_obj_shape(container);
+            } else if (__ja_is_packed(container) && top->capacity > container->u.array.size) {
+                void *data = __ja_packed_realloc(container->u.array.doubles,
+                                                 container->u.array.size * __ja_packed_width(container));
+                if (data) container->u.array.doubles = data;
+            }
+
+            depth--;
+            if (!__ja_inflow_attach(frames, depth, container, &root)) break;
+            state = AFTER_VALUE;
+            continue;
+        }
+
+        if (state == EXPECT_KEY) {
+            if (c != '"') {
+                __ja_inflow_error(window, window->position, JA_ERROR_UNEXPECTED_CHARACTER,
+                                  "Expected a string as object key");
+                break;
+            }
+
+            size_t length = __ja_inflow_token(window);
+            if (window->failed) break;
+
+            int consumed = 0;
+            top->key = __ja_parse_key(window->data + window->position, &consumed);
+            if (!top->key) {
+                __ja_inflow_token_error(window, length);
+                break;
+            }
+            window->position += (size_t)consumed;
+
+            c = __ja_inflow_peek(window);
+            if (window->failed) break;
+            if (c != ':') {
+                __ja_inflow_error(window, window->position, c ? JA_ERROR_UNEXPECTED_CHARACTER : JA_ERROR_UNEXPECTED_END,
+                                  "Expected ':' after object key");
+                break;
+            }
+            window->position++;
+            state = EXPECT_VALUE;
+            continue;
+        }
+
+        if (c == '{' || c == '[') {
+            if (depth == JA_MAX_DEPTH) {
+                __ja_inflow_error(window, window->position, JA_ERROR_DEPTH_LIMIT, "Too many nested arrays and objects");
+                break;
+            }
+            if (depth == frames_capacity) {
+                size_t capacity = frames_capacity ? frames_capacity * 2 : 16;
+                __ja_inflow_frame *grown = realloc(frames, capacity * sizeof(__ja_inflow_frame));
+                if (!grown) {
+                    JA_MEM_ERROR();
+                    break;
+                }
+                frames = grown;
+                frames_capacity = capacity;
+            }
+
+            ja_val *container = c == '{' ? ja_new_obj() : ja_new_arr();
+            if (!container) break;
+            frames[depth++] = (__ja_inflow_frame){ container, NULL, 0 };
+            window->position++;
+            state = c == '{' ? EXPECT_KEY : EXPECT_VALUE;
+            continue;
+        }
+
+        size_t length = __ja_inflow_token(window);
+        if (window->failed) break;
+
+        const char *text = window->data + window->position;
+        int consumed = 0;
+        if (top && !object) {
+            bool stored = false;
+            if (!__ja_parse_packed(top->container, text, &consumed, &top->capacity, &stored)) {
+                __ja_inflow_token_error(window, length);
+                break;
+            }
+            if (stored) {
+                window->position += (size_t)consumed;
+                state = AFTER_VALUE;
+                continue;
+            }
+        }
+
+        ja_val *value = __ja_parse(text, &consumed);
+        if (!value) {
+            __ja_inflow_token_error(window, length);
+            break;
+        }
+        window->position += (size_t)consumed;
+        if (!__ja_inflow_attach(frames, depth, value, &root)) break;
+        state = AFTER_VALUE;
+    }
+
+    while (depth > 0) {
+        depth--;
+        if (frames[depth].key) __ja_key_release(frames[depth].key);
+        ja_free_val(&frames[depth].container);
+    }
+    free(frames);
+
+    if (!done) ja_free_val(&root);
+    return root;
+}
+
+// Parses a compressed file chunk by chunk, without ever holding its whole text
+static ja_val *__ja_read_inflow(FILE *file, const char *filename, __ja_compression compression) {
+    __ja_inflow_window *window = calloc(1, sizeof(__ja_inflow_window));
+    if (!window) {
+        JA_MEM_ERROR();
+        fclose(file);
+        return NULL;
+    }
+
+    ja_val *value = NULL;
+    if (__ja_inflow_open(&window->source, file, filename, compression)) {
+        ja_error_code previous_code = __ja_last_error_value.code;
+        __ja_last_error_value.code = JA_ERROR_NONE; // Tells memory errors of this call apart
+
+        __ja_parse_scope scope = { 0 };
+        __ja_parse_scope *previous = __ja_intern_begin(&scope);
+        window->scope = &scope;
+        window->line = 1;
+        value = __ja_parse_inflow(window);
+        __ja_intern_end(&scope, previous);
+
+        if (value) __ja_last_error_value.code = previous_code;
+    }
+
+    __ja_inflow_close(&window->source);
+    free(window->data);
+    free(window);
+    return value;
+}
+#endif
+
+char *__ja_read_file(const char *filename, size_t *length) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        JA_ERROR(JA_ERROR_IO, "Error while opening file: %s", filename);
+        return NULL;
+    }
+
+    __ja_compression compression = __ja_file_compression(file);
+    if (!__ja_compression_supported(compression, filename)) {
+        fclose(file);
+        return NULL;
+    }
+#if defined(JA_ZLIB) || defined(JA_ZSTD)
+    if (compression != __JA_COMPRESSION_NONE) return __ja_read_compressed(file, filename, compression, length);
+#endif
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (file_size <= 0) {
+        JA_ERROR(JA_ERROR_IO, "File is empty or unreadable: %s", filename);
+        fclose(file);
+        return NULL;
+    }
+
+    char* buffer = malloc(file_size + 1);
+    if (!buffer) {
+        JA_MEM_ERROR();
+        fclose(file);
+        return NULL;
+    }
+
+    size_t bytes_read = fread(buffer, 1, file_size, file);
+    fclose(file);
+
+    if ((long)bytes_read != file_size) {
+        JA_ERROR(JA_ERROR_IO, "Expected to read %ld bytes but only read %zu.", file_size, bytes_read);
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[file_size] = '\0';
+    if (length) *length = bytes_read;
+
+    return buffer;
+}
+
+// Reads a file into `ja_json_object` and parses it, on `thread_count` threads when `parallel` is set.
+// Compressed files are parsed while they are decompressed, on the calling thread and without keeping
+// the text. `caller` names the public function in the errors.
+static bool __ja_read_json_with(ja_json *ja_json_object, const char *filename, bool parallel, int thread_count,
+                                const char *caller) {
+    if (!ja_json_object) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "%s() received NULL ja_json.", caller);
+        return false;
+    }
+
+    if (!filename) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Filename not specified, can't open file");
+        return false;
+    }
+
+#if defined(JA_ZLIB) || defined(JA_ZSTD)
+    FILE *file = fopen(filename, "rb");
+    __ja_compression compression = file ? __ja_file_compression(file) : __JA_COMPRESSION_NONE;
+    if (compression != __JA_COMPRESSION_NONE) {
+        if (!__ja_compression_supported(compression, filename)) {
+            fclose(file);
+            JA_PROPAGATE_ERROR(caller);
+            return false;
+        }
+
+        ja_val *parsed = __ja_read_inflow(file, filename, compression);
+        if (!parsed) {
+            JA_PROPAGATE_ERROR(caller);
+            return false;
+        }
+
+        ja_json_object->json_str = NULL;
+        ja_json_object->content = parsed;
+        return true;
+    }
+    if (file) fclose(file);
+#endif
+
+    char *buffer = __ja_read_file(filename, NULL);
+    if (!buffer) {
+        JA_PROPAGATE_ERROR(caller);
+        return false;
+    }
+
+    ja_val *parsed = parallel ? ja_parse_parallel(buffer, thread_count) : ja_parse(buffer);
+    if (!parsed) {
+        JA_PROPAGATE_ERROR(caller);
+        free(buffer);
+        ja_json_object->json_str = NULL;
+        ja_json_object->content = NULL;
+        return false;
+    }
+
+    ja_json_object->json_str = buffer;
+    ja_json_object->content = parsed;
+
+    return true;
+}
+
+bool ja_read_json(ja_json *ja_json_object, const char *filename) {
+    return __ja_read_json_with(ja_json_object, filename, false, 0, "ja_read_json");
+}
+
+bool ja_read_json_parallel(ja_json *ja_json_object, const char *filename, int thread_count) {
+    return __ja_read_json_with(ja_json_object, filename, true, thread_count, "ja_read_json_parallel");
+}
+
+bool ja_write_json(ja_json *ja_json_object, const char *filename) {
+    if (!ja_json_object) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_sync_json() called with NULL pointer.");
+        return false;
+    }
+
+    if (!filename) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't save file with NULL filename.");
+        return false;
+    }
+
+    ja_sync_json(ja_json_object);
+
+    if (!ja_json_object->json_str) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "No JSON string to write.");
+        return false;
+    }
+
+    if (!__ja_write_file(filename, ja_json_object->json_str, strlen(ja_json_object->json_str))) {
+        JA_PROPAGATE_ERROR("ja_write_json");
+        return false;
+    }
+
+    return true;
+}
+
+// Checks whether a filename ends with an extension
+static bool __ja_has_extension(const char *filename, const char *extension) {
+    size_t length = strlen(filename);
+    size_t extension_length = strlen(extension);
+    return length > extension_length && strcmp(filename + length - extension_length, extension) == 0;
+}
+
+#ifdef JA_ZLIB
+// Deflates a buffer into a gzip file, one chunk of output at a time
+static bool __ja_write_gzip(FILE *file, const char *data, size_t length) {
+    unsigned char output[JA_COMPRESSED_CHUNK];
+    z_stream stream = { 0 };
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+
+    bool ok = true;
+    int status = Z_OK;
+    while (ok && status != Z_STREAM_END) {
+        if (stream.avail_in == 0 && length > 0) {
+            uInt chunk = length > UINT_MAX ? UINT_MAX : (uInt)length;
+            stream.next_in = (Bytef *)data;
+            stream.avail_in = chunk;
+            data += chunk;
+            length -= chunk;
+        }
+
+        stream.next_out = output;
+        stream.avail_out = sizeof(output);
+        status = deflate(&stream, length == 0 ? Z_FINISH : Z_NO_FLUSH);
+
+        size_t produced = sizeof(output) - stream.avail_out;
+        ok = status != Z_STREAM_ERROR && fwrite(output, 1, produced, file) == produced;
+    }
+
+    deflateEnd(&stream);
+    return ok;
+}
+#endif
+
+#ifdef JA_ZSTD
+// Compresses a buffer into a Zstandard file, one chunk of output at a time
+static bool __ja_write_zstd(FILE *file, const char *data, size_t length) {
+    unsigned char output[JA_COMPRESSED_CHUNK];
+    ZSTD_CCtx *context = ZSTD_createCCtx();
+    if (!context) return false;
+
+    ZSTD_inBuffer in = { data, length, 0 };
+    size_t remaining;
+    bool ok = true;
+    do {
+        ZSTD_outBuffer out = { output, sizeof(output), 0 };
+        remaining = ZSTD_compressStream2(context, &out, &in, ZSTD_e_end);
+        ok = !ZSTD_isError(remaining) && fwrite(output, 1, out.pos, file) == out.pos;
+    } while (ok && remaining != 0);
+
+    ZSTD_freeCCtx(context);
+    return ok;
+}
+#endif
+
+bool __ja_write_file(const char *filename, const char *data, size_t length) {
+    bool gzip = __ja_has_extension(filename, ".gz");
+    bool zstd = __ja_has_extension(filename, ".zst");
+
+#ifndef JA_ZLIB
+    if (gzip) {
+        JA_ERROR(JA_ERROR_IO, "Can't write %s, build with JA_ZLIB to write gzip files.", filename);
+        return false;
+    }
+#endif
+#ifndef JA_ZSTD
+    if (zstd) {
+        JA_ERROR(JA_ERROR_IO, "Can't write %s, build with JA_ZSTD to write Zstandard files.", filename);
+        return false;
+    }
+#endif
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        JA_ERROR(JA_ERROR_IO, "Error opening file: %s", filename);
+        return false;
+    }
+
+    bool ok;
+#ifdef JA_ZLIB
+    if (gzip) ok = __ja_write_gzip(file, data, length);
+    else
+#endif
+#ifdef JA_ZSTD
+    if (zstd) ok = __ja_write_zstd(file, data, length);
+    else
+#endif
+    ok = fwrite(data, 1, length, file) == length;
+
+    if (fclose(file) != 0) ok = false;
+    if (!ok) JA_ERROR(JA_ERROR_IO, "Error while writing file: %s", filename);
+    return ok;
+}
+
+void ja_sync_json(ja_json *ja_json_object) {
+    if (!ja_json_object) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_sync_json() called with NULL pointer.");
+        return;
+    }
+
+    if (!ja_json_object->content) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "No content to sync.");
+        return;
+    }
+
+    char *json_str = ja_stringify(ja_json_object->content);
+    if (!json_str) {
+        JA_PROPAGATE_ERROR("ja_write_json");
+        return;
+    }
+
+    free(ja_json_object->json_str);
+    ja_json_object->json_str = json_str;
+}
+
+size_t ja_minify(char *json_str, size_t length) {
+    if (!json_str) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL string passed to ja_minify().");
+        return 0;
+    }
+
+    __ja_minify_state state = { false, false };
+    size_t new_length = __ja_minify_buffer(json_str, length, &state);
+    if (new_length < length) json_str[new_length] = '\0';
+    return new_length;
+}
+
+bool ja_minify_stream(FILE *input, FILE *output) {
+    if (!input || !output) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL stream passed to ja_minify_stream().");
+        return false;
+    }
+
+    char *buffer = malloc(JA_MINIFY_BUFFER_SIZE);
+    if (!buffer) {
+        JA_MEM_ERROR();
+        return false;
+    }
+
+    __ja_minify_state state = { false, false };
+    size_t read_count;
+    bool result = true;
+
+    while ((read_count = fread(buffer, 1, JA_MINIFY_BUFFER_SIZE, input)) > 0) {
+        size_t length = __ja_minify_buffer(buffer, read_count, &state);
+        if (fwrite(buffer, 1, length, output) != length) {
+            JA_ERROR(JA_ERROR_IO, "Error writing minified JSON.");
+            result = false;
+            break;
+        }
+    }
+
+    if (result && ferror(input)) {
+        JA_ERROR(JA_ERROR_IO, "Error reading JSON to be minified.");
+        result = false;
+    }
+
+    free(buffer);
+    return result;
+}
+
+bool ja_minify_file(const char *input_filename, const char *output_filename) {
+    if (!input_filename || !output_filename) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL filename passed to ja_minify_file().");
+        return false;
+    }
+
+    FILE *input = fopen(input_filename, "rb");
+    if (!input) {
+        JA_ERROR(JA_ERROR_IO, "Error opening file: %s", input_filename);
+        return false;
+    }
+
+    FILE *output = fopen(output_filename, "wb");
+    if (!output) {
+        JA_ERROR(JA_ERROR_IO, "Error opening file: %s", output_filename);
+        fclose(input);
+        return false;
+    }
+
+    bool result = ja_minify_stream(input, output);
+
+    fclose(input);
+    if (fclose(output) != 0) {
+        JA_ERROR(JA_ERROR_IO, "Error writing file: %s", output_filename);
+        result = false;
+    }
+    return result;
+}
+
+size_t __ja_minify_buffer(char *json_str, size_t length, __ja_minify_state *state) {
+    size_t read = 0, write = 0;
+
+    while (read < length) {
+        if (state->in_string) {
+            if (state->escaped) {
+                json_str[write++] = json_str[read++];
+                state->escaped = false;
+                continue;
+            }
+
+            // Strings are copied as they are, up to the next quote or backslash
+            const char *stop = __ja_string_scan(json_str + read, json_str + length);
+            size_t run = (size_t)(stop - (json_str + read));
+            if (write != read) memmove(json_str + write, json_str + read, run);
+            write += run;
+            read += run;
+            if (read == length) break;
+
+            char c = json_str[read++];
+            json_str[write++] = c;
+            if (c == '"') state->in_string = false;
+            else if (c == '\\') state->escaped = true;
+            continue;
+        }
+
+        size_t run = __ja_minify_span(json_str + read, length - read, false);
+        if (write != read) memmove(json_str + write, json_str + read, run);
+        write += run;
+        read += run;
+        if (read == length) break;
+
+        if (json_str[read] == '"') {
+            json_str[write++] = json_str[read++];
+            state->in_string = true;
+        } else {
+            read += __ja_minify_span(json_str + read, length - read, true);
+        }
+    }
+
+    return write;
+}
+
+#define __JA_IS_JSON_SPACE(c) ((c) == ' ' || (c) == '\n' || (c) == '\r' || (c) == '\t')
+
+size_t __ja_minify_span(const char *p, size_t length, bool whitespace) {
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i quote = _mm_set1_epi8('"');
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(const void *)(p + i));
+        __m128i spaces = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage_return), _mm_cmpeq_epi8(chunk, tab)));
+
+        unsigned mask = whitespace
+            ? ~(unsigned)_mm_movemask_epi8(spaces) & 0xFFFF
+            : (unsigned)_mm_movemask_epi8(_mm_or_si128(spaces, _mm_cmpeq_epi8(chunk, quote)));
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+#endif
+
+    if (whitespace) {
+        while (i < length && __JA_IS_JSON_SPACE(p[i])) i++;
+    } else {
+        while (i < length && !__JA_IS_JSON_SPACE(p[i]) && p[i] != '"') i++;
+    }
+    return i;
+}
+
+void ja_json_end(ja_json *ja_json_object) {
+    if (!ja_json_object) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't end NULL ja_json.");
+        return;
+    }
+    
+    if (ja_json_object->json_str) {
+        free(ja_json_object->json_str);
+        ja_json_object->json_str = NULL;
+    }
+
+    if (ja_json_object->content) {
+        ja_free_val(&ja_json_object->content);
+        ja_json_object->content = NULL;
+    }
+
+    free(ja_json_object);
+}
+
+int __ja_thread_count(int requested) {
+#ifdef JA_THREADS
+    if (requested > 0) return requested;
+
+    #ifdef _WIN32
+        SYSTEM_INFO system_info;
+        GetSystemInfo(&system_info);
+        return system_info.dwNumberOfProcessors > 0 ? (int)system_info.dwNumberOfProcessors : 1;
+    #else
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        return cores > 0 ? (int)cores : 1;
+    #endif
+#else
+    (void)requested;
+    return 1;
+#endif
+}
+
+// Shared state of a __ja_parallel_for() call
+typedef struct __ja_parallel_job {
+    __ja_task_fn task;
+    void *context;
+    size_t task_count;
+    size_t next_task;
+    size_t helpers;                   // Pool threads that may still join the job
+    size_t active;                    // Pool threads running tasks of the job
+    struct __ja_parallel_job *next;   // Jobs waiting for helpers
+} __ja_parallel_job;
+
+static void __ja_parallel_run(__ja_parallel_job *job) {
+    size_t index;
+
+    while ((index = __atomic_fetch_add(&job->next_task, 1, __ATOMIC_RELAXED)) < job->task_count) {
+        job->task(job->context, index);
+    }
+}
+
+#ifdef JA_THREADS
+// Threads kept between __ja_parallel_for() calls, started when a call needs more of them
+static pthread_mutex_t __ja_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t __ja_pool_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t __ja_pool_done = PTHREAD_COND_INITIALIZER;
+static pthread_t *__ja_pool_threads = NULL;
+static size_t __ja_pool_size = 0;
+static __ja_parallel_job *__ja_pool_jobs = NULL;
+static bool __ja_pool_stopping = false;
+
+static void *__ja_pool_worker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&__ja_pool_lock);
+
+    for (;;) {
+        while (!__ja_pool_jobs && !__ja_pool_stopping) {
+            pthread_cond_wait(&__ja_pool_queued, &__ja_pool_lock);
+        }
+        if (!__ja_pool_jobs) break; // Stopping, and nothing left to help with
+
+        __ja_parallel_job *job = __ja_pool_jobs;
+        if (--job->helpers == 0) __ja_pool_jobs = job->next;
+        job->active++;
+
+        pthread_mutex_unlock(&__ja_pool_lock);
+        __ja_parallel_run(job);
+        pthread_mutex_lock(&__ja_pool_lock);
+
+        if (--job->active == 0) pthread_cond_broadcast(&__ja_pool_done);
+    }
+
+    pthread_mutex_unlock(&__ja_pool_lock);
+    return NULL;
+}
+
+// Starts pool threads until there are `wanted` of them (or as many as could be started)
+static void __ja_pool_grow(size_t wanted) {
+    if (__ja_pool_size >= wanted || __ja_pool_stopping) return;
+
+    pthread_t *threads = realloc(__ja_pool_threads, sizeof(pthread_t) * wanted);
+    if (!threads) {
+        JA_MEM_ERROR(); // Not fatal, the threads already started share the tasks
+        return;
+    }
+    __ja_pool_threads = threads;
+
+    while (__ja_pool_size < wanted && pthread_create(&threads[__ja_pool_size], NULL, __ja_pool_worker, NULL) == 0) {
+        __ja_pool_size++;
+    }
+}
+#endif
+
+void __ja_parallel_for(size_t task_count, int thread_count, __ja_task_fn task, void *context) {
+    if (!task || task_count == 0) return;
+
+    __ja_parallel_job job = { task, context, task_count, 0, 0, 0, NULL };
+
+#ifdef JA_THREADS
+    size_t workers = (size_t)__ja_thread_count(thread_count);
+    if (workers > task_count) workers = task_count;
+
+    if (workers > 1) {
+        pthread_mutex_lock(&__ja_pool_lock);
+        __ja_pool_grow(workers - 1);
+        job.helpers = workers - 1 < __ja_pool_size ? workers - 1 : __ja_pool_size;
+        if (job.helpers > 0) {
+            // Queued last, so calls made at the same time (or from inside a task) get helpers in turn
+            __ja_parallel_job **tail = &__ja_pool_jobs;
+            while (*tail) tail = &(*tail)->next;
+            *tail = &job;
+            pthread_cond_broadcast(&__ja_pool_queued);
+        }
+        pthread_mutex_unlock(&__ja_pool_lock);
+
+        __ja_parallel_run(&job);
+
+        // Every task is taken: no thread may join anymore, wait for the ones still running
+        pthread_mutex_lock(&__ja_pool_lock);
+        if (job.helpers > 0) {
+            for (__ja_parallel_job **link = &__ja_pool_jobs; *link; link = &(*link)->next) {
+                if (*link == &job) {
+                    *link = job.next;
+                    break;
+                }
+            }
+            job.helpers = 0;
+        }
+        while (job.active > 0) pthread_cond_wait(&__ja_pool_done, &__ja_pool_lock);
+        pthread_mutex_unlock(&__ja_pool_lock);
+        return;
+    }
+#else
+    (void)thread_count;
+#endif
+
+    __ja_parallel_run(&job);
+}
+
+void ja_stop_worker_threads(void) {
+#ifdef JA_THREADS
+    pthread_mutex_lock(&__ja_pool_lock);
+    if (__ja_pool_stopping) { // Already being stopped by another thread
+        pthread_mutex_unlock(&__ja_pool_lock);
+        return;
+    }
+    __ja_pool_stopping = true;
+    pthread_cond_broadcast(&__ja_pool_queued);
+    pthread_t *threads = __ja_pool_threads;
+    size_t size = __ja_pool_size;
+    pthread_mutex_unlock(&__ja_pool_lock);
+
+    for (size_t i = 0; i < size; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_lock(&__ja_pool_lock);
+    free(__ja_pool_threads);
+    __ja_pool_threads = NULL;
+    __ja_pool_size = 0;
+    __ja_pool_stopping = false;
+    pthread_mutex_unlock(&__ja_pool_lock);
+#endif
+}
+
+ja_ndjson_options ja_ndjson_default_options(void) {
+    ja_ndjson_options options;
+
+    options.thread_count = 0;
+    options.batch_size = JA_NDJSON_DEFAULT_BATCH_SIZE;
+    options.ordered = true;
+    options.skip_invalid = false;
+
+    return options;
+}
+
+ja_ndjson_reader *ja_ndjson_open(const char *filename, const ja_ndjson_options *options) {
+    if (!filename) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Filename not specified, can't open file");
+        return NULL;
+    }
+
+    ja_ndjson_reader *reader = calloc(1, sizeof(ja_ndjson_reader));
+    if (!reader) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    reader->options = options ? *options : ja_ndjson_default_options();
+    if (reader->options.batch_size == 0) {
+        reader->options.batch_size = JA_NDJSON_DEFAULT_BATCH_SIZE;
+    }
+
+    reader->file = fopen(filename, "rb");
+    if (!reader->file) {
+        JA_ERROR(JA_ERROR_IO, "Error while opening file: %s", filename);
+        free(reader);
+        return NULL;
+    }
+
+    // One extra byte so the last line can be terminated even without a trailing newline
+    reader->buffer = malloc(reader->options.batch_size + 1);
+    if (!reader->buffer) {
+        JA_MEM_ERROR();
+        fclose(reader->file);
+        free(reader);
+        return NULL;
+    }
+
+    reader->buffer_capacity = reader->options.batch_size;
+    reader->next_line = 1;
+
+    return reader;
+}
+
+// Shared state for parsing the lines of one batch
+typedef struct __ja_ndjson_job {
+    ja_ndjson_reader *reader;
+    size_t lines_per_task;
+    ja_ndjson_callback callback;
+    void *user_data;
+    bool stop;
+} __ja_ndjson_job;
+
+void __ja_ndjson_parse_task(void *context, size_t task_index) {
+    __ja_ndjson_job *job = context;
+    ja_ndjson_reader *reader = job->reader;
+
+    size_t first = task_index * job->lines_per_task;
+    size_t last = first + job->lines_per_task;
+    if (last > reader->line_count) last = reader->line_count;
+
+    // Lines of the same task share their keys and shapes
+    __ja_parse_scope scope = { .end = reader->buffer + reader->buffer_used };
+    __ja_parse_scope *previous = __ja_intern_begin(&scope);
+
+    for (size_t i = first; i < last; i++) {
+        if (__atomic_load_n(&job->stop, __ATOMIC_RELAXED)) break;
+
+        __ja_ndjson_line *line = &reader->lines[i];
+        int consumed = 0;
+        ja_val *document = __ja_parse(line->text, &consumed);
+
+        if (document) {
+            // A line must hold exactly one value
+            const char *rest = line->text + consumed;
+            __ja_jump_whitespaces(&rest, NULL);
+            if (*rest != '\0') {
+                JA_LOG_ERROR("Unexpected content after value at line %zu: '%c'", line->line, *rest);
+                ja_free_val(&document);
+            }
+        }
+
+        if (!document) {
+            line->invalid = true;
+            if (job->callback && !reader->options.skip_invalid) {
+                __atomic_store_n(&job->stop, true, __ATOMIC_RELAXED);
+            }
+            continue;
+        }
+
+        if (!job->callback) {
+            line->document = document;
+        } else if (!job->callback(document, line->line, job->user_data)) {
+            __atomic_store_n(&job->stop, true, __ATOMIC_RELAXED);
+        }
     }
 
-    case JA_TYPE_STRING: {
-        ja_val *str_cpy = ja_copy(target);
-        ja_val *new_arr = ja_new_arr();
-        if (!new_arr || !str_cpy) {
+    __ja_intern_end(&scope, previous);
+}
+
+bool __ja_ndjson_load_batch(ja_ndjson_reader *reader, ja_ndjson_callback callback, void *user_data) {
+    for (size_t i = reader->cursor; i < reader->line_count; i++) {
+        ja_free_val(&reader->lines[i].document);
+    }
+    reader->line_count = 0;
+    reader->cursor = 0;
+
+    // Keep the incomplete line at the end of the previous batch
+    if (reader->consumed > 0) {
+        memmove(reader->buffer, reader->buffer + reader->consumed, reader->buffer_used - reader->consumed);
+        reader->buffer_used -= reader->consumed;
+        reader->buffer_offset += reader->consumed;
+        reader->consumed = 0;
+    }
+
+    size_t complete = 0; // Bytes up to the last newline, only complete lines are parsed
+    while (true) {
+        if (!reader->eof && reader->buffer_used < reader->buffer_capacity) {
+            size_t bytes_read = fread(reader->buffer + reader->buffer_used, 1,
+                                      reader->buffer_capacity - reader->buffer_used, reader->file);
+            reader->buffer_used += bytes_read;
+
+            if (bytes_read == 0) {
+                if (ferror(reader->file)) {
+                    JA_ERROR(JA_ERROR_IO, "Error while reading NDJSON file.");
+                    reader->stopped = true;
+                    return false;
+                }
+                reader->eof = true;
+            }
+        }
+
+        size_t last_newline = reader->buffer_used;
+        while (last_newline > 0 && reader->buffer[last_newline - 1] != '\n') last_newline--;
+
+        if (last_newline > 0) {
+            complete = last_newline;
+            break;
+        }
+
+        if (reader->eof) {
+            complete = reader->buffer_used;
+            break;
+        }
+
+        if (reader->buffer_used == reader->buffer_capacity) {
+            // A single line is bigger than the buffer
+            size_t new_capacity = reader->buffer_capacity * 2;
+            char *new_buffer = realloc(reader->buffer, new_capacity + 1);
+            if (!new_buffer) {
+                JA_MEM_ERROR();
+                reader->stopped = true;
+                return false;
+            }
+            reader->buffer = new_buffer;
+            reader->buffer_capacity = new_capacity;
+        }
+    }
+
+    if (complete == 0) return false;
+
+    size_t start = 0;
+    while (start < complete) {
+        char *newline = memchr(reader->buffer + start, '\n', complete - start);
+        size_t end = newline ? (size_t)(newline - reader->buffer) : complete;
+        size_t text_end = end;
+
+        if (text_end > start && reader->buffer[text_end - 1] == '\r') text_end--;
+        reader->buffer[text_end] = '\0';
+
+        const char *text = reader->buffer + start;
+        __ja_jump_whitespaces(&text, NULL);
+
+        if (*text != '\0') {
+            if (reader->line_count == reader->line_capacity) {
+                size_t new_capacity = reader->line_capacity ? reader->line_capacity * 2 : 1024;
+                __ja_ndjson_line *new_lines = realloc(reader->lines, sizeof(__ja_ndjson_line) * new_capacity);
+                if (!new_lines) {
+                    JA_MEM_ERROR();
+                    reader->stopped = true;
+                    return false;
+                }
+                reader->lines = new_lines;
+                reader->line_capacity = new_capacity;
+            }
+
+            __ja_ndjson_line *line = &reader->lines[reader->line_count++];
+            line->text = reader->buffer + start;
+            line->line = reader->next_line;
+            line->offset = reader->buffer_offset + start;
+            line->document = NULL;
+            line->invalid = false;
+        }
+
+        reader->next_line++;
+        start = end + 1;
+    }
+    reader->consumed = complete;
+
+    if (reader->line_count == 0) return true;
+
+    int threads = __ja_thread_count(reader->options.thread_count);
+    size_t task_count = (size_t)threads * 4; // Smaller tasks balance lines of uneven length
+    if (task_count > reader->line_count) task_count = reader->line_count;
+
+    __ja_ndjson_job job;
+    job.reader = reader;
+    job.lines_per_task = (reader->line_count + task_count - 1) / task_count;
+    job.callback = callback;
+    job.user_data = user_data;
+    job.stop = false;
+
+    __ja_parallel_for((reader->line_count + job.lines_per_task - 1) / job.lines_per_task,
+                      threads, __ja_ndjson_parse_task, &job);
+
+    for (size_t i = 0; i < reader->line_count; i++) {
+        if (!reader->lines[i].invalid) continue;
+
+        __ja_ndjson_add_error(reader, &reader->lines[i]);
+        if (!reader->options.skip_invalid) break; // Only the first one is reached when stopping
+    }
+
+    if (callback && job.stop) reader->stopped = true;
+
+    return true;
+}
+
+void __ja_ndjson_add_error(ja_ndjson_reader *reader, const __ja_ndjson_line *line) {
+    if (reader->error_count == reader->error_capacity) {
+        size_t new_capacity = reader->error_capacity ? reader->error_capacity * 2 : 16;
+        ja_ndjson_error *new_errors = realloc(reader->errors, sizeof(ja_ndjson_error) * new_capacity);
+        if (!new_errors) {
             JA_MEM_ERROR();
             return;
         }
+        reader->errors = new_errors;
+        reader->error_capacity = new_capacity;
+    }
 
-        size_t str_length = strlen(target->u.string);
-        for (size_t i = 0; i < str_length; i++) {
-            char sub_str[2] = {0};
-            sub_str[0] = str_cpy->u.string[i];
-            ja_arr_append(new_arr, ja_new_str(sub_str));
+    reader->errors[reader->error_count].line = line->line;
+    reader->errors[reader->error_count].offset = line->offset;
+    reader->error_count++;
+}
+
+ja_val *ja_ndjson_next(ja_ndjson_reader *reader, size_t *line) {
+    if (!reader) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_ndjson_next() received NULL reader.");
+        return NULL;
+    }
+
+    while (!reader->stopped) {
+        while (reader->cursor < reader->line_count) {
+            __ja_ndjson_line *current = &reader->lines[reader->cursor++];
+
+            if (current->invalid) {
+                if (reader->options.skip_invalid) continue;
+                reader->stopped = true;
+                return NULL;
+            }
+
+            ja_val *document = current->document;
+            current->document = NULL;
+            if (line) *line = current->line;
+            return document;
         }
 
-        __ja_free_val(target);
-        target->u.array.items = new_arr->u.array.items;
-        target->u.array.size = new_arr->u.array.size;
-        target->type = JA_TYPE_ARRAY;
-        free(new_arr);
-        return;
+        if (!__ja_ndjson_load_batch(reader, NULL, NULL)) return NULL;
     }
 
-    case JA_TYPE_BOOL: {
-        ja_val *bool_cpy = ja_copy(target);
-        ja_val *new_arr = ja_new_arr();
-        if (!new_arr || !bool_cpy) {
-            return;
+    return NULL;
+}
+
+bool ja_ndjson_for_each(ja_ndjson_reader *reader, ja_ndjson_callback callback, void *user_data) {
+    if (!reader || !callback) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL pointers passed to ja_ndjson_for_each().");
+        return false;
+    }
+
+    if (reader->options.ordered) {
+        ja_val *document;
+        size_t line = 0;
+
+        while ((document = ja_ndjson_next(reader, &line))) {
+            if (!callback(document, line, user_data)) {
+                reader->stopped = true;
+                return false;
+            }
         }
+    } else {
+        while (!reader->stopped && __ja_ndjson_load_batch(reader, callback, user_data));
+    }
 
-        __ja_free_val(target);
-        ja_arr_append(new_arr, bool_cpy);
-        target->u.array.items = new_arr->u.array.items;
-        target->u.array.size = new_arr->u.array.size;
-        target->type = JA_TYPE_ARRAY;
-        free(new_arr);
+    return !reader->stopped;
+}
+
+const ja_ndjson_error *ja_ndjson_errors(ja_ndjson_reader *reader, size_t *count) {
+    if (!reader) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_ndjson_errors() received NULL reader.");
+        if (count) *count = 0;
+        return NULL;
+    }
+
+    if (count) *count = reader->error_count;
+    return reader->errors;
+}
+
+void ja_ndjson_close(ja_ndjson_reader *reader) {
+    if (!reader) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "Can't close NULL ja_ndjson_reader.");
         return;
     }
 
-    case JA_TYPE_NULL: {
-        ja_val *new_arr = ja_new_arr();
-        if (!new_arr) {
-            return;
-        }
+    for (size_t i = reader->cursor; i < reader->line_count; i++) {
+        ja_free_val(&reader->lines[i].document);
+    }
 
-        __ja_free_val(target);
-        target->u.array.items = new_arr->u.array.items;
-        target->u.array.size = new_arr->u.array.size;
-        target->type = JA_TYPE_ARRAY;
-        free(new_arr);
+    if (reader->file) fclose(reader->file);
+    free(reader->lines);
+    free(reader->errors);
+    free(reader->buffer);
+    free(reader);
+}
+
+// Tables of the document being parsed by the current thread (NULL outside of the parser)
+static JA_THREAD_LOCAL __ja_parse_scope *__ja_parse_current = NULL;
+
+static ja_intern_mode __ja_intern_mode = JA_INTERN_DOCUMENT;
+static ja_key_table __ja_global_keys = { 0 };
+#ifdef JA_THREADS
+static pthread_mutex_t __ja_global_keys_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void ja_set_intern_mode(ja_intern_mode mode) {
+    if (mode != JA_INTERN_DOCUMENT && mode != JA_INTERN_GLOBAL) {
+        JA_LOG_ERROR("Invalid intern mode: %d", (int)mode);
         return;
     }
+    __atomic_store_n(&__ja_intern_mode, mode, __ATOMIC_RELAXED);
+}
+
+void ja_clear_interned_keys(void) {
+#ifdef JA_THREADS
+    pthread_mutex_lock(&__ja_global_keys_lock);
+#endif
+    __ja_key_table_clear(&__ja_global_keys);
+#ifdef JA_THREADS
+    pthread_mutex_unlock(&__ja_global_keys_lock);
+#endif
+}
+
+uint64_t __ja_hash_str(const char *str, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+__ja_key *__ja_key_header(const char *key) {
+    return (__ja_key *)(void *)(key - sizeof(__ja_key));
+}
+
+char *__ja_key_new(const char *key, size_t length) {
+    __ja_key *header = malloc(sizeof(__ja_key) + length + 1);
+    if (!header) {
+        JA_MEM_ERROR();
+        return NULL;
+    }
+
+    header->refcount = 1;
+    header->hash = __ja_hash_str(key, length);
+    header->length = length;
+
+    char *characters = (char *)(header + 1);
+    memcpy(characters, key, length);
+    characters[length] = '\0';
+    return characters;
+}
+
+char *__ja_key_retain(char *key) {
+    if (key) __atomic_add_fetch(&__ja_key_header(key)->refcount, 1, __ATOMIC_RELAXED);
+    return key;
+}
+
+void __ja_key_release(char *key) {
+    if (!key) return;
+
+    __ja_key *header = __ja_key_header(key);
+    if (__atomic_sub_fetch(&header->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(header);
+    }
+}
+
+bool __ja_key_equals(const char *stored, const char *key, uint64_t hash, size_t length) {
+    if (stored == key) return true;
+
+    const __ja_key *header = __ja_key_header(stored);
+    return header->hash == hash && header->length == length && memcmp(stored, key, length) == 0;
+}
+
+char *__ja_key_intern(ja_key_table *table, const char *key, size_t length) {
+    if (table->count * 2 >= table->capacity) {
+        size_t new_capacity = table->capacity ? table->capacity * 2 : 64;
+        char **new_slots = calloc(new_capacity, sizeof(char*));
+        if (!new_slots) {
+            JA_MEM_ERROR();
+            return NULL;
+        }
+
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (!table->slots[i]) continue;
+
+            size_t slot = (size_t)__ja_key_header(table->slots[i])->hash & (new_capacity - 1);
+            while (new_slots[slot]) slot = (slot + 1) & (new_capacity - 1);
+            new_slots[slot] = table->slots[i];
+        }
+
+        free(table->slots);
+        table->slots = new_slots;
+        table->capacity = new_capacity;
+    }
+
+    uint64_t hash = __ja_hash_str(key, length);
+    size_t slot = (size_t)hash & (table->capacity - 1);
+
+    while (table->slots[slot]) {
+        if (__ja_key_equals(table->slots[slot], key, hash, length)) {
+            return __ja_key_retain(table->slots[slot]);
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    char *interned = __ja_key_new(key, length);
+    if (!interned) return NULL;
+
+    table->slots[slot] = interned; // The table keeps the first reference
+    table->count++;
+    return __ja_key_retain(interned);
+}
+
+void __ja_key_table_clear(ja_key_table *table) {
+    for (size_t i = 0; i < table->capacity; i++) {
+        __ja_key_release(table->slots[i]);
+    }
+
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+    table->count = 0;
+}
+
+char *__ja_key_make(const char *key, size_t length) {
+    if (__atomic_load_n(&__ja_intern_mode, __ATOMIC_RELAXED) == JA_INTERN_GLOBAL) {
+#ifdef JA_THREADS
+        pthread_mutex_lock(&__ja_global_keys_lock);
+#endif
+        char *interned = __ja_key_intern(&__ja_global_keys, key, length);
+#ifdef JA_THREADS
+        pthread_mutex_unlock(&__ja_global_keys_lock);
+#endif
+        return interned;
+    }
+
+    if (__ja_parse_current) return __ja_key_intern(&__ja_parse_current->keys, key, length);
+
+    return __ja_key_new(key, length);
+}
+
+__ja_parse_scope *__ja_intern_begin(__ja_parse_scope *scope) {
+    __ja_parse_scope *previous = __ja_parse_current;
+    __ja_parse_current = scope;
+    return previous;
+}
+
+const char *__ja_parse_end(void) {
+    return __ja_parse_current ? __ja_parse_current->end : NULL;
+}
+
+void __ja_intern_end(__ja_parse_scope *scope, __ja_parse_scope *previous) {
+    __ja_parse_current = previous;
+
+    for (size_t i = 0; i < scope->shapes.capacity; i++) {
+        __ja_shape_release(scope->shapes.slots[i]);
+    }
+    free(scope->shapes.slots);
+    scope->shapes.slots = NULL;
+    scope->shapes.capacity = 0;
+    scope->shapes.count = 0;
+
+    __ja_key_table_clear(&scope->keys);
+}
+
+size_t __ja_obj_find(ja_val *object, const char *key, uint64_t hash, size_t length) {
+    if (object->flags & JA_FLAG_SHAPED) {
+        ja_shape *shape = __JA_OBJ_SHAPE(object);
+        size_t slot = __ja_shape_find(shape, key, hash, length);
+        if (slot < shape->size) __atomic_store_n(&shape->cached, slot, __ATOMIC_RELAXED);
+        return slot;
+    }
+
+    if (object->flags & JA_FLAG_KEY_MAP) {
+        const ja_key_map *map = __JA_OBJ_MAP(object);
+        size_t entry = (size_t)hash & map->index_mask;
+
+        while (map->index[entry]) {
+            size_t position = map->index[entry] - 1;
+            if (__ja_key_equals(object->u.object.pairs[position].key, key, hash, length)) return position;
+            entry = (entry + 1) & map->index_mask;
+        }
+        return object->u.object.size;
+    }
+
+    for (size_t i = 0; i < object->u.object.size; i++) {
+        if (__ja_key_equals(object->u.object.pairs[i].key, key, hash, length)) return i;
+    }
+    return object->u.object.size;
+}
+
+size_t __ja_obj_lookup(ja_val *object, const char *key) {
+    if (object->flags & JA_FLAG_SHAPED) {
+        // Loops reading the same field of many records hit the cached slot without hashing
+        ja_shape *shape = __JA_OBJ_SHAPE(object);
+        size_t cached = __atomic_load_n(&shape->cached, __ATOMIC_RELAXED);
+        if (strcmp(shape->keys[cached], key) == 0) return cached;
+    }
+
+    size_t length = strlen(key);
+    return __ja_obj_find(object, key, __ja_hash_str(key, length), length);
+}
+
+char *__ja_obj_key(ja_val *object, size_t index) {
+    if (object->flags & JA_FLAG_SHAPED) return __JA_OBJ_SHAPE(object)->keys[index];
+    return object->u.object.pairs[index].key;
+}
+
+ja_val **__ja_obj_slot(ja_val *object, size_t index) {
+    if (object->flags & JA_FLAG_SHAPED) return &object->u.object.values[index];
+    return &object->u.object.pairs[index].value_ptr;
+}
+
+ja_shape *__ja_obj_shape_of(const ja_val *object) {
+    return object->type == JA_TYPE_OBJECT && (object->flags & JA_FLAG_SHAPED) ? __JA_OBJ_SHAPE(object) : NULL;
+}
+
+ja_key_map *__ja_obj_key_map(const ja_val *object) {
+    return object->type == JA_TYPE_OBJECT && (object->flags & JA_FLAG_KEY_MAP) ? __JA_OBJ_MAP(object) : NULL;
+}
+
+// Forgets the positions of the members of a key map, after members were added, removed or moved
+static inline void __ja_key_map_moved(ja_key_map *map) {
+    free(map->members);
+    map->members = NULL;
+}
+
+// Indexes the pair at a position in a key map
+static void __ja_key_map_add(ja_key_map *map, uint64_t hash, size_t position) {
+    size_t entry = (size_t)hash & map->index_mask;
+    while (map->index[entry]) entry = (entry + 1) & map->index_mask;
+    map->index[entry] = (uint32_t)(position + 1);
+}
+
+// Gives an object a key map sized for `capacity` pairs, replacing the one it had, with the pairs resized to
+// `capacity` behind it. The object must own its pairs. false if they can't be allocated, the object left as it was.
+static bool __ja_key_map_build(ja_val *object, size_t capacity) {
+    if (capacity >= UINT32_MAX) return false; // Positions are stored in 32 bits, like the slots of shapes
+
+    size_t index_capacity = 16;
+    while (index_capacity < capacity * 2) index_capacity *= 2;
+
+    ja_key_map *map = malloc(sizeof(ja_key_map) + sizeof(uint32_t) * index_capacity);
+    if (!map) return false;
+
+    bool mapped = object->flags & JA_FLAG_KEY_MAP;
+    size_t bytes = sizeof(__ja_children_head) + sizeof(ja_pair) * capacity;
+    __ja_children_head *head = mapped ? realloc(__JA_CHILDREN_HEAD(object->u.object.pairs), bytes) : malloc(bytes);
+    if (!head) {
+        free(map);
+        return false;
+    }
+    if (!mapped) { // The pairs move behind the word holding the map
+        if (object->u.object.size) memcpy(head + 1, object->u.object.pairs, sizeof(ja_pair) * object->u.object.size);
+        free(object->u.object.pairs);
+    }
+
+    map->capacity = capacity;
+    map->removed = mapped ? head->map->removed : 0;
+    map->members = NULL;
+    map->index_mask = index_capacity - 1;
+    if (mapped) __ja_key_map_free(head->map);
+
+    head->map = map;
+    object->u.object.pairs = (ja_pair *)(void *)(head + 1);
+    object->flags |= JA_FLAG_KEY_MAP;
+    __ja_obj_reindex(object);
+    return true;
+}
+
+// Takes the key map out of an object, which must be compacted first since only mapped objects have tombstones
+static void __ja_key_map_drop(ja_val *object) {
+    if (!(object->flags & JA_FLAG_KEY_MAP)) return;
+
+    __ja_obj_compact(object);
+    ja_pair *pairs = object->u.object.pairs;
+    __ja_children_head *head = __JA_CHILDREN_HEAD(pairs);
+    __ja_key_map_free(head->map);
+
+    memmove(head, pairs, sizeof(ja_pair) * object->u.object.size); // The pairs take the place of the map
+    object->u.object.pairs = (ja_pair *)(void *)head;
+    object->flags &= ~JA_FLAG_KEY_MAP;
+}
+
+bool __ja_obj_put(ja_val *object, char *key, ja_val *value) {
+    const __ja_key *header = __ja_key_header(key);
+    size_t index = __ja_obj_find(object, key, header->hash, header->length);
+
+    if (index < object->u.object.size) {
+        __ja_key_release(key); // Keep the key already stored
+        ja_val **slot = __ja_obj_slot(object, index);
+        ja_free_val(slot);
+        *slot = value;
+        return true;
+    }
+
+    if (!__ja_obj_unshape(object) || !__ja_block_own_data(object) || !__ja_obj_reserve(object)) {
+        __ja_key_release(key);
+        return false;
+    }
+
+    size_t size = object->u.object.size;
+    object->u.object.pairs[size].key = key;
+    object->u.object.pairs[size].value_ptr = value;
+    object->u.object.size = size + 1;
+    if (object->flags & JA_FLAG_KEY_MAP) {
+        __ja_key_map_add(__JA_OBJ_MAP(object), header->hash, size);
+        __ja_key_map_moved(__JA_OBJ_MAP(object));
+    }
+    return true;
+}
+
+bool __ja_obj_reserve(ja_val *object) {
+    size_t size = object->u.object.size;
+    size_t capacity = (object->flags & JA_FLAG_KEY_MAP) ? __JA_OBJ_MAP(object)->capacity : size;
+    if (size < capacity) return true;
+
+    // Small objects stay tight, big ones double so appending stays amortized constant time
+    size_t grown = size + 1 < JA_OBJ_MAP_MIN ? size + 1 : size * 2;
+    if (grown > size + 1 && __ja_key_map_build(object, grown)) return true; // The pairs grow along with the map
+
+    __ja_key_map_drop(object); // Not fatal, the object is searched linearly
+    ja_pair *pairs = realloc(object->u.object.pairs, (object->u.object.size + 1) * sizeof(ja_pair));
+    if (!pairs) {
+        JA_MEM_ERROR();
+        return false;
+    }
+    object->u.object.pairs = pairs;
+    return true;
+}
+
+ja_val *__ja_obj_remove(ja_val *object, size_t index, char **key) {
+    if (!__ja_obj_unshape(object) || !__ja_block_own_data(object)) return NULL;
+
+    if (!(object->flags & JA_FLAG_KEY_MAP) && object->u.object.size >= JA_OBJ_MAP_MIN) {
+        __ja_key_map_build(object, object->u.object.size); // Not fatal, the pairs are shifted instead
+    }
+    if (!(object->flags & JA_FLAG_KEY_MAP)) return __ja_obj_take(object, index, key);
+
+    ja_key_map *map = __JA_OBJ_MAP(object);
+    ja_pair *pairs = object->u.object.pairs;
+    ja_val *value = pairs[index].value_ptr;
+    *key = pairs[index].key;
+
+    // Finds the entry of the position, then shifts back the entries probed past it (no tombstones in the index)
+    size_t hole = (size_t)__ja_key_header(*key)->hash & map->index_mask;
+    while (map->index[hole] != index + 1) hole = (hole + 1) & map->index_mask;
+
+    for (size_t entry = (hole + 1) & map->index_mask; map->index[entry]; entry = (entry + 1) & map->index_mask) {
+        size_t home = (size_t)__ja_key_header(pairs[map->index[entry] - 1].key)->hash & map->index_mask;
+        if (((entry - home) & map->index_mask) >= ((entry - hole) & map->index_mask)) {
+            map->index[hole] = map->index[entry];
+            hole = entry;
+        }
+    }
+    map->index[hole] = 0;
+
+    pairs[index].key = NULL;
+    pairs[index].value_ptr = NULL;
+    map->removed++;
+    __ja_key_map_moved(map);
+
+    size_t size = object->u.object.size;
+    while (size > 0 && !pairs[size - 1].key) {
+        size--;
+        map->removed--;
+    }
+    object->u.object.size = size;
+
+    if (map->removed * 2 > size) __ja_obj_compact(object);
+    return value;
+}
+
+void __ja_obj_compact(ja_val *object) {
+    if (!(object->flags & JA_FLAG_KEY_MAP) || __JA_OBJ_MAP(object)->removed == 0) return;
+
+    ja_pair *pairs = object->u.object.pairs;
+    size_t size = 0;
+    for (size_t i = 0; i < object->u.object.size; i++) {
+        if (pairs[i].key) pairs[size++] = pairs[i];
+    }
 
-    case JA_TYPE_ARRAY:
-        break;
+    object->u.object.size = size;
+    __JA_OBJ_MAP(object)->removed = 0;
+    __ja_obj_reindex(object);
+}
 
-    case JA_TYPE_OBJECT: {
-        ja_val *new_arr = ja_new_arr();
-        if (!new_arr) {
-            return;
+size_t __ja_obj_position(ja_val *object, size_t index) {
+    if (!(object->flags & JA_FLAG_KEY_MAP) || __JA_OBJ_MAP(object)->removed == 0) return index;
+
+    // Readers may get here at the same time: the table is installed atomically, the losers free theirs
+    ja_key_map *map = __JA_OBJ_MAP(object);
+    uint32_t *members = __atomic_load_n(&map->members, __ATOMIC_ACQUIRE);
+    if (!members) {
+        uint32_t *fresh = malloc(sizeof(uint32_t) * __ja_obj_live(object));
+        if (!fresh) { // Not fatal, the tombstones are counted instead
+            for (size_t i = 0; i < object->u.object.size; i++) {
+                if (!__ja_obj_tombstone(object, i) && index-- == 0) return i;
+            }
+            return object->u.object.size;
         }
 
-        for (size_t i = 0; i < target->u.object.size; i++) {
-            ja_arr_append(new_arr, ja_copy(target->u.object.pairs[i].value_ptr));
+        size_t count = 0;
+        for (size_t i = 0; i < object->u.object.size; i++) {
+            if (!__ja_obj_tombstone(object, i)) fresh[count++] = (uint32_t)i;
+        }
+        if (__atomic_compare_exchange_n(&map->members, &members, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            members = fresh;
+        } else {
+            free(fresh);
         }
-
-        __ja_free_val(target);
-        target->u.array.items = new_arr->u.array.items;
-        target->u.array.size = new_arr->u.array.size;
-        target->type = JA_TYPE_ARRAY;
-        free(new_arr);
-        break;
     }
+    return members[index];
+}
 
-    default: {
-        JA_LOG_ERROR("Invalid type for conversion to array.");
-        break;
-    }
+void __ja_obj_reindex(ja_val *object) {
+    if (!(object->flags & JA_FLAG_KEY_MAP)) return;
+
+    ja_key_map *map = __JA_OBJ_MAP(object);
+    ja_pair *pairs = object->u.object.pairs;
+    memset(map->index, 0, sizeof(uint32_t) * (map->index_mask + 1));
+    __ja_key_map_moved(map);
+
+    for (size_t i = 0; i < object->u.object.size; i++) {
+        if (pairs[i].key) __ja_key_map_add(map, __ja_key_header(pairs[i].key)->hash, i);
     }
 }
 
-void __ja_convert_to_obj(ja_val *target) {
-    if (!target) return;
+void __ja_obj_shape(ja_val *object) {
+    if (!__ja_parse_current || (object->flags & JA_FLAG_SHAPED)) return;
 
-    switch (target->type) {
-    case JA_TYPE_INT:
-    case JA_TYPE_DOUBLE:
-    case JA_TYPE_STRING:
-    case JA_TYPE_BOOL: {
-        ja_val *new_obj = ja_new_obj();
-        ja_val *var_cpy = ja_copy(target);
-        if (!new_obj || !var_cpy) {
-            return;
-        }
+    size_t size = object->u.object.size;
+    if (size == 0 || size >= UINT32_MAX) return;
 
-        ja_set_obj_at(new_obj, ja_str_type_of(target), var_cpy);
-        __ja_free_val(target);
-        target->u.object.pairs = new_obj->u.object.pairs;
-        target->u.object.size = new_obj->u.object.size;
-        target->type = JA_TYPE_OBJECT;
-        free(new_obj);
-        break;
+    ja_shape *shape = __ja_shape_intern(&__ja_parse_current->shapes, object->u.object.pairs, size);
+    ja_val **values = shape ? __ja_shaped_alloc(shape, size) : NULL;
+    if (!values) {
+        __ja_shape_release(shape); // Not fatal, the object keeps its pairs
+        return;
     }
 
-    case JA_TYPE_NULL: {
-        ja_val *new_obj = ja_new_obj();
-        if (!new_obj) {
-            return;
-        }
-
-        __ja_free_val(target);
-        target->u.object.pairs = new_obj->u.object.pairs;
-        target->u.object.size = new_obj->u.object.size;
-        target->type = JA_TYPE_OBJECT;
-        free(new_obj);
-        break;
+    ja_pair *pairs = object->u.object.pairs;
+    for (size_t i = 0; i < size; i++) {
+        values[i] = pairs[i].value_ptr;
+        __ja_key_release(pairs[i].key); // The shape holds the same keys
     }
+    if (object->flags & JA_FLAG_KEY_MAP) __ja_key_map_free(__JA_OBJ_MAP(object)); // Parsed objects have no tombstones
+    free(__ja_children_base(object));
 
-    case JA_TYPE_ARRAY: {
-        ja_val *new_obj = ja_new_obj();
-        ja_val *arr_cpy = ja_copy(target);
-        if (!new_obj || !arr_cpy) {
-            return;
-        }
+    object->u.object.values = values;
+    object->flags = (uint16_t)((object->flags & ~JA_FLAG_KEY_MAP) | JA_FLAG_SHAPED);
+}
 
-        for (size_t i = 0; i < target->u.array.size; i++) {
-            char idx_buffer[32];
-            sprintf(idx_buffer, "%zu", i);
-            ja_set_obj_at(new_obj, idx_buffer, ja_copy(ja_get_arr_at(target, i)));
-        }
-        
-        __ja_free_val(target);
-        target->u.object.pairs = new_obj->u.object.pairs;
-        target->u.object.size = new_obj->u.object.size;
-        target->type = JA_TYPE_OBJECT;
-        free(new_obj);
-        break;
-    }
+bool __ja_obj_unshape(ja_val *object) {
+    if (!(object->flags & JA_FLAG_SHAPED)) return true;
 
-    case JA_TYPE_OBJECT:
-        break;
+    size_t size = object->u.object.size;
+    ja_shape *shape = __JA_OBJ_SHAPE(object);
 
-    default: {
-        JA_LOG_ERROR("Invalid type for conversion to array.");
-        break;
+    ja_pair *pairs = malloc(sizeof(ja_pair) * size);
+    if (!pairs) {
+        JA_MEM_ERROR();
+        return false;
     }
+
+    for (size_t i = 0; i < size; i++) {
+        pairs[i].key = __ja_key_retain(shape->keys[i]);
+        pairs[i].value_ptr = object->u.object.values[i];
     }
+
+    if (!(object->flags & JA_FLAG_BLOCK_DATA)) free(__ja_children_base(object));
+    object->u.object.pairs = pairs;
+    object->flags &= ~(JA_FLAG_SHAPED | JA_FLAG_BLOCK_DATA);
+    __ja_shape_release(shape);
+    return true;
 }
 
-void __ja_convert_to_null(ja_val *target) {
-    if (!target) return;
-        
-    __ja_free_val(target);
-    memset(&target->u, 0, sizeof(target->u));
+// Hash of a key sequence, mixed from the hashes cached in the key headers
+static uint64_t __ja_shape_hash(const ja_pair *pairs, size_t size) {
+    uint64_t hash = 14695981039346656037ULL ^ size;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ __ja_key_header(pairs[i].key)->hash) * 1099511628211ULL;
+    }
+    return hash;
+}
 
-    target->type = JA_TYPE_NULL;
+static bool __ja_shape_matches(const ja_shape *shape, const ja_pair *pairs, size_t size, uint64_t hash) {
+    if (shape->hash != hash || shape->size != size) return false;
+
+    for (size_t i = 0; i < size; i++) {
+        const __ja_key *header = __ja_key_header(pairs[i].key);
+        if (!__ja_key_equals(shape->keys[i], pairs[i].key, header->hash, header->length)) return false;
+    }
+    return true;
 }
 
-char* ja_stringify(ja_val* value) {
-    if (!value) {
-        JA_LOG_ERROR("NULL value. Can't convert to string.");
+static ja_shape *__ja_shape_new(const ja_pair *pairs, size_t size, uint64_t hash) {
+    size_t index_capacity = 8;
+    while (index_capacity < size * 2) index_capacity *= 2;
+
+    // Shape, keys and index share one allocation
+    ja_shape *shape = malloc(sizeof(ja_shape) + sizeof(char*) * size + sizeof(uint32_t) * index_capacity);
+    if (!shape) {
+        JA_MEM_ERROR();
         return NULL;
     }
 
-    switch (value->type) {
-    case JA_TYPE_INT: {
-        int needed = snprintf(NULL, 0, "%d", value->u.number.as_int);
-        char* str = malloc(needed + 1);
-        if (!str) {
+    shape->refcount = 1;
+    shape->size = size;
+    shape->hash = hash;
+    shape->cached = 0;
+    shape->index = (uint32_t *)(void *)&shape->keys[size];
+    shape->index_mask = index_capacity - 1;
+    memset(shape->index, 0, sizeof(uint32_t) * index_capacity);
+
+    for (size_t i = 0; i < size; i++) {
+        shape->keys[i] = __ja_key_retain(pairs[i].key);
+
+        size_t entry = (size_t)__ja_key_header(pairs[i].key)->hash & shape->index_mask;
+        while (shape->index[entry]) entry = (entry + 1) & shape->index_mask;
+        shape->index[entry] = (uint32_t)(i + 1);
+    }
+
+    return shape;
+}
+
+ja_shape *__ja_shape_intern(ja_shape_table *table, const ja_pair *pairs, size_t size) {
+    if (table->count * 2 >= table->capacity) {
+        size_t new_capacity = table->capacity ? table->capacity * 2 : 16;
+        ja_shape **new_slots = calloc(new_capacity, sizeof(ja_shape*));
+        if (!new_slots) {
             JA_MEM_ERROR();
             return NULL;
         }
-        snprintf(str, needed + 1, "%d", value->u.number.as_int);
-        return str;
-    }
 
-    case JA_TYPE_DOUBLE: {
-        int needed;
-        char* str;
-        double val = value->u.number.as_double;
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (!table->slots[i]) continue;
 
-        if (fabs(val - round(val)) < 1e-12) {
-            needed = snprintf(NULL, 0, "%.0f", val);
-            str = malloc(needed + 1);
-            if (!str) { JA_MEM_ERROR(); return NULL; }
-            snprintf(str, needed + 1, "%.0f", val);
-        } else {
-            needed = snprintf(NULL, 0, "%.15g", val);
-            str = malloc(needed + 1);
-            if (!str) { JA_MEM_ERROR(); return NULL; }
-            snprintf(str, needed + 1, "%.15g", val);
+            size_t slot = (size_t)table->slots[i]->hash & (new_capacity - 1);
+            while (new_slots[slot]) slot = (slot + 1) & (new_capacity - 1);
+            new_slots[slot] = table->slots[i];
         }
-        return str;
+
+        free(table->slots);
+        table->slots = new_slots;
+        table->capacity = new_capacity;
     }
 
-    case JA_TYPE_STRING: {
-        if (!value->u.string) return strdup("\"\"");
-        
-        const char *src = value->u.string;
-        size_t len = strlen(src);
-        size_t total = len+3;
+    uint64_t hash = __ja_shape_hash(pairs, size);
+    size_t slot = (size_t)hash & (table->capacity - 1);
 
-        char *out = malloc(total);
-        if (!out) {
-            JA_MEM_ERROR();
-            return NULL;
+    while (table->slots[slot]) {
+        ja_shape *shape = table->slots[slot];
+        if (__ja_shape_matches(shape, pairs, size, hash)) {
+            __atomic_add_fetch(&shape->refcount, 1, __ATOMIC_RELAXED);
+            return shape;
         }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
 
-        out[0] = '"';
-        memcpy(out + 1, src, len);
-        out[len + 1] = '"';
-        out[len + 2] = '\0';
+    ja_shape *shape = __ja_shape_new(pairs, size, hash);
+    if (!shape) return NULL;
 
-        return out;
-    }
+    table->slots[slot] = shape; // The table keeps the first reference
+    table->count++;
+    __atomic_add_fetch(&shape->refcount, 1, __ATOMIC_RELAXED);
+    return shape;
+}
 
-    case JA_TYPE_BOOL: {
-        return strdup(value->u.boolean ? "true" : "false");
+size_t __ja_shape_find(ja_shape *shape, const char *key, uint64_t hash, size_t length) {
+    size_t entry = (size_t)hash & shape->index_mask;
+
+    while (shape->index[entry]) {
+        size_t slot = shape->index[entry] - 1;
+        if (__ja_key_equals(shape->keys[slot], key, hash, length)) return slot;
+        entry = (entry + 1) & shape->index_mask;
     }
+    return shape->size;
+}
 
-    case JA_TYPE_ARRAY: {
-        if (value->u.array.size == 0) return strdup("[]");
+void __ja_shape_release(ja_shape *shape) {
+    if (!shape) return;
 
-        char** elements = malloc(value->u.array.size * sizeof(char*));
-        if (!elements) {
-            JA_MEM_ERROR();
-            return NULL;
+    if (__atomic_sub_fetch(&shape->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        for (size_t i = 0; i < shape->size; i++) {
+            __ja_key_release(shape->keys[i]);
         }
+        free(shape);
+    }
+}
 
-        size_t total_length = 2;
-        for (size_t i = 0; i < value->u.array.size; i++) {
-            elements[i] = ja_stringify(value->u.array.items[i]);
-            total_length += strlen(elements[i]) + 1;
+void __ja_block_free(ja_val *root) {
+    if (!(root->flags & JA_FLAG_SNAPSHOT)) {
+        free(root);
+        return;
+    }
+
+    ja_val *header = root - 1;
+#ifdef JA_HAS_MMAP
+    if (header->flags & JA_FLAG_MAPPED) {
+        munmap(header, header->u.array.size);
+        return;
+    }
+#endif
+    free(header);
+}
+
+#define JA_SNAPSHOT_MAGIC "jaSNAP"
+#define JA_SNAPSHOT_VERSION 2
+#define JA_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+// Trailer at the end of a snapshot file. The file starts with the nodes (a header node, then the root),
+// followed by the pointer slots, the pairs, the string pool, the key pool, the shape words and the trailer.
+typedef struct __ja_snapshot_trailer {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;    // JA_SNAPSHOT_BYTE_ORDER as stored by the machine that saved the file
+    uint32_t value_size;    // sizeof(ja_val)
+    uint32_t pointer_size;  // sizeof(void*)
+    uint64_t nodes;         // Including the header node
+    uint64_t slots;         // Including the shape id in front of the values of each shaped object
+    uint64_t pairs;
+    uint64_t string_bytes;
+    uint64_t key_count;
+    uint64_t key_bytes;
+    uint64_t shape_count;
+    uint64_t shape_words;   // For each shape: amount of keys, then the id of each key
+} __ja_snapshot_trailer;
+
+// Distinct null-terminated strings, in the order they were added (their id)
+typedef struct __ja_snapshot_pool {
+    char *data;
+    size_t length;
+    size_t capacity;
+    size_t *offsets;    // Offset of each string in data, by id
+    size_t count;
+    size_t *index;      // Open addressing table of id + 1
+    size_t index_mask;
+} __ja_snapshot_pool;
+
+static void __ja_snapshot_pool_free(__ja_snapshot_pool *pool) {
+    free(pool->data);
+    free(pool->offsets);
+    free(pool->index);
+}
+
+// Adds a string to a pool (or finds it), returning its id in `id`
+static bool __ja_snapshot_pool_add(__ja_snapshot_pool *pool, const char *str, size_t *id) {
+    size_t length = strlen(str);
+    uint64_t hash = __ja_hash_str(str, length);
+
+    if (pool->index) {
+        for (size_t entry = (size_t)hash & pool->index_mask; pool->index[entry]; entry = (entry + 1) & pool->index_mask) {
+            size_t candidate = pool->index[entry] - 1;
+            if (strcmp(pool->data + pool->offsets[candidate], str) == 0) {
+                *id = candidate;
+                return true;
+            }
         }
+    }
 
-        char* str = malloc(total_length * sizeof(char));
-        if (!str) {
+    if (!pool->index || (pool->count + 1) * 2 > pool->index_mask + 1) {
+        size_t new_capacity = pool->index ? (pool->index_mask + 1) * 2 : 64;
+        size_t *new_index = calloc(new_capacity, sizeof(size_t));
+        size_t *new_offsets = realloc(pool->offsets, sizeof(size_t) * new_capacity / 2);
+        if (!new_index || !new_offsets) {
             JA_MEM_ERROR();
-            for (size_t i = 0; i < value->u.array.size; i++) free(elements[i]);
-            free(elements); 
-            return NULL;
+            free(new_index);
+            if (new_offsets) pool->offsets = new_offsets;
+            return false;
         }
+        pool->offsets = new_offsets;
 
-        char* ptr = str;
-        *ptr++ = '[';
-
-        for (size_t i = 0; i < value->u.array.size; i++) {
-            size_t len = strlen(elements[i]);
-            memcpy(ptr, elements[i], len);
-            ptr += len;
-            if (i < value->u.array.size - 1) {
-                *ptr++ = ',';
-            }
-            free(elements[i]);
+        for (size_t i = 0; i < pool->count; i++) {
+            const char *stored = pool->data + pool->offsets[i];
+            size_t entry = (size_t)__ja_hash_str(stored, strlen(stored)) & (new_capacity - 1);
+            while (new_index[entry]) entry = (entry + 1) & (new_capacity - 1);
+            new_index[entry] = i + 1;
         }
 
-        *ptr++ = ']';
-        *ptr = '\0';
-        
-        free(elements);
-        return str;
+        free(pool->index);
+        pool->index = new_index;
+        pool->index_mask = new_capacity - 1;
     }
 
-    case JA_TYPE_OBJECT: {
-        if (value->u.object.size == 0) return strdup("{}");
+    if (pool->length + length + 1 > pool->capacity) {
+        size_t new_capacity = pool->capacity ? pool->capacity : 4096;
+        while (pool->length + length + 1 > new_capacity) new_capacity *= 2;
 
-        char** pairs = malloc(value->u.object.size * sizeof(char*));
-        if (!pairs) {
+        char *new_data = realloc(pool->data, new_capacity);
+        if (!new_data) {
             JA_MEM_ERROR();
-            return NULL;
+            return false;
         }
+        pool->data = new_data;
+        pool->capacity = new_capacity;
+    }
 
-        size_t total_length = 2;
-        for (size_t i = 0; i < value->u.object.size; i++) {
-            char* value_json = ja_stringify(value->u.object.pairs[i].value_ptr);
-            if (!value_json) {
-                for (size_t k = 0; k < i; k++) free(pairs[k]);
-                free(pairs);
-                return NULL;
-            }
+    memcpy(pool->data + pool->length, str, length + 1);
+    pool->offsets[pool->count] = pool->length;
+    pool->length += length + 1;
 
-            size_t key_len = strlen(value->u.object.pairs[i].key);
-            size_t val_len = strlen(value_json);
+    size_t entry = (size_t)hash & pool->index_mask;
+    while (pool->index[entry]) entry = (entry + 1) & pool->index_mask;
+    pool->index[entry] = pool->count + 1;
 
-            pairs[i] = malloc(key_len + val_len + 4);
-            if (!pairs[i]) {
-                JA_MEM_ERROR();
-                free(value_json);
-                for (size_t k = 0; k < i; k++) free(pairs[k]);
-                free(pairs);
-                return NULL;
-            }
+    *id = pool->count++;
+    return true;
+}
 
-            sprintf(pairs[i], "\"%s\":%s", value->u.object.pairs[i].key, value_json);
-            total_length += strlen(pairs[i]) + 1; // +1 for comma
-            free(value_json);
+// Distinct shapes of a snapshot, by address
+typedef struct __ja_snapshot_shapes {
+    ja_shape **list;
+    size_t count;
+    size_t *index;      // Open addressing table of id + 1
+    size_t index_mask;
+} __ja_snapshot_shapes;
+
+static bool __ja_snapshot_shape_id(__ja_snapshot_shapes *shapes, ja_shape *shape, size_t *id) {
+    size_t hash = (size_t)(((uintptr_t)shape >> 4) * 11400714819323198485ULL);
+
+    if (shapes->index) {
+        for (size_t entry = hash & shapes->index_mask; shapes->index[entry]; entry = (entry + 1) & shapes->index_mask) {
+            if (shapes->list[shapes->index[entry] - 1] == shape) {
+                *id = shapes->index[entry] - 1;
+                return true;
+            }
         }
+    }
 
-        char* str = malloc(total_length);
-        if (!str) {
+    if (!shapes->index || (shapes->count + 1) * 2 > shapes->index_mask + 1) {
+        size_t new_capacity = shapes->index ? (shapes->index_mask + 1) * 2 : 16;
+        size_t *new_index = calloc(new_capacity, sizeof(size_t));
+        ja_shape **new_list = realloc(shapes->list, sizeof(ja_shape*) * new_capacity / 2);
+        if (!new_index || !new_list) {
             JA_MEM_ERROR();
-            for (size_t i = 0; i < value->u.object.size; i++) free(pairs[i]);
-            free(pairs);
-            return NULL;
+            free(new_index);
+            if (new_list) shapes->list = new_list;
+            return false;
         }
+        shapes->list = new_list;
 
-        char* ptr = str;
-        *ptr++ = '{';
+        for (size_t i = 0; i < shapes->count; i++) {
+            size_t entry = (size_t)(((uintptr_t)shapes->list[i] >> 4) * 11400714819323198485ULL) & (new_capacity - 1);
+            while (new_index[entry]) entry = (entry + 1) & (new_capacity - 1);
+            new_index[entry] = i + 1;
+        }
 
-        for (size_t i = 0; i < value->u.object.size; i++) {
-            size_t len = strlen(pairs[i]);
-            memcpy(ptr, pairs[i], len);
-            ptr += len;
-            if (i < value->u.object.size - 1) {
-                *ptr++ = ',';
-            }
-            free(pairs[i]);
+        free(shapes->index);
+        shapes->index = new_index;
+        shapes->index_mask = new_capacity - 1;
+    }
+
+    size_t entry = hash & shapes->index_mask;
+    while (shapes->index[entry]) entry = (entry + 1) & shapes->index_mask;
+    shapes->index[entry] = shapes->count + 1;
+    shapes->list[shapes->count] = shape;
+
+    *id = shapes->count++;
+    return true;
+}
+
+// Writes the nodes, slots and pairs of a snapshot into `image`, with offsets instead of pointers
+static bool __ja_snapshot_layout(ja_val *value, const __ja_compact_size *size, char *image,
+                                 __ja_snapshot_pool *strings, __ja_snapshot_pool *keys, __ja_snapshot_shapes *shapes) {
+    ja_val *nodes = (ja_val *)image;
+    size_t slots_start = size->nodes * sizeof(ja_val);
+    size_t pairs_start = slots_start + size->slots * sizeof(ja_val*);
+    size_t strings_start = pairs_start + size->pairs * sizeof(ja_pair);
+    ja_val **slots = (ja_val **)(image + slots_start);
+    ja_pair *pairs = (ja_pair *)(image + pairs_start);
+    size_t next_node = 2;
+
+    // Header node, filled when the snapshot is loaded
+    nodes[0].type = JA_TYPE_NULL;
+    nodes[0].flags = JA_FLAG_IN_BLOCK;
+
+    // Same breadth-first order as __ja_compact_write(), each node holds its original until it's reached
+    nodes[1].u.object.source = value;
+    nodes[1].flags = 0;
+
+    for (size_t i = 1; i < next_node; i++) {
+        ja_val *copy = &nodes[i];
+        const ja_val *source = copy->u.object.source;
+
+        if (copy->flags & JA_FLAG_PACKED) { // Element of a packed array, see __ja_compact_child()
+            __ja_packed_get(source, copy->u.object.size, copy);
+            copy->flags = JA_FLAG_IN_BLOCK;
+            continue;
         }
 
-        *ptr++ = '}';
-        *ptr = '\0';
+        copy->type = source->type;
+        copy->flags = JA_FLAG_IN_BLOCK | (i == 1 ? JA_FLAG_BLOCK_ROOT | JA_FLAG_SNAPSHOT : 0);
+        copy->shares = 0;
+        memset(&copy->u, 0, sizeof(copy->u)); // Drops the source pointer, the unused words are written as zeros
+
+        switch (source->type) {
+        case JA_TYPE_STRING: {
+            size_t id;
+            if (!__ja_snapshot_pool_add(strings, source->u.string, &id)) return false;
+            copy->u.string = (char *)(uintptr_t)(strings_start + strings->offsets[id]);
+            copy->flags |= JA_FLAG_BLOCK_DATA;
+            break;
+        }
+        case JA_TYPE_ARRAY:
+        case JA_TYPE_OBJECT: {
+            bool shaped = source->type == JA_TYPE_OBJECT && (source->flags & JA_FLAG_SHAPED);
+            size_t children = source->type == JA_TYPE_ARRAY ? source->u.array.size : __ja_obj_live(source);
+
+            copy->u.object.size = children; // Same word as u.array.size
+            if (children == 0) break;
+
+            copy->flags |= JA_FLAG_BLOCK_DATA;
+            if (shaped) { // The id of the shape takes the slot in front of the values
+                size_t id;
+                if (!__ja_snapshot_shape_id(shapes, __JA_OBJ_SHAPE(source), &id)) return false;
+                copy->flags |= JA_FLAG_SHAPED;
+                *slots++ = (ja_val *)(uintptr_t)id;
+            }
 
-        free(pairs);
-        return str;
+            if (source->type == JA_TYPE_ARRAY || shaped) {
+                copy->u.object.values = (ja_val **)(uintptr_t)((char *)slots - image);
+                for (size_t j = 0; j < children; j++) {
+                    __ja_compact_child(&nodes[next_node], source, j);
+                    slots[j] = (ja_val *)(uintptr_t)(next_node++ * sizeof(ja_val));
+                }
+                slots += children;
+            } else {
+                copy->u.object.pairs = (ja_pair *)(uintptr_t)((char *)pairs - image);
+                for (size_t j = 0; j < source->u.object.size; j++) {
+                    if (__ja_obj_tombstone(source, j)) continue;
+
+                    size_t id;
+                    if (!__ja_snapshot_pool_add(keys, source->u.object.pairs[j].key, &id)) return false;
+                    __ja_compact_child(&nodes[next_node], source, j);
+                    pairs->key = (char *)(uintptr_t)id;
+                    pairs->value_ptr = (ja_val *)(uintptr_t)(next_node++ * sizeof(ja_val));
+                    pairs++;
+                }
+            }
+            break;
+        }
+        case JA_TYPE_BOOL:
+            copy->u.boolean = source->u.boolean;
+            break;
+        case JA_TYPE_NULL:
+            break;
+        default: // Numbers, field by field so the padding stays zeroed
+            copy->u.number.as_int = source->u.number.as_int;
+            copy->u.number.as_double = source->u.number.as_double;
+            break;
+        }
     }
 
-    case JA_TYPE_NULL:
-        return strdup("null");
-
-    default:
-        JA_LOG_ERROR("Can't retrieve string from this type.");
-        return NULL;
-    }
+    return true;
 }
 
-void ja_print(ja_val* value) {
-    if (!value) {
-        JA_LOG_ERROR("NULL value. Can't print.");
-        return;
+bool ja_save_snapshot(ja_val *value, const char *filename) {
+    if (!value || !filename) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_save_snapshot() called with NULL pointer.");
+        return false;
     }
 
-    char* str = ja_stringify(value);
-    if (!str) {
-        JA_PROPAGATE_ERROR("ja_print");
-        return;
+    __ja_compact_size size;
+    if (!__ja_compact_measure(value, &size)) {
+        JA_PROPAGATE_ERROR("ja_save_snapshot");
+        return false;
     }
+    size.nodes++; // Header node
 
-    fprintf(stdout, "%s\n", str);
-    free(str);
-}
+    size_t image_bytes = size.nodes * sizeof(ja_val) + size.slots * sizeof(ja_val*) + size.pairs * sizeof(ja_pair);
+    char *image = calloc(1, image_bytes); // Zeroed, so padding bytes are the same in every file
+    __ja_snapshot_pool strings = { 0 };
+    __ja_snapshot_pool keys = { 0 };
+    __ja_snapshot_shapes shapes = { 0 };
+    uint64_t *shape_words = NULL;
+    size_t shape_word_count = 0;
+    bool result = false;
 
-ja_val *ja_parse(const char *json_str) {
-    if (!json_str) {
-        JA_LOG_ERROR("NULL string passed to ja_parse().");
-        return NULL;
-    }
-    ja_val *value = __ja_parse(json_str, NULL);
-    if (!value) {
-        JA_PROPAGATE_ERROR("ja_parse");
-        return NULL;
+    if (!image) {
+        JA_MEM_ERROR();
+        return false;
     }
-    return value;
-}
 
-ja_val *__ja_parse(const char *json_str, int *chars_consumed) {
-    if (!json_str) {
-        JA_LOG_ERROR("Can't parse NULL string.");
-        return NULL;
+    if (!__ja_snapshot_layout(value, &size, image, &strings, &keys, &shapes)) goto cleanup;
+
+    for (size_t i = 0; i < shapes.count; i++) shape_word_count += 1 + shapes.list[i]->size;
+    shape_words = malloc(sizeof(uint64_t) * (shape_word_count ? shape_word_count : 1));
+    if (!shape_words) {
+        JA_MEM_ERROR();
+        goto cleanup;
     }
 
-    if (*json_str == '\0') {
-        JA_LOG_ERROR("Empty string.");
-        return NULL;
+    size_t word = 0;
+    for (size_t i = 0; i < shapes.count; i++) {
+        shape_words[word++] = shapes.list[i]->size;
+        for (size_t k = 0; k < shapes.list[i]->size; k++) {
+            size_t id;
+            if (!__ja_snapshot_pool_add(&keys, shapes.list[i]->keys[k], &id)) goto cleanup;
+            shape_words[word++] = id;
+        }
     }
 
-    __ja_jump_whitespaces(&json_str, chars_consumed);
+    __ja_snapshot_trailer trailer = { { 0 }, JA_SNAPSHOT_VERSION, JA_SNAPSHOT_BYTE_ORDER, sizeof(ja_val), sizeof(void*),
+        size.nodes, size.slots, size.pairs, strings.length, keys.count, keys.length, shapes.count, shape_word_count };
+    memcpy(trailer.magic, JA_SNAPSHOT_MAGIC, sizeof(JA_SNAPSHOT_MAGIC));
 
-    switch (*json_str) {
-    case '{':
-        return __ja_parse_object(json_str, chars_consumed);
-    case '[':
-        return __ja_parse_array(json_str, chars_consumed);
-    case '"':
-        return __ja_parse_string(json_str, chars_consumed);
-    case 't':
-    case 'f':
-        return __ja_parse_bool(json_str, chars_consumed);
-    case 'n':
-        return __ja_parse_null(json_str, chars_consumed);
-    default:
-        if (isdigit(*json_str) || *json_str == '-') {
-            return __ja_parse_number(json_str, chars_consumed);
-        } else {
-            JA_LOG_ERROR("Invalid character: %c", *json_str);
-            return NULL;
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        JA_ERROR(JA_ERROR_IO, "Error opening file: %s", filename);
+        goto cleanup;
+    }
+
+    static const char padding[8] = { 0 };
+    size_t unaligned = (image_bytes + strings.length + keys.length) % 8;
+
+    result = fwrite(image, 1, image_bytes, file) == image_bytes &&
+             (!strings.length || fwrite(strings.data, 1, strings.length, file) == strings.length) &&
+             (!keys.length || fwrite(keys.data, 1, keys.length, file) == keys.length) &&
+             (!unaligned || fwrite(padding, 1, 8 - unaligned, file) == 8 - unaligned) &&
+             (!shape_word_count || fwrite(shape_words, sizeof(uint64_t), shape_word_count, file) == shape_word_count) &&
+             fwrite(&trailer, sizeof(trailer), 1, file) == 1;
+    result = fclose(file) == 0 && result;
+
+    if (!result) JA_ERROR(JA_ERROR_IO, "Error writing snapshot: %s", filename);
+
+cleanup:
+    free(image);
+    free(shape_words);
+    __ja_snapshot_pool_free(&strings);
+    __ja_snapshot_pool_free(&keys);
+    free(shapes.list);
+    free(shapes.index);
+    return result;
+}
+
+// Maps (or reads) a whole file, writable and private to this process
+static char *__ja_snapshot_open(const char *filename, size_t *length, bool *mapped) {
+    *mapped = false;
+
+#ifdef JA_HAS_MMAP
+    int fd = open(filename, O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void *data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                close(fd);
+                *length = (size_t)info.st_size;
+                *mapped = true;
+                return data;
+            }
         }
+        close(fd);
     }
+#endif
+
+    return __ja_read_file(filename, length);
 }
 
-ja_val *__ja_parse_number(const char *json_str, int *chars_consumed) {
-    const char *p = json_str;
-    int dots_count = 0, e_count = 0;
+// Checks that an offset points to the next node written by __ja_snapshot_layout(). Children are numbered in
+// breadth-first order, so each node is referenced exactly once and after its parent (no aliases or cycles)
+static inline bool __ja_snapshot_node_ok(uintptr_t offset, uint64_t nodes, uint64_t *next) {
+    if (offset % sizeof(ja_val) != 0 || offset / sizeof(ja_val) != *next || *next >= nodes) return false;
+    (*next)++;
+    return true;
+}
 
-    if (*p == '-' || *p == '+') {
-        p++;
-        if (chars_consumed) (*chars_consumed)++;
-    }
+// Checks every offset and id of the nodes before anything is relocated
+static bool __ja_snapshot_check(char *data, const __ja_snapshot_trailer *trailer, ja_shape **shapes) {
+    ja_val *nodes = (ja_val *)data;
+    uint64_t slots_start = trailer->nodes * sizeof(ja_val);
+    uint64_t pairs_start = slots_start + trailer->slots * sizeof(ja_val*);
+    uint64_t strings_start = pairs_start + trailer->pairs * sizeof(ja_pair);
+    uint64_t strings_end = strings_start + trailer->string_bytes;
+    uint64_t next = 2; // Next node to be referenced, the header and the root aren't
+    uint64_t next_slot = slots_start; // Children buffers follow each other in node order, like the nodes
+    uint64_t next_pair = pairs_start;
+
+    for (uint64_t i = 1; i < trailer->nodes; i++) {
+        ja_val *node = &nodes[i];
+        if (i >= next && i > 1) return false; // Not referenced by any node before it
+        if (node->flags & (JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL)) return false; // Arrays are saved with a node per element
+
+        switch (node->type) {
+        case JA_TYPE_INT:
+        case JA_TYPE_DOUBLE:
+        case JA_TYPE_BOOL:
+        case JA_TYPE_NULL:
+            break;
+        case JA_TYPE_STRING: {
+            uintptr_t offset = (uintptr_t)node->u.string;
+            if (offset < strings_start || offset >= strings_end) return false;
+            break;
+        }
+        case JA_TYPE_ARRAY:
+        case JA_TYPE_OBJECT: {
+            uint64_t size = node->u.object.size;
+            if (size == 0) break;
+
+            uintptr_t offset = (uintptr_t)node->u.object.pairs;
+            bool has_pairs = node->type == JA_TYPE_OBJECT && !(node->flags & JA_FLAG_SHAPED);
+
+            // The offset must be where the previous buffer ended, and the room left is checked before it moves on
+            if (has_pairs) {
+                if (offset != next_pair || size > (strings_start - offset) / sizeof(ja_pair)) return false;
+                next_pair += size * sizeof(ja_pair);
+
+                ja_pair *pairs = (ja_pair *)(data + offset);
+                for (uint64_t j = 0; j < size; j++) {
+                    if ((uintptr_t)pairs[j].key >= trailer->key_count ||
+                        !__ja_snapshot_node_ok((uintptr_t)pairs[j].value_ptr, trailer->nodes, &next)) return false;
+                }
+                break;
+            }
 
-    while (*p && (isdigit((unsigned char)*p) || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) {
-        if (*p == '.') {
-            dots_count++;
-            if (dots_count > 1) {
-                JA_LOG_ERROR("Multiple decimal points in number.");
-                return NULL;
+            if (node->type == JA_TYPE_OBJECT) { // Shaped, its shape id comes first
+                if (next_slot >= pairs_start) return false;
+                uintptr_t id = *(uintptr_t *)(void *)(data + next_slot);
+                if (id >= trailer->shape_count || shapes[id]->size != size) return false;
+                next_slot += sizeof(ja_val*);
             }
-        } else if (*p == 'e' || *p == 'E') {
-            e_count++;
-            if (e_count > 1) {
-                JA_LOG_ERROR("Multiple exponent indicators in number.");
-                return NULL;
+            if (offset != next_slot || size > (pairs_start - offset) / sizeof(ja_val*)) return false;
+            next_slot += size * sizeof(ja_val*);
+
+            ja_val **slots = (ja_val **)(data + offset);
+            for (uint64_t j = 0; j < size; j++) {
+                if (!__ja_snapshot_node_ok((uintptr_t)slots[j], trailer->nodes, &next)) return false;
             }
+            break;
+        }
+        default:
+            return false;
         }
-        p++;
-        if (chars_consumed) (*chars_consumed)++;
     }
 
-    char *end_ptr;
-    double number_value = strtold(json_str, &end_ptr);
+    return next == trailer->nodes;
+}
 
-    if (end_ptr == json_str) {
-        JA_LOG_ERROR("Error while parsing number.");
+ja_val *ja_load_snapshot(const char *filename) {
+    if (!filename) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "ja_load_snapshot() called with NULL filename.");
         return NULL;
     }
 
-    return ja_new_num(number_value);
-}
+    size_t length;
+    bool mapped;
+    char *data = __ja_snapshot_open(filename, &length, &mapped);
+    if (!data) {
+        JA_PROPAGATE_ERROR("ja_load_snapshot");
+        return NULL;
+    }
 
-ja_val *__ja_parse_string(const char *json_str, int *chars_consumed) {
-    const char *p = json_str;
-    const char *start = ++p;
-    size_t length = 0;
-    int consumed = 1;
+    __ja_snapshot_trailer trailer;
+    char **keys = NULL;
+    ja_shape **shapes = NULL;
+    size_t key_count = 0;
+    size_t shape_count = 0;
+    ja_val *root = NULL;
 
-    while (*p && *p != '"') {
-        if (*p == '\\') {
-            p++;
-            consumed++;
-            if (*p == 'u') {
-                p++;
-                consumed++;
-                for (int i = 0; i < 4 && *p; i++, p++, consumed++);
-            } else if (*p) {
-                p++;
-                consumed++;
-            }
-        } else {
-            p++;
-            consumed++;
+    if (length < sizeof(trailer)) goto invalid;
+    memcpy(&trailer, data + length - sizeof(trailer), sizeof(trailer));
+
+    if (memcmp(trailer.magic, JA_SNAPSHOT_MAGIC, sizeof(JA_SNAPSHOT_MAGIC)) != 0 ||
+        trailer.version != JA_SNAPSHOT_VERSION || trailer.byte_order != JA_SNAPSHOT_BYTE_ORDER ||
+        trailer.value_size != sizeof(ja_val) || trailer.pointer_size != sizeof(void*) || trailer.nodes < 2) goto invalid;
+
+    // Every section must fit in the file, in order
+    uint64_t sections[] = { trailer.nodes, trailer.slots, trailer.pairs, trailer.string_bytes, trailer.key_bytes, trailer.shape_words };
+    uint64_t units[] = { sizeof(ja_val), sizeof(ja_val*), sizeof(ja_pair), 1, 1, sizeof(uint64_t) };
+    uint64_t end = 0;
+    for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); i++) {
+        if (i == 5) end = (end + 7) / 8 * 8; // Shape words are aligned
+        if (sections[i] > (length - sizeof(trailer) - end) / units[i]) goto invalid;
+        end += sections[i] * units[i];
+    }
+    if (end != length - sizeof(trailer)) goto invalid;
+
+    size_t strings_start = trailer.nodes * sizeof(ja_val) + trailer.slots * sizeof(ja_val*) + trailer.pairs * sizeof(ja_pair);
+    size_t keys_start = strings_start + trailer.string_bytes;
+    size_t words_start = (keys_start + trailer.key_bytes + 7) / 8 * 8;
+
+    if ((trailer.string_bytes && data[keys_start - 1] != '\0') ||
+        (trailer.key_bytes && data[keys_start + trailer.key_bytes - 1] != '\0')) goto invalid;
+
+    // A key takes at least its terminator and a shape at least two words, so the counts are bounded by the file
+    if (trailer.key_count > trailer.key_bytes || trailer.shape_count > trailer.shape_words / 2) goto invalid;
+
+    // Keys and shapes are created once, nodes only point to them
+    keys = malloc(sizeof(char*) * (trailer.key_count ? trailer.key_count : 1));
+    shapes = malloc(sizeof(ja_shape*) * (trailer.shape_count ? trailer.shape_count : 1));
+    if (!keys || !shapes) {
+        JA_MEM_ERROR();
+        goto cleanup;
+    }
+
+    for (size_t offset = keys_start; offset < keys_start + trailer.key_bytes && key_count < trailer.key_count; ) {
+        size_t key_length = strlen(data + offset);
+        keys[key_count] = __ja_key_make(data + offset, key_length);
+        if (!keys[key_count]) {
+            JA_MEM_ERROR();
+            goto cleanup;
         }
+        key_count++;
+        offset += key_length + 1;
     }
+    if (key_count != trailer.key_count) goto invalid;
 
-    if (*p != '"') {
-        JA_LOG_ERROR("Unmatched quotes in string.");
-        return NULL;
+    const uint64_t *words = (const uint64_t *)(void *)(data + words_start);
+    for (size_t word = 0; shape_count < trailer.shape_count; shape_count++) {
+        if (word >= trailer.shape_words || words[word] == 0 || words[word] >= UINT32_MAX ||
+            words[word] > trailer.shape_words - word - 1) goto invalid;
+
+        size_t size = (size_t)words[word++];
+        ja_pair *pairs = malloc(sizeof(ja_pair) * size);
+        if (!pairs) {
+            JA_MEM_ERROR();
+            goto cleanup;
+        }
+
+        bool ids_ok = true;
+        for (size_t k = 0; k < size; k++) {
+            ids_ok = ids_ok && words[word + k] < key_count;
+            pairs[k].key = ids_ok ? keys[words[word + k]] : NULL;
+        }
+        shapes[shape_count] = ids_ok ? __ja_shape_new(pairs, size, __ja_shape_hash(pairs, size)) : NULL;
+        free(pairs);
+        word += size;
+
+        if (!ids_ok) goto invalid;
+        if (!shapes[shape_count]) goto cleanup;
     }
 
-    length = p - start;
-    char temp_str[length + 1];
+    if (!__ja_snapshot_check(data, &trailer, shapes)) goto invalid;
 
-    strncpy(temp_str, start, length);
-    temp_str[length] = '\0';
-    ja_val *jav = ja_new_str(temp_str);
-    if (!jav) {
-        return NULL;
+    if (!mapped) {
+        // Keys and shapes are built, the rest of the file isn't needed anymore
+        char *shrunk = realloc(data, keys_start);
+        if (shrunk) data = shrunk;
     }
 
-    consumed++;
-    if (chars_consumed) *chars_consumed += consumed;
-    return jav;
-}
+    ja_val *nodes = (ja_val *)data;
+    for (uint64_t i = 1; i < trailer.nodes; i++) {
+        ja_val *node = &nodes[i];
+        node->shares = 0;
+        node->flags &= JA_FLAG_SHAPED;
+        node->flags |= JA_FLAG_IN_BLOCK | (i == 1 ? JA_FLAG_BLOCK_ROOT | JA_FLAG_SNAPSHOT : 0);
 
-ja_val *__ja_parse_bool(const char *json_str, int *chars_consumed) {
-    if (strncmp(json_str, "true", 4) == 0) {
-        if (chars_consumed) (*chars_consumed) += 4;
-        return ja_new_bool(true);
-    } else if (strncmp(json_str, "false", 5) == 0) {
-        if (chars_consumed) (*chars_consumed) += 5;
-        return ja_new_bool(false);
+        switch (node->type) {
+        case JA_TYPE_STRING:
+            node->u.string = data + (uintptr_t)node->u.string;
+            node->flags |= JA_FLAG_BLOCK_DATA;
+            break;
+        case JA_TYPE_ARRAY:
+        case JA_TYPE_OBJECT: {
+            size_t size = node->u.object.size;
+            if (node->type == JA_TYPE_ARRAY) node->flags &= ~JA_FLAG_SHAPED;
+            if (size == 0) {
+                node->u.object.pairs = NULL;
+                node->flags &= ~JA_FLAG_SHAPED;
+                break;
+            }
+
+            node->flags |= JA_FLAG_BLOCK_DATA;
+            if (node->type == JA_TYPE_OBJECT && !(node->flags & JA_FLAG_SHAPED)) {
+                ja_pair *pairs = (ja_pair *)(void *)(data + (uintptr_t)node->u.object.pairs);
+                node->u.object.pairs = pairs;
+                for (size_t j = 0; j < size; j++) {
+                    pairs[j].key = __ja_key_retain(keys[(uintptr_t)pairs[j].key]);
+                    pairs[j].value_ptr = (ja_val *)(void *)(data + (uintptr_t)pairs[j].value_ptr);
+                }
+                break;
+            }
+
+            ja_val **slots = (ja_val **)(void *)(data + (uintptr_t)node->u.object.values);
+            if (node->type == JA_TYPE_OBJECT) {
+                __ja_children_head *head = __JA_CHILDREN_HEAD(slots);
+                head->shape = shapes[(uintptr_t)head->slot];
+                __atomic_add_fetch(&head->shape->refcount, 1, __ATOMIC_RELAXED);
+            }
+
+            node->u.object.values = slots;
+            for (size_t j = 0; j < size; j++) {
+                slots[j] = (ja_val *)(void *)(data + (uintptr_t)slots[j]);
+            }
+            break;
+        }
+        default:
+            break;
+        }
     }
-    JA_LOG_ERROR("Invalid boolean value.");
-    return NULL;
+
+    // The header node remembers how the block is released
+    nodes[0].type = JA_TYPE_NULL;
+    nodes[0].flags = JA_FLAG_IN_BLOCK | (mapped ? JA_FLAG_MAPPED : 0);
+    nodes[0].shares = 0;
+    nodes[0].u.array.items = NULL;
+    nodes[0].u.array.size = length;
+    root = &nodes[1];
+    goto cleanup;
+
+invalid:
+    JA_ERROR(JA_ERROR_INVALID_SNAPSHOT, "Invalid or incompatible snapshot: %s", filename);
+
+cleanup:
+    for (size_t i = 0; i < key_count; i++) __ja_key_release(keys[i]);
+    for (size_t i = 0; i < shape_count; i++) __ja_shape_release(shapes[i]);
+    free(keys);
+    free(shapes);
+
+    if (!root) {
+#ifdef JA_HAS_MMAP
+        if (mapped) munmap(data, length);
+        else free(data);
+#else
+        free(data);
+#endif
+    }
+    return root;
 }
 
-ja_val *__ja_parse_array(const char *json_str, int *chars_consumed) {
-    ja_val *jav = ja_new_arr();
-    if (!jav) return NULL;
+bool __ja_buffer_reserve(__ja_buffer *buffer, size_t extra) {
+    if (buffer->failed) return false;
+    if (buffer->capacity - buffer->length >= extra) return true;
 
-    json_str++;
-    if (chars_consumed) (*chars_consumed)++; // Count the '['
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity - buffer->length < extra) capacity *= 2;
 
-    while (*json_str) {
-        __ja_jump_whitespaces(&json_str, chars_consumed);
+    unsigned char *data = realloc(buffer->data, capacity);
+    if (!data) {
+        JA_MEM_ERROR();
+        buffer->failed = true;
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
 
-        if (*json_str == ']') {
-            json_str++;
-            if (chars_consumed) (*chars_consumed)++;
-            return jav;
-        }
+bool __ja_buffer_put(__ja_buffer *buffer, const void *bytes, size_t length) {
+    if (!__ja_buffer_reserve(buffer, length)) return false;
 
-        int inner_chars_consumed = 0;
-        ja_val *value = __ja_parse(json_str, &inner_chars_consumed);
-        if (!value) {
-            ja_free_val(&jav);
-            return NULL;
-        }
+    if (length) memcpy(buffer->data + buffer->length, bytes, length);
+    buffer->length += length;
+    return true;
+}
 
-        ja_arr_append(jav, value);
-        json_str += inner_chars_consumed;
-        if (chars_consumed) (*chars_consumed) += inner_chars_consumed;
+unsigned char *__ja_buffer_finish(__ja_buffer *buffer, size_t *length) {
+    if (buffer->failed) {
+        free(buffer->data);
+        buffer->data = NULL;
+        return NULL;
+    }
 
-        __ja_jump_whitespaces(&json_str, chars_consumed);
+    unsigned char *data = buffer->data;
+    if (buffer->length && buffer->length < buffer->capacity) {
+        unsigned char *shrunk = realloc(data, buffer->length);
+        if (shrunk) data = shrunk;
+    } else if (!data) {
+        data = malloc(1); // Nothing written, still hand out a buffer to be freed
+        if (!data) JA_MEM_ERROR();
+    }
 
-        if (*json_str == ',') {
-            json_str++;
-            if (chars_consumed) (*chars_consumed)++; // Count the ','
-        } else if (*json_str != ']') {
-            JA_LOG_ERROR("Invalid character in array: %c", *json_str);
-            ja_free_val(&jav);
-            return NULL;
-        }
-    } 
+    if (length) *length = data ? buffer->length : 0;
+    buffer->data = NULL;
+    return data;
+}
 
-    JA_LOG_ERROR("Unmatched brackets in array.");
-    ja_free_val(&jav);
-    return NULL;
+// Writes a lead byte followed by the `size` lower bytes of `number`, in big-endian order
+static bool __ja_buffer_put_be(__ja_buffer *buffer, uint8_t lead, uint64_t number, size_t size) {
+    unsigned char bytes[9];
+    bytes[0] = lead;
+    for (size_t i = 0; i < size; i++) bytes[1 + i] = (unsigned char)(number >> (8 * (size - 1 - i)));
+    return __ja_buffer_put(buffer, bytes, size + 1);
 }
 
-ja_val *__ja_parse_object(const char *json_str, int *chars_consumed) {
-    ja_val *jav = ja_new_obj();
-    if (!jav) return NULL;
+// Writes a CBOR head (major type and argument) in its shortest form
+static bool __ja_cbor_head(__ja_buffer *buffer, uint8_t major, uint64_t argument) {
+    major <<= 5;
+    if (argument < 24) return __ja_buffer_put_be(buffer, major | (uint8_t)argument, 0, 0);
+    if (argument <= UINT8_MAX) return __ja_buffer_put_be(buffer, major | 24, argument, 1);
+    if (argument <= UINT16_MAX) return __ja_buffer_put_be(buffer, major | 25, argument, 2);
+    if (argument <= UINT32_MAX) return __ja_buffer_put_be(buffer, major | 26, argument, 4);
+    return __ja_buffer_put_be(buffer, major | 27, argument, 8);
+}
 
-    ja_val *key_container = NULL;
-    ja_val *value = NULL;
+// Writes a MessagePack integer in its shortest form
+static bool __ja_msgpack_int(__ja_buffer *buffer, int64_t number) {
+    if (number >= 0) {
+        if (number < 128) return __ja_buffer_put_be(buffer, (uint8_t)number, 0, 0);
+        if (number <= UINT8_MAX) return __ja_buffer_put_be(buffer, 0xcc, (uint64_t)number, 1);
+        if (number <= UINT16_MAX) return __ja_buffer_put_be(buffer, 0xcd, (uint64_t)number, 2);
+        if (number <= UINT32_MAX) return __ja_buffer_put_be(buffer, 0xce, (uint64_t)number, 4);
+        return __ja_buffer_put_be(buffer, 0xcf, (uint64_t)number, 8);
+    }
+
+    if (number >= -32) return __ja_buffer_put_be(buffer, (uint8_t)number, 0, 0); // Negative fixint
+    if (number >= INT8_MIN) return __ja_buffer_put_be(buffer, 0xd0, (uint64_t)number, 1);
+    if (number >= INT16_MIN) return __ja_buffer_put_be(buffer, 0xd1, (uint64_t)number, 2);
+    if (number >= INT32_MIN) return __ja_buffer_put_be(buffer, 0xd2, (uint64_t)number, 4);
+    return __ja_buffer_put_be(buffer, 0xd3, (uint64_t)number, 8);
+}
 
-    json_str++; // Skip '{'
-    if (chars_consumed) (*chars_consumed)++;
+// Writes the length of a MessagePack string, array or map
+static bool __ja_msgpack_length(__ja_buffer *buffer, ja_type type, uint64_t length) {
+    bool string = type == JA_TYPE_STRING;
+    uint8_t fix = string ? 0xa0 : type == JA_TYPE_ARRAY ? 0x90 : 0x80;
+    uint8_t lead16 = string ? 0xda : type == JA_TYPE_ARRAY ? 0xdc : 0xde; // The 32-bit form follows it
 
-    while (*json_str) {
-        key_container = NULL;
-        value = NULL;
-        __ja_jump_whitespaces(&json_str, chars_consumed);
+    if (length < (string ? 32u : 16u)) return __ja_buffer_put_be(buffer, fix | (uint8_t)length, 0, 0);
+    if (string && length <= UINT8_MAX) return __ja_buffer_put_be(buffer, 0xd9, length, 1);
+    if (length <= UINT16_MAX) return __ja_buffer_put_be(buffer, lead16, length, 2);
+    if (length <= UINT32_MAX) return __ja_buffer_put_be(buffer, lead16 + 1, length, 4);
 
-        if (*json_str == '}') {
-            json_str++;
-            if (chars_consumed) (*chars_consumed)++;
-            return jav;
-        }
+    JA_ERROR(JA_ERROR_UNSUPPORTED_TYPE, "Length %llu doesn't fit in MessagePack.", (unsigned long long)length);
+    buffer->failed = true;
+    return false;
+}
 
-        int inner_chars_consumed = 0;
-        if (*json_str != '"') {
-            if (*json_str == '\0')
-                JA_LOG_ERROR("Unexpected end of file.");
-            else
-                JA_LOG_ERROR("Invalid character in object key: '%c'", *json_str);
-            ja_free_val(&key_container);
-            ja_free_val(&value);
-            ja_free_val(&jav);
-            return NULL;
-        }
+// Writes a string or key with its length
+static bool __ja_binary_string(__ja_buffer *buffer, const char *string, bool cbor) {
+    size_t length = strlen(string);
+    bool head = cbor ? __ja_cbor_head(buffer, 3, length) : __ja_msgpack_length(buffer, JA_TYPE_STRING, length);
+    return head && __ja_buffer_put(buffer, string, length);
+}
 
-        key_container = __ja_parse_string(json_str, &inner_chars_consumed);
-        if (!key_container) {
-            ja_free_val(&jav);
-            return NULL;
-        }
-        char *key = key_container->u.string;
+// Writes a value and its children as MessagePack or CBOR
+static bool __ja_binary_encode(__ja_buffer *buffer, ja_val *value, bool cbor, size_t depth) {
+    switch (value->type) {
+    case JA_TYPE_NULL:
+        return __ja_buffer_put_be(buffer, cbor ? 0xf6 : 0xc0, 0, 0);
 
-        json_str += inner_chars_consumed;
-        if (chars_consumed) (*chars_consumed) += inner_chars_consumed;
+    case JA_TYPE_BOOL:
+        if (cbor) return __ja_buffer_put_be(buffer, value->u.boolean ? 0xf5 : 0xf4, 0, 0);
+        return __ja_buffer_put_be(buffer, value->u.boolean ? 0xc3 : 0xc2, 0, 0);
 
-        __ja_jump_whitespaces(&json_str, chars_consumed);
+    case JA_TYPE_INT: {
+        int64_t number = value->u.number.as_int;
+        if (!cbor) return __ja_msgpack_int(buffer, number);
+        return number >= 0 ? __ja_cbor_head(buffer, 0, (uint64_t)number) : __ja_cbor_head(buffer, 1, (uint64_t)(-1 - number));
+    }
 
-        if (*json_str != ':') {
-            JA_LOG_ERROR("Missing colon after key: %s", key);
-            ja_free_val(&jav);
-            ja_free_val(&key_container);
-            return NULL;
-        }
+    case JA_TYPE_DOUBLE: {
+        uint64_t bits;
+        memcpy(&bits, &value->u.number.as_double, sizeof(bits));
+        return __ja_buffer_put_be(buffer, cbor ? 0xfb : 0xcb, bits, 8);
+    }
 
-        json_str++;
-        if (chars_consumed) (*chars_consumed)++;
-        __ja_jump_whitespaces(&json_str, chars_consumed);
+    case JA_TYPE_STRING:
+        return __ja_binary_string(buffer, value->u.string ? value->u.string : "", cbor);
 
-        int value_chars_consumed = 0;
-        value = __ja_parse(json_str, &value_chars_consumed);
-        if (!value) {
-            ja_free_val(&jav);
-            ja_free_val(&key_container);
-            return NULL;
+    case JA_TYPE_ARRAY:
+    case JA_TYPE_OBJECT: {
+        if (depth >= JA_MAX_DEPTH) {
+            JA_ERROR(JA_ERROR_DEPTH_LIMIT, "More than %d nested arrays and objects.", JA_MAX_DEPTH);
+            buffer->failed = true;
+            return false;
         }
 
-        json_str += value_chars_consumed;
-        if (chars_consumed) (*chars_consumed) += value_chars_consumed;
-        __ja_jump_whitespaces(&json_str, chars_consumed);
+        bool array = value->type == JA_TYPE_ARRAY;
+        size_t size = array ? value->u.array.size : __ja_obj_live(value);
+        bool head = cbor ? __ja_cbor_head(buffer, array ? 4 : 5, size) : __ja_msgpack_length(buffer, value->type, size);
+        if (!head) return false;
 
-        if (*json_str == ',') {
-            json_str++;
-            if (chars_consumed) (*chars_consumed)++;
-        } else if (*json_str != '}') {
-            JA_LOG_ERROR("Invalid character in object: '%c'", *json_str);
-            ja_free_val(&jav);
-            ja_free_val(&key_container);
-            ja_free_val(&value);
-            return NULL;
+        ja_val scratch;
+        for (size_t i = 0; i < value->u.object.size; i++) { // Same word as u.array.size, tombstones included
+            if (array) {
+                if (!__ja_binary_encode(buffer, __ja_arr_peek(value, i, &scratch), cbor, depth + 1)) return false;
+                continue;
+            }
+            if (__ja_obj_tombstone(value, i)) continue;
+            if (!__ja_binary_string(buffer, __ja_obj_key(value, i), cbor) ||
+                !__ja_binary_encode(buffer, *__ja_obj_slot(value, i), cbor, depth + 1)) return false;
         }
-
-        ja_set_obj_at(jav, key, value);
-        ja_free_val(&key_container);
-        key_container = NULL;
-        value = NULL;
+        return true;
+    }
     }
 
-    JA_LOG_ERROR("Unmatched brackets in object.");
-    ja_free_val(&key_container);
-    ja_free_val(&value);
-    ja_free_val(&jav);
-    return NULL;
+    return false;
 }
 
-ja_val *__ja_parse_null(const char *json_str, int *chars_consumed) {
-    if (strncmp(json_str, "null", 4) == 0) {
-        if (chars_consumed) (*chars_consumed) += 4;
-        return ja_new_null();
+// Encodes a whole value into an allocated buffer
+static unsigned char *__ja_binary_encode_all(ja_val *value, size_t *length, bool cbor) {
+    if (length) *length = 0;
+    if (!value) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL value. Can't encode it.");
+        return NULL;
     }
-    JA_LOG_ERROR("Invalid null value.");
+
+    __ja_buffer buffer = { 0 };
+    __ja_binary_encode(&buffer, value, cbor, 0);
+    return __ja_buffer_finish(&buffer, length);
+}
+
+unsigned char *ja_to_msgpack(ja_val *value, size_t *length) {
+    unsigned char *data = __ja_binary_encode_all(value, length, false);
+    if (!data) JA_PROPAGATE_ERROR("ja_to_msgpack");
+    return data;
+}
+
+unsigned char *ja_to_cbor(ja_val *value, size_t *length) {
+    unsigned char *data = __ja_binary_encode_all(value, length, true);
+    if (!data) JA_PROPAGATE_ERROR("ja_to_cbor");
+    return data;
+}
+
+// Position of a decoder in its input
+typedef struct __ja_binary_reader {
+    const unsigned char *data;
+    size_t length;
+    size_t offset;
+} __ja_binary_reader;
+
+// Records a decoding error at the current offset
+static ja_val *__ja_binary_fail(__ja_binary_reader *reader, ja_error_code code) {
+    JA_ERROR(code, "Can't decode byte %zu: %s", reader->offset, __ja_error_reason(code));
+    __ja_last_error_value.offset = reader->offset;
     return NULL;
 }
 
-void __ja_jump_whitespaces(const char **str_ptr, int *chars_consumed) {
-    while (**str_ptr && isspace(**str_ptr)) {
-        (*str_ptr)++;
-        if (chars_consumed) (*chars_consumed)++;
+// Reads a big-endian number of `size` bytes
+static bool __ja_binary_read(__ja_binary_reader *reader, size_t size, uint64_t *number) {
+    if (reader->length - reader->offset < size) {
+        __ja_binary_fail(reader, JA_ERROR_UNEXPECTED_END);
+        return false;
     }
+
+    uint64_t result = 0;
+    for (size_t i = 0; i < size; i++) result = (result << 8) | reader->data[reader->offset + i];
+    reader->offset += size;
+    *number = result;
+    return true;
 }
 
-int ja_enum_type_of(ja_val *value) {
-    if (!value) {
-        JA_LOG_ERROR("Can't retrieve type of a NULL pointer.");
-        return 0;
-    }
+// Creates a number from a decoded integer (-1 - magnitude when negative, as in CBOR)
+static ja_val *__ja_binary_int(uint64_t magnitude, bool negative) {
+    ja_val *jav = __ja_new_generic();
+    if (!jav) return NULL;
 
-    switch (value->type) {
-    case JA_TYPE_INT: 
-    case JA_TYPE_DOUBLE: 
-    case JA_TYPE_STRING: 
-    case JA_TYPE_BOOL: 
-    case JA_TYPE_ARRAY: 
-    case JA_TYPE_OBJECT: 
-    case JA_TYPE_NULL: 
-        return (int)value->type;
-    default:
-        return -1;
+    if (magnitude <= INT_MAX) {
+        jav->type = JA_TYPE_INT;
+        jav->u.number.as_int = negative ? -1 - (int)magnitude : (int)magnitude;
+        jav->u.number.as_double = jav->u.number.as_int;
+    } else {
+        // Out of the range of as_int, kept as a double like ja_new_num() would
+        jav->type = JA_TYPE_DOUBLE;
+        jav->u.number.as_int = negative ? INT_MIN : INT_MAX;
+        jav->u.number.as_double = negative ? -1.0 - (double)magnitude : (double)magnitude;
     }
+    return jav;
 }
 
-const char *ja_str_type_of(ja_val *value) {
-    if (!value) {
-        JA_LOG_ERROR("Can't retrieve type of a NULL pointer.");
-        return NULL;
-    }
+// Creates a number from a decoded signed integer
+static ja_val *__ja_binary_signed(int64_t number) {
+    if (number < 0) return __ja_binary_int((uint64_t)(-(number + 1)), true);
+    return __ja_binary_int((uint64_t)number, false);
+}
 
-    return __ja_type_enum_to_str(value->type);
+// Creates a double from decoded bits
+static ja_val *__ja_binary_double(double number) {
+    ja_val *jav = __ja_new_generic();
+    if (!jav) return NULL;
+
+    jav->type = JA_TYPE_DOUBLE;
+    jav->u.number.as_double = number;
+    jav->u.number.as_int = number > INT_MIN && number < INT_MAX ? (int)number : 0;
+    return jav;
 }
 
-const char *__ja_type_enum_to_str(ja_type type) {
-    switch (type) {
-    case JA_TYPE_INT: return "Number";
-    case JA_TYPE_DOUBLE: return "Number";
-    case JA_TYPE_STRING: return "String";
-    case JA_TYPE_BOOL: return "Bool";
-    case JA_TYPE_ARRAY: return "Array";
-    case JA_TYPE_OBJECT: return "Object";
-    case JA_TYPE_NULL: return "Null";
-    default: return "Unknown";
-    }
+// Converts a CBOR half precision float (RFC 8949, appendix D)
+static double __ja_half_to_double(uint16_t half) {
+    int exponent = (half >> 10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    double value;
+
+    if (exponent == 0) value = ldexp(mantissa, -24);
+    else if (exponent != 31) value = ldexp(mantissa + 1024, exponent - 25);
+    else value = mantissa == 0 ? INFINITY : NAN;
+
+    return half & 0x8000 ? -value : value;
 }
 
-size_t ja_size_of(ja_val *value) {
-    if (!value) {
-        JA_LOG_ERROR("Can't access size of NULL value.");
-        return 0;
+// Checks the bytes of a string of `length` bytes, which can't hold a null character
+static const char *__ja_binary_bytes(__ja_binary_reader *reader, uint64_t length) {
+    if (reader->length - reader->offset < length) {
+        __ja_binary_fail(reader, JA_ERROR_UNEXPECTED_END);
+        return NULL;
     }
 
-    switch (value->type) {
-    case JA_TYPE_STRING: return strlen(value->u.string);
-    case JA_TYPE_ARRAY: return value->u.array.size;
-    case JA_TYPE_OBJECT: return value->u.object.size;
-    default:
-        JA_LOG_ERROR("Can't use ja_size_of() for this type (%s).", ja_str_type_of(value));
-        return 0;
+    const char *start = (const char *)reader->data + reader->offset;
+    const char *zero = memchr(start, '\0', (size_t)length);
+    if (zero) {
+        reader->offset += (size_t)(zero - start);
+        __ja_binary_fail(reader, JA_ERROR_INVALID_STRING);
+        return NULL;
     }
-}
 
-void ja_free_val(ja_val **val_ptr) {
-    if (!val_ptr || !(*val_ptr)) return;
-    
-    __ja_free_val(*val_ptr);
-    free(*val_ptr);
-    *val_ptr = NULL;
+    reader->offset += (size_t)length;
+    return start;
 }
 
-void __ja_free_val(ja_val *value) {
-    if (!value) return;
+// Creates a string value of `length` bytes
+static ja_val *__ja_binary_str(__ja_binary_reader *reader, uint64_t length) {
+    const char *start = __ja_binary_bytes(reader, length);
+    if (!start) return NULL;
 
-    switch (value->type) {
-        case JA_TYPE_STRING:
-            free(value->u.string);
-            value->u.string = NULL;
-            break;
-        case JA_TYPE_ARRAY:
-            for (size_t i = 0; i < value->u.array.size; i++) {
-                ja_free_val(&value->u.array.items[i]);
-            }
-            free(value->u.array.items);
-            value->u.array.items = NULL;
-            break;
-        case JA_TYPE_OBJECT:
-            for (size_t i = 0; i < value->u.object.size; i++) {
-                free(value->u.object.pairs[i].key);
-                value->u.object.pairs[i].key = NULL;
-                ja_free_val(&value->u.object.pairs[i].value_ptr);
-            }
-            free(value->u.object.pairs);
-            value->u.object.pairs = NULL;
-            break;
-        default:
-            break;
+    ja_val *jav = __ja_new_generic();
+    char *string = malloc((size_t)length + 1);
+    if (!jav || !string) {
+        if (jav && !string) JA_MEM_ERROR();
+        free(jav);
+        free(string);
+        return NULL;
     }
+
+    memcpy(string, start, (size_t)length);
+    string[length] = '\0';
+    jav->type = JA_TYPE_STRING;
+    jav->u.string = string;
+    return jav;
 }
 
-ja_json* ja_json_init() {
-    ja_json *ja_json_object = malloc(sizeof(ja_json));
-    if (!ja_json_object) {
-        JA_MEM_ERROR();
+// Reads an object key, which must be a string
+static char *__ja_binary_key(__ja_binary_reader *reader, bool cbor) {
+    if (reader->offset >= reader->length) {
+        __ja_binary_fail(reader, JA_ERROR_UNEXPECTED_END);
         return NULL;
     }
 
-    ja_json_object->json_str = NULL;
-    ja_json_object->content = NULL;
+    uint8_t lead = reader->data[reader->offset];
+    uint64_t length = 0;
+    bool read = false;
+
+    if (cbor && lead >> 5 == 3 && (lead & 0x1f) < 28) {
+        reader->offset++;
+        length = lead & 0x1f;
+        read = length < 24 || __ja_binary_read(reader, (size_t)1 << (length - 24), &length);
+    } else if (!cbor && (lead & 0xe0) == 0xa0) {
+        reader->offset++;
+        length = lead & 0x1f;
+        read = true;
+    } else if (!cbor && lead >= 0xd9 && lead <= 0xdb) {
+        reader->offset++;
+        read = __ja_binary_read(reader, (size_t)1 << (lead - 0xd9), &length);
+    } else {
+        __ja_binary_fail(reader, JA_ERROR_UNSUPPORTED_TYPE);
+        return NULL;
+    }
 
-    return ja_json_object;
+    const char *start = read ? __ja_binary_bytes(reader, length) : NULL;
+    return start ? __ja_key_make(start, (size_t)length) : NULL;
 }
 
-bool ja_read_json(ja_json *ja_json_object, const char *filename) {
-    if (!ja_json_object) {
-        JA_LOG_ERROR("ja_read_json() received NULL ja_json.");
-        return false;
-    }
+static ja_val *__ja_binary_item(__ja_binary_reader *reader, bool cbor, size_t depth);
 
-    if (!filename) {
-        JA_LOG_ERROR("Filename not specified, can't open file");
-        return false;
-    }
-    
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        JA_LOG_ERROR("Error while opening file: %s", filename);
-        return false;
+// Returns true and skips the break byte ending an indefinite-length CBOR array or map
+static bool __ja_cbor_break(__ja_binary_reader *reader) {
+    if (reader->offset >= reader->length || reader->data[reader->offset] != 0xff) return false;
+    reader->offset++;
+    return true;
+}
+
+// Decodes `count` items into an array (until a break byte if indefinite)
+static ja_val *__ja_binary_array(__ja_binary_reader *reader, bool cbor, size_t depth, uint64_t count, bool indefinite) {
+    if (depth >= JA_MAX_DEPTH) return __ja_binary_fail(reader, JA_ERROR_DEPTH_LIMIT);
+    if (!indefinite && count > reader->length - reader->offset) {
+        return __ja_binary_fail(reader, JA_ERROR_UNEXPECTED_END); // Every item takes a byte at least
     }
 
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    ja_val *array = ja_new_arr();
+    if (!array) return NULL;
 
-    if (file_size <= 0) {
-        JA_LOG_ERROR("File is empty or unreadable: %s", filename);
-        fclose(file);
-        return false;
-    }
+    size_t capacity = 0;
+    for (uint64_t i = 0; indefinite || i < count; i++) {
+        if (indefinite && __ja_cbor_break(reader)) break;
 
-    char* buffer = malloc(file_size + 1);
-    if (!buffer) {
-        JA_MEM_ERROR();
-        fclose(file);
-        return false;
+        if (array->u.array.size == capacity) {
+            capacity = indefinite ? (capacity ? capacity * 2 : 8) : (size_t)count;
+            ja_val **items = realloc(array->u.array.items, capacity * sizeof(ja_val*));
+            if (!items) {
+                JA_MEM_ERROR();
+                ja_free_val(&array);
+                return NULL;
+            }
+            array->u.array.items = items;
+        }
+
+        ja_val *item = __ja_binary_item(reader, cbor, depth + 1);
+        if (!item) {
+            ja_free_val(&array);
+            return NULL;
+        }
+        array->u.array.items[array->u.array.size++] = item;
     }
 
-    size_t bytes_read = fread(buffer, 1, file_size, file);
-    fclose(file);
+    __ja_arr_pack(array);
+    return array;
+}
 
-    if ((long)bytes_read != file_size) {
-        JA_LOG_ERROR("Expected to read %ld bytes but only read %zu.", file_size, bytes_read);
-        free(buffer);
-        return false;
+// Decodes `count` key-value pairs into an object (until a break byte if indefinite)
+static ja_val *__ja_binary_object(__ja_binary_reader *reader, bool cbor, size_t depth, uint64_t count, bool indefinite) {
+    if (depth >= JA_MAX_DEPTH) return __ja_binary_fail(reader, JA_ERROR_DEPTH_LIMIT);
+    if (!indefinite && count > (reader->length - reader->offset) / 2) {
+        return __ja_binary_fail(reader, JA_ERROR_UNEXPECTED_END); // Every pair takes two bytes at least
     }
 
-    buffer[file_size] = '\0';
+    ja_val *object = ja_new_obj();
+    if (!object) return NULL;
 
-    ja_val *parsed = ja_parse(buffer);
-    if (!parsed) {
-        JA_PROPAGATE_ERROR("ja_read_json");
-        free(buffer);
-        ja_json_object->json_str = NULL;
-        ja_json_object->content = NULL;
-        return false;
-    }
+    size_t capacity = 0;
+    for (uint64_t i = 0; indefinite || i < count; i++) {
+        if (indefinite && __ja_cbor_break(reader)) break;
 
-    ja_json_object->json_str = buffer;
-    ja_json_object->content = parsed;
+        if (object->u.object.size == capacity) {
+            capacity = indefinite ? (capacity ? capacity * 2 : 8) : (size_t)count;
+            ja_pair *pairs = realloc(object->u.object.pairs, capacity * sizeof(ja_pair));
+            if (!pairs) {
+                JA_MEM_ERROR();
+                ja_free_val(&object);
+                return NULL;
+            }
+            object->u.object.pairs = pairs;
+        }
 
-    return true;
+        char *key = __ja_binary_key(reader, cbor);
+        ja_val *value = key ? __ja_binary_item(reader, cbor, depth + 1) : NULL;
+        if (!value) {
+            if (key) __ja_key_release(key);
+            ja_free_val(&object);
+            return NULL;
+        }
+
+        // Repeated keys keep the last value, as in the parser
+        const __ja_key *header = __ja_key_header(key);
+        size_t index = __ja_obj_find(object, key, header->hash, header->length);
+        if (index < object->u.object.size) {
+            __ja_key_release(key);
+            ja_free_val(&object->u.object.pairs[index].value_ptr);
+            object->u.object.pairs[index].value_ptr = value;
+            continue;
+        }
+
+        object->u.object.pairs[object->u.object.size].key = key;
+        object->u.object.pairs[object->u.object.size].value_ptr = value;
+        object->u.object.size++;
+    }
+
+    __ja_obj_shape(object);
+    return object;
 }
 
-bool ja_write_json(ja_json *ja_json_object, const char *filename) {
-    if (!ja_json_object) {
-        JA_LOG_ERROR("ja_sync_json() called with NULL pointer.");
-        return false;
+// Decodes a MessagePack value
+static ja_val *__ja_msgpack_item(__ja_binary_reader *reader, size_t depth) {
+    if (reader->offset >= reader->length) return __ja_binary_fail(reader, JA_ERROR_UNEXPECTED_END);
+
+    uint8_t lead = reader->data[reader->offset++];
+    uint64_t number;
+
+    if (lead <= 0x7f) return __ja_binary_int(lead, false);
+    if (lead >= 0xe0) return __ja_binary_signed((int8_t)lead);
+    if ((lead & 0xf0) == 0x80) return __ja_binary_object(reader, false, depth, lead & 0x0f, false);
+    if ((lead & 0xf0) == 0x90) return __ja_binary_array(reader, false, depth, lead & 0x0f, false);
+    if ((lead & 0xe0) == 0xa0) return __ja_binary_str(reader, lead & 0x1f);
+
+    switch (lead) {
+    case 0xc0: return ja_new_null();
+    case 0xc2: return ja_new_bool(false);
+    case 0xc3: return ja_new_bool(true);
+
+    case 0xca: {
+        if (!__ja_binary_read(reader, 4, &number)) return NULL;
+        uint32_t bits = (uint32_t)number;
+        float single;
+        memcpy(&single, &bits, sizeof(single));
+        return __ja_binary_double(single);
     }
 
-    if (!filename) {
-        JA_LOG_ERROR("Can't save file with NULL filename.");
-        return false;
+    case 0xcb: {
+        if (!__ja_binary_read(reader, 8, &number)) return NULL;
+        double value;
+        memcpy(&value, &number, sizeof(value));
+        return __ja_binary_double(value);
     }
 
-    ja_sync_json(ja_json_object);
+    case 0xcc: case 0xcd: case 0xce: case 0xcf:
+        if (!__ja_binary_read(reader, (size_t)1 << (lead - 0xcc), &number)) return NULL;
+        return __ja_binary_int(number, false);
 
-    if (!ja_json_object->json_str) {
-        JA_LOG_ERROR("No JSON string to write.");
-        return false;
+    case 0xd0: case 0xd1: case 0xd2: case 0xd3: {
+        size_t size = (size_t)1 << (lead - 0xd0);
+        if (!__ja_binary_read(reader, size, &number)) return NULL;
+        uint64_t sign = (uint64_t)1 << (8 * size - 1);
+        int64_t value = size == 8 ? (int64_t)number : (int64_t)(number ^ sign) - (int64_t)sign;
+        return __ja_binary_signed(value);
     }
 
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        JA_LOG_ERROR("Error opening file: %s", filename);
-        return false;
-    }
+    case 0xd9: case 0xda: case 0xdb:
+        if (!__ja_binary_read(reader, (size_t)1 << (lead - 0xd9), &number)) return NULL;
+        return __ja_binary_str(reader, number);
 
-    fputs(ja_json_object->json_str, file);
-    fclose(file);
+    case 0xdc: case 0xdd:
+        if (!__ja_binary_read(reader, lead == 0xdc ? 2 : 4, &number)) return NULL;
+        return __ja_binary_array(reader, false, depth, number, false);
 
-    return true;
+    case 0xde: case 0xdf:
+        if (!__ja_binary_read(reader, lead == 0xde ? 2 : 4, &number)) return NULL;
+        return __ja_binary_object(reader, false, depth, number, false);
+    }
+
+    reader->offset--; // Binary data, extensions and the unused 0xc1
+    return __ja_binary_fail(reader, JA_ERROR_UNSUPPORTED_TYPE);
 }
 
-void ja_sync_json(ja_json *ja_json_object) {
-    if (!ja_json_object) {
-        JA_LOG_ERROR("ja_sync_json() called with NULL pointer.");
-        return;
-    }
+// Decodes a CBOR value
+static ja_val *__ja_cbor_item(__ja_binary_reader *reader, size_t depth) {
+    if (reader->offset >= reader->length) return __ja_binary_fail(reader, JA_ERROR_UNEXPECTED_END);
+
+    uint8_t lead = reader->data[reader->offset++];
+    uint8_t major = lead >> 5;
+    uint8_t info = lead & 0x1f;
+    uint64_t argument = info;
+
+    if (major == 7) {
+        switch (info) {
+        case 20: return ja_new_bool(false);
+        case 21: return ja_new_bool(true);
+        case 22:
+        case 23: return ja_new_null(); // null and undefined
+
+        case 25:
+            if (!__ja_binary_read(reader, 2, &argument)) return NULL;
+            return __ja_binary_double(__ja_half_to_double((uint16_t)argument));
+
+        case 26: {
+            if (!__ja_binary_read(reader, 4, &argument)) return NULL;
+            uint32_t bits = (uint32_t)argument;
+            float single;
+            memcpy(&single, &bits, sizeof(single));
+            return __ja_binary_double(single);
+        }
 
-    if (!ja_json_object->content) {
-        JA_LOG_ERROR("No content to sync.");
-        return;
+        case 27: {
+            if (!__ja_binary_read(reader, 8, &argument)) return NULL;
+            double value;
+            memcpy(&value, &argument, sizeof(value));
+            return __ja_binary_double(value);
+        }
+        }
+    } else if (info == 31) {
+        if (major == 4) return __ja_binary_array(reader, true, depth, 0, true);
+        if (major == 5) return __ja_binary_object(reader, true, depth, 0, true);
+    } else if (info < 28) {
+        if (info >= 24 && !__ja_binary_read(reader, (size_t)1 << (info - 24), &argument)) return NULL;
+
+        switch (major) {
+        case 0: return __ja_binary_int(argument, false);
+        case 1: return __ja_binary_int(argument, true);
+        case 3: return __ja_binary_str(reader, argument);
+        case 4: return __ja_binary_array(reader, true, depth, argument, false);
+        case 5: return __ja_binary_object(reader, true, depth, argument, false);
+        case 6:
+            // Tags (dates, big numbers...) only annotate the next item, which is decoded as is
+            if (depth >= JA_MAX_DEPTH) return __ja_binary_fail(reader, JA_ERROR_DEPTH_LIMIT);
+            return __ja_cbor_item(reader, depth + 1);
+        }
+        reader->offset -= (info >= 24 ? (size_t)1 << (info - 24) : 0);
     }
 
-    char *json_str = ja_stringify(ja_json_object->content);
-    if (!json_str) {
-        JA_PROPAGATE_ERROR("ja_write_json");
-        return;
-    }
+    reader->offset--; // Byte strings, indefinite-length strings, simple values and reserved heads
+    return __ja_binary_fail(reader, JA_ERROR_UNSUPPORTED_TYPE);
+}
 
-    free(ja_json_object->json_str);
-    ja_json_object->json_str = json_str;
+static ja_val *__ja_binary_item(__ja_binary_reader *reader, bool cbor, size_t depth) {
+    return cbor ? __ja_cbor_item(reader, depth) : __ja_msgpack_item(reader, depth);
 }
 
-void ja_json_end(ja_json *ja_json_object) {
-    if (!ja_json_object) {
-        JA_LOG_ERROR("Can't end NULL ja_json.");
-        return;
-    }
-    
-    if (ja_json_object->json_str) {
-        free(ja_json_object->json_str);
-        ja_json_object->json_str = NULL;
+// Decodes a whole input holding exactly one value
+static ja_val *__ja_binary_decode_all(const unsigned char *data, size_t length, bool cbor) {
+    if (!data) {
+        JA_ERROR(JA_ERROR_NULL_ARGUMENT, "NULL data. Can't decode it.");
+        return NULL;
     }
 
-    if (ja_json_object->content) {
-        ja_free_val(&ja_json_object->content);
-        ja_json_object->content = NULL;
+    __ja_binary_reader reader = { data, length, 0 };
+    __ja_parse_scope scope = { 0 };
+    __ja_parse_scope *previous = __ja_intern_begin(&scope);
+    ja_val *value = __ja_binary_item(&reader, cbor, 0);
+    __ja_intern_end(&scope, previous);
+
+    if (value && reader.offset != length) {
+        ja_free_val(&value);
+        __ja_binary_fail(&reader, JA_ERROR_TRAILING_CONTENT);
     }
+    return value;
+}
 
-    free(ja_json_object);
+ja_val *ja_from_msgpack(const unsigned char *data, size_t length) {
+    ja_val *value = __ja_binary_decode_all(data, length, false);
+    if (!value) JA_PROPAGATE_ERROR("ja_from_msgpack");
+    return value;
+}
+
+ja_val *ja_from_cbor(const unsigned char *data, size_t length) {
+    ja_val *value = __ja_binary_decode_all(data, length, true);
+    if (!value) JA_PROPAGATE_ERROR("ja_from_cbor");
+    return value;
 }
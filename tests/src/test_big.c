@@ -1,6 +1,7 @@
 #include "jajson.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * @file test_big.c
@@ -91,6 +92,56 @@ static void run_big_json_tests(ja_json *json) {
     );
 }
 
+/**
+ * @brief Checks that the parallel parser builds the same tree as the serial one.
+ */
+static void run_parallel_tests(ja_json *json) {
+    ja_json *parallel_json = ja_json_init();
+    if (!parallel_json || !ja_read_json_parallel(parallel_json, "tests/data/test_big.json", 4)) {
+        assert_test("ja_read_json_parallel() should read test_big.json", 0);
+        if (parallel_json) ja_json_end(parallel_json);
+        return;
+    }
+
+    char *serial_str = ja_stringify(json->content);
+    char *parallel_str = ja_stringify(parallel_json->content);
+    assert_test("Parallel parse should match the serial parse",
+        serial_str && parallel_str && strcmp(serial_str, parallel_str) == 0
+    );
+    free(serial_str);
+    free(parallel_str);
+
+    run_big_json_tests(parallel_json);
+
+    bool serial_missing = !ja_read_json(parallel_json, "tests/data/missing.json") && ja_last_error()->code == JA_ERROR_IO;
+    assert_test("Both readers should report a missing file the same way", serial_missing &&
+        !ja_read_json_parallel(parallel_json, "tests/data/missing.json", 4) && ja_last_error()->code == JA_ERROR_IO);
+    ja_json_end(parallel_json);
+
+    // Element boundaries found by the pre-scan must still be validated
+    size_t count = 20000;
+    char *big_array = malloc(count * 8 + 16);
+    char *ptr = big_array;
+    *ptr++ = '[';
+    for (size_t i = 0; i < count; i++) {
+        ptr += sprintf(ptr, "%s\"%zu\"", i ? "," : "", i);
+    }
+    strcpy(ptr, "]");
+
+    ja_val *parsed = ja_parse_parallel(big_array, 4);
+    assert_test("Big array should be parsed in order",
+        parsed && ja_size_of(parsed) == count &&
+        strcmp(ja_get_str(ja_get_arr_at(parsed, count - 1)), "19999") == 0
+    );
+    ja_free_val(&parsed);
+
+    strcpy(ptr, " 7]");
+    parsed = ja_parse_parallel(big_array, 4);
+    assert_test("Big array with missing comma should fail", parsed == NULL);
+
+    free(big_array);
+}
+
 /**
  * @brief Entry point for the jaJSON big data test.
  */
@@ -110,6 +161,12 @@ int main(void) {
     }
 
     run_big_json_tests(json);
+    run_parallel_tests(json);
+
+    ja_error error;
+    assert_test("ja_validate() should accept test_big.json",
+        ja_validate(json->json_str, strlen(json->json_str), &error) && error.code == JA_ERROR_NONE
+    );
 
     // 📊 Summary
     printf("\n=================================\n");
@@ -0,0 +1,293 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests MessagePack and CBOR encoding (ja_to_msgpack / ja_from_msgpack, ja_to_cbor / ja_from_cbor).
+ *
+ * It verifies:
+ *  - ✅ Documents encode and decode back equal in both formats, keeping ints and doubles apart.
+ *  - ✅ Encodings match the shortest forms of the specifications byte for byte.
+ *  - ✅ Encodings written by other libraries (wide integers, floats, indefinite lengths, tags) are read.
+ *  - ✅ Truncated, unsupported or trailing input is rejected at the right offset.
+ *  - ✅ The big test file is smaller and encodes faster than its JSON text.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+#define SAMPLE_JSON \
+    "{\"service\": \"api\", \"ports\": [80, 443, -1, -200, 70000], \"ratio\": 0.75," \
+    " \"debug\": false, \"owner\": null, \"records\": [{\"id\": 1, \"role\": \"admin\"}, {\"id\": 2, \"role\": \"user\"}]," \
+    " \"text\": \"a string longer than thirty-one bytes, so it needs str8\", \"empty\": {\"list\": [], \"map\": {}}}"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Checks that two values serialize to the same text.
+ */
+static bool same_text(ja_val *a, ja_val *b) {
+    char *a_str = ja_stringify(a);
+    char *b_str = ja_stringify(b);
+    bool equal = a_str && b_str && strcmp(a_str, b_str) == 0;
+    free(a_str);
+    free(b_str);
+    return equal;
+}
+
+/**
+ * @brief Checks that an encoding matches the expected bytes.
+ */
+static bool same_bytes(const unsigned char *data, size_t length, const unsigned char *expected, size_t expected_length) {
+    return data && length == expected_length && memcmp(data, expected, length) == 0;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Encodes and decodes a document in both formats.
+ */
+static void run_round_trip_test(void) {
+    printf("\n> Round trip\n");
+
+    ja_val *original = ja_parse(SAMPLE_JSON);
+    size_t length = 0;
+
+    unsigned char *msgpack = ja_to_msgpack(original, &length);
+    ja_val *from_msgpack = ja_from_msgpack(msgpack, length);
+    log_test_result("MessagePack decodes back equal", from_msgpack && same_text(original, from_msgpack));
+    free(msgpack);
+
+    unsigned char *cbor = ja_to_cbor(original, &length);
+    ja_val *from_cbor = ja_from_cbor(cbor, length);
+    log_test_result("CBOR decodes back equal", from_cbor && same_text(original, from_cbor));
+    free(cbor);
+
+    bool types = from_msgpack && from_cbor;
+    ja_val *decoded[] = { from_msgpack, from_cbor };
+    for (int i = 0; types && i < 2; i++) {
+        ja_val *ports = ja_get_obj_at(decoded[i], "ports");
+        types = ja_get_obj_at(decoded[i], "ratio")->type == JA_TYPE_DOUBLE &&
+            ja_get_arr_at(ports, 0)->type == JA_TYPE_INT &&
+            ja_get_int(ja_get_arr_at(ports, 3)) == -200 && ja_get_int(ja_get_arr_at(ports, 4)) == 70000;
+    }
+    log_test_result("Ints and doubles keep their type", types);
+
+    ja_val *records = ja_get_obj_at(from_cbor, "records");
+    log_test_result("Decoded objects are shaped like parsed ones",
+        (ja_get_arr_at(records, 0)->flags & JA_FLAG_SHAPED) &&
+        __ja_obj_shape_of(ja_get_arr_at(records, 0)) == __ja_obj_shape_of(ja_get_arr_at(records, 1)));
+
+    ja_set_obj_at(from_msgpack, "service", ja_new_str("rpc"));
+    ja_arr_append(ja_get_obj_at(from_msgpack, "ports"), ja_new_num(8080));
+    log_test_result("Decoded values can be modified",
+        strcmp(ja_get_str(ja_get_obj_at(from_msgpack, "service")), "rpc") == 0 &&
+        ja_size_of(ja_get_obj_at(from_msgpack, "ports")) == 6);
+
+    ja_free_val(&from_msgpack);
+    ja_free_val(&from_cbor);
+    ja_free_val(&original);
+}
+
+/**
+ * @brief Compares encodings with the bytes given by the specifications.
+ */
+static void run_encoding_test(void) {
+    printf("\n> Encodings\n");
+
+    ja_val *value = ja_parse("{\"a\": [1, -1, 300, true, null], \"b\": 1.5}");
+    size_t length = 0;
+
+    unsigned char *msgpack = ja_to_msgpack(value, &length);
+    const unsigned char expected_msgpack[] = {
+        0x82, 0xa1, 'a', 0x95, 0x01, 0xff, 0xcd, 0x01, 0x2c, 0xc3, 0xc0,
+        0xa1, 'b', 0xcb, 0x3f, 0xf8, 0, 0, 0, 0, 0, 0
+    };
+    log_test_result("MessagePack uses the shortest forms",
+        same_bytes(msgpack, length, expected_msgpack, sizeof(expected_msgpack)));
+    free(msgpack);
+
+    unsigned char *cbor = ja_to_cbor(value, &length);
+    const unsigned char expected_cbor[] = {
+        0xa2, 0x61, 'a', 0x85, 0x01, 0x20, 0x19, 0x01, 0x2c, 0xf5, 0xf6,
+        0x61, 'b', 0xfb, 0x3f, 0xf8, 0, 0, 0, 0, 0, 0
+    };
+    log_test_result("CBOR uses the shortest forms", same_bytes(cbor, length, expected_cbor, sizeof(expected_cbor)));
+    free(cbor);
+    ja_free_val(&value);
+
+    value = ja_new_num(-100000);
+    msgpack = ja_to_msgpack(value, &length);
+    const unsigned char expected_int32[] = { 0xd2, 0xff, 0xfe, 0x79, 0x60 };
+    log_test_result("Negative ints use the signed forms", same_bytes(msgpack, length, expected_int32, sizeof(expected_int32)));
+    free(msgpack);
+    ja_free_val(&value);
+}
+
+/**
+ * @brief Decodes forms that this library doesn't write, but other encoders do.
+ */
+static void run_foreign_test(void) {
+    printf("\n> Foreign encodings\n");
+
+    // [uint64 2^40, int8 -5, float 0.5, str16 "hi", map16 {"k": 1}]
+    const unsigned char msgpack[] = {
+        0x95, 0xcf, 0, 0, 0x01, 0, 0, 0, 0, 0, 0xd0, 0xfb, 0xca, 0x3f, 0, 0, 0,
+        0xda, 0, 2, 'h', 'i', 0xde, 0, 1, 0xa1, 'k', 0x01
+    };
+    ja_val *value = ja_from_msgpack(msgpack, sizeof(msgpack));
+    log_test_result("Wide MessagePack forms are read", value &&
+        ja_get_arr_at(value, 0)->type == JA_TYPE_DOUBLE && ja_get_double(ja_get_arr_at(value, 0)) == 1099511627776.0 &&
+        ja_get_int(ja_get_arr_at(value, 1)) == -5 && ja_get_double(ja_get_arr_at(value, 2)) == 0.5 &&
+        strcmp(ja_get_str(ja_get_arr_at(value, 3)), "hi") == 0 &&
+        ja_get_int(ja_get_obj_at(ja_get_arr_at(value, 4), "k")) == 1);
+    ja_free_val(&value);
+
+    // {_ "a": [_ 1, half 1.5], "b": tag 1 (epoch) 1000, "c": undefined}
+    const unsigned char cbor[] = {
+        0xbf, 0x61, 'a', 0x9f, 0x01, 0xf9, 0x3e, 0x00, 0xff,
+        0x61, 'b', 0xc1, 0x19, 0x03, 0xe8, 0x61, 'c', 0xf7, 0xff
+    };
+    value = ja_from_cbor(cbor, sizeof(cbor));
+    log_test_result("Indefinite lengths, halfs and tags are read", value &&
+        ja_size_of(ja_get_obj_at(value, "a")) == 2 &&
+        ja_get_double(ja_get_arr_at(ja_get_obj_at(value, "a"), 1)) == 1.5 &&
+        ja_get_int(ja_get_obj_at(value, "b")) == 1000 && ja_get_obj_at(value, "c")->type == JA_TYPE_NULL);
+    ja_free_val(&value);
+
+    const unsigned char repeated[] = { 0x82, 0xa1, 'k', 0x01, 0xa1, 'k', 0x02 };
+    value = ja_from_msgpack(repeated, sizeof(repeated));
+    log_test_result("Repeated keys keep the last value", value && ja_size_of(value) == 1 &&
+        ja_get_int(ja_get_obj_at(value, "k")) == 2);
+    ja_free_val(&value);
+}
+
+/**
+ * @brief Checks that bad input is rejected.
+ */
+static void run_invalid_test(void) {
+    printf("\n> Invalid input\n");
+
+    ja_val *original = ja_parse(SAMPLE_JSON);
+    size_t length = 0;
+    unsigned char *msgpack = ja_to_msgpack(original, &length);
+    unsigned char *cbor = ja_to_cbor(original, &length);
+    ja_free_val(&original);
+
+    bool truncated = msgpack && cbor;
+    for (size_t i = 0; truncated && i < length; i++) {
+        truncated = ja_from_cbor(cbor, i) == NULL && ja_last_error()->code == JA_ERROR_UNEXPECTED_END;
+    }
+    log_test_result("Every truncation is rejected", truncated);
+
+    const unsigned char bin[] = { 0x92, 0x01, 0xc4, 0x01, 0x00 };
+    log_test_result("MessagePack binary data is unsupported", ja_from_msgpack(bin, sizeof(bin)) == NULL &&
+        ja_last_error()->code == JA_ERROR_UNSUPPORTED_TYPE && ja_last_error()->offset == 2);
+
+    const unsigned char bytes[] = { 0x81, 0x42, 'h', 'i' };
+    log_test_result("CBOR byte strings are unsupported", ja_from_cbor(bytes, sizeof(bytes)) == NULL &&
+        ja_last_error()->code == JA_ERROR_UNSUPPORTED_TYPE && ja_last_error()->offset == 1);
+
+    const unsigned char int_key[] = { 0x81, 0x01, 0x02 };
+    log_test_result("Keys must be strings", ja_from_msgpack(int_key, sizeof(int_key)) == NULL &&
+        ja_last_error()->code == JA_ERROR_UNSUPPORTED_TYPE);
+
+    const unsigned char trailing[] = { 0xc0, 0xc0 };
+    log_test_result("Trailing bytes are rejected", ja_from_msgpack(trailing, sizeof(trailing)) == NULL &&
+        ja_last_error()->code == JA_ERROR_TRAILING_CONTENT && ja_last_error()->offset == 1);
+
+    const unsigned char huge[] = { 0xdd, 0xff, 0xff, 0xff, 0xff, 0x01 };
+    log_test_result("Lengths longer than the input are rejected", ja_from_msgpack(huge, sizeof(huge)) == NULL &&
+        ja_last_error()->code == JA_ERROR_UNEXPECTED_END);
+
+    unsigned char deep[JA_MAX_DEPTH + 2]; // One array more than allowed
+    memset(deep, 0x91, sizeof(deep) - 1);
+    deep[JA_MAX_DEPTH + 1] = 0xc0;
+    log_test_result("Nesting is limited", ja_from_msgpack(deep, sizeof(deep)) == NULL &&
+        ja_last_error()->code == JA_ERROR_DEPTH_LIMIT);
+
+    free(msgpack);
+    free(cbor);
+}
+
+/**
+ * @brief Compares the encodings of the big test file with its JSON text.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    double start = now();
+    char *text = ja_stringify(json->content);
+    double stringify_time = now() - start;
+
+    size_t msgpack_length = 0, cbor_length = 0;
+    start = now();
+    unsigned char *msgpack = ja_to_msgpack(json->content, &msgpack_length);
+    double msgpack_time = now() - start;
+    unsigned char *cbor = ja_to_cbor(json->content, &cbor_length);
+
+    start = now();
+    ja_val *decoded = ja_from_msgpack(msgpack, msgpack_length);
+    double decode_time = now() - start;
+
+    ja_val *from_cbor = ja_from_cbor(cbor, cbor_length);
+    log_test_result("Big file decodes back equal", decoded && from_cbor &&
+        same_text(json->content, decoded) && same_text(json->content, from_cbor));
+    log_test_result("Encodings are smaller than the text", text && msgpack_length < strlen(text) && cbor_length < strlen(text));
+    printf("     JSON %zu bytes in %.4f s, MessagePack %zu bytes in %.4f s (decoded in %.4f s), CBOR %zu bytes\n",
+        text ? strlen(text) : 0, stringify_time, msgpack_length, msgpack_time, decode_time, cbor_length);
+
+    ja_free_val(&decoded);
+    ja_free_val(&from_cbor);
+    free(text);
+    free(msgpack);
+    free(cbor);
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the MessagePack and CBOR tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON MessagePack and CBOR Tests ===\n");
+
+    run_round_trip_test();
+    run_encoding_test();
+    run_foreign_test();
+    run_invalid_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests columnar extraction (ja_extract_column / ja_extract_column_parallel).
+ *
+ * It verifies:
+ *  - ✅ Int, double, bool and string columns are filled from every element, strings pointing into the document.
+ *  - ✅ Missing, null and mismatched fields are zeroed and cleared in the bitmap.
+ *  - ✅ Bad arguments are rejected.
+ *  - ✅ Columns of the big test file match the accessors, and the parallel extraction matches the sequential one.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+#define ROWS_JSON \
+    "[{\"id\": 1, \"price\": 2.5, \"ok\": true, \"tag\": \"a\", \"dims\": {\"w\": 3}}," \
+    " {\"id\": 2, \"price\": 4, \"ok\": false, \"tag\": \"b\"}," \
+    " {\"price\": null, \"ok\": 1, \"tag\": 7, \"dims\": {\"w\": 5.5}}," \
+    " 42," \
+    " {\"id\": 3.5, \"ok\": null, \"tag\": null, \"dims\": [1]}]"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Extracts each type of column from a small array.
+ */
+static void run_types_test(void) {
+    printf("\n> Column types\n");
+
+    ja_val *rows = ja_parse(ROWS_JSON);
+    if (!rows) {
+        log_test_result("Parse rows", false);
+        return;
+    }
+
+    int64_t ids[5];
+    double prices[5];
+    bool oks[5];
+    const char *tags[5];
+    uint8_t valid[JA_BITMAP_BYTES(5)];
+
+    log_test_result("Int column", ja_extract_column(rows, "/id", JA_TYPE_INT, ids, valid) &&
+        ids[0] == 1 && ids[1] == 2 && ids[2] == 0 && ids[3] == 0 && ids[4] == 0 && valid[0] == 0x03);
+    log_test_result("Double column takes ints", ja_extract_column(rows, "/price", JA_TYPE_DOUBLE, prices, valid) &&
+        prices[0] == 2.5 && prices[1] == 4.0 && prices[2] == 0.0 && valid[0] == 0x03);
+    log_test_result("Bool column", ja_extract_column(rows, "/ok", JA_TYPE_BOOL, oks, valid) &&
+        oks[0] && !oks[1] && !oks[2] && JA_BITMAP_TEST(valid, 1) && !JA_BITMAP_TEST(valid, 2));
+    log_test_result("String column points into the document",
+        ja_extract_column(rows, "/tag", JA_TYPE_STRING, tags, valid) && valid[0] == 0x03 &&
+        tags[0] == ja_get_str(ja_get_obj_at(ja_get_arr_at(rows, 0), "tag")) && strcmp(tags[1], "b") == 0 &&
+        tags[2] == NULL && tags[4] == NULL);
+    log_test_result("Nested fields and the elements themselves",
+        ja_extract_column(rows, "/dims/w", JA_TYPE_DOUBLE, prices, valid) && valid[0] == 0x05 && prices[2] == 5.5 &&
+        ja_extract_column(rows, "", JA_TYPE_INT, ids, NULL) && ids[3] == 42 && ids[0] == 0);
+
+    ja_free_val(&rows);
+}
+
+/**
+ * @brief Checks that bad arguments are rejected.
+ */
+static void run_error_test(void) {
+    printf("\n> Errors\n");
+
+    ja_val *object = ja_parse("{\"a\": [1, 2]}");
+    int64_t ints[2];
+    log_test_result("Only arrays have columns", !ja_extract_column(object, "/a", JA_TYPE_INT, ints, NULL) &&
+        ja_last_error()->code == JA_ERROR_TYPE_MISMATCH);
+    log_test_result("Only scalar columns", !ja_extract_column(ja_get_obj_at(object, "a"), "", JA_TYPE_ARRAY, ints, NULL) &&
+        ja_last_error()->code == JA_ERROR_TYPE_MISMATCH);
+    log_test_result("Invalid pointers and NULL buffers",
+        !ja_extract_column(ja_get_obj_at(object, "a"), "a", JA_TYPE_INT, ints, NULL) &&
+        !ja_extract_column(ja_get_obj_at(object, "a"), "", JA_TYPE_INT, NULL, NULL) &&
+        ja_last_error()->code == JA_ERROR_NULL_ARGUMENT);
+    ja_free_val(&object);
+}
+
+/**
+ * @brief Extracts columns of the big test file, sequentially and in parallel.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *data = ja_get_obj_at(json->content, "data");
+    size_t count = ja_size_of(data);
+    int64_t *ids = malloc(count * sizeof(int64_t));
+    bool *active = malloc(count * sizeof(bool));
+    const char **themes = malloc(count * sizeof(char *));
+    uint8_t *valid = malloc(JA_BITMAP_BYTES(count));
+
+    double start = now();
+    for (size_t i = 0; i < count; i++) {
+        ja_val *record = ja_get_arr_at(data, i);
+        ids[i] = ja_get_int(ja_get_obj_at(record, "id"));
+        themes[i] = ja_get_str(ja_get_obj_at(ja_get_obj_at(ja_get_obj_at(record, "profile"), "settings"), "theme"));
+    }
+    double loop_time = now() - start;
+
+    start = now();
+    bool extracted = ja_extract_column(data, "/id", JA_TYPE_INT, ids, NULL) &&
+        ja_extract_column(data, "/profile/settings/theme", JA_TYPE_STRING, themes, valid) &&
+        ja_extract_column(data, "/active", JA_TYPE_BOOL, active, NULL);
+    double column_time = now() - start;
+
+    bool same = extracted;
+    for (size_t i = 0; same && i < count; i++) {
+        ja_val *record = ja_get_arr_at(data, i);
+        same = ids[i] == (int64_t)i && JA_BITMAP_TEST(valid, i) &&
+            themes[i] == ja_get_str(ja_get_obj_at(ja_get_obj_at(ja_get_obj_at(record, "profile"), "settings"), "theme")) &&
+            active[i] == ja_get_bool(ja_get_obj_at(record, "active"));
+    }
+    log_test_result("Columns match the accessors", count > 0 && same);
+    printf("     %zu records: %.6f s with the accessors (2 fields), %.6f s with columns (3 fields)\n",
+        count, loop_time, column_time);
+
+    // Enough records for the extraction to be split across threads
+    ja_val *big = ja_new_arr();
+    for (int copy = 0; copy < 16; copy++) {
+        for (size_t i = 0; i < count; i++) ja_arr_append(big, ja_copy_cow(ja_get_arr_at(data, i)));
+    }
+    ja_arr_append(big, ja_new_null());
+    size_t big_count = ja_size_of(big);
+
+    double *sequential = malloc(big_count * sizeof(double));
+    double *parallel = malloc(big_count * sizeof(double));
+    uint8_t *sequential_valid = malloc(JA_BITMAP_BYTES(big_count));
+    uint8_t *parallel_valid = malloc(JA_BITMAP_BYTES(big_count));
+    ja_extract_column(big, "/scores/3", JA_TYPE_DOUBLE, sequential, sequential_valid);
+    start = now();
+    bool split = ja_extract_column_parallel(big, "/scores/3", JA_TYPE_DOUBLE, parallel, parallel_valid, 4);
+    double parallel_time = now() - start;
+
+    log_test_result("Parallel extraction matches the sequential one", split &&
+        memcmp(sequential, parallel, big_count * sizeof(double)) == 0 &&
+        memcmp(sequential_valid, parallel_valid, JA_BITMAP_BYTES(big_count)) == 0 &&
+        !JA_BITMAP_TEST(parallel_valid, big_count - 1) && parallel[count + 5] == 8.0);
+    printf("     %zu records in %.6f s in parallel\n", big_count, parallel_time);
+
+    free(sequential);
+    free(parallel);
+    free(sequential_valid);
+    free(parallel_valid);
+    ja_free_val(&big);
+    free(ids);
+    free(active);
+    free(themes);
+    free(valid);
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the columnar extraction tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Column Tests ===\n");
+
+    run_types_test();
+    run_error_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * This file tests single-allocation copies (ja_copy_compact).
+ *
+ * It verifies:
+ *  - ✅ The copy is equal to the original, and its nodes, buffers and strings live in one block.
+ *  - ✅ Siblings are laid out next to each other.
+ *  - ✅ Compact copies can be modified (grown, shrunk, replaced) and freed like any other value.
+ *  - ✅ Compact copies nested in other values, copied or deferred are freed correctly.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define SAMPLE_JSON \
+    "{\"name\": \"sample\", \"values\": [1, 2.5, true, null, \"text\"]," \
+    " \"records\": [{\"id\": 1, \"tag\": \"a\"}, {\"id\": 2, \"tag\": \"b\"}], \"empty\": {}}"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Checks that two values serialize to the same text.
+ */
+static bool same_text(ja_val *a, ja_val *b) {
+    char *a_str = ja_stringify(a);
+    char *b_str = ja_stringify(b);
+    bool equal = a_str && b_str && strcmp(a_str, b_str) == 0;
+    free(a_str);
+    free(b_str);
+    return equal;
+}
+
+/**
+ * @brief Checks the layout of a compact copy.
+ */
+static void run_layout_test(void) {
+    printf("\n> Layout\n");
+
+    ja_val *original = ja_parse(SAMPLE_JSON);
+    ja_val *copy = ja_copy_compact(original);
+    if (!original || !copy) {
+        log_test_result("Parse and copy", false);
+        return;
+    }
+
+    log_test_result("Copy matches the original", same_text(original, copy));
+
+    __ja_compact_size size;
+    __ja_compact_measure(original, &size);
+    char *start = (char *)copy;
+    char *end = start + __ja_compact_bytes(&size);
+
+    ja_val *values = ja_obj_val_at(copy, 1);
+    ja_val *text = ja_get_arr_at(values, 4);
+    log_test_result("Nodes, buffers and strings share the block",
+        size.nodes == 16 && (copy->flags & JA_FLAG_BLOCK_ROOT) &&
+        (char *)values > start && (char *)values < end &&
+        (char *)values->u.array.items > start && (char *)values->u.array.items < end &&
+        text->u.string > start && text->u.string + 5 <= end
+    );
+    log_test_result("Siblings are adjacent",
+        ja_get_arr_at(values, 1) == ja_get_arr_at(values, 0) + 1 && ja_obj_val_at(copy, 3) == copy + 4);
+
+    ja_free_val(&original);
+    ja_free_val(&copy);
+}
+
+/**
+ * @brief Modifies a compact copy in every way that resizes or replaces its contents.
+ */
+static void run_mutation_test(void) {
+    printf("\n> Mutations\n");
+
+    ja_val *original = ja_parse(SAMPLE_JSON);
+    ja_val *copy = ja_copy_compact(original);
+    if (!original || !copy) {
+        log_test_result("Parse and copy", false);
+        return;
+    }
+
+    ja_val *values = ja_get_obj_at(copy, "values");
+    ja_arr_append(values, ja_new_str("appended"));
+    ja_arr_remove_at(values, 0);
+    ja_set_arr_at(values, 3, ja_new_num(7));
+    ja_set_str(ja_get_obj_at(copy, "name"), "renamed");
+    ja_convert_to(ja_get_arr_at(values, 0), JA_TYPE_STRING);
+    ja_obj_remove_at(ja_get_arr_at(ja_get_obj_at(copy, "records"), 0), "tag");
+    ja_set_obj_at(ja_get_arr_at(ja_get_obj_at(copy, "records"), 1), "extra", ja_new_bool(false));
+    ja_set_obj_at(copy, "empty", ja_new_set_arr(1, ja_new_null()));
+    ja_set_obj_at(copy, "added", ja_copy_compact(original)); // A block inside another block
+
+    char *str = ja_stringify(copy);
+    log_test_result("Every change is applied", str && strncmp(str,
+        "{\"name\":\"renamed\",\"values\":[\"2.5\",true,null,7,\"appended\"],"
+        "\"records\":[{\"id\":1},{\"id\":2,\"tag\":\"b\",\"extra\":false}],\"empty\":[null],\"added\":{", 128) == 0);
+    free(str);
+
+    ja_val *second = ja_copy_compact(copy);
+    log_test_result("A mutated tree is compacted again", second && same_text(copy, second));
+    ja_free_val(&copy);
+
+    ja_val *holder = ja_new_arr();
+    ja_arr_append(holder, second);
+    ja_arr_append(holder, ja_copy_cow(second)); // Block children are copied, not shared
+    ja_val *deep = ja_copy(second);
+    log_test_result("Copies of compact values are independent", deep && same_text(deep, second));
+
+    ja_free_val(&holder); // Compact values inside a regular tree
+    ja_free_val_deferred(&deep);
+    ja_val *compact = ja_copy_compact(original);
+    ja_free_val_deferred(&compact);
+    ja_wait_deferred_free();
+    log_test_result("Compact values are freed anywhere", holder == NULL && compact == NULL);
+
+    ja_free_val(&original);
+}
+
+/**
+ * @brief Entry point for the compact copy tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Compact Copy Tests ===\n");
+
+    run_layout_test();
+    run_mutation_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef JA_ZLIB
+    #include <zlib.h>
+#endif
+
+/**
+ * This file tests reading and writing compressed files (build with -DJA_ZLIB -lz and/or -DJA_ZSTD -lzstd).
+ *
+ * It verifies:
+ *  - ✅ ".gz" and ".zst" files written by ja_write_json() are compressed and read back equal by ja_read_json().
+ *  - ✅ Compression is detected by the magic bytes, whatever the name, and concatenated gzip members are read.
+ *  - ✅ Compressed files are parsed while they are decompressed, without keeping the text, tokens across chunks included.
+ *  - ✅ Syntax errors in compressed files report the offset, line and column of the whole text.
+ *  - ✅ Truncated compressed files are rejected.
+ *  - ✅ Without JA_ZLIB / JA_ZSTD, compressed files fail with JA_ERROR_IO instead of being parsed as text.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE        "tests/data/test_big.json"
+#define GZIP_FILE       "build/data/test_compressed.json.gz"
+#define ZSTD_FILE       "build/data/test_compressed.json.zst"
+#define RENAMED_FILE    "build/data/test_compressed.data"
+#define TRUNCATED_FILE  "build/data/test_compressed_truncated.json.gz"
+
+#define SAMPLE_JSON "{\"name\": \"archive\", \"values\": [1, 2.5, true, null], \"nested\": {\"list\": [\"a\", \"b\"]}}"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+#if defined(JA_ZLIB) || defined(JA_ZSTD)
+/**
+ * @brief Checks that two values serialize to the same text.
+ */
+static bool same_text(ja_val *a, ja_val *b) {
+    char *a_str = ja_stringify(a);
+    char *b_str = ja_stringify(b);
+    bool equal = a_str && b_str && strcmp(a_str, b_str) == 0;
+    free(a_str);
+    free(b_str);
+    return equal;
+}
+
+/**
+ * @brief Returns the size of a file, or 0 if it can't be opened.
+ */
+static long file_size(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+/**
+ * @brief Copies the first `length` bytes of a file (all of it with -1) into another file.
+ */
+static bool copy_file(const char *from, const char *to, long length) {
+    FILE *file = fopen(from, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    size_t size = (size_t)ftell(file);
+    rewind(file);
+    char *data = malloc(size ? size : 1);
+    bool ok = data && fread(data, 1, size, file) == size;
+    fclose(file);
+
+    if (length >= 0 && (size_t)length < size) size = (size_t)length;
+    file = ok ? fopen(to, "wb") : NULL;
+    ok = file && fwrite(data, 1, size, file) == size;
+    if (file) fclose(file);
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Builds a document whose tokens are longer than a chunk of decompressed text.
+ */
+static char *long_tokens_json(void) {
+    size_t string_length = 200000;
+    char *text = malloc(string_length + 4096);
+    if (!text) return NULL;
+
+    char *p = text + sprintf(text, "{\"long\": \"");
+    for (size_t i = 0; i < string_length; i += 8) p += sprintf(p, i % 64 ? "abcdefg " : "esc \\\"d ");
+    p += sprintf(p, "\", \"numbers\": [");
+    for (int i = 0; i < 300; i++) p += sprintf(p, "%s%d.5", i ? ", " : "", i);
+    sprintf(p, "], \"nested\": [[{\"a\": [true, false]}, {}], [], \"end\"]}");
+    return text;
+}
+
+/**
+ * @brief Writes a compressed file and reads it back.
+ */
+static void run_round_trip(const char *filename, const char *format) {
+    char name[128];
+
+    ja_json *json = ja_json_init();
+    bool read = ja_read_json(json, BIG_FILE);
+    snprintf(name, sizeof(name), "%s file is written", format);
+    log_test_result(name, read && ja_write_json(json, filename));
+
+    ja_json *loaded = ja_json_init();
+    snprintf(name, sizeof(name), "%s file reads back equal", format);
+    log_test_result(name, ja_read_json(loaded, filename) && read && same_text(json->content, loaded->content));
+
+    snprintf(name, sizeof(name), "%s file is parsed without keeping the text", format);
+    log_test_result(name, loaded->content && !loaded->json_str);
+
+    snprintf(name, sizeof(name), "%s file is smaller than the text", format);
+    log_test_result(name, read && file_size(filename) > 0 && (size_t)file_size(filename) < strlen(json->json_str) / 2);
+    printf("     %ld bytes of %s for %zu bytes of text\n", file_size(filename), format, read ? strlen(json->json_str) : 0);
+
+    copy_file(filename, RENAMED_FILE, -1);
+    ja_val *renamed = NULL;
+    size_t length = 0;
+    char *text = __ja_read_file(RENAMED_FILE, &length);
+    if (text) renamed = ja_parse(text);
+    snprintf(name, sizeof(name), "%s is detected by its magic bytes", format);
+    log_test_result(name, renamed && read && length == strlen(json->json_str) && same_text(json->content, renamed));
+    ja_free_val(&renamed);
+    free(text);
+
+    ja_json_end(loaded);
+    ja_json_end(json);
+}
+#endif
+
+/**
+ * @brief Checks the gzip support (JA_ZLIB).
+ */
+static void run_gzip_test(void) {
+    printf("\n> gzip\n");
+
+#ifdef JA_ZLIB
+    run_round_trip(GZIP_FILE, "gzip");
+
+    // Two members, as written by `cat a.gz b.gz`
+    gzFile file = gzopen(GZIP_FILE, "wb");
+    gzputs(file, "[1, 2, ");
+    gzclose(file);
+    file = gzopen(GZIP_FILE, "ab");
+    gzputs(file, "3]");
+    gzclose(file);
+
+    ja_json *json = ja_json_init();
+    log_test_result("Concatenated members are read", ja_read_json(json, GZIP_FILE) &&
+        ja_size_of(json->content) == 3 && ja_get_int(ja_get_arr_at(json->content, 2)) == 3);
+    ja_json_end(json);
+
+    // A string of 200 KB spans several chunks of decompressed text
+    char *text = long_tokens_json();
+    ja_val *expected = ja_parse(text);
+    file = gzopen(GZIP_FILE, "wb");
+    gzputs(file, text);
+    gzclose(file);
+    json = ja_json_init();
+    size_t numbers = 0;
+    log_test_result("Tokens longer than a chunk are read", expected && ja_read_json(json, GZIP_FILE) &&
+        same_text(expected, json->content) && ja_arr_as_doubles(ja_get_obj_at(json->content, "numbers"), &numbers) &&
+        numbers == 300);
+    ja_json_end(json);
+    ja_free_val(&expected);
+    free(text);
+
+    const char *broken = "{\n  \"a\": [1, 2,,]\n}";
+    ja_error error;
+    ja_validate(broken, strlen(broken), &error);
+    file = gzopen(GZIP_FILE, "wb");
+    gzputs(file, broken);
+    gzclose(file);
+    json = ja_json_init();
+    bool read = ja_read_json(json, GZIP_FILE);
+    const ja_error *last = ja_last_error();
+    log_test_result("Syntax errors are located in the whole text", !read && last->code == error.code &&
+        last->offset == error.offset && last->line == 2 && last->column == error.column);
+    ja_json_end(json);
+
+    json = ja_json_init();
+    json->content = ja_parse(SAMPLE_JSON);
+    ja_write_json(json, GZIP_FILE);
+    ja_json_end(json);
+
+    copy_file(GZIP_FILE, TRUNCATED_FILE, file_size(GZIP_FILE) - 6);
+    json = ja_json_init();
+    log_test_result("Truncated file is rejected",
+        !ja_read_json(json, TRUNCATED_FILE) && ja_last_error()->code == JA_ERROR_IO);
+    ja_json_end(json);
+#else
+    ja_json *json = ja_json_init();
+    json->content = ja_parse(SAMPLE_JSON);
+    log_test_result("Writing needs JA_ZLIB", !ja_write_json(json, GZIP_FILE) && ja_last_error()->code == JA_ERROR_IO);
+    ja_json_end(json);
+
+    FILE *file = fopen(TRUNCATED_FILE, "wb");
+    fwrite("\x1f\x8b\x08\x00", 1, 4, file);
+    fclose(file);
+    json = ja_json_init();
+    log_test_result("Reading needs JA_ZLIB",
+        !ja_read_json(json, TRUNCATED_FILE) && ja_last_error()->code == JA_ERROR_IO);
+    ja_json_end(json);
+#endif
+}
+
+/**
+ * @brief Checks the Zstandard support (JA_ZSTD).
+ */
+static void run_zstd_test(void) {
+    printf("\n> Zstandard\n");
+
+#ifdef JA_ZSTD
+    run_round_trip(ZSTD_FILE, "Zstandard");
+#else
+    ja_json *json = ja_json_init();
+    json->content = ja_parse(SAMPLE_JSON);
+    log_test_result("Writing needs JA_ZSTD", !ja_write_json(json, ZSTD_FILE) && ja_last_error()->code == JA_ERROR_IO);
+    ja_json_end(json);
+#endif
+}
+
+/**
+ * @brief Entry point for the compressed file tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Compressed File Tests ===\n");
+
+    run_gzip_test();
+    run_zstd_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
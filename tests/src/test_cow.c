@@ -0,0 +1,208 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef JA_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * This file tests copy-on-write copies (ja_copy_cow).
+ *
+ * It verifies:
+ *  - ✅ Copies share the children of the original until they are edited, reading them changes nothing.
+ *  - ✅ Changes through ja_edit_arr_at() and ja_edit_obj_at() only clone the path down to them, and never reach the other trees.
+ *  - ✅ Edits starting from a shared value are rejected.
+ *  - ✅ Originals and copies can be freed in any order.
+ *  - ✅ Values shared by more copies than the share count can hold are copied instead.
+ *  - ✅ Copies can be read from several threads at once (with JA_THREADS).
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BASE_JSON \
+    "{\"name\": \"base\", \"limits\": {\"requests\": 100, \"storage\": 10}," \
+    " \"regions\": [\"eu\", \"us\"], \"features\": {\"beta\": false, \"flags\": [1, 2, 3]}}"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Checks that a value serializes to the expected text.
+ */
+static bool stringifies_to(ja_val *value, const char *expected) {
+    char *str = ja_stringify(value);
+    bool equal = str && strcmp(str, expected) == 0;
+    free(str);
+    return equal;
+}
+
+/**
+ * @brief Layers changes over a shared base document.
+ */
+static void run_layer_test(void) {
+    printf("\n> Layered copies\n");
+
+    ja_val *base = ja_parse(BASE_JSON);
+    ja_val *tenant = ja_copy_cow(base);
+    if (!base || !tenant) {
+        log_test_result("Parse and copy", false);
+        return;
+    }
+
+    log_test_result("Children are shared",
+        *__ja_obj_slot(base, 1) == *__ja_obj_slot(tenant, 1) && (*__ja_obj_slot(tenant, 1))->shares == 1);
+
+    ja_val *features = ja_obj_val_at(tenant, 3);
+    log_test_result("Reading a child leaves it shared", features == *__ja_obj_slot(base, 3) && features->shares == 1 &&
+        ja_get_obj_at(tenant, "features") == features && ja_get_obj_at(features, "flags")->shares == 0);
+
+    features = ja_edit_obj_at(tenant, "features");
+    log_test_result("Editing a child gives the copy its own",
+        features && features != *__ja_obj_slot(base, 3) && features->shares == 0 && (*__ja_obj_slot(base, 3))->shares == 0);
+
+    log_test_result("Edits from a shared value are rejected", ja_edit_obj_at(ja_get_obj_at(tenant, "limits"), "requests") == NULL &&
+        ja_last_error()->code == JA_ERROR_SHARED_VALUE && ja_get_int(ja_get_obj_at(ja_get_obj_at(base, "limits"), "requests")) == 100);
+
+    ja_set_num(ja_edit_obj_at(ja_edit_obj_at(tenant, "limits"), "requests"), 500);
+    ja_arr_append(ja_edit_obj_at(tenant, "regions"), ja_new_str("ap"));
+    ja_obj_remove_at(ja_edit_obj_at(tenant, "features"), "beta");
+    ja_set_obj_at(tenant, "name", ja_new_str("tenant"));
+
+    log_test_result("Copy sees its changes", stringifies_to(tenant,
+        "{\"name\":\"tenant\",\"limits\":{\"requests\":500,\"storage\":10},"
+        "\"regions\":[\"eu\",\"us\",\"ap\"],\"features\":{\"flags\":[1,2,3]}}"));
+    log_test_result("Original is untouched", stringifies_to(base,
+        "{\"name\":\"base\",\"limits\":{\"requests\":100,\"storage\":10},"
+        "\"regions\":[\"eu\",\"us\"],\"features\":{\"beta\":false,\"flags\":[1,2,3]}}"));
+
+    ja_val *flags = *__ja_obj_slot(*__ja_obj_slot(base, 3), 1);
+    log_test_result("Untouched subtrees stay shared", flags->shares == 1);
+
+    ja_free_val(&base); // The copy keeps the shared values alive
+    log_test_result("Copy outlives the original", flags->shares == 0 &&
+        ja_get_int(ja_get_arr_at(ja_get_obj_at(ja_get_obj_at(tenant, "features"), "flags"), 2)) == 3);
+    ja_free_val(&tenant);
+}
+
+/**
+ * @brief Checks many copies of the same document, freed in mixed order.
+ */
+static void run_many_test(void) {
+    printf("\n> Many copies\n");
+
+    ja_val *base = ja_parse(BASE_JSON);
+    ja_val *copies[64];
+    bool ok = base != NULL;
+
+    for (int i = 0; ok && i < 64; i++) {
+        copies[i] = ja_copy_cow(i % 2 ? copies[i - 1] : base); // Copies of copies too
+        ok = copies[i] != NULL;
+        if (ok) ja_set_num(ja_edit_obj_at(ja_edit_obj_at(copies[i], "limits"), "storage"), i);
+    }
+
+    for (int i = 0; ok && i < 64; i++) {
+        ok = ja_get_int(ja_get_obj_at(ja_get_obj_at(copies[i], "limits"), "storage")) == i;
+    }
+    log_test_result("Every copy keeps its own change", ok && ja_get_int(ja_get_obj_at(ja_get_obj_at(base, "limits"), "storage")) == 10);
+
+    for (int i = 0; i < 64; i += 2) ja_free_val(&copies[i]);
+    ja_free_val(&base);
+    for (int i = 1; i < 64; i += 2) ja_free_val(&copies[i]);
+    log_test_result("Copies and original are freed in any order", base == NULL && copies[63] == NULL);
+
+    // Past UINT16_MAX owners, children are copied instead of shared
+    ja_val *root = ja_new_set_arr(1, ja_new_str("leaf"));
+    ja_val **wide = malloc(sizeof(ja_val*) * 70000);
+    ok = root && wide;
+    for (int i = 0; ok && i < 70000; i++) {
+        wide[i] = ja_copy_cow(root);
+        ok = wide[i] && strcmp(wide[i]->u.array.items[0]->u.string, "leaf") == 0;
+    }
+    log_test_result("Saturated values are copied", ok && root->u.array.items[0]->shares == UINT16_MAX);
+
+    for (int i = 0; wide && i < 70000; i++) ja_free_val(&wide[i]);
+    free(wide);
+    log_test_result("Saturated values are released", root && root->u.array.items[0]->shares == 0);
+    ja_free_val(&root);
+}
+
+#ifdef JA_THREADS
+typedef struct {
+    ja_val *tree;
+    int sum;
+} read_job;
+
+/**
+ * @brief Reads every shared value of a copy through the getters.
+ */
+static void *read_worker(void *arg) {
+    read_job *job = arg;
+    for (int round = 0; round < 1000; round++) {
+        ja_val *flags = ja_get_obj_at(ja_get_obj_at(job->tree, "features"), "flags");
+        for (size_t i = 0; i < ja_size_of(flags); i++) job->sum += ja_get_int(ja_get_arr_at(flags, i));
+        job->sum += ja_get_int(ja_obj_val_at(ja_try_get_obj_at(job->tree, "limits"), 0));
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reads the same shared values from several threads at once.
+ */
+static void run_thread_test(void) {
+    printf("\n> Concurrent readers\n");
+
+    ja_val *base = ja_parse(BASE_JSON);
+    ja_val *copies[4];
+    pthread_t threads[8];
+    read_job jobs[8];
+    for (int i = 0; i < 4; i++) copies[i] = ja_copy_cow(base);
+
+    for (int i = 0; i < 8; i++) {
+        jobs[i] = (read_job){i < 4 ? copies[i] : base, 0};
+        pthread_create(&threads[i], NULL, read_worker, &jobs[i]);
+    }
+
+    bool ok = true;
+    for (int i = 0; i < 8; i++) {
+        pthread_join(threads[i], NULL);
+        ok = ok && jobs[i].sum == 1000 * 106;
+    }
+    log_test_result("Every reader sees the shared values", ok);
+    log_test_result("Reading leaves the children shared",
+        *__ja_obj_slot(base, 3) == *__ja_obj_slot(copies[0], 3) && (*__ja_obj_slot(base, 3))->shares == 4);
+
+    for (int i = 0; i < 4; i++) ja_free_val(&copies[i]);
+    ja_free_val(&base);
+}
+#endif
+
+/**
+ * @brief Entry point for the copy-on-write tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Copy-on-write Tests ===\n");
+
+    run_layer_test();
+    run_many_test();
+#ifdef JA_THREADS
+    run_thread_test();
+#endif
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
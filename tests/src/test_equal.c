@@ -0,0 +1,208 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests deep equality and structural hashing (ja_equal / ja_equal_ordered / ja_hash / ja_hash_cached).
+ *
+ * It verifies:
+ *  - ✅ Values of every type compare deeply, numbers by value and object keys in any order.
+ *  - ✅ ja_equal_ordered() also requires object keys in the same order.
+ *  - ✅ Equal values hash alike, whatever their layout (packed, shaped, compact, copy-on-write), and changes alter the hash.
+ *  - ✅ Cached hashes match uncached ones and skip subtrees already seen.
+ *  - ✅ The big test file compares with a copy faster than through ja_stringify() and strcmp().
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Parses two texts and checks whether they are equal, and hash alike when they are.
+ */
+static bool texts_equal(const char *a, const char *b) {
+    ja_val *first = ja_parse(a);
+    ja_val *second = ja_parse(b);
+    bool equal = first && second && ja_equal(first, second) && ja_equal(second, first);
+    bool consistent = !equal || ja_hash(first) == ja_hash(second);
+    if (!consistent) printf("     %s and %s are equal but hash differently\n", a, b);
+    ja_free_val(&first);
+    ja_free_val(&second);
+    return equal && consistent;
+}
+
+/**
+ * @brief Compares small values.
+ */
+static void run_equal_test(void) {
+    printf("\n> Equality\n");
+
+    log_test_result("Scalars", texts_equal("\"a\"", "\"a\"") && !texts_equal("\"a\"", "\"b\"") &&
+        texts_equal("true", "true") && !texts_equal("true", "false") && texts_equal("null", "null") &&
+        !texts_equal("null", "false") && !texts_equal("0", "false") && !texts_equal("\"1\"", "1"));
+    log_test_result("Numbers compare by value", texts_equal("1", "1.0") && texts_equal("[0.5, -0.0]", "[0.5, 0]") &&
+        !texts_equal("1", "1.5") && texts_equal("3000000000", "3e9"));
+    log_test_result("Arrays keep their order", texts_equal("[1, [2, \"x\"], {}]", "[1, [2, \"x\"], {}]") &&
+        !texts_equal("[1, 2]", "[2, 1]") && !texts_equal("[1, 2]", "[1, 2, 3]") && !texts_equal("[]", "{}"));
+    log_test_result("Object keys in any order", texts_equal("{\"a\": 1, \"b\": [true]}", "{\"b\": [true], \"a\": 1}") &&
+        !texts_equal("{\"a\": 1, \"b\": 2}", "{\"a\": 1, \"c\": 2}") && !texts_equal("{\"a\": 1}", "{\"a\": 1, \"b\": 2}") &&
+        !texts_equal("{\"a\": {\"x\": 1}}", "{\"a\": {\"x\": 2}}"));
+    log_test_result("Packed arrays equal arrays of nodes", texts_equal("[1, 2.5, true]", "[1, 2.5, true]") &&
+        texts_equal("[1, 2, 3]", "[1, 2, 3]") && !texts_equal("[true, false]", "[true, true]"));
+
+    ja_val *packed = ja_parse("[1, 2, 3]");
+    ja_val *nodes = ja_new_arr();
+    for (int i = 1; i <= 3; i++) ja_arr_append(nodes, ja_new_num(i));
+    log_test_result("Layouts don't matter", (packed->flags & JA_FLAG_PACKED) && !(nodes->flags & JA_FLAG_PACKED) &&
+        ja_equal(packed, nodes) && ja_hash(packed) == ja_hash(nodes));
+    ja_free_val(&packed);
+    ja_free_val(&nodes);
+
+    ja_val *ab = ja_parse("{\"a\": 1, \"b\": 2}");
+    ja_val *ba = ja_parse("{\"b\": 2, \"a\": 1}");
+    ja_val *built = ja_new_obj();
+    ja_set_obj_at(built, "a", ja_new_num(1));
+    ja_set_obj_at(built, "b", ja_new_num(2));
+    log_test_result("ja_equal_ordered() also compares key order", ja_equal(ab, ba) && !ja_equal_ordered(ab, ba) &&
+        ja_equal_ordered(ab, built) && ja_hash(ab) == ja_hash(ba) && ja_hash(ab) == ja_hash(built));
+    ja_free_val(&ab);
+    ja_free_val(&ba);
+    ja_free_val(&built);
+
+    log_test_result("NULL arguments are rejected", !ja_equal(NULL, NULL) &&
+        ja_last_error()->code == JA_ERROR_NULL_ARGUMENT && ja_hash(NULL) == 0);
+}
+
+/**
+ * @brief Hashes values and copies of them.
+ */
+static void run_hash_test(void) {
+    printf("\n> Hashes\n");
+
+    const char *text = "{\"user\": {\"name\": \"ana\", \"tags\": [\"a\", \"b\"], \"age\": 29}, \"scores\": [1, 2.5], \"ok\": true}";
+    ja_val *doc = ja_parse(text);
+    uint64_t hash = ja_hash(doc);
+
+    ja_val *copy = ja_copy(doc);
+    ja_val *compact = ja_copy_compact(doc);
+    ja_val *cow = ja_copy_cow(doc);
+    log_test_result("Copies hash alike", hash == ja_hash(copy) && hash == ja_hash(compact) && hash == ja_hash(cow) &&
+        ja_equal(doc, copy) && ja_equal(doc, compact) && ja_equal(doc, cow));
+
+    ja_set_num(ja_get_obj_at(ja_get_obj_at(copy, "user"), "age"), 30);
+    ja_arr_append(ja_edit_obj_at(ja_edit_obj_at(cow, "user"), "tags"), ja_new_str("c"));
+    log_test_result("Changes are seen", !ja_equal(doc, copy) && hash != ja_hash(copy) && !ja_equal(doc, cow) &&
+        hash != ja_hash(cow) && ja_hash(doc) == hash);
+
+    log_test_result("Values of different types hash apart", ja_hash(ja_get_obj_at(doc, "ok")) != ja_hash(ja_get_arr_at(
+        ja_get_obj_at(doc, "scores"), 0)) && ja_hash(ja_get_obj_at(doc, "scores")) != ja_hash(ja_get_obj_at(doc, "user")));
+
+    ja_hash_cache *cache = ja_hash_cache_new();
+    bool same = ja_hash_cached(doc, cache) == hash && cache->count == 4;
+    ja_hash_cache_clear(cache);
+    log_test_result("Cached hashes match", same && cache->count == 0 && ja_hash_cached(copy, cache) == ja_hash(copy) &&
+        ja_hash_cached(compact, NULL) == hash);
+    ja_hash_cache_free(&cache);
+    log_test_result("Caches are freed", cache == NULL);
+
+    ja_free_val(&copy);
+    ja_free_val(&compact);
+    ja_free_val(&cow);
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Compares and hashes the big test file.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *copy = ja_copy(json->content);
+
+    double start = now();
+    char *first = ja_stringify(json->content);
+    char *second = ja_stringify(copy);
+    bool same_text = first && second && strcmp(first, second) == 0;
+    double stringify_time = now() - start;
+    free(first);
+    free(second);
+
+    start = now();
+    bool equal = ja_equal(json->content, copy);
+    double equal_time = now() - start;
+
+    log_test_result("Copies are equal", same_text && equal);
+    printf("     %.6f s with ja_stringify() and strcmp(), %.6f s with ja_equal()\n", stringify_time, equal_time);
+
+    ja_val *data = ja_get_obj_at(copy, "data");
+    ja_val *last = ja_get_arr_at(data, ja_size_of(data) - 1);
+    ja_set_str(ja_get_obj_at(ja_get_obj_at(ja_get_obj_at(last, "profile"), "settings"), "theme"), "sepia");
+    log_test_result("A change in the last record is found", !ja_equal(json->content, copy) &&
+        ja_hash(json->content) != ja_hash(copy));
+
+    // Copy-on-write copies share every record, which the cache hashes once
+    ja_val *cow = ja_copy_cow(json->content);
+    ja_hash_cache *cache = ja_hash_cache_new();
+    start = now();
+    uint64_t hash = ja_hash_cached(json->content, cache);
+    double first_time = now() - start;
+    start = now();
+    uint64_t cow_hash = ja_hash_cached(cow, cache);
+    double cached_time = now() - start;
+
+    log_test_result("Shared subtrees come from the cache", hash == cow_hash && hash == ja_hash(cow));
+    printf("     %.6f s to hash the document, %.6f s to hash a copy-on-write copy of it\n", first_time, cached_time);
+
+    ja_hash_cache_free(&cache);
+    ja_free_val(&cow);
+    ja_free_val(&copy);
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the equality and hashing tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Equality and Hashing Tests ===\n");
+
+    run_equal_test();
+    run_hash_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * This file tests structured errors and the logging callback.
+ *
+ * It verifies:
+ *  - ✅ Failed accessors record a code, reason and path in ja_last_error().
+ *  - ✅ Failed parses record the offset, line, column and path of the first error.
+ *  - ✅ Successful calls and probes (ja_has_key(), ja_try_get_obj_at()) leave the last error untouched.
+ *  - ✅ Nothing is logged without a callback, and a callback receives every message with its level.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Checks the errors recorded by accessors.
+ */
+static void run_accessor_test(void) {
+    printf("\n> Accessor errors\n");
+
+    ja_val *object = ja_parse("{\"name\": \"jaJSON\", \"tags\": [1, 2]}");
+    if (!object) {
+        log_test_result("Parse object", false);
+        return;
+    }
+
+    ja_clear_last_error();
+    log_test_result("Cleared error has no code", ja_last_error()->code == JA_ERROR_NONE);
+
+    ja_get_obj_at(object, "a/b~c");
+    const ja_error *error = ja_last_error();
+    log_test_result("Missing key is recorded with its escaped path",
+        error->code == JA_ERROR_KEY_NOT_FOUND && strcmp(error->path, "/a~1b~0c") == 0 &&
+        strcmp(error->reason, "Key not found") == 0
+    );
+
+    ja_get_obj_at(object, "name");
+    log_test_result("Successful calls keep the last error", ja_last_error()->code == JA_ERROR_KEY_NOT_FOUND);
+
+    ja_get_arr_at(object, 0);
+    log_test_result("Type mismatch is recorded", ja_last_error()->code == JA_ERROR_TYPE_MISMATCH);
+
+    ja_get_arr_at(ja_get_obj_at(object, "tags"), 5);
+    log_test_result("Index out of bounds is recorded", ja_last_error()->code == JA_ERROR_INDEX_OUT_OF_BOUNDS);
+
+    ja_size_of(NULL);
+    log_test_result("NULL argument is recorded", ja_last_error()->code == JA_ERROR_NULL_ARGUMENT);
+
+    ja_clear_last_error();
+    bool probes = ja_has_key(object, "name") && !ja_has_key(object, "missing") && !ja_has_key(NULL, "name") &&
+        ja_try_get_obj_at(object, "missing") == NULL && ja_try_get_obj_at(object, "tags") != NULL;
+    log_test_result("Probes don't record errors", probes && ja_last_error()->code == JA_ERROR_NONE);
+
+    ja_free_val(&object);
+}
+
+/**
+ * @brief Checks the position and path recorded by failed parses.
+ */
+static void run_parse_test(void) {
+    printf("\n> Parse errors\n");
+
+    ja_val *value = ja_parse("{\"data\": [\n  {\"name\": \"a\"},\n  {\"name\": tru}\n]}");
+    const ja_error *error = ja_last_error();
+    log_test_result("Parse error is recorded with its position and path",
+        !value && error->code == JA_ERROR_INVALID_LITERAL &&
+        error->offset == 42 && error->line == 3 && error->column == 15 &&
+        strcmp(error->path, "/data/1/name") == 0
+    );
+
+    value = ja_parse("[1, 2");
+    log_test_result("Unexpected end is recorded",
+        !value && ja_last_error()->code == JA_ERROR_UNEXPECTED_END && ja_last_error()->offset == 5);
+
+    ja_clear_last_error();
+    value = ja_parse("[true, {\"ok\": null}]");
+    log_test_result("Successful parse keeps the last error", value && ja_last_error()->code == JA_ERROR_NONE);
+    ja_free_val(&value);
+
+    ja_error validated;
+    ja_validate("{\"a\": {\"b\": [0, 01]}}", 21, &validated);
+    log_test_result("ja_validate() fills the path", validated.code == JA_ERROR_INVALID_NUMBER &&
+        strcmp(validated.path, "/a/b/1") == 0);
+}
+
+/**
+ * @brief Log callback counting messages per level.
+ */
+static void count_message(ja_log_level level, const char *file, int line, const char *message, void *user_data) {
+    (void)file;
+    (void)line;
+    (void)message;
+    ((int *)user_data)[level]++;
+}
+
+/**
+ * @brief Checks that messages only reach a callback when one is set.
+ */
+static void run_callback_test(void) {
+    printf("\n> Log callback\n");
+
+    int counts[JA_LOG_LEVEL_TRACE + 1] = { 0 };
+    ja_val *object = ja_new_obj();
+
+    ja_get_obj_at(object, "missing");
+    ja_set_log_callback(count_message, counts);
+    log_test_result("Nothing is logged without a callback", counts[JA_LOG_LEVEL_WARN] == 0);
+
+    ja_get_obj_at(object, "missing");
+    ja_get_arr_at(object, 0);
+    ja_free_val(&object);
+    ja_val *value = ja_parse("[1, }");
+
+#ifdef JA_DEBUG
+    log_test_result("Messages reach the callback with their level",
+        counts[JA_LOG_LEVEL_WARN] == 1 && counts[JA_LOG_LEVEL_ERROR] >= 2 && counts[JA_LOG_LEVEL_TRACE] >= 1);
+#else
+    log_test_result("Nothing is logged without JA_DEBUG", counts[JA_LOG_LEVEL_ERROR] == 0);
+#endif
+
+    ja_set_log_callback(NULL, NULL);
+    ja_free_val(&value);
+}
+
+/**
+ * @brief Entry point for the error tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Error Tests ===\n");
+
+    run_accessor_test();
+    run_parse_test();
+    run_callback_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
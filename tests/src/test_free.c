@@ -0,0 +1,136 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests how values are freed.
+ *
+ * It verifies:
+ *  - ✅ Deeply nested documents are freed without running out of stack.
+ *  - ✅ Mixed documents (shaped objects, shared keys, strings) are freed, and conversions free the old contents.
+ *  - ✅ Deferred frees hand documents to a background thread and can be waited for.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define DEEP_LEVELS 1000000
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Builds arrays and objects nested `levels` times, alternating between both.
+ */
+static ja_val *build_deep(size_t levels) {
+    ja_val *root = ja_new_arr();
+    ja_val *current = root;
+
+    for (size_t i = 0; i < levels && current; i++) {
+        ja_val *child = (i % 2) ? ja_new_arr() : ja_new_obj();
+        if (!child) return root;
+
+        if (current->type == JA_TYPE_ARRAY) {
+            ja_arr_append(current, ja_new_str("sibling"));
+            ja_arr_append(current, child);
+        } else {
+            ja_set_obj_at(current, "next", child);
+        }
+        current = child;
+    }
+
+    return root;
+}
+
+/**
+ * @brief Frees a deep document that would overflow the stack with recursion.
+ */
+static void run_deep_test(void) {
+    printf("\n> Deep documents\n");
+
+    ja_val *deep = build_deep(DEEP_LEVELS);
+    ja_free_val(&deep);
+    log_test_result("A million levels are freed", deep == NULL);
+
+    deep = build_deep(1000);
+    ja_set_num(deep, 1); // Frees the old contents first
+    log_test_result("Conversions free nested contents", deep && deep->type == JA_TYPE_INT && ja_get_int(deep) == 1);
+    ja_free_val(&deep);
+}
+
+/**
+ * @brief Frees parsed documents with shaped objects and shared keys.
+ */
+static void run_mixed_test(void) {
+    printf("\n> Mixed documents\n");
+
+    ja_val *records = ja_parse(
+        "[{\"id\": 1, \"tags\": [\"a\", \"b\"], \"meta\": {\"ok\": true}},"
+        " {\"id\": 2, \"tags\": [], \"meta\": {\"ok\": false}},"
+        " {\"tags\": null, \"id\": 3, \"meta\": {}}]"
+    );
+    ja_val *copy = ja_copy(records);
+    ja_val *first = ja_copy(ja_get_arr_at(records, 0));
+
+    ja_free_val(&records); // Shapes and keys are still used by the copies
+    bool alive = copy && first && ja_get_int(ja_get_obj_at(ja_get_arr_at(copy, 1), "id")) == 2 &&
+        strcmp(ja_get_str(ja_get_arr_at(ja_get_obj_at(first, "tags"), 1)), "b") == 0;
+    log_test_result("Copies outlive the freed original", alive);
+
+    ja_free_val(&copy);
+    ja_free_val(&first);
+    log_test_result("Copies are freed", copy == NULL && first == NULL);
+}
+
+/**
+ * @brief Hands documents to ja_free_val_deferred() and waits for them.
+ */
+static void run_deferred_test(void) {
+    printf("\n> Deferred frees\n");
+
+    size_t freed = __ja_deferred_freed_count();
+    ja_val *deep = build_deep(DEEP_LEVELS);
+    clock_t start = clock();
+    ja_free_val_deferred(&deep);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    log_test_result("Deferred free returns and clears the pointer", deep == NULL);
+    printf("     Handed off in %.6f seconds\n", seconds);
+
+    ja_val *scalar = ja_new_str("scalar");
+    ja_val *records = ja_parse("[{\"id\": 1}, {\"id\": 2}]");
+    ja_free_val_deferred(&scalar);
+    ja_free_val_deferred(&records);
+    ja_free_val_deferred(NULL);
+
+    ja_wait_deferred_free();
+    log_test_result("Every deferred value is freed after waiting",
+        scalar == NULL && records == NULL && __ja_deferred_freed_count() - freed == 3);
+}
+
+/**
+ * @brief Entry point for the free tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Free Tests ===\n");
+
+    run_deep_test();
+    run_mixed_test();
+    run_deferred_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,294 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests field indexes over arrays (ja_index_build / ja_index_lookup / ja_index_range).
+ *
+ * It verifies:
+ *  - ✅ Lookups by number, string and boolean find the first matching element, ints and doubles alike.
+ *  - ✅ Ranges return the elements between two keys in key order, with open bounds.
+ *  - ✅ Appends are indexed right away, removals and replacements rebuild the index.
+ *  - ✅ Freed arrays and bad arguments are reported.
+ *  - ✅ Lookups over the big test file match a linear scan.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+#define USERS_JSON \
+    "[{\"id\": 3, \"name\": \"cy\", \"age\": 41}," \
+    " {\"id\": 1, \"name\": \"ana\", \"age\": 29.5}," \
+    " {\"id\": 2.0, \"name\": \"bea\", \"age\": 29.5}," \
+    " {\"name\": \"dan\"}," \
+    " 7," \
+    " {\"id\": \"4\", \"name\": \"eva\", \"age\": null}," \
+    " {\"id\": true, \"name\": \"fay\", \"age\": 18}]"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Returns the name of a user, or "" if there's none.
+ */
+static const char *name_of(ja_val *user) {
+    const char *name = ja_get_str(ja_get_obj_at(user, "name"));
+    return name ? name : "";
+}
+
+/**
+ * @brief Checks that a range returns the users with the given names, in order.
+ */
+static bool range_is(ja_index *index, ja_val *low, ja_val *high, const char *expected) {
+    size_t count = 0;
+    ja_val **results = ja_index_range(index, low, high, &count);
+    char names[128] = "";
+    for (size_t i = 0; results && i < count; i++) {
+        strcat(names, i ? "," : "");
+        strcat(names, name_of(results[i]));
+    }
+
+    bool equal = results && strcmp(names, expected) == 0;
+    if (!equal) printf("     expected %s, got %s\n", expected, results ? names : "(error)");
+    free(results);
+    return equal;
+}
+
+/**
+ * @brief Looks up small arrays.
+ */
+static void run_lookup_test(void) {
+    printf("\n> Lookups\n");
+
+    ja_val *users = ja_parse(USERS_JSON);
+    ja_index *ids = ja_index_build(users, "/id");
+    ja_index *names = ja_index_build(users, "/name");
+    if (!ids || !names) {
+        log_test_result("Build indexes", false);
+        ja_free_val(&users);
+        return;
+    }
+
+    log_test_result("Numbers match ints and doubles alike", ja_index_lookup_num(ids, 1) == ja_get_arr_at(users, 1) &&
+        strcmp(name_of(ja_index_lookup_num(ids, 2)), "bea") == 0 && ja_index_lookup_num(ids, 2.5) == NULL);
+
+    ja_val *key = ja_new_str("4");
+    ja_val *flag = ja_new_bool(true);
+    log_test_result("Strings and booleans are keys of their own", strcmp(name_of(ja_index_lookup(ids, key)), "eva") == 0 &&
+        strcmp(name_of(ja_index_lookup(ids, flag)), "fay") == 0 && ja_index_lookup_num(ids, 4) == NULL);
+    ja_free_val(&key);
+    ja_free_val(&flag);
+
+    log_test_result("String fields", ja_index_lookup_str(names, "dan") == ja_get_arr_at(users, 3) &&
+        ja_index_lookup_str(names, "zoe") == NULL);
+
+    ja_index *ages = ja_index_build(users, "/age");
+    log_test_result("Duplicates return the first element", strcmp(name_of(ja_index_lookup_num(ages, 29.5)), "ana") == 0);
+
+    ja_index *self = ja_index_build(users, "");
+    log_test_result("The elements themselves", ja_get_int(ja_index_lookup_num(self, 7)) == 7 &&
+        ja_index_lookup_str(self, "cy") == NULL);
+
+    ja_clear_last_error();
+    ja_val *null = ja_new_null();
+    log_test_result("Misses record no error", ja_index_lookup(ids, null) == NULL &&
+        ja_last_error()->code == JA_ERROR_NONE);
+    ja_free_val(&null);
+
+    ja_index_free(&self);
+    ja_index_free(&ages);
+    ja_index_free(&names);
+    ja_index_free(&ids);
+    log_test_result("Indexes are freed", ids == NULL && !(users->flags & JA_FLAG_INDEXED));
+    ja_free_val(&users);
+}
+
+/**
+ * @brief Asks ranges of keys.
+ */
+static void run_range_test(void) {
+    printf("\n> Ranges\n");
+
+    ja_val *users = ja_parse(USERS_JSON);
+    ja_index *ages = ja_index_build(users, "/age");
+    ja_index *names = ja_index_build(users, "/name");
+
+    ja_val *twenty = ja_new_num(20);
+    ja_val *forty = ja_new_num(40);
+    ja_val *b = ja_new_str("b");
+    ja_val *d = ja_new_str("dz");
+    log_test_result("Numbers between two keys, ordered by key", range_is(ages, twenty, forty, "ana,bea") &&
+        range_is(ages, ja_get_obj_at(ja_get_arr_at(users, 0), "age"), NULL, "cy") && range_is(ages, forty, twenty, ""));
+    log_test_result("Open bounds", range_is(ages, NULL, forty, "fay,ana,bea") && range_is(ages, NULL, NULL, "fay,ana,bea,cy"));
+    log_test_result("Strings", range_is(names, b, d, "bea,cy,dan") && range_is(names, NULL, b, "ana"));
+
+    size_t count = 7;
+    log_test_result("Bounds of different kinds are rejected", ja_index_range(ages, twenty, b, &count) == NULL &&
+        count == 0 && ja_last_error()->code == JA_ERROR_TYPE_MISMATCH);
+
+    ja_free_val(&twenty);
+    ja_free_val(&forty);
+    ja_free_val(&b);
+    ja_free_val(&d);
+    ja_index_free(&ages);
+    ja_index_free(&names);
+    ja_free_val(&users);
+}
+
+/**
+ * @brief Modifies indexed arrays.
+ */
+static void run_update_test(void) {
+    printf("\n> Updates\n");
+
+    ja_val *users = ja_parse(USERS_JSON);
+    ja_index *ids = ja_index_build(users, "/id");
+
+    ja_val *zoe = ja_parse("{\"id\": 9, \"name\": \"zoe\"}");
+    ja_arr_append(users, zoe);
+    log_test_result("Appends are indexed right away", !ids->stale && ja_index_lookup_num(ids, 9) == zoe);
+
+    ja_arr_remove_at(users, 0);
+    log_test_result("Removals rebuild the index", ids->stale && ja_index_lookup_num(ids, 3) == NULL &&
+        ja_index_lookup_num(ids, 9) == zoe && ja_index_lookup_num(ids, 1) == ja_get_arr_at(users, 0));
+
+    ja_set_arr_at(users, 0, ja_parse("{\"id\": 5, \"name\": \"gus\"}"));
+    ja_path *second = ja_path_compile("/1");
+    ja_path_set(second, users, ja_parse("{\"id\": 6, \"name\": \"hal\"}"));
+    log_test_result("Replacements rebuild the index", ja_index_lookup_num(ids, 1) == NULL &&
+        strcmp(name_of(ja_index_lookup_num(ids, 5)), "gus") == 0 && strcmp(name_of(ja_index_lookup_num(ids, 6)), "hal") == 0);
+    ja_path_free(&second);
+
+    ja_set_num(ja_get_obj_at(zoe, "id"), 10);
+    bool unseen = ja_index_lookup_num(ids, 10) == NULL;
+    ja_index_invalidate(ids);
+    log_test_result("In-place changes need ja_index_invalidate()", unseen && ja_index_lookup_num(ids, 10) == zoe);
+
+    ja_val *numbers = ja_parse("[4, 8, 15]");
+    ja_index *self = ja_index_build(numbers, "");
+    ja_arr_append(numbers, ja_new_num(16));
+    ja_arr_remove_at(numbers, 0);
+    log_test_result("Packed arrays", ja_get_int(ja_index_lookup_num(self, 16)) == 16 &&
+        ja_index_lookup_num(self, 4) == NULL && ja_index_lookup_num(self, 8) == ja_get_arr_at(numbers, 0));
+
+    ja_free_val(&numbers);
+    log_test_result("Freed arrays are reported", ja_index_lookup_num(self, 8) == NULL &&
+        ja_last_error()->code == JA_ERROR_NULL_ARGUMENT);
+    ja_index_free(&self);
+
+    ja_val *object = ja_parse("{\"a\": 1}");
+    log_test_result("Only arrays are indexed", ja_index_build(object, "/a") == NULL &&
+        ja_last_error()->code == JA_ERROR_TYPE_MISMATCH && ja_index_build(users, "id") == NULL &&
+        ja_index_lookup_num(NULL, 1) == NULL);
+    ja_free_val(&object);
+
+    ja_index_free(&ids);
+    ja_free_val(&users);
+}
+
+/**
+ * @brief Compares lookups over the big test file with a linear scan.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *data = ja_get_obj_at(json->content, "data");
+    size_t count = ja_size_of(data);
+    size_t lookups = count < 1000 ? count : 1000;
+
+    double start = now();
+    size_t scanned = 0;
+    for (size_t i = 0; i < lookups; i++) {
+        int id = (int)((i * 7919) % count);
+        for (size_t j = 0; j < count; j++) {
+            if (ja_get_int(ja_get_obj_at(ja_get_arr_at(data, j), "id")) == id) {
+                scanned += ja_get_arr_at(data, j) == ja_get_arr_at(data, (size_t)id);
+                break;
+            }
+        }
+    }
+    double scan_time = now() - start;
+
+    start = now();
+    ja_index *ids = ja_index_build(data, "/id");
+    double build_time = now() - start;
+
+    start = now();
+    size_t found = 0;
+    for (size_t i = 0; i < lookups; i++) {
+        int id = (int)((i * 7919) % count);
+        found += ja_index_lookup_num(ids, id) == ja_get_arr_at(data, (size_t)id);
+    }
+    double lookup_time = now() - start;
+
+    log_test_result("Lookups match a linear scan", count > 0 && found == lookups && scanned == lookups);
+    printf("     %zu lookups in %zu records: %.6f s scanning, %.6f s to build the index, %.6f s with it\n",
+        lookups, count, scan_time, build_time, lookup_time);
+
+    ja_index *themes = ja_index_build(data, "/profile/settings/theme");
+    ja_val *dark = ja_new_str("dark");
+    size_t dark_count = 0;
+    ja_val **results = ja_index_range(themes, dark, dark, &dark_count);
+    size_t expected = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char *theme = ja_get_str(ja_get_obj_at(ja_get_obj_at(ja_get_obj_at(ja_get_arr_at(data, i), "profile"),
+            "settings"), "theme"));
+        expected += theme && strcmp(theme, "dark") == 0;
+    }
+    log_test_result("Ranges of equal keys keep the order of the array", results && dark_count == expected &&
+        (dark_count < 2 || ja_get_int(ja_get_obj_at(results[0], "id")) < ja_get_int(ja_get_obj_at(results[1], "id"))));
+    free(results);
+    ja_free_val(&dark);
+
+    ja_json_end(json); // Detaches the indexes
+    log_test_result("Indexes outlive their document", ja_index_lookup_num(ids, 0) == NULL);
+    ja_index_free(&themes);
+    ja_index_free(&ids);
+}
+
+/**
+ * @brief Entry point for the field index tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Field Index Tests ===\n");
+
+    run_lookup_test();
+    run_range_test();
+    run_update_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
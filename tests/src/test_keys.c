@@ -0,0 +1,212 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * This file tests how object keys are stored.
+ *
+ * It verifies:
+ *  - ✅ Equal keys of a parsed document share the same string.
+ *  - ✅ Copies share keys with the original, and both can be freed in any order.
+ *  - ✅ Global interning shares keys between documents and objects built by hand.
+ *  - ✅ Lookups, replacements and removals still work with shared keys.
+ *  - ✅ Records with the same keys in the same order share a shape, and mutations split it off.
+ *  - ✅ Shapes, key maps and indexes don't make nodes bigger than a number (24 bytes on 64-bit).
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Checks that records of the same document share their keys.
+ */
+static void run_document_test(void) {
+    printf("\n> Document interning\n");
+
+    ja_val *records = ja_parse("[{\"id\": 1, \"name\": \"a\"}, {\"id\": 2, \"name\": \"b\"}, {\"name\": \"c\", \"id\": 3}]");
+    if (!records) {
+        log_test_result("Parse records", false);
+        return;
+    }
+
+    ja_val *first = ja_get_arr_at(records, 0);
+    ja_val *last = ja_get_arr_at(records, 2);
+    log_test_result("Equal keys point to the same string",
+        ja_obj_key_at(first, 0) == ja_obj_key_at(ja_get_arr_at(records, 1), 0) &&
+        ja_obj_key_at(first, 0) == ja_obj_key_at(last, 1)
+    );
+    log_test_result("Lookups find shared keys", ja_get_int(ja_get_obj_at(last, "id")) == 3);
+
+    ja_val *other = ja_parse("{\"id\": 4}");
+    log_test_result("Separate documents don't share keys", other && ja_obj_key_at(other, 0) != ja_obj_key_at(first, 0));
+    ja_free_val(&other);
+
+    ja_val *copy = ja_copy(first);
+    log_test_result("Copies share keys with the original", copy && ja_obj_key_at(copy, 1) == ja_obj_key_at(first, 1));
+
+    ja_free_val(&records); // The copy keeps its keys alive
+    ja_set_obj_at(copy, "id", ja_new_num(10));
+    ja_obj_remove_at(copy, "name");
+    ja_set_obj_at(copy, "extra", ja_new_bool(true));
+    log_test_result("Copy outlives the original",
+        ja_size_of(copy) == 2 &&
+        ja_get_int(ja_get_obj_at(copy, "id")) == 10 &&
+        strcmp(ja_obj_key_at(copy, 1), "extra") == 0
+    );
+    ja_free_val(&copy);
+}
+
+/**
+ * @brief Checks global interning between documents and objects built by hand.
+ */
+static void run_global_test(void) {
+    printf("\n> Global interning\n");
+
+    ja_set_intern_mode(JA_INTERN_GLOBAL);
+
+    ja_val *parsed = ja_parse("{\"status\": \"ok\"}");
+    ja_val *built = ja_new_set_obj(1, "status", ja_new_str("ok"));
+    ja_val *set = ja_new_obj();
+    ja_set_obj_at(set, "status", ja_new_null());
+
+    bool shared = parsed && built && set &&
+        ja_obj_key_at(parsed, 0) == ja_obj_key_at(built, 0) &&
+        ja_obj_key_at(built, 0) == ja_obj_key_at(set, 0);
+    log_test_result("Every object shares the same key", shared);
+
+    ja_clear_interned_keys();
+    log_test_result("Keys survive clearing the table", parsed && strcmp(ja_obj_key_at(parsed, 0), "status") == 0);
+
+    ja_free_val(&parsed);
+    ja_free_val(&built);
+    ja_free_val(&set);
+
+    ja_set_intern_mode(JA_INTERN_DOCUMENT);
+}
+
+/**
+ * @brief Checks that records with identical key sequences share a shape.
+ */
+static void run_shape_test(void) {
+    printf("\n> Object shapes\n");
+
+    ja_val *records = ja_parse(
+        "[{\"id\": 1, \"name\": \"a\", \"active\": true},"
+        " {\"id\": 2, \"name\": \"b\", \"active\": false},"
+        " {\"name\": \"c\", \"id\": 3, \"active\": true},"
+        " {\"id\": 4, \"name\": \"d\", \"active\": true}]"
+    );
+    if (!records) {
+        log_test_result("Parse records", false);
+        return;
+    }
+
+    ja_val *first = ja_get_arr_at(records, 0);
+    ja_val *second = ja_get_arr_at(records, 1);
+    ja_val *third = ja_get_arr_at(records, 2);
+    ja_val *fourth = ja_get_arr_at(records, 3);
+
+    log_test_result("Same key sequence shares a shape",
+        (first->flags & JA_FLAG_SHAPED) && (fourth->flags & JA_FLAG_SHAPED) &&
+        __ja_obj_shape_of(first) == __ja_obj_shape_of(second) &&
+        __ja_obj_shape_of(first) == __ja_obj_shape_of(fourth)
+    );
+    log_test_result("Different key order gets another shape", __ja_obj_shape_of(first) != __ja_obj_shape_of(third));
+
+    int id_sum = 0;
+    for (size_t i = 0; i < ja_size_of(records); i++) {
+        id_sum += ja_get_int(ja_get_obj_at(ja_get_arr_at(records, i), "id"));
+    }
+    log_test_result("Repeated lookups go through the shape", id_sum == 10 &&
+        strcmp(ja_get_str(ja_get_obj_at(third, "name")), "c") == 0 &&
+        strcmp(ja_obj_key_at(third, 0), "name") == 0 &&
+        ja_get_bool(ja_obj_val_at(second, 2)) == false
+    );
+
+    ja_set_obj_at(first, "name", ja_new_str("z"));
+    log_test_result("Replacing a value keeps the shape",
+        (first->flags & JA_FLAG_SHAPED) && strcmp(ja_get_str(ja_get_obj_at(first, "name")), "z") == 0);
+
+    ja_val *copy = ja_copy(fourth);
+    log_test_result("Copies share the shape", copy && __ja_obj_shape_of(copy) == __ja_obj_shape_of(fourth));
+    ja_free_val(&copy);
+
+    ja_set_obj_at(first, "extra", ja_new_null());
+    ja_obj_remove_at(second, "active");
+    char *str = ja_stringify(records);
+    log_test_result("Adding or removing keys splits the shape off",
+        !(first->flags & JA_FLAG_SHAPED) && !(second->flags & JA_FLAG_SHAPED) &&
+        (fourth->flags & JA_FLAG_SHAPED) && ja_size_of(first) == 4 && ja_size_of(second) == 2 &&
+        str && strcmp(str,
+            "[{\"id\":1,\"name\":\"z\",\"active\":true,\"extra\":null},"
+            "{\"id\":2,\"name\":\"b\"},"
+            "{\"name\":\"c\",\"id\":3,\"active\":true},"
+            "{\"id\":4,\"name\":\"d\",\"active\":true}]") == 0
+    );
+    free(str);
+
+    ja_free_val(&records);
+}
+
+/**
+ * @brief Checks that every node keeps the size it had before shapes, key maps and indexes.
+ */
+static void run_size_test(void) {
+    printf("\n> Node size\n");
+
+    log_test_result("Contents are no bigger than a number", sizeof(((ja_val *)NULL)->u) == sizeof(ja_num));
+    log_test_result("Nodes take 24 bytes on 64-bit", sizeof(void *) != 8 || sizeof(ja_val) == 24);
+
+    // Objects with a shape or a key map and indexed arrays keep their contents in the same two words
+    ja_val *records = ja_parse("[{\"id\": 1}, {\"id\": 2}]");
+    ja_val *big = ja_new_obj();
+    char key[16];
+    for (int i = 0; big && i < 64; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        ja_set_obj_at(big, key, ja_new_num(i));
+    }
+    ja_index *index = records ? ja_index_build(records, "/id") : NULL;
+    ja_obj_remove_at(big, "k10");
+
+    log_test_result("Shapes, key maps and indexes live outside the node",
+        index && (ja_get_arr_at(records, 1)->flags & JA_FLAG_SHAPED) && (records->flags & JA_FLAG_INDEXED) &&
+        big && (big->flags & JA_FLAG_KEY_MAP) && ja_size_of(big) == 63 &&
+        ja_get_int(ja_get_obj_at(ja_index_lookup_num(index, 2), "id")) == 2 &&
+        ja_get_int(ja_get_obj_at(big, "k63")) == 63 && !ja_has_key(big, "k10")
+    );
+
+    ja_index_free(&index);
+    ja_free_val(&records);
+    ja_free_val(&big);
+}
+
+/**
+ * @brief Entry point for the key tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Key Tests ===\n");
+
+    run_document_test();
+    run_global_test();
+    run_shape_test();
+    run_size_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef JA_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * This file tests big objects used as maps, whose keys get a key map and leave tombstones when removed.
+ *
+ * It verifies:
+ *  - ✅ Removed keys are gone from lookups, sizes and positions, and the members left keep their order.
+ *  - ✅ Copies, comparisons, hashes, text and patches never see the tombstones, and leave them in place.
+ *  - ✅ Several threads can read a map holding tombstones at once.
+ *  - ✅ Emptied maps can be filled again, and parsed objects turn into maps on their first removal.
+ *  - ✅ Removing every key of a 100k-key map takes the same time per key whatever the map size.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_SIZE 100000
+#define THREAD_COUNT 4
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Checks that a value serializes to the given text.
+ */
+static bool text_is(ja_val *value, const char *expected) {
+    char *str = ja_stringify(value);
+    bool equal = str && strcmp(str, expected) == 0;
+    if (!equal) printf("     expected %s, got %s\n", expected, str ? str : "(error)");
+    free(str);
+    return equal;
+}
+
+/**
+ * @brief Builds an object with the keys "k0" to "k<size - 1>", each holding its number.
+ */
+static ja_val *build_map(size_t size, size_t step) {
+    ja_val *map = ja_new_obj();
+    char key[32];
+    for (size_t i = 0; i < size; i += step) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        ja_set_obj_at(map, key, ja_new_num((double)i));
+    }
+    return map;
+}
+
+/**
+ * @brief Removes every `step`-th key of a map built by build_map(), starting at `first`.
+ */
+static void remove_keys(ja_val *map, size_t size, size_t first, size_t step) {
+    char key[32];
+    for (size_t i = first; i < size; i += step) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        ja_obj_remove_at(map, key);
+    }
+}
+
+/**
+ * @brief Removes keys from a map and reads it back.
+ */
+static void run_remove_test(void) {
+    printf("\n> Remove\n");
+
+    ja_val *map = build_map(300, 1);
+    remove_keys(map, 300, 1, 2);
+    ja_val *expected = build_map(300, 2);
+    log_test_result("Members left keep their order", ja_size_of(map) == 150 && ja_equal_ordered(map, expected) &&
+        strcmp(ja_obj_key_at(map, 1), "k2") == 0 && ja_get_int(ja_obj_val_at(map, 149)) == 298);
+
+    log_test_result("Removed keys are gone", !ja_has_key(map, "k1") && !ja_has_key(map, "k299") &&
+        ja_get_int(ja_get_obj_at(map, "k298")) == 298 && ja_try_get_obj_at(map, "k3") == NULL);
+
+    ja_obj_remove_at(map, "k7");
+    log_test_result("Missing keys are reported", ja_last_error()->code == JA_ERROR_KEY_NOT_FOUND && ja_size_of(map) == 150);
+
+    ja_set_obj_at(map, "k1", ja_new_str("back"));
+    log_test_result("Keys added again go last", ja_size_of(map) == 151 && strcmp(ja_obj_key_at(map, 150), "k1") == 0 &&
+        strcmp(ja_get_str(ja_get_obj_at(map, "k1")), "back") == 0);
+
+    ja_val *taken = ja_obj_take_at(map, "k100");
+    log_test_result("Values are taken out", taken && ja_get_int(taken) == 100 && !ja_has_key(map, "k100") &&
+        ja_size_of(map) == 150);
+    ja_free_val(&taken);
+
+    remove_keys(map, 300, 0, 2);
+    ja_obj_remove_at(map, "k1");
+    log_test_result("Emptied maps are empty", ja_size_of(map) == 0 && text_is(map, "{}"));
+
+    ja_set_obj_at(map, "again", ja_new_bool(true));
+    log_test_result("Emptied maps can be filled again", text_is(map, "{\"again\":true}"));
+
+    ja_free_val(&expected);
+    ja_free_val(&map);
+}
+
+/**
+ * @brief Builds a map of 200 keys without every third key, leaving tombstones below the compaction ratio.
+ */
+static ja_val *build_holed_map(void) {
+    ja_val *map = build_map(200, 1);
+    remove_keys(map, 200, 0, 3);
+    return map;
+}
+
+/**
+ * @brief Reads maps holding tombstones through the functions that walk every member.
+ */
+static void run_walk_test(void) {
+    printf("\n> Walk\n");
+
+    ja_val *plain = ja_new_obj();
+    char key[32];
+    for (size_t i = 1; i < 200; i += i % 3 == 1 ? 1 : 2) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        ja_set_obj_at(plain, key, ja_new_num((double)i));
+    }
+
+    ja_val *maps[5];
+    for (int i = 0; i < 5; i++) maps[i] = build_holed_map();
+
+    ja_val *copy = ja_copy(maps[0]);
+    ja_val *cow = ja_copy_cow(maps[1]);
+    ja_val *compact = ja_copy_compact(maps[2]);
+    log_test_result("Copies have the members left", ja_size_of(plain) == 133 && ja_equal_ordered(copy, plain) &&
+        ja_equal_ordered(cow, plain) && ja_equal_ordered(compact, plain) && ja_hash(maps[3]) == ja_hash(plain));
+
+    char *text = ja_stringify(maps[4]);
+    log_test_result("Text has the members left", text && text_is(plain, text) && strstr(text, "\"k3\"") == NULL);
+    free(text);
+
+    size_t length = 0;
+    unsigned char *data = ja_to_msgpack(maps[0], &length);
+    ja_val *decoded = data ? ja_from_msgpack(data, length) : NULL;
+    log_test_result("MessagePack has the members left", decoded && ja_equal_ordered(decoded, plain));
+    ja_free_val(&decoded);
+    free(data);
+
+    bool kept = true;
+    for (int i = 0; i < 5; i++) kept = kept && __ja_obj_key_map(maps[i])->removed == 67;
+    log_test_result("Reading leaves the tombstones in place", kept && ja_size_of(maps[0]) == 133 &&
+        strcmp(ja_obj_key_at(maps[0], 0), "k1") == 0 && ja_get_int(ja_obj_val_at(maps[0], 132)) == 199 &&
+        __ja_obj_key_map(maps[0])->removed == 67);
+
+    ja_val *map = build_holed_map();
+    ja_val *other = build_holed_map();
+    remove_keys(other, 200, 1, 3);
+    ja_val *patch = ja_diff(map, other);
+    log_test_result("Diffs and patches skip the tombstones", patch && ja_size_of(patch) == 67 &&
+        ja_patch_apply(map, patch) && ja_equal_ordered(map, other));
+    ja_free_val(&patch);
+
+    ja_val *failing = ja_parse("[{\"op\": \"remove\", \"path\": \"/k5\"}, {\"op\": \"test\", \"path\": \"/k8\", \"value\": 0}]");
+    ja_obj_remove_at(other, "k2");
+    ja_val *before = ja_copy(other);
+    ja_obj_remove_at(other, "k14");
+    ja_set_obj_at(other, "k14", ja_new_num(14));
+    ja_obj_remove_at(before, "k14");
+    ja_set_obj_at(before, "k14", ja_new_num(14));
+    log_test_result("Failed patches restore the order", !ja_patch_apply(other, failing) && ja_equal_ordered(other, before));
+
+    ja_val *merge = ja_parse("{\"k5\": null, \"k11\": null, \"new\": 1}");
+    log_test_result("Merge patches remove members", ja_merge_patch(other, merge) && !ja_has_key(other, "k5") &&
+        ja_size_of(other) == ja_size_of(before) - 1 && strcmp(ja_obj_key_at(other, ja_size_of(other) - 1), "new") == 0);
+
+    ja_free_val(&merge);
+    ja_free_val(&before);
+    ja_free_val(&failing);
+    ja_free_val(&other);
+    ja_free_val(&map);
+    ja_free_val(&compact);
+    ja_free_val(&cow);
+    ja_free_val(&copy);
+    for (int i = 0; i < 5; i++) ja_free_val(&maps[i]);
+    ja_free_val(&plain);
+}
+
+#ifdef JA_THREADS
+/**
+ * @brief Reads every member of a shared map by position and through a copy.
+ */
+static void *read_map(void *arg) {
+    ja_val *map = arg;
+    bool same = true;
+    for (size_t i = 0; i < ja_size_of(map); i++) {
+        same = same && ja_get_int(ja_obj_val_at(map, i)) == atoi(ja_obj_key_at(map, i) + 1);
+    }
+
+    ja_val *copy = ja_copy(map);
+    char *text = ja_stringify(map);
+    same = same && copy && ja_equal_ordered(copy, map) && ja_hash(copy) == ja_hash(map) && text_is(copy, text);
+    free(text);
+    ja_free_val(&copy);
+    return same ? map : NULL;
+}
+
+/**
+ * @brief Reads the same map holding tombstones from several threads at once.
+ */
+static void run_thread_test(void) {
+    printf("\n> Threads\n");
+
+    ja_val *map = build_holed_map();
+    pthread_t threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) pthread_create(&threads[i], NULL, read_map, map);
+
+    bool same = true;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        void *result = NULL;
+        pthread_join(threads[i], &result);
+        same = same && result == map;
+    }
+    log_test_result("Threads read the same map", same && __ja_obj_key_map(map)->removed == 67);
+
+    ja_free_val(&map);
+}
+#endif
+
+/**
+ * @brief Removes keys from a big parsed object.
+ */
+static void run_parsed_test(void) {
+    printf("\n> Parsed objects\n");
+
+    size_t size = 1000;
+    char *text = malloc(size * 24 + 3);
+    char *p = text;
+    *p++ = '{';
+    for (size_t i = 0; i < size; i++) p += sprintf(p, "%s\"k%zu\":%zu", i ? "," : "", i, i);
+    *p++ = '}';
+    *p = '\0';
+
+    ja_val *parsed = ja_parse(text);
+    ja_val *built = build_map(size, 1);
+    log_test_result("Parsed and built maps are equal", parsed && ja_equal_ordered(parsed, built));
+
+    remove_keys(parsed, size, 0, 2);
+    remove_keys(built, size, 0, 2);
+    log_test_result("Removals give the same maps", ja_size_of(parsed) == size / 2 && ja_equal_ordered(parsed, built) &&
+        ja_get_int(ja_get_obj_at(parsed, "k999")) == 999);
+
+    ja_free_val(&built);
+    ja_free_val(&parsed);
+    free(text);
+}
+
+/**
+ * @brief Times the removal of every key from maps of growing sizes.
+ */
+static void run_big_test(void) {
+    printf("\n> Big map\n");
+
+    double per_key[2] = {0};
+    size_t sizes[2] = {BIG_SIZE / 10, BIG_SIZE};
+    bool removed = true;
+
+    for (int run = 0; run < 2; run++) {
+        ja_val *map = build_map(sizes[run], 1);
+
+        // Oldest sessions first, the worst case for shifting the members left
+        double start = now();
+        remove_keys(map, sizes[run], 0, 1);
+        per_key[run] = (now() - start) / (double)sizes[run];
+
+        removed = removed && ja_size_of(map) == 0;
+        ja_free_val(&map);
+    }
+
+    ja_val *map = build_map(BIG_SIZE, 1);
+    remove_keys(map, BIG_SIZE, 0, 2);
+    remove_keys(map, BIG_SIZE, 3, 4);
+    bool found = ja_size_of(map) == BIG_SIZE / 4 && ja_get_int(ja_get_obj_at(map, "k99997")) == 99997 &&
+        !ja_has_key(map, "k99999") && strcmp(ja_obj_key_at(map, 0), "k1") == 0;
+    ja_free_val(&map);
+
+    log_test_result("Every key is removed", removed && found);
+    printf("     %.3f us per key with %d keys, %.3f us per key with %d keys\n",
+        per_key[0] * 1e6, BIG_SIZE / 10, per_key[1] * 1e6, BIG_SIZE);
+}
+
+/**
+ * @brief Entry point for the map tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Map Tests ===\n");
+
+    run_remove_test();
+    run_walk_test();
+#ifdef JA_THREADS
+    run_thread_test();
+#endif
+    run_parsed_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
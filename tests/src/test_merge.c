@@ -0,0 +1,253 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests JSON Merge Patch (ja_merge_patch / ja_merge_patch_consume / ja_merge_layers).
+ *
+ * It verifies:
+ *  - ✅ The examples of RFC 7386 give the same results through the three functions.
+ *  - ✅ Targets keep their address, patches are left untouched or moved into the target when consumed.
+ *  - ✅ Layers merge like successive patches, keeping the nulls of the base document and the layers untouched.
+ *  - ✅ Merging layers over the big test file beats copying it and applying the patches one by one.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Checks that a value serializes to the given text.
+ */
+static bool text_is(ja_val *value, const char *expected) {
+    char *str = ja_stringify(value);
+    bool equal = str && strcmp(str, expected) == 0;
+    if (!equal) printf("     expected %s, got %s\n", expected, str ? str : "(error)");
+    free(str);
+    return equal;
+}
+
+/**
+ * @brief Merges a patch into a target with the three functions and checks every result.
+ */
+static bool merges_to(const char *target, const char *patch, const char *expected) {
+    ja_val *in_place = ja_parse(target);
+    ja_val *consumed = ja_parse(target);
+    ja_val *operations = ja_parse(patch);
+    ja_val *moved = ja_parse(patch);
+    ja_val *layers[] = {in_place, operations};
+    ja_val *layered = ja_merge_layers(layers, 2);
+
+    bool ok = ja_merge_patch(in_place, operations) && text_is(in_place, expected) && text_is(operations, patch) &&
+        ja_merge_patch_consume(consumed, &moved) && moved == NULL && text_is(consumed, expected) &&
+        text_is(layered, expected);
+
+    ja_free_val(&in_place);
+    ja_free_val(&consumed);
+    ja_free_val(&operations);
+    ja_free_val(&layered);
+    return ok;
+}
+
+/**
+ * @brief Applies the examples of RFC 7386, appendix A.
+ */
+static void run_rfc_test(void) {
+    printf("\n> RFC 7386 examples\n");
+
+    log_test_result("Members are replaced, added and deleted", merges_to("{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}") &&
+        merges_to("{\"a\":\"b\"}", "{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}") &&
+        merges_to("{\"a\":\"b\"}", "{\"a\":null}", "{}") &&
+        merges_to("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}", "{\"b\":\"c\"}"));
+    log_test_result("Arrays are replaced whole", merges_to("{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":\"c\"}") &&
+        merges_to("{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":[\"b\"]}") &&
+        merges_to("{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}", "{\"a\":[1]}") &&
+        merges_to("[\"a\",\"b\"]", "[\"c\",\"d\"]", "[\"c\",\"d\"]"));
+    log_test_result("Objects merge", merges_to("{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}", "{\"a\":{\"b\":\"d\"}}") &&
+        merges_to("{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}") &&
+        merges_to("{}", "{\"a\":{\"bb\":{\"ccc\":null}}}", "{\"a\":{\"bb\":{}}}"));
+    log_test_result("Targets and patches of other types", merges_to("{\"a\":\"b\"}", "[\"c\"]", "[\"c\"]") &&
+        merges_to("{\"a\":\"foo\"}", "null", "null") && merges_to("{\"a\":\"foo\"}", "\"bar\"", "\"bar\"") &&
+        merges_to("[1,2]", "{\"a\":\"b\",\"c\":null}", "{\"a\":\"b\"}") &&
+        merges_to("{\"a\":\"b\"}", "{\"a\":{\"b\":null}}", "{\"a\":{}}"));
+}
+
+/**
+ * @brief Checks what happens to targets and patches.
+ */
+static void run_patch_test(void) {
+    printf("\n> Targets and patches\n");
+
+    ja_val *target = ja_parse("{\"name\": \"svc\", \"limits\": {\"cpu\": 1, \"memory\": 512}, \"tags\": [\"a\"]}");
+    ja_val *patch = ja_parse("{\"limits\": {\"cpu\": 2}, \"tags\": [\"b\", \"c\"], \"replicas\": 3}");
+    ja_val *limits = ja_get_obj_at(target, "limits");
+
+    log_test_result("Objects are merged where they are", ja_merge_patch(target, patch) &&
+        ja_get_obj_at(target, "limits") == limits && text_is(target,
+        "{\"name\":\"svc\",\"limits\":{\"cpu\":2,\"memory\":512},\"tags\":[\"b\",\"c\"],\"replicas\":3}"));
+
+    ja_arr_append(ja_edit_obj_at(target, "tags"), ja_new_str("d"));
+    log_test_result("The patch keeps its own values", text_is(ja_get_obj_at(patch, "tags"), "[\"b\",\"c\"]") &&
+        text_is(ja_get_obj_at(target, "tags"), "[\"b\",\"c\",\"d\"]"));
+
+    ja_val *tags = ja_get_obj_at(patch, "tags");
+    log_test_result("Consumed patches hand over their values", ja_merge_patch_consume(target, &patch) && patch == NULL &&
+        ja_get_obj_at(target, "tags") == tags);
+    ja_free_val(&target);
+
+    target = ja_parse("{\"a\": {\"b\": 1}}");
+    ja_val *compact = ja_parse("{\"a\": {\"c\": [2]}, \"d\": \"e\"}");
+    ja_val *block = ja_copy_compact(compact);
+    log_test_result("Compact patches are copied from", ja_merge_patch_consume(target, &block) && block == NULL &&
+        text_is(target, "{\"a\":{\"b\":1,\"c\":[2]},\"d\":\"e\"}"));
+    ja_free_val(&compact);
+
+    ja_val *root = ja_parse("[1, 2]");
+    bool replaced = ja_merge_patch(target, root) && text_is(target, "[1,2]");
+    ja_arr_append(target, ja_new_num(3));
+    log_test_result("The target changes type in place", replaced && text_is(target, "[1,2,3]") && text_is(root, "[1,2]"));
+    ja_free_val(&root);
+    ja_free_val(&target);
+
+    log_test_result("NULL arguments are rejected", !ja_merge_patch(NULL, NULL) &&
+        ja_last_error()->code == JA_ERROR_NULL_ARGUMENT && !ja_merge_patch_consume(NULL, NULL) &&
+        ja_merge_layers(NULL, 0) == NULL);
+}
+
+/**
+ * @brief Merges layers of configuration.
+ */
+static void run_layers_test(void) {
+    printf("\n> Layers\n");
+
+    const char *texts[] = {
+        "{\"log\": {\"level\": \"info\", \"file\": null}, \"db\": {\"host\": \"localhost\", \"port\": 5432}, \"features\": [\"a\"]}",
+        "{\"log\": {\"level\": \"warn\"}, \"db\": {\"host\": \"db.prod\", \"pool\": {\"size\": 10, \"idle\": null}}, \"cache\": null}",
+        "{\"db\": {\"port\": null, \"pool\": {\"size\": 20}}, \"features\": null, \"tenant\": \"acme\"}",
+        "{\"features\": [\"b\"], \"log\": \"off\"}"
+    };
+    ja_val *layers[4];
+    for (int i = 0; i < 4; i++) layers[i] = ja_parse(texts[i]);
+
+    ja_val *merged = ja_merge_layers(layers, 4);
+    ja_val *expected = ja_copy(layers[0]);
+    for (int i = 1; i < 4; i++) ja_merge_patch(expected, layers[i]);
+
+    log_test_result("Layers merge like successive patches", merged && ja_equal(merged, expected) &&
+        text_is(merged, "{\"log\":\"off\",\"db\":{\"host\":\"db.prod\",\"pool\":{\"size\":20}},\"features\":[\"b\"],"
+        "\"tenant\":\"acme\"}"));
+
+    ja_val *two = ja_merge_layers(layers, 2);
+    log_test_result("Nulls of the base document are kept", two && text_is(ja_get_obj_at(two, "log"),
+        "{\"level\":\"warn\",\"file\":null}") && !ja_has_key(two, "cache"));
+
+    ja_val *db = ja_edit_obj_at(two, "db");
+    ja_set_str(ja_edit_obj_at(db, "host"), "changed");
+    ja_arr_append(ja_edit_obj_at(two, "features"), ja_new_str("z"));
+    bool untouched = true;
+    for (int i = 0; i < 4; i++) {
+        ja_val *original = ja_parse(texts[i]);
+        untouched = untouched && ja_equal_ordered(layers[i], original);
+        ja_free_val(&original);
+    }
+    log_test_result("Layers are left untouched", untouched);
+
+    ja_val *single = ja_merge_layers(layers, 1);
+    ja_arr_append(ja_edit_obj_at(single, "features"), ja_new_str("x"));
+    log_test_result("A single layer gives a copy of it", single && single != layers[0] &&
+        text_is(ja_get_obj_at(layers[0], "features"), "[\"a\"]"));
+
+    ja_val *deleted = ja_new_null();
+    ja_val *gone[] = {layers[0], deleted};
+    ja_val *result = ja_merge_layers(gone, 2);
+    log_test_result("A null layer deletes the document", result && text_is(result, "null"));
+
+    ja_free_val(&result);
+    ja_free_val(&deleted);
+    ja_free_val(&single);
+    ja_free_val(&two);
+    ja_free_val(&expected);
+    ja_free_val(&merged);
+    for (int i = 0; i < 4; i++) ja_free_val(&layers[i]);
+}
+
+/**
+ * @brief Merges layers over the big test file.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *environment = ja_parse("{\"meta\": {\"env\": \"prod\"}, \"region\": \"eu\"}");
+    ja_val *tenant = ja_parse("{\"region\": null, \"meta\": {\"tenant\": \"acme\"}}");
+    ja_val *layers[] = {json->content, environment, tenant};
+
+    double start = now();
+    ja_val *sequential = ja_copy(json->content);
+    ja_merge_patch(sequential, environment);
+    ja_merge_patch(sequential, tenant);
+    double copy_time = now() - start;
+
+    start = now();
+    ja_val *merged = ja_merge_layers(layers, 3);
+    double merge_time = now() - start;
+
+    log_test_result("Same result as copying and patching", merged && ja_equal(merged, sequential) &&
+        ja_size_of(ja_get_obj_at(merged, "data")) == ja_size_of(ja_get_obj_at(json->content, "data")) &&
+        !ja_has_key(merged, "region"));
+    printf("     %.6f s with ja_copy() and ja_merge_patch(), %.6f s with ja_merge_layers()\n", copy_time, merge_time);
+
+    ja_free_val(&merged);
+    ja_free_val(&sequential);
+    ja_free_val(&tenant);
+    ja_free_val(&environment);
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the JSON Merge Patch tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON JSON Merge Patch Tests ===\n");
+
+    run_rfc_test();
+    run_patch_test();
+    run_layers_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * This file tests the minifier.
+ *
+ * It verifies:
+ *  - ✅ Whitespace between tokens is removed, whitespace inside strings is kept.
+ *  - ✅ Escaped quotes and backslashes don't end strings early.
+ *  - ✅ Text split across buffers at any position gives the same result.
+ *  - ✅ Minifying test_big.json file to file keeps the same values.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE      "tests/data/test_big.json"
+#define MINIFIED_FILE "build/data/test_big.min.json"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Minifies a copy of a string in place and compares it with the expected result.
+ */
+static void run_test(const char *json_str, const char *expected) {
+    char *copy = strdup(json_str);
+    size_t length = ja_minify(copy, strlen(copy));
+
+    bool condition = length == strlen(expected) && strcmp(copy, expected) == 0;
+    log_test_result(expected, condition);
+    if (!condition) printf("       got: %s\n", copy);
+
+    free(copy);
+}
+
+/**
+ * @brief Splits a string in two buffers at every position and checks the minified result.
+ */
+static void run_split_test(const char *json_str, const char *expected) {
+    size_t length = strlen(json_str);
+    bool condition = true;
+
+    for (size_t split = 0; split <= length && condition; split++) {
+        char *copy = strdup(json_str);
+        __ja_minify_state state = { false, false };
+
+        size_t first = __ja_minify_buffer(copy, split, &state);
+        size_t second = __ja_minify_buffer(copy + split, length - split, &state);
+
+        memmove(copy + first, copy + split, second);
+        condition = first + second == strlen(expected) && strncmp(copy, expected, first + second) == 0;
+        free(copy);
+    }
+
+    log_test_result("Same result with the text split at every position", condition);
+}
+
+/**
+ * @brief Minifies test_big.json file to file and compares the values with the original.
+ */
+static void run_file_test(void) {
+    printf("\n> File to file\n");
+
+    if (!ja_minify_file(BIG_FILE, MINIFIED_FILE)) {
+        log_test_result("ja_minify_file() should minify test_big.json", false);
+        return;
+    }
+
+    ja_json *original = ja_json_init();
+    ja_json *minified = ja_json_init();
+    bool read = ja_read_json(original, BIG_FILE) && ja_read_json(minified, MINIFIED_FILE);
+
+    char *original_str = read ? ja_stringify(original->content) : NULL;
+    char *minified_str = read ? ja_stringify(minified->content) : NULL;
+
+    log_test_result("Minified file holds the same values",
+        original_str && minified_str && strcmp(original_str, minified_str) == 0);
+    log_test_result("Minified file is smaller and has no line breaks",
+        read && strlen(minified->json_str) < strlen(original->json_str) && !strchr(minified->json_str, '\n'));
+
+    free(original_str);
+    free(minified_str);
+    ja_json_end(original);
+    ja_json_end(minified);
+    remove(MINIFIED_FILE);
+}
+
+/**
+ * @brief Entry point for the minifier tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Minify Tests ===\n");
+
+    printf("\n> In place\n");
+    run_test("{ \"a\" : 1 ,\n  \"b\" : [ 1, 2 ]\n}",            "{\"a\":1,\"b\":[1,2]}");
+    run_test("[ \"keep  these   spaces\" ,\t\"x\" ]",           "[\"keep  these   spaces\",\"x\"]");
+    run_test("{ \"escaped \\\" quote \" : \"back\\\\\" , \"n\" : null }",
+             "{\"escaped \\\" quote \":\"back\\\\\",\"n\":null}");
+    run_test("\r\n  {\r\n    \"long key with more than sixteen bytes\"  :  true\r\n  }\r\n",
+             "{\"long key with more than sixteen bytes\":true}");
+    run_test("[1,2,3]",                                          "[1,2,3]");
+
+    printf("\n> Split buffers\n");
+    run_split_test("{ \"a b\" : [ \"c\\\\\", \"d \\\" e\" ] ,\n \"f\" : 1 }",
+                   "{\"a b\":[\"c\\\\\",\"d \\\" e\"],\"f\":1}");
+
+    run_file_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests moving values between containers (ja_arr_take_at / ja_obj_take_at / ja_arr_extend / ja_obj_merge_move).
+ *
+ * It verifies:
+ *  - ✅ Taken values are the same nodes, detached from their container and owned by the caller.
+ *  - ✅ Values taken out of packed arrays, compact copies and copy-on-write copies outlive their source.
+ *  - ✅ Extending and merging move every element and member, leaving the source empty and usable.
+ *  - ✅ Regrouping the records of the big test file by moving them beats copying them.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Checks that a value serializes to the given text.
+ */
+static bool text_is(ja_val *value, const char *expected) {
+    char *str = ja_stringify(value);
+    bool equal = str && strcmp(str, expected) == 0;
+    if (!equal) printf("     expected %s, got %s\n", expected, str ? str : "(error)");
+    free(str);
+    return equal;
+}
+
+/**
+ * @brief Takes values out of arrays and objects.
+ */
+static void run_take_test(void) {
+    printf("\n> Take\n");
+
+    ja_val *doc = ja_parse("{\"list\": [\"a\", {\"b\": [1, 2]}, \"c\"], \"numbers\": [1, 2.5, 3], \"name\": \"x\"}");
+    ja_val *list = ja_get_obj_at(doc, "list");
+    ja_val *second = ja_get_arr_at(list, 1);
+
+    ja_val *taken = ja_arr_take_at(list, 1);
+    log_test_result("Array elements are detached", taken == second && text_is(list, "[\"a\",\"c\"]") &&
+        text_is(taken, "{\"b\":[1,2]}"));
+
+    ja_val *numbers = ja_get_obj_at(doc, "numbers");
+    ja_val *number = ja_arr_take_at(numbers, 1);
+    log_test_result("Packed elements get a node", number && ja_get_double(number) == 2.5 &&
+        (numbers->flags & JA_FLAG_PACKED) && text_is(numbers, "[1,3]"));
+
+    ja_val *name = ja_obj_take_at(doc, "name");
+    ja_val *moved = ja_obj_take_at(doc, "list");
+    log_test_result("Object members are detached", name && moved == list && !ja_has_key(doc, "list") &&
+        text_is(doc, "{\"numbers\":[1,3]}"));
+
+    ja_free_val(&doc);
+    log_test_result("Taken values outlive their container", text_is(taken, "{\"b\":[1,2]}") && text_is(name, "\"x\"") &&
+        text_is(moved, "[\"a\",\"c\"]"));
+
+    log_test_result("Missing values are reported", ja_obj_take_at(taken, "z") == NULL &&
+        ja_last_error()->code == JA_ERROR_KEY_NOT_FOUND && ja_arr_take_at(moved, 2) == NULL &&
+        ja_last_error()->code == JA_ERROR_INDEX_OUT_OF_BOUNDS && ja_arr_take_at(taken, 0) == NULL &&
+        ja_last_error()->code == JA_ERROR_TYPE_MISMATCH);
+
+    ja_free_val(&taken);
+    ja_free_val(&number);
+    ja_free_val(&name);
+    ja_free_val(&moved);
+
+    ja_val *original = ja_parse("{\"a\": {\"b\": \"c\"}, \"d\": [{\"e\": 1}]}");
+    ja_val *compact = ja_copy_compact(original);
+    ja_val *from_block = ja_obj_take_at(compact, "a");
+    ja_val *element = ja_arr_take_at(ja_get_obj_at(compact, "d"), 0);
+    ja_free_val(&compact);
+    log_test_result("Values of compact copies are copied out", from_block && !(from_block->flags & JA_FLAG_IN_BLOCK) &&
+        text_is(from_block, "{\"b\":\"c\"}") && text_is(element, "{\"e\":1}"));
+    ja_free_val(&from_block);
+    ja_free_val(&element);
+
+    ja_val *cow = ja_copy_cow(original);
+    ja_val *shared = ja_obj_take_at(cow, "a");
+    ja_set_obj_at(shared, "b", ja_new_str("changed"));
+    log_test_result("Values of copy-on-write copies become their own", text_is(shared, "{\"b\":\"changed\"}") &&
+        text_is(original, "{\"a\":{\"b\":\"c\"},\"d\":[{\"e\":1}]}"));
+    ja_free_val(&shared);
+    ja_free_val(&cow);
+    ja_free_val(&original);
+}
+
+/**
+ * @brief Moves every element or member of a container into another one.
+ */
+static void run_extend_test(void) {
+    printf("\n> Extend and merge\n");
+
+    ja_val *target = ja_parse("[\"a\", {\"b\": 1}]");
+    ja_val *source = ja_parse("[[2], \"c\", null]");
+    ja_val *first = ja_get_arr_at(source, 0);
+    log_test_result("Elements are moved", ja_arr_extend(target, source) && ja_size_of(source) == 0 &&
+        ja_get_arr_at(target, 2) == first && text_is(target, "[\"a\",{\"b\":1},[2],\"c\",null]"));
+
+    ja_arr_append(source, ja_new_str("again"));
+    log_test_result("The source stays usable", text_is(source, "[\"again\"]"));
+    ja_free_val(&source);
+    ja_free_val(&target);
+
+    ja_val *numbers = ja_parse("[1, 2]");
+    ja_val *more = ja_parse("[3.5, 4]");
+    bool packed = ja_arr_extend(numbers, more) && (numbers->flags & JA_FLAG_PACKED) && text_is(numbers, "[1,2,3.5,4]");
+    ja_val *empty = ja_new_arr();
+    log_test_result("Packed arrays stay packed", packed && ja_arr_extend(empty, numbers) &&
+        (empty->flags & JA_FLAG_PACKED) && text_is(empty, "[1,2,3.5,4]") && ja_size_of(numbers) == 0);
+
+    ja_val *mixed = ja_parse("[true, \"x\"]");
+    log_test_result("Packed and plain arrays mix", ja_arr_extend(mixed, empty) && text_is(mixed, "[true,\"x\",1,2,3.5,4]") &&
+        ja_arr_extend(mixed, mixed) && ja_size_of(mixed) == 6);
+    ja_free_val(&mixed);
+    ja_free_val(&empty);
+    ja_free_val(&more);
+    ja_free_val(&numbers);
+
+    ja_val *records = ja_parse("[{\"id\": 1}]");
+    ja_val *extra = ja_parse("[{\"id\": 2}, {\"id\": 3}]");
+    ja_index *ids = ja_index_build(records, "/id");
+    log_test_result("Indexes see the new elements", ja_arr_extend(records, extra) && ja_index_lookup_num(ids, 3) ==
+        ja_get_arr_at(records, 2));
+    ja_index_free(&ids);
+    ja_free_val(&extra);
+    ja_free_val(&records);
+
+    ja_val *object = ja_parse("{\"a\": 1, \"b\": [2]}");
+    ja_val *members = ja_parse("{\"b\": {\"c\": 3}, \"d\": \"e\"}");
+    ja_val *nested = ja_get_obj_at(members, "b");
+    log_test_result("Members are moved", ja_obj_merge_move(object, members) && ja_size_of(members) == 0 &&
+        ja_get_obj_at(object, "b") == nested && text_is(object, "{\"a\":1,\"b\":{\"c\":3},\"d\":\"e\"}"));
+
+    ja_set_obj_at(members, "f", ja_new_bool(false));
+    log_test_result("The source object stays usable", text_is(members, "{\"f\":false}") &&
+        ja_obj_merge_move(object, object) && ja_size_of(object) == 3);
+    ja_free_val(&members);
+    ja_free_val(&object);
+
+    ja_val *array = ja_new_arr();
+    log_test_result("Bad arguments are rejected", !ja_arr_extend(NULL, NULL) &&
+        ja_last_error()->code == JA_ERROR_NULL_ARGUMENT && !ja_obj_merge_move(array, array) &&
+        ja_last_error()->code == JA_ERROR_TYPE_MISMATCH);
+    ja_free_val(&array);
+}
+
+/**
+ * @brief Regroups the records of the big test file by language.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_path *language = ja_path_compile("/profile/settings/language");
+    ja_val *copied = ja_copy(json->content);
+    ja_val *data = ja_get_obj_at(copied, "data");
+    size_t size = ja_size_of(data);
+
+    // By copying each record into its group, then freeing the originals
+    double start = now();
+    ja_val *by_copy = ja_new_obj();
+    for (size_t i = 0; i < size; i++) {
+        ja_val *record = ja_get_arr_at(data, i);
+        const char *key = ja_get_str(ja_path_get(language, record));
+        if (!ja_has_key(by_copy, key)) ja_set_obj_at(by_copy, key, ja_new_arr());
+        ja_arr_append(ja_get_obj_at(by_copy, key), ja_copy(record));
+    }
+    ja_obj_remove_at(copied, "data");
+    double copy_time = now() - start;
+
+    // By moving the records, from the end of the array
+    data = ja_get_obj_at(json->content, "data");
+    ja_val *last = ja_get_arr_at(data, size - 1);
+    start = now();
+    ja_val *by_move = ja_new_obj();
+    for (size_t i = size; i-- > 0;) {
+        ja_val *record = ja_arr_take_at(data, i);
+        const char *key = ja_get_str(ja_path_get(language, record));
+        if (!ja_has_key(by_move, key)) ja_set_obj_at(by_move, key, ja_new_arr());
+        ja_arr_append(ja_get_obj_at(by_move, key), record);
+    }
+    double move_time = now() - start;
+
+    ja_val *english = ja_get_obj_at(by_move, "en");
+    ja_val *portuguese = ja_get_obj_at(by_move, "pt");
+    log_test_result("Records are regrouped", ja_size_of(data) == 0 && english && portuguese &&
+        ja_size_of(english) + ja_size_of(portuguese) == size &&
+        ja_size_of(english) == ja_size_of(ja_get_obj_at(by_copy, "en")) &&
+        (ja_get_arr_at(english, 0) == last || ja_get_arr_at(portuguese, 0) == last));
+    printf("     %zu records: %.6f s by copying, %.6f s by moving\n", size, copy_time, move_time);
+
+    ja_free_val(&by_move);
+    ja_free_val(&by_copy);
+    ja_free_val(&copied);
+    ja_path_free(&language);
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the move tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Move Tests ===\n");
+
+    run_take_test();
+    run_extend_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * This file tests the NDJSON (JSON Lines) reader.
+ *
+ * It verifies:
+ *  - ✅ Documents are delivered in file order, blank lines are ignored.
+ *  - ✅ Malformed lines are skipped or stop the reading, and their line/offset are reported.
+ *  - ✅ Small batches (lines split across reads, lines bigger than a batch) give the same results.
+ *  - ✅ Out of order delivery hands every document to the callback.
+ *  - ✅ Worker threads are kept between batches and work again after ja_stop_worker_threads().
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define NDJSON_FILE "tests/data/test_ndjson/test_lines.ndjson"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Reads the test file with ja_ndjson_next() and checks documents and errors.
+ */
+static void run_ordered_test(size_t batch_size) {
+    printf("\n> Ordered reading (batch size %zu)\n", batch_size);
+
+    ja_ndjson_options options = ja_ndjson_default_options();
+    options.batch_size = batch_size;
+    options.skip_invalid = true;
+
+    ja_ndjson_reader *reader = ja_ndjson_open(NDJSON_FILE, &options);
+    if (!reader) {
+        log_test_result("Open reader", false);
+        return;
+    }
+
+    const size_t expected_lines[] = { 1, 2, 4, 7, 9 };
+    const int expected_types[] = { JA_TYPE_OBJECT, JA_TYPE_ARRAY, JA_TYPE_STRING, JA_TYPE_OBJECT, JA_TYPE_NULL };
+    size_t count = 0;
+    bool in_order = true;
+    ja_val *document;
+    size_t line;
+
+    while ((document = ja_ndjson_next(reader, &line))) {
+        if (count >= 5 || line != expected_lines[count] || (int)document->type != expected_types[count]) {
+            in_order = false;
+        }
+        if (line == 7) {
+            ja_val *ok = ja_get_obj_at(ja_get_obj_at(document, "nested"), "ok");
+            in_order = in_order && ok && ja_get_bool(ok);
+        }
+        count++;
+        ja_free_val(&document);
+    }
+
+    log_test_result("Every valid line is delivered in order", in_order && count == 5);
+
+    size_t error_count = 0;
+    const ja_ndjson_error *errors = ja_ndjson_errors(reader, &error_count);
+    log_test_result("Malformed lines are reported with their offsets",
+        error_count == 2 &&
+        errors[0].line == 5 && errors[0].offset == 54 &&
+        errors[1].line == 8 && errors[1].offset == 114
+    );
+
+    ja_ndjson_close(reader);
+}
+
+/**
+ * @brief Checks that reading stops at the first malformed line when it isn't skipped.
+ */
+static void run_fail_test(void) {
+    printf("\n> Stop on malformed line\n");
+
+    ja_ndjson_reader *reader = ja_ndjson_open(NDJSON_FILE, NULL);
+    if (!reader) {
+        log_test_result("Open reader", false);
+        return;
+    }
+
+    size_t count = 0;
+    ja_val *document;
+    while ((document = ja_ndjson_next(reader, NULL))) {
+        count++;
+        ja_free_val(&document);
+    }
+
+    size_t error_count = 0;
+    const ja_ndjson_error *errors = ja_ndjson_errors(reader, &error_count);
+    log_test_result("Lines before the malformed one are delivered", count == 3);
+    log_test_result("Only the first malformed line is reported", error_count == 1 && errors[0].line == 5);
+
+    ja_ndjson_close(reader);
+}
+
+/**
+ * @brief Callback counting documents, may be called from several threads.
+ */
+static bool count_document(ja_val *document, size_t line, void *user_data) {
+    (void)line;
+    __atomic_fetch_add((size_t *)user_data, 1, __ATOMIC_RELAXED);
+    ja_free_val(&document);
+    return true;
+}
+
+/**
+ * @brief Checks out of order delivery through ja_ndjson_for_each().
+ */
+static void run_unordered_test(void) {
+    printf("\n> Out of order reading\n");
+
+    ja_ndjson_options options = ja_ndjson_default_options();
+    options.ordered = false;
+    options.skip_invalid = true;
+    options.thread_count = 4;
+
+    ja_ndjson_reader *reader = ja_ndjson_open(NDJSON_FILE, &options);
+    if (!reader) {
+        log_test_result("Open reader", false);
+        return;
+    }
+
+    size_t count = 0;
+    bool result = ja_ndjson_for_each(reader, count_document, &count);
+    log_test_result("Every valid line reaches the callback", result && count == 5);
+    ja_ndjson_close(reader);
+
+    // The worker threads are kept between batches and readers, and started again once stopped
+    options.batch_size = 16;
+    bool restarted = true;
+    for (int run = 0; run < 3; run++) {
+        reader = ja_ndjson_open(NDJSON_FILE, &options);
+        count = 0;
+        restarted = restarted && reader && ja_ndjson_for_each(reader, count_document, &count) && count == 5;
+        ja_ndjson_close(reader);
+        if (run > 0) ja_stop_worker_threads();
+    }
+    ja_stop_worker_threads();
+    log_test_result("Worker threads are reused and restarted", restarted);
+}
+
+/**
+ * @brief Entry point for the NDJSON reader tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON NDJSON Tests ===\n");
+
+    run_ordered_test(0);  // Default batch size, whole file in one batch
+    run_ordered_test(16); // Lines split across batches and bigger than the buffer
+    run_fail_test();
+    run_unordered_test();
+
+    log_test_result("Opening a missing file fails", ja_ndjson_open("tests/data/test_ndjson/missing.ndjson", NULL) == NULL);
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,290 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef JA_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * This file tests packed arrays of numbers and booleans (ja_arr_as_doubles / ja_arr_as_bools).
+ *
+ * It verifies:
+ *  - ✅ The parser, the binary decoders and ja_new_set_arr() pack arrays holding only numbers or only booleans.
+ *  - ✅ Packed elements read back with the same type and value, through every accessor and serializer.
+ *  - ✅ Matching values keep an array packed, anything else turns it back into an array of nodes.
+ *  - ✅ Reading elements keeps an array packed, also from several threads, and changing one writes it back.
+ *  - ✅ Copies, compact copies, snapshots and MessagePack round trips keep the elements.
+ *  - ✅ ja_arr_as_doubles() hands out the numbers of a big array without copying them.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define SNAPSHOT_FILE "build/data/test_packed.jasnap"
+#define BIG_SIZE 1000000
+#define THREAD_COUNT 4
+#define SHARED_SIZE 10000
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Checks that a value serializes to the given text.
+ */
+static bool text_is(ja_val *value, const char *expected) {
+    char *str = ja_stringify(value);
+    bool equal = str && strcmp(str, expected) == 0;
+    if (!equal) printf("     expected %s, got %s\n", expected, str ? str : "(error)");
+    free(str);
+    return equal;
+}
+
+/**
+ * @brief Checks whether an array stores its elements packed.
+ */
+static bool is_packed(ja_val *array) {
+    return array && (array->flags & (JA_FLAG_PACKED | JA_FLAG_PACKED_BOOL));
+}
+
+/**
+ * @brief Parses packed arrays and reads them back.
+ */
+static void run_parse_test(void) {
+    printf("\n> Parse\n");
+
+    ja_val *doc = ja_parse("{\"scores\": [1, 2.5, -3, 1e3, 3000000000], \"flags\": [true, false, true],"
+                           " \"mixed\": [1, \"a\"], \"late\": [1, 2, null], \"empty\": []}");
+    if (!doc) {
+        log_test_result("Parse document", false);
+        return;
+    }
+
+    ja_val *scores = ja_get_obj_at(doc, "scores");
+    size_t size = 0;
+    const double *numbers = ja_arr_as_doubles(scores, &size);
+    log_test_result("Numbers are packed as doubles", is_packed(scores) && numbers && size == 5 &&
+        numbers[0] == 1.0 && numbers[1] == 2.5 && numbers[2] == -3.0 && numbers[3] == 1000.0 && numbers[4] == 3e9);
+    log_test_result("Packed numbers print as before", text_is(scores, "[1,2.5,-3,1000,3000000000]"));
+
+    ja_val *flags = ja_get_obj_at(doc, "flags");
+    const bool *booleans = ja_arr_as_bools(flags, &size);
+    log_test_result("Booleans are packed", is_packed(flags) && booleans && size == 3 && booleans[0] && !booleans[1] &&
+        text_is(flags, "[true,false,true]"));
+
+    log_test_result("Mixed arrays keep their nodes", !is_packed(ja_get_obj_at(doc, "mixed")) &&
+        !is_packed(ja_get_obj_at(doc, "late")) && text_is(ja_get_obj_at(doc, "late"), "[1,2,null]") &&
+        ja_arr_as_doubles(ja_get_obj_at(doc, "mixed"), &size) == NULL && ja_last_error()->code == JA_ERROR_TYPE_MISMATCH);
+    log_test_result("Numbers aren't booleans", ja_arr_as_bools(scores, &size) == NULL && size == 0 &&
+        ja_arr_as_doubles(ja_get_obj_at(doc, "empty"), &size) != NULL && size == 0);
+
+    ja_val *third = ja_get_arr_at(scores, 2);
+    log_test_result("Elements are read without unpacking", third && third->type == JA_TYPE_INT &&
+        ja_get_int(third) == -3 && is_packed(scores) && ja_get_arr_at(scores, 1)->type == JA_TYPE_DOUBLE &&
+        ja_get_arr_at(scores, 2) == third);
+
+    ja_set_num(third, 8);
+    log_test_result("Changing an element turns the array back into nodes", !is_packed(scores) &&
+        ja_get_arr_at(scores, 2) == third && text_is(scores, "[1,2.5,8,1000,3000000000]"));
+    log_test_result("Arrays of numbers are packed again on request", ja_arr_as_doubles(scores, &size) != NULL &&
+        size == 5 && is_packed(scores) && text_is(scores, "[1,2.5,8,1000,3000000000]"));
+
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Modifies packed arrays.
+ */
+static void run_modify_test(void) {
+    printf("\n> Modify\n");
+
+    ja_val *array = ja_new_set_arr(3, ja_new_num(1), ja_new_num(2), ja_new_num(3));
+    log_test_result("ja_new_set_arr() packs numbers", is_packed(array));
+
+    ja_arr_append(array, ja_new_num(4.5));
+    ja_arr_remove_at(array, 0);
+    log_test_result("Numbers are appended and removed in place", is_packed(array) && text_is(array, "[2,3,4.5]"));
+
+    ja_arr_append(array, ja_new_str("x"));
+    log_test_result("Anything else turns the array back into nodes", !is_packed(array) && text_is(array, "[2,3,4.5,\"x\"]"));
+    ja_free_val(&array);
+
+    array = ja_parse("[true, false]");
+    ja_set_arr_at(array, 1, ja_new_bool(true));
+    bool still_packed = is_packed(array);
+    ja_set_arr_at(array, 0, ja_new_num(0));
+    log_test_result("Setting elements", still_packed && !is_packed(array) && text_is(array, "[0,true]"));
+    ja_free_val(&array);
+
+    array = ja_parse("[7]");
+    ja_arr_remove_at(array, 0);
+    ja_arr_append(array, ja_new_str("a"));
+    log_test_result("Emptied arrays take any value", !is_packed(array) && text_is(array, "[\"a\"]"));
+    ja_free_val(&array);
+
+    ja_val *doc = ja_parse("{\"a\": [1, 2, 3]}");
+    ja_path *path = ja_path_compile("/a/1");
+    ja_query *query = ja_query_compile("$.a[?(@ > 1)]");
+    size_t count = 0;
+    ja_val **results = ja_query_eval(query, doc, &count);
+    log_test_result("Paths and queries reach the elements", ja_get_int(ja_path_get(path, doc)) == 2 &&
+        results && count == 2 && ja_get_int(results[1]) == 3 && is_packed(ja_get_obj_at(doc, "a")));
+    free(results);
+
+    ja_val *elements = ja_get_obj_at(doc, "a");
+    ja_val *first = ja_get_arr_at(elements, 0);
+    ja_arr_append(elements, ja_new_num(4));
+    ja_arr_remove_at(elements, 1);
+    log_test_result("Elements read stay valid when the array changes", !is_packed(elements) &&
+        ja_get_arr_at(elements, 0) == first && ja_get_int(first) == 1 && text_is(elements, "[1,3,4]"));
+    ja_query_free(&query);
+    ja_path_free(&path);
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Copies and serializes packed arrays.
+ */
+static void run_copy_test(void) {
+    printf("\n> Copies\n");
+
+    const char *text = "{\"a\":[1,2.5,-3],\"b\":[true,false],\"c\":[[0.25],\"s\"]}";
+    ja_val *doc = ja_parse(text);
+
+    ja_val *copy = ja_copy(doc);
+    ja_val *cow = ja_copy_cow(doc);
+    ja_arr_append(ja_edit_obj_at(cow, "a"), ja_new_num(9));
+    log_test_result("Copies keep their own elements", is_packed(ja_get_obj_at(copy, "a")) && text_is(copy, text) &&
+        text_is(doc, text) && text_is(ja_get_obj_at(cow, "a"), "[1,2.5,-3,9]"));
+    ja_free_val(&copy);
+    ja_free_val(&cow);
+
+    ja_val *compact = ja_copy_compact(doc);
+    log_test_result("Compact copies store the elements as nodes", compact && text_is(compact, text) &&
+        ja_get_bool(ja_get_arr_at(ja_get_obj_at(compact, "b"), 0)));
+    ja_free_val(&compact);
+
+    ja_val *loaded = ja_save_snapshot(doc, SNAPSHOT_FILE) ? ja_load_snapshot(SNAPSHOT_FILE) : NULL;
+    log_test_result("Snapshots", loaded && text_is(loaded, text));
+    ja_free_val(&loaded);
+
+    size_t length = 0;
+    unsigned char *data = ja_to_msgpack(doc, &length);
+    ja_val *decoded = data ? ja_from_msgpack(data, length) : NULL;
+    log_test_result("MessagePack round trip packs again", decoded && text_is(decoded, text) &&
+        is_packed(ja_get_obj_at(decoded, "a")) && is_packed(ja_get_arr_at(ja_get_obj_at(decoded, "c"), 0)));
+    free(data);
+    ja_free_val(&decoded);
+
+    ja_free_val(&doc);
+}
+
+#ifdef JA_THREADS
+/**
+ * @brief Sums the elements of a shared packed array through ja_get_arr_at().
+ */
+static void *sum_elements(void *arg) {
+    ja_val *array = arg;
+    long long sum = 0;
+    for (size_t i = 0; i < SHARED_SIZE; i++) sum += ja_get_int(ja_get_arr_at(array, i));
+    return (void *)(intptr_t)sum;
+}
+
+/**
+ * @brief Reads the same packed array from several threads at once.
+ */
+static void run_thread_test(void) {
+    printf("\n> Threads\n");
+
+    ja_val *array = ja_new_arr();
+    for (int i = 0; i < SHARED_SIZE; i++) ja_arr_append(array, ja_new_num(i));
+    ja_arr_as_doubles(array, &(size_t){0});
+
+    pthread_t threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) pthread_create(&threads[i], NULL, sum_elements, array);
+
+    bool sums = true;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        void *sum = NULL;
+        pthread_join(threads[i], &sum);
+        sums = sums && (intptr_t)sum == (intptr_t)SHARED_SIZE * (SHARED_SIZE - 1) / 2;
+    }
+    log_test_result("Threads read the same packed array", sums && is_packed(array));
+
+    ja_free_val(&array);
+}
+#endif
+
+/**
+ * @brief Parses a big array of numbers and sums it through ja_arr_as_doubles().
+ */
+static void run_big_test(void) {
+    printf("\n> Big array\n");
+
+    char *text = malloc((size_t)BIG_SIZE * 12 + 3);
+    char *p = text;
+    *p++ = '[';
+    for (int i = 0; i < BIG_SIZE; i++) p += sprintf(p, i ? ",%d.5" : "%d.5", i % 1000);
+    *p++ = ']';
+    *p = '\0';
+
+    double start = now();
+    ja_val *array = ja_parse(text);
+    double parse_time = now() - start;
+
+    size_t size = 0;
+    start = now();
+    const double *numbers = ja_arr_as_doubles(array, &size);
+    double sum = 0.0;
+    for (size_t i = 0; numbers && i < size; i++) sum += numbers[i];
+    double sum_time = now() - start;
+
+    double expected = 0.0;
+    for (int i = 0; i < BIG_SIZE; i++) expected += i % 1000 + 0.5;
+    log_test_result("Sum over the packed numbers", numbers && size == BIG_SIZE && sum == expected);
+    log_test_result("No copy is made", numbers == ja_arr_as_doubles(array, &size));
+    printf("     %d numbers: parsed in %.6f s, summed in %.6f s\n", BIG_SIZE, parse_time, sum_time);
+
+    ja_free_val(&array);
+    free(text);
+}
+
+/**
+ * @brief Entry point for the packed array tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Packed Array Tests ===\n");
+
+    run_parse_test();
+    run_modify_test();
+    run_copy_test();
+#ifdef JA_THREADS
+    run_thread_test();
+#endif
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
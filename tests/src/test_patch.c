@@ -0,0 +1,298 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests JSON Patch (ja_diff / ja_patch_apply).
+ *
+ * It verifies:
+ *  - ✅ The examples of RFC 6902 apply as the RFC describes, errors included.
+ *  - ✅ A failed operation undoes the ones before it, key order included.
+ *  - ✅ Patches from ja_diff() turn the first value into the second, for random edits of arrays too.
+ *  - ✅ A changed field in a record of an array gives a single operation.
+ *  - ✅ A few changed records of the big test file give a patch much smaller than the document.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Checks that a value serializes to the given text.
+ */
+static bool text_is(ja_val *value, const char *expected) {
+    char *str = ja_stringify(value);
+    bool equal = str && strcmp(str, expected) == 0;
+    if (!equal) printf("     expected %s, got %s\n", expected, str ? str : "(error)");
+    free(str);
+    return equal;
+}
+
+/**
+ * @brief Applies a patch to a document and checks the result, or that it fails when `expected` is NULL.
+ */
+static bool patch_gives(const char *document, const char *patch, const char *expected) {
+    ja_val *doc = ja_parse(document);
+    ja_val *operations = ja_parse(patch);
+    bool applied = doc && operations && ja_patch_apply(doc, operations);
+    bool ok = expected ? applied && text_is(doc, expected) : !applied;
+    ja_free_val(&doc);
+    ja_free_val(&operations);
+    return ok;
+}
+
+/**
+ * @brief Checks that the patch from ja_diff() turns a copy of `from` into `to`.
+ */
+static bool diff_applies(ja_val *from, ja_val *to, size_t *operations) {
+    ja_val *patch = ja_diff(from, to);
+    ja_val *copy = ja_copy(from);
+    bool ok = patch && copy && ja_patch_apply(copy, patch) && ja_equal(copy, to);
+    if (operations) *operations = ja_size_of(patch);
+    if (!ok) {
+        char *str = ja_stringify(patch);
+        printf("     patch %s failed\n", str ? str : "(error)");
+        free(str);
+    }
+    ja_free_val(&patch);
+    ja_free_val(&copy);
+    return ok;
+}
+
+/**
+ * @brief Same as diff_applies(), with both values given as text.
+ */
+static bool texts_diff(const char *from, const char *to, size_t expected_operations) {
+    ja_val *first = ja_parse(from);
+    ja_val *second = ja_parse(to);
+    size_t operations = 0;
+    bool ok = first && second && diff_applies(first, second, &operations) && operations == expected_operations;
+    if (!ok) printf("     %s -> %s gave %zu operations\n", from, to, operations);
+    ja_free_val(&first);
+    ja_free_val(&second);
+    return ok;
+}
+
+/**
+ * @brief Applies the examples of RFC 6902, appendix A.
+ */
+static void run_rfc_test(void) {
+    printf("\n> RFC 6902 examples\n");
+
+    log_test_result("Adding members and elements", patch_gives("{\"foo\": \"bar\"}",
+        "[{\"op\": \"add\", \"path\": \"/baz\", \"value\": \"qux\"}]", "{\"foo\":\"bar\",\"baz\":\"qux\"}") &&
+        patch_gives("{\"foo\": [\"bar\", \"baz\"]}", "[{\"op\": \"add\", \"path\": \"/foo/1\", \"value\": \"qux\"}]",
+        "{\"foo\":[\"bar\",\"qux\",\"baz\"]}") &&
+        patch_gives("{\"foo\": [\"bar\"]}", "[{\"op\": \"add\", \"path\": \"/foo/-\", \"value\": [\"abc\", \"def\"]}]",
+        "{\"foo\":[\"bar\",[\"abc\",\"def\"]]}"));
+    log_test_result("Removing", patch_gives("{\"baz\": \"qux\", \"foo\": \"bar\"}", "[{\"op\": \"remove\", \"path\": \"/baz\"}]",
+        "{\"foo\":\"bar\"}") && patch_gives("{\"foo\": [\"bar\", \"qux\", \"baz\"]}",
+        "[{\"op\": \"remove\", \"path\": \"/foo/1\"}]", "{\"foo\":[\"bar\",\"baz\"]}"));
+    log_test_result("Replacing", patch_gives("{\"baz\": \"qux\", \"foo\": \"bar\"}",
+        "[{\"op\": \"replace\", \"path\": \"/baz\", \"value\": \"boo\"}]", "{\"baz\":\"boo\",\"foo\":\"bar\"}") &&
+        patch_gives("[1, 2]", "[{\"op\": \"replace\", \"path\": \"\", \"value\": {\"a\": true}}]", "{\"a\":true}"));
+    log_test_result("Moving", patch_gives("{\"foo\": {\"bar\": \"baz\", \"waldo\": \"fred\"}, \"qux\": {\"corge\": \"grault\"}}",
+        "[{\"op\": \"move\", \"from\": \"/foo/waldo\", \"path\": \"/qux/thud\"}]",
+        "{\"foo\":{\"bar\":\"baz\"},\"qux\":{\"corge\":\"grault\",\"thud\":\"fred\"}}") &&
+        patch_gives("{\"foo\": [\"all\", \"grass\", \"cows\", \"eat\"]}", "[{\"op\": \"move\", \"from\": \"/foo/1\", \"path\": \"/foo/3\"}]",
+        "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}"));
+    log_test_result("Copying and testing", patch_gives("{\"baz\": \"qux\", \"foo\": [\"a\", 2, \"c\"]}",
+        "[{\"op\": \"test\", \"path\": \"/baz\", \"value\": \"qux\"}, {\"op\": \"test\", \"path\": \"/foo/1\", \"value\": 2.0},"
+        " {\"op\": \"copy\", \"from\": \"/foo\", \"path\": \"/bar\"}]", "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"],\"bar\":[\"a\",2,\"c\"]}") &&
+        patch_gives("{\"/\": 9, \"~1\": 10}", "[{\"op\": \"test\", \"path\": \"/~01\", \"value\": 10}]", "{\"/\":9,\"~1\":10}"));
+
+    log_test_result("Failed tests and missing paths", patch_gives("{\"baz\": \"qux\"}",
+        "[{\"op\": \"test\", \"path\": \"/baz\", \"value\": \"bar\"}]", NULL) && ja_last_error()->code == JA_ERROR_PATCH_TEST_FAILED &&
+        patch_gives("{\"foo\": \"bar\"}", "[{\"op\": \"add\", \"path\": \"/baz/bat\", \"value\": \"qux\"}]", NULL) &&
+        ja_last_error()->code == JA_ERROR_KEY_NOT_FOUND &&
+        patch_gives("{\"foo\": [1]}", "[{\"op\": \"add\", \"path\": \"/foo/2\", \"value\": 2}]", NULL) &&
+        patch_gives("{\"foo\": [1]}", "[{\"op\": \"replace\", \"path\": \"/bar\", \"value\": 2}]", NULL));
+    log_test_result("Malformed operations", patch_gives("{}", "[{\"op\": \"add\", \"path\": \"/a\"}]", NULL) &&
+        ja_last_error()->code == JA_ERROR_INVALID_PATCH && patch_gives("{}", "[{\"op\": \"jump\", \"path\": \"/a\"}]", NULL) &&
+        patch_gives("{\"a\": {}}", "[{\"op\": \"move\", \"from\": \"/a\", \"path\": \"/a/b\"}]", NULL) &&
+        patch_gives("{}", "{\"op\": \"remove\"}", NULL) && patch_gives("{}", "[{\"op\": \"remove\", \"path\": \"\"}]", NULL));
+}
+
+/**
+ * @brief Checks that failed patches leave the document as it was.
+ */
+static void run_rollback_test(void) {
+    printf("\n> Rollback\n");
+
+    const char *text = "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"e\",\"f\":[true]},\"g\":null}";
+    ja_val *doc = ja_parse(text);
+    ja_val *patch = ja_parse("[{\"op\": \"remove\", \"path\": \"/a\"}, {\"op\": \"add\", \"path\": \"/b/1\", \"value\": 9},"
+        " {\"op\": \"replace\", \"path\": \"/c/d\", \"value\": [0]}, {\"op\": \"move\", \"from\": \"/c/f\", \"path\": \"/b/0\"},"
+        " {\"op\": \"copy\", \"from\": \"/c\", \"path\": \"/h\"}, {\"op\": \"remove\", \"path\": \"/b/4\"},"
+        " {\"op\": \"move\", \"from\": \"/g\", \"path\": \"\"}, {\"op\": \"add\", \"path\": \"/x\", \"value\": 1}]");
+
+    log_test_result("Every operation is undone", !ja_patch_apply(doc, patch) && ja_last_error()->offset == 7 &&
+        text_is(doc, text));
+
+    ja_arr_remove_at(patch, 7);
+    log_test_result("Moving a member to the root", ja_patch_apply(doc, patch) && text_is(doc, "null"));
+    ja_free_val(&patch);
+    ja_free_val(&doc);
+
+    ja_val *records = ja_parse("[{\"id\": 1}, {\"id\": 2}, {\"id\": 3}]");
+    ja_index *ids = ja_index_build(records, "/id");
+    patch = ja_parse("[{\"op\": \"remove\", \"path\": \"/0\"}, {\"op\": \"add\", \"path\": \"/-\", \"value\": {\"id\": 4}}]");
+    log_test_result("Indexes follow the changes", ja_patch_apply(records, patch) && ja_index_lookup_num(ids, 1) == NULL &&
+        ja_index_lookup_num(ids, 4) == ja_get_arr_at(records, 2));
+    ja_index_free(&ids);
+    ja_free_val(&patch);
+    ja_free_val(&records);
+}
+
+/**
+ * @brief Diffs values and applies the patches.
+ */
+static void run_diff_test(void) {
+    printf("\n> Diff\n");
+
+    log_test_result("Equal values give empty patches", texts_diff("{\"a\": [1, {\"b\": 2}]}", "{\"a\": [1.0, {\"b\": 2}]}", 0) &&
+        texts_diff("[]", "[]", 0));
+    log_test_result("Members", texts_diff("{\"a\": 1, \"b\": 2, \"c\": 3}", "{\"a\": 1, \"b\": 5, \"d\": 4}", 3) &&
+        texts_diff("{\"a/b\": 1, \"m~n\": 2}", "{\"a/b\": 2, \"m~n\": 3}", 2));
+    log_test_result("Elements", texts_diff("[1, 2, 3, 4, 5]", "[1, 3, 4, 6, 5]", 2) && texts_diff("[1, 2]", "[0, 1, 2, 3]", 2) &&
+        texts_diff("[true, false]", "[]", 2) && texts_diff("[\"a\", \"b\", \"c\"]", "[\"c\", \"b\", \"a\"]", 4));
+    log_test_result("Type changes", texts_diff("{\"a\": [1]}", "{\"a\": {\"0\": 1}}", 1) && texts_diff("1", "\"1\"", 1) &&
+        texts_diff("[1]", "{}", 1));
+
+    ja_val *from = ja_parse("[{\"id\": 1, \"name\": \"ana\"}, {\"id\": 2, \"name\": \"bea\"}, {\"id\": 3, \"name\": \"cy\"}]");
+    ja_val *to = ja_copy(from);
+    ja_set_str(ja_get_obj_at(ja_get_arr_at(to, 1), "name"), "bo");
+    ja_val *patch = ja_diff(from, to);
+    ja_val *operation = ja_get_arr_at(patch, 0);
+    log_test_result("A changed field gives one operation", ja_size_of(patch) == 1 &&
+        strcmp(ja_get_str(ja_get_obj_at(operation, "op")), "replace") == 0 &&
+        strcmp(ja_get_str(ja_get_obj_at(operation, "path")), "/1/name") == 0);
+    ja_free_val(&patch);
+    ja_free_val(&to);
+    ja_free_val(&from);
+
+    // Random edits of arrays, to exercise the edit scripts
+    srand(42);
+    bool all = true;
+    for (int round = 0; round < 200 && all; round++) {
+        ja_val *first = ja_new_arr();
+        int size = rand() % 20;
+        for (int i = 0; i < size; i++) ja_arr_append(first, ja_new_num(rand() % 6));
+
+        ja_val *second = ja_copy(first);
+        for (int edits = rand() % 6; edits > 0; edits--) {
+            size_t length = ja_size_of(second);
+            int kind = rand() % 3;
+            if (kind == 0 || length == 0) ja_arr_append(second, ja_new_num(rand() % 6));
+            else if (kind == 1) ja_arr_remove_at(second, (size_t)rand() % length);
+            else ja_set_arr_at(second, (size_t)rand() % length, ja_new_num(rand() % 6));
+        }
+        all = diff_applies(first, second, NULL) && diff_applies(second, first, NULL);
+        ja_free_val(&first);
+        ja_free_val(&second);
+    }
+    log_test_result("Random edits of arrays", all);
+
+    ja_val *left = ja_new_arr();
+    ja_val *right = ja_new_arr();
+    for (int i = 0; i < JA_DIFF_MAX_EDITS * 2; i++) {
+        ja_arr_append(left, ja_new_num(i));
+        ja_arr_append(right, ja_new_num(-i - 1));
+    }
+    ja_arr_append(right, ja_new_str("extra"));
+    size_t operations = 0;
+    log_test_result("Arrays too different for an edit script", diff_applies(left, right, &operations) &&
+        operations == JA_DIFF_MAX_EDITS * 2 + 1);
+    ja_free_val(&left);
+    ja_free_val(&right);
+
+    log_test_result("NULL arguments are rejected", ja_diff(NULL, NULL) == NULL &&
+        ja_last_error()->code == JA_ERROR_NULL_ARGUMENT && !ja_patch_apply(NULL, NULL));
+}
+
+/**
+ * @brief Diffs the big test file with a few changed records.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *changed = ja_copy(json->content);
+    ja_val *data = ja_get_obj_at(changed, "data");
+    ja_set_str(ja_get_obj_at(ja_get_arr_at(data, 10), "name"), "renamed");
+    ja_set_num(ja_get_arr_at(ja_get_obj_at(ja_get_arr_at(data, 500), "scores"), 3), 99);
+    ja_arr_remove_at(data, 1200);
+    ja_arr_append(ja_get_obj_at(changed, "data"), ja_copy(ja_get_arr_at(data, 0)));
+
+    double start = now();
+    ja_val *patch = ja_diff(json->content, changed);
+    double diff_time = now() - start;
+
+    char *document_text = ja_stringify(json->content);
+    char *patch_text = ja_stringify(patch);
+    size_t document_size = document_text ? strlen(document_text) : 0;
+    size_t patch_size = patch_text ? strlen(patch_text) : 0;
+
+    start = now();
+    bool applied = patch && ja_patch_apply(json->content, patch);
+    double apply_time = now() - start;
+
+    log_test_result("A few changed records give a few operations", applied && ja_size_of(patch) == 4 &&
+        ja_equal(json->content, changed) && patch_size * 100 < document_size);
+    printf("     %zu bytes of JSON, %zu bytes of patch: diffed in %.6f s, applied in %.6f s\n",
+        document_size, patch_size, diff_time, apply_time);
+
+    free(document_text);
+    free(patch_text);
+    ja_free_val(&patch);
+    ja_free_val(&changed);
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the JSON Patch tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON JSON Patch Tests ===\n");
+
+    run_rfc_test();
+    run_rollback_test();
+    run_diff_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
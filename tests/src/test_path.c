@@ -0,0 +1,205 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests compiled JSON Pointers (ja_path_compile / ja_path_get / ja_path_set).
+ *
+ * It verifies:
+ *  - ✅ The examples of RFC 6901 resolve to the expected values, escapes included.
+ *  - ✅ Missing steps return NULL without recording errors, and malformed pointers are rejected.
+ *  - ✅ ja_path_set() replaces values, adds keys and appends to arrays, and reports missing parents.
+ *  - ✅ Steps cache the shape and slot they matched, across the records of the big test file.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+// Example document of RFC 6901, section 5
+#define RFC_JSON \
+    "{\"foo\": [\"bar\", \"baz\"], \"\": 0, \"a/b\": 1, \"c%d\": 2, \"e^f\": 3, \"g|h\": 4," \
+    " \"i\\\\j\": 5, \"k\\\"l\": 6, \" \": 7, \"m~n\": 8}"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Compiles a pointer, resolves it once and frees it.
+ */
+static ja_val *get_once(const char *pointer, ja_val *root) {
+    ja_path *path = ja_path_compile(pointer);
+    ja_val *value = ja_path_get(path, root);
+    ja_path_free(&path);
+    return value;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Resolves the examples of RFC 6901.
+ */
+static void run_rfc_test(void) {
+    printf("\n> RFC 6901 examples\n");
+
+    ja_val *doc = ja_parse(RFC_JSON);
+    if (!doc) {
+        log_test_result("Parse example document", false);
+        return;
+    }
+
+    log_test_result("\"\" is the whole document", get_once("", doc) == doc);
+    log_test_result("/foo and /foo/0", ja_size_of(get_once("/foo", doc)) == 2 &&
+        strcmp(ja_get_str(get_once("/foo/0", doc)), "bar") == 0);
+    log_test_result("Empty key and special characters",
+        ja_get_int(get_once("/", doc)) == 0 && ja_get_int(get_once("/c%d", doc)) == 2 &&
+        ja_get_int(get_once("/e^f", doc)) == 3 && ja_get_int(get_once("/g|h", doc)) == 4 &&
+        ja_get_int(get_once("/ ", doc)) == 7);
+    log_test_result("~1 and ~0 are unescaped", ja_get_int(get_once("/a~1b", doc)) == 1 &&
+        ja_get_int(get_once("/m~0n", doc)) == 8);
+
+    ja_clear_last_error();
+    bool missing = get_once("/missing", doc) == NULL && get_once("/foo/2", doc) == NULL &&
+        get_once("/foo/-", doc) == NULL && get_once("/foo/01", doc) == NULL && get_once("/a~1b/x", doc) == NULL;
+    log_test_result("Misses return NULL without errors", missing && ja_last_error()->code == JA_ERROR_NONE);
+
+    log_test_result("Pointers not starting with '/' are rejected",
+        ja_path_compile("foo") == NULL && ja_last_error()->code == JA_ERROR_UNEXPECTED_CHARACTER);
+    log_test_result("Bad escapes are rejected at their offset",
+        ja_path_compile("/foo/a~2") == NULL && ja_last_error()->offset == 6);
+
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Sets values through paths.
+ */
+static void run_set_test(void) {
+    printf("\n> Set\n");
+
+    ja_val *doc = ja_parse("{\"user\": {\"name\": \"ana\", \"tags\": [\"a\"]}}");
+    ja_path *name = ja_path_compile("/user/name");
+    ja_path *email = ja_path_compile("/user/email");
+    ja_path *append = ja_path_compile("/user/tags/-");
+    ja_path *second = ja_path_compile("/user/tags/2");
+    ja_path *orphan = ja_path_compile("/account/id");
+
+    bool set = ja_path_set(name, doc, ja_new_str("bea")) && ja_path_set(email, doc, ja_new_str("bea@example.com")) &&
+        ja_path_set(append, doc, ja_new_str("b")) && ja_path_set(second, doc, ja_new_str("c"));
+    char *str = ja_stringify(doc);
+    log_test_result("Values are replaced, added and appended", set && str && strcmp(str,
+        "{\"user\":{\"name\":\"bea\",\"tags\":[\"a\",\"b\",\"c\"],\"email\":\"bea@example.com\"}}") == 0);
+    free(str);
+
+    ja_val *value = ja_new_num(1);
+    ja_path *past_end = ja_path_compile("/user/tags/7");
+    log_test_result("Missing parents are reported with their path", !ja_path_set(orphan, doc, value) &&
+        ja_last_error()->code == JA_ERROR_KEY_NOT_FOUND && strcmp(ja_last_error()->path, "/account") == 0);
+    log_test_result("Indexes past the end are rejected", !ja_path_set(past_end, doc, value) &&
+        ja_last_error()->code == JA_ERROR_INDEX_OUT_OF_BOUNDS && strcmp(ja_last_error()->path, "/user/tags/7") == 0);
+    ja_path_free(&past_end);
+    ja_free_val(&value);
+
+    ja_val *copy = ja_copy_cow(doc);
+    ja_path_set(name, copy, ja_new_str("cy"));
+    log_test_result("Copy-on-write copies are unshared along the path",
+        strcmp(ja_get_str(ja_path_get(name, doc)), "bea") == 0 && strcmp(ja_get_str(ja_path_get(name, copy)), "cy") == 0);
+    ja_free_val(&copy);
+
+    ja_path_free(&name);
+    ja_path_free(&email);
+    ja_path_free(&append);
+    ja_path_free(&second);
+    ja_path_free(&orphan);
+    log_test_result("Paths are freed", name == NULL && orphan == NULL);
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Resolves the same path over every record of the big test file.
+ */
+static void run_cache_test(void) {
+    printf("\n> Inline caches\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *data = ja_get_obj_at(json->content, "data");
+    size_t count = ja_size_of(data);
+    ja_path *theme = ja_path_compile("/profile/settings/theme");
+
+    double start = now();
+    for (size_t i = 0; i < count; i++) {
+        ja_get_obj_at(ja_get_obj_at(ja_get_obj_at(ja_get_arr_at(data, i), "profile"), "settings"), "theme");
+    }
+    double chained_time = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < count; i++) ja_path_get(theme, ja_get_arr_at(data, i));
+    double path_time = now() - start;
+
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++) {
+        ja_val *record = ja_get_arr_at(data, i);
+        ja_val *chained = ja_get_obj_at(ja_get_obj_at(ja_get_obj_at(record, "profile"), "settings"), "theme");
+        matches += chained && chained == ja_path_get(theme, record);
+    }
+
+    log_test_result("Paths match the chained accessors", count > 0 && matches == count);
+    log_test_result("Steps cache the shape they matched",
+        theme->steps[0].shape == __ja_obj_shape_of(ja_get_arr_at(data, 0)) && theme->steps[2].shape != NULL);
+    printf("     %zu records: %.6f s with chained accessors, %.6f s with a compiled path\n", count, chained_time, path_time);
+
+    ja_val *record = ja_get_arr_at(data, 0);
+    ja_obj_remove_at(record, "name"); // Unshapes the record
+    ja_path *id = ja_path_compile("/id");
+    ja_path *scores = ja_path_compile("/scores/9");
+    log_test_result("Records without shape are still found", ja_path_get(id, record) == ja_get_obj_at(record, "id") &&
+        ja_get_int(ja_path_get(scores, record)) == 9 && ja_get_int(ja_path_get(id, ja_get_arr_at(data, 1))) == 1);
+
+    ja_path_free(&id);
+    ja_path_free(&scores);
+    ja_json_end(json); // The path still holds the shapes it cached
+    ja_path_free(&theme);
+    log_test_result("Paths are freed after their document", theme == NULL);
+}
+
+/**
+ * @brief Entry point for the JSON Pointer tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON JSON Pointer Tests ===\n");
+
+    run_rfc_test();
+    run_set_test();
+    run_cache_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
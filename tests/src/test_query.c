@@ -0,0 +1,265 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests JSONPath queries (ja_query_compile / ja_query_eval / ja_query_eval_parallel).
+ *
+ * It verifies:
+ *  - ✅ Names, wildcards, indexes, slices and recursive descent select the expected values, in document order.
+ *  - ✅ Escapes in quoted names and strings are decoded, and unknown escapes are rejected.
+ *  - ✅ Filters with comparisons, existence tests, &&, || and ! select the expected elements.
+ *  - ✅ Results point into the document instead of copying it.
+ *  - ✅ Malformed queries are rejected at their offset.
+ *  - ✅ A filter over the big test file matches a hand-written loop, and the parallel evaluation matches the sequential one.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+
+#define STORE_JSON \
+    "{\"store\": {\"book\": [" \
+    "{\"category\": \"reference\", \"author\": \"Nigel Rees\", \"title\": \"Sayings of the Century\", \"price\": 8.95}," \
+    "{\"category\": \"fiction\", \"author\": \"Evelyn Waugh\", \"title\": \"Sword of Honour\", \"price\": 12.99}," \
+    "{\"category\": \"fiction\", \"author\": \"Herman Melville\", \"title\": \"Moby Dick\", \"isbn\": \"0-553-21311-3\", \"price\": 8.99}," \
+    "{\"category\": \"fiction\", \"author\": \"J. R. R. Tolkien\", \"title\": \"The Lord of the Rings\", \"isbn\": \"0-395-19395-8\", \"price\": 22.99}]," \
+    " \"bicycle\": {\"color\": \"red\", \"price\": 399}}}"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Runs a query once and returns its results as one JSON array, or NULL on error.
+ */
+static char *query_text(const char *expression, ja_val *root) {
+    ja_query *query = ja_query_compile(expression);
+    size_t count = 0;
+    ja_val **results = ja_query_eval(query, root, &count);
+    ja_query_free(&query);
+    if (!results) return NULL;
+
+    ja_val *array = ja_new_arr();
+    for (size_t i = 0; i < count; i++) ja_arr_append(array, ja_copy(results[i]));
+    char *str = ja_stringify(array);
+    ja_free_val(&array);
+    free(results);
+    return str;
+}
+
+/**
+ * @brief Checks that a query returns the given JSON array.
+ */
+static bool query_is(const char *expression, ja_val *root, const char *expected) {
+    char *str = query_text(expression, root);
+    bool equal = str && strcmp(str, expected) == 0;
+    if (!equal) printf("     %s gave %s\n", expression, str ? str : "(error)");
+    free(str);
+    return equal;
+}
+
+/**
+ * @brief Checks the selectors without filters.
+ */
+static void run_selector_test(void) {
+    printf("\n> Selectors\n");
+
+    ja_val *doc = ja_parse(STORE_JSON);
+    if (!doc) {
+        log_test_result("Parse example document", false);
+        return;
+    }
+
+    log_test_result("Names and wildcards", query_is("$.store.book[*].author", doc,
+        "[\"Nigel Rees\",\"Evelyn Waugh\",\"Herman Melville\",\"J. R. R. Tolkien\"]") &&
+        query_is("$['store'][\"bicycle\"].color", doc, "[\"red\"]") && query_is("$.store.missing", doc, "[]"));
+    log_test_result("Indexes count from the end when negative", query_is("$.store.book[-1].price", doc, "[22.99]") &&
+        query_is("$.store.book[4]", doc, "[]") && query_is("$.store.book[0].title", doc, "[\"Sayings of the Century\"]"));
+    log_test_result("Slices", query_is("$.store.book[1:3].price", doc, "[12.99,8.99]") &&
+        query_is("$.store.book[:2].price", doc, "[8.95,12.99]") && query_is("$.store.book[-2:].price", doc, "[8.99,22.99]") &&
+        query_is("$.store.book[::2].price", doc, "[8.95,8.99]") && query_is("$.store.book[::-1].price", doc, "[22.99,8.99,12.99,8.95]") &&
+        query_is("$.store.book[0:4:0]", doc, "[]"));
+    ja_val *quoted = ja_new_obj();
+    ja_val *inner = ja_new_obj();
+    ja_set_obj_at(inner, "c\\d", ja_new_num(2));
+    ja_set_obj_at(quoted, "q'", ja_new_num(1));
+    ja_set_obj_at(quoted, "a\"b", inner);
+    ja_set_obj_at(quoted, "e\n", ja_new_num(3));
+    log_test_result("Escapes in quoted names are decoded", query_is("$['q\\'']", quoted, "[1]") &&
+        query_is("$[\"a\\\"b\"]['c\\\\d']", quoted, "[2]") && query_is("$['e\\n']", quoted, "[3]") &&
+        query_is("$[?(@['c\\\\d'] == 2)]['c\\\\d']", quoted, "[2]") && query_is("$[?(@ == 'q\\'')]", quoted, "[]"));
+    ja_free_val(&quoted);
+    log_test_result("Recursive descent in document order", query_is("$..price", doc, "[8.95,12.99,8.99,22.99,399]") &&
+        query_is("$..book[2].author", doc, "[\"Herman Melville\"]") && query_is("$.store..color", doc, "[\"red\"]"));
+
+    ja_query *query = ja_query_compile("$.store.book[0]");
+    size_t count = 0;
+    ja_val **results = ja_query_eval(query, doc, &count);
+    log_test_result("Results point into the document",
+        results && count == 1 && results[0] == ja_get_arr_at(ja_get_obj_at(ja_get_obj_at(doc, "store"), "book"), 0));
+    free(results);
+    ja_query_free(&query);
+
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Checks filter expressions.
+ */
+static void run_filter_test(void) {
+    printf("\n> Filters\n");
+
+    ja_val *doc = ja_parse(STORE_JSON);
+    if (!doc) {
+        log_test_result("Parse example document", false);
+        return;
+    }
+
+    log_test_result("Comparisons with numbers", query_is("$.store.book[?(@.price < 10)].title", doc,
+        "[\"Sayings of the Century\",\"Moby Dick\"]") && query_is("$..book[?(@.price >= 22.99)].price", doc, "[22.99]"));
+    log_test_result("Comparisons with strings", query_is("$.store.book[?(@.category != 'fiction')].author", doc,
+        "[\"Nigel Rees\"]") && query_is("$.store.book[?(@.author > \"J\")].price", doc, "[8.95,22.99]"));
+    log_test_result("Existence tests", query_is("$.store.book[?(@.isbn)].price", doc, "[8.99,22.99]") &&
+        query_is("$.store.book[?(!@.isbn)].price", doc, "[8.95,12.99]"));
+    log_test_result("&&, || and parentheses", query_is(
+        "$.store.book[?(@.category == 'fiction' && (@.price < 9 || @.price > 20))].price", doc, "[8.99,22.99]") &&
+        query_is("$.store.book[?@.price < 9 || @.price > 20 && @.isbn].price", doc, "[8.95,8.99,22.99]"));
+    log_test_result("Filters over object members", query_is("$.store[?(@.color == 'red')].price", doc, "[399]") &&
+        query_is("$..[?(@.price > 100)].color", doc, "[\"red\"]"));
+    log_test_result("Mismatched types never compare", query_is("$.store.book[?(@.price == '8.95')]", doc, "[]") &&
+        query_is("$.store.book[?(@.title < 5)]", doc, "[]") && query_is("$.store.book[?(@.missing == null)]", doc, "[]"));
+
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Checks that malformed queries are rejected.
+ */
+static void run_syntax_test(void) {
+    printf("\n> Syntax errors\n");
+
+    log_test_result("Queries must start with $",
+        ja_query_compile("store") == NULL && ja_last_error()->code == JA_ERROR_UNEXPECTED_CHARACTER);
+    log_test_result("Errors record their offset", ja_query_compile("$.store[?(@.price <)]") == NULL &&
+        ja_last_error()->code == JA_ERROR_UNEXPECTED_CHARACTER && ja_last_error()->offset == 19);
+    log_test_result("Unterminated queries are rejected", ja_query_compile("$.store['book") == NULL &&
+        ja_last_error()->code == JA_ERROR_UNEXPECTED_END && ja_query_compile("$.store[?(@.a == 1]") == NULL &&
+        ja_query_compile("$.store[1:") == NULL);
+    log_test_result("Unknown escapes are rejected", ja_query_compile("$['a\\x']") == NULL &&
+        ja_last_error()->code == JA_ERROR_UNEXPECTED_CHARACTER && ja_last_error()->offset == 5 &&
+        ja_query_compile("$['\\u0041']") == NULL);
+    log_test_result("Constants alone aren't tests", ja_query_compile("$[?(1)]") == NULL && ja_query_compile("$[]") == NULL);
+}
+
+/**
+ * @brief Compares a filter over the big test file with a hand-written loop, sequentially and in parallel.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *data = ja_get_obj_at(json->content, "data");
+    double start = now();
+    size_t expected = 0;
+    for (size_t i = 0; i < ja_size_of(data); i++) {
+        ja_val *record = ja_get_arr_at(data, i);
+        ja_val *language = ja_get_obj_at(ja_get_obj_at(ja_get_obj_at(record, "profile"), "settings"), "language");
+        expected += ja_get_bool(ja_get_obj_at(record, "active")) && strcmp(ja_get_str(language), "en") == 0;
+    }
+    double loop_time = now() - start;
+
+    ja_query *query = ja_query_compile("$.data[?(@.active == true && @.profile.settings.language == 'en')]");
+    size_t count = 0;
+    start = now();
+    ja_val **results = ja_query_eval(query, json->content, &count);
+    double query_time = now() - start;
+
+    bool matches = results && count == expected && expected > 0;
+    for (size_t i = 0; matches && i < count; i++) {
+        matches = ja_get_bool(ja_get_obj_at(results[i], "active")) && (i == 0 ||
+            ja_get_int(ja_get_obj_at(results[i], "id")) > ja_get_int(ja_get_obj_at(results[i - 1], "id")));
+    }
+    log_test_result("Filter matches a hand-written loop", matches);
+    printf("     %zu of %zu records: %.6f s with a loop, %.6f s with a query\n", count, ja_size_of(data), loop_time, query_time);
+    free(results);
+
+    // Enough records for the filter to be split across threads
+    ja_val *big = ja_new_arr();
+    for (int copy = 0; copy < 4; copy++) {
+        for (size_t i = 0; i < ja_size_of(data); i++) ja_arr_append(big, ja_copy_cow(ja_get_arr_at(data, i)));
+    }
+    ja_set_obj_at(json->content, "data", big);
+
+    const char *expressions[] = {
+        "$.data[?(@.active == true && @.profile.settings.language == 'en')]",
+        "$.data[*].scores[?(@ > 8)]",
+        "$.data[?(@.id < 100)]..theme",
+    };
+    bool same = true;
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        ja_query *compiled = ja_query_compile(expressions[e]);
+        size_t sequential_count = 0;
+        size_t parallel_count = 0;
+        ja_val **sequential = ja_query_eval(compiled, json->content, &sequential_count);
+        start = now();
+        ja_val **parallel = ja_query_eval_parallel(compiled, json->content, &parallel_count, 4);
+        double parallel_time = now() - start;
+
+        same = same && sequential && parallel && sequential_count == parallel_count && sequential_count > 0 &&
+            memcmp(sequential, parallel, sequential_count * sizeof(ja_val *)) == 0;
+        printf("     %s: %zu results in %.6f s in parallel\n", expressions[e], parallel_count, parallel_time);
+        free(sequential);
+        free(parallel);
+        ja_query_free(&compiled);
+    }
+    log_test_result("Parallel evaluation matches the sequential one", same);
+
+    ja_json_end(json);
+    ja_query_free(&query);
+    log_test_result("Queries are freed after their document", query == NULL);
+}
+
+/**
+ * @brief Entry point for the JSONPath tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON JSONPath Tests ===\n");
+
+    run_selector_test();
+    run_filter_test();
+    run_syntax_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
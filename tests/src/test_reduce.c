@@ -0,0 +1,205 @@
+#include "jajson.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests the statistics over arrays (ja_arr_reduce / ja_arr_histogram and their _path versions).
+ *
+ * It verifies:
+ *  - ✅ Sum, min, max, mean and count match over packed arrays and arrays of nodes, skipping other values.
+ *  - ✅ Fields of the elements are reduced through a JSON Pointer.
+ *  - ✅ Histograms count numbers into their bins, the last one including the end of the range.
+ *  - ✅ Empty arrays and bad arguments are handled.
+ *  - ✅ Reductions over a big packed array and over the big test file match hand-written loops.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define BIG_FILE "tests/data/test_big.json"
+#define BIG_SIZE 1000003 // Not a multiple of the vector width
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Checks that a reduction succeeds with the expected result.
+ */
+static bool reduces_to(ja_val *array, const char *pointer, ja_reduce_op op, double expected) {
+    double result = -1.0;
+    bool ok = pointer ? ja_arr_reduce_path(array, pointer, op, &result) : ja_arr_reduce(array, op, &result);
+    if (isnan(expected)) return ok && isnan(result);
+    return ok && fabs(result - expected) <= 1e-9 * fmax(1.0, fabs(expected));
+}
+
+/**
+ * @brief Reduces small arrays.
+ */
+static void run_reduce_test(void) {
+    printf("\n> Reductions\n");
+
+    ja_val *doc = ja_parse("{\"packed\": [4, -2.5, 10, 0.5, 3, 7, 1, 8, 2, 6], \"mixed\": [4, \"x\", -2.5, null, 10, [1]],"
+                           " \"rows\": [{\"v\": 2}, {\"v\": 6.5}, {\"w\": 1}, 5, {\"v\": {\"x\": 1}}, {\"v\": -1}], \"empty\": []}");
+    if (!doc) {
+        log_test_result("Parse document", false);
+        return;
+    }
+
+    ja_val *packed = ja_get_obj_at(doc, "packed");
+    log_test_result("Packed arrays", reduces_to(packed, NULL, JA_REDUCE_SUM, 39.0) &&
+        reduces_to(packed, NULL, JA_REDUCE_MIN, -2.5) && reduces_to(packed, NULL, JA_REDUCE_MAX, 10.0) &&
+        reduces_to(packed, NULL, JA_REDUCE_MEAN, 3.9) && reduces_to(packed, NULL, JA_REDUCE_COUNT, 10.0));
+
+    ja_val *mixed = ja_get_obj_at(doc, "mixed");
+    log_test_result("Other values are skipped", reduces_to(mixed, NULL, JA_REDUCE_SUM, 11.5) &&
+        reduces_to(mixed, NULL, JA_REDUCE_MIN, -2.5) && reduces_to(mixed, NULL, JA_REDUCE_COUNT, 3.0));
+
+    ja_val *rows = ja_get_obj_at(doc, "rows");
+    log_test_result("Fields of the elements", reduces_to(rows, "/v", JA_REDUCE_SUM, 7.5) &&
+        reduces_to(rows, "/v", JA_REDUCE_MAX, 6.5) && reduces_to(rows, "/v", JA_REDUCE_MEAN, 2.5) &&
+        reduces_to(rows, "", JA_REDUCE_COUNT, 1.0));
+
+    ja_val *empty = ja_get_obj_at(doc, "empty");
+    log_test_result("Empty arrays", reduces_to(empty, NULL, JA_REDUCE_SUM, 0.0) &&
+        reduces_to(empty, NULL, JA_REDUCE_COUNT, 0.0) && reduces_to(empty, NULL, JA_REDUCE_MIN, NAN) &&
+        reduces_to(empty, NULL, JA_REDUCE_MEAN, NAN));
+
+    double result = 0.0;
+    log_test_result("Bad arguments are rejected", !ja_arr_reduce(doc, JA_REDUCE_SUM, &result) &&
+        ja_last_error()->code == JA_ERROR_TYPE_MISMATCH && !ja_arr_reduce(packed, JA_REDUCE_SUM, NULL) &&
+        ja_last_error()->code == JA_ERROR_NULL_ARGUMENT && !ja_arr_reduce_path(rows, "v", JA_REDUCE_SUM, &result));
+
+    log_test_result("Arrays stay packed", ja_arr_as_doubles(packed, &(size_t){0}) != NULL &&
+        (packed->flags & JA_FLAG_PACKED));
+
+    ja_free_val(&doc);
+}
+
+/**
+ * @brief Builds histograms.
+ */
+static void run_histogram_test(void) {
+    printf("\n> Histograms\n");
+
+    ja_val *array = ja_parse("[0, 0.5, 1, 2.5, 4, 5, -1, 6, 3.99, 2, 1.25, 7.5]");
+    size_t counts[5] = {9, 9, 9, 9, 9};
+    log_test_result("Numbers fall into their bins", ja_arr_histogram(array, 0, 5, 5, counts) &&
+        counts[0] == 2 && counts[1] == 2 && counts[2] == 2 && counts[3] == 1 && counts[4] == 2);
+
+    ja_val *rows = ja_parse("[{\"t\": 1}, {\"t\": 1.5}, {\"t\": \"2\"}, {\"t\": 9}]");
+    size_t halves[2];
+    log_test_result("Fields of the elements", ja_arr_histogram_path(rows, "/t", 1, 2, 2, halves) &&
+        halves[0] == 1 && halves[1] == 1);
+
+    log_test_result("Empty ranges are rejected", !ja_arr_histogram(array, 1, 1, 5, counts) &&
+        !ja_arr_histogram(array, 0, 5, 0, counts) && ja_last_error()->code == JA_ERROR_INDEX_OUT_OF_BOUNDS &&
+        !ja_arr_histogram(array, 0, INFINITY, 5, counts));
+
+    ja_free_val(&rows);
+    ja_free_val(&array);
+}
+
+/**
+ * @brief Compares reductions over big arrays with hand-written loops.
+ */
+static void run_big_test(void) {
+    printf("\n> Big arrays\n");
+
+    char *text = malloc((size_t)BIG_SIZE * 10 + 3);
+    char *p = text;
+    *p++ = '[';
+    for (int i = 0; i < BIG_SIZE; i++) p += sprintf(p, i ? ",%.2f" : "%.2f", (i % 1000) - 499.75);
+    *p++ = ']';
+    *p = '\0';
+    ja_val *array = ja_parse(text);
+    free(text);
+
+    double start = now();
+    double loop_sum = 0.0;
+    double loop_max = -INFINITY;
+    for (size_t i = 0; i < ja_size_of(array); i++) {
+        double value = ja_get_double(ja_get_arr_at(array, i));
+        loop_sum += value;
+        loop_max = value > loop_max ? value : loop_max;
+    }
+    double loop_time = now() - start;
+
+    size_t size = 0;
+    bool packed = ja_arr_as_doubles(array, &size) != NULL && size == BIG_SIZE; // The accessors unpacked it
+
+    start = now();
+    double sum = 0.0;
+    double max = 0.0;
+    bool reduced = ja_arr_reduce(array, JA_REDUCE_SUM, &sum) && ja_arr_reduce(array, JA_REDUCE_MAX, &max);
+    double reduce_time = now() - start;
+
+    log_test_result("Sum and max of a packed array", packed && reduced &&
+        fabs(sum - loop_sum) <= 1e-6 * fabs(loop_sum) && max == loop_max);
+    printf("     %d numbers: %.6f s with the accessors (sum and max), %.6f s with ja_arr_reduce()\n",
+        BIG_SIZE, loop_time, reduce_time);
+
+    size_t counts[10];
+    size_t total = 0;
+    bool histogram = ja_arr_histogram(array, -500, 500, 10, counts);
+    for (size_t i = 0; i < 10; i++) total += counts[i];
+    log_test_result("Histogram of a packed array", histogram && total == BIG_SIZE && counts[0] == counts[9] + 3);
+    ja_free_val(&array);
+
+    ja_json *json = ja_json_init();
+    if (!ja_read_json(json, BIG_FILE)) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_val *data = ja_get_obj_at(json->content, "data");
+    double expected = 0.0;
+    for (size_t i = 0; i < ja_size_of(data); i++) {
+        expected += ja_get_int(ja_get_obj_at(ja_get_arr_at(data, i), "id"));
+    }
+
+    double ids = 0.0;
+    double count = 0.0;
+    log_test_result("Fields of the big test file", ja_arr_reduce_path(data, "/id", JA_REDUCE_SUM, &ids) &&
+        ja_arr_reduce_path(data, "/scores/3", JA_REDUCE_COUNT, &count) && ids == expected &&
+        count == (double)ja_size_of(data));
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the array statistics tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Array Statistics Tests ===\n");
+
+    run_reduce_test();
+    run_histogram_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
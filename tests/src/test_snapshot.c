@@ -0,0 +1,312 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * This file tests binary snapshots (ja_save_snapshot / ja_load_snapshot).
+ *
+ * It verifies:
+ *  - ✅ A saved document loads back equal, with its shapes, keys and strings.
+ *  - ✅ Saving the same document twice writes the same bytes.
+ *  - ✅ Loaded documents can be read through the accessors, modified and freed like any other value.
+ *  - ✅ Repeated strings are stored once.
+ *  - ✅ Truncated, corrupt or missing files are rejected: offsets past their section, nodes referenced twice and
+ *    counts larger than the file, and no single bit flip makes the loader read out of bounds.
+ *  - ✅ The big test file loads faster than it parses.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+#define SNAPSHOT_FILE "build/data/test_snapshot.jasnap"
+#define CORRUPT_FILE  "build/data/test_snapshot_corrupt.jasnap"
+#define BIG_FILE      "tests/data/test_big.json"
+
+#define SAMPLE_JSON \
+    "{\"service\": \"api\", \"ports\": [80, 443], \"ratio\": 0.75, \"debug\": false, \"owner\": null," \
+    " \"records\": [{\"id\": 1, \"role\": \"admin\"}, {\"id\": 2, \"role\": \"admin\"}, {\"role\": \"user\", \"id\": 3}]," \
+    " \"empty\": {\"list\": [], \"map\": {}}}"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Checks that two values serialize to the same text.
+ */
+static bool same_text(ja_val *a, ja_val *b) {
+    char *a_str = ja_stringify(a);
+    char *b_str = ja_stringify(b);
+    bool equal = a_str && b_str && strcmp(a_str, b_str) == 0;
+    free(a_str);
+    free(b_str);
+    return equal;
+}
+
+/**
+ * @brief Returns the size of a file, or 0 if it can't be opened.
+ */
+static long file_size(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Saves and loads a small document.
+ */
+static void run_round_trip_test(void) {
+    printf("\n> Round trip\n");
+
+    ja_val *original = ja_parse(SAMPLE_JSON);
+    bool saved = original && ja_save_snapshot(original, SNAPSHOT_FILE);
+    log_test_result("Snapshot is saved", saved);
+
+    ja_val *again = ja_parse(SAMPLE_JSON);
+    size_t first_length = 0, second_length = 0;
+    char *first_bytes = __ja_read_file(SNAPSHOT_FILE, &first_length);
+    ja_save_snapshot(again, CORRUPT_FILE);
+    char *second_bytes = __ja_read_file(CORRUPT_FILE, &second_length);
+    log_test_result("Same documents give the same bytes", first_bytes && second_bytes && first_length == second_length &&
+        memcmp(first_bytes, second_bytes, first_length) == 0);
+    free(second_bytes);
+    free(first_bytes);
+    ja_free_val(&again);
+
+    ja_val *loaded = ja_load_snapshot(SNAPSHOT_FILE);
+    log_test_result("Snapshot loads back equal", loaded && same_text(original, loaded));
+    if (!loaded) {
+        ja_free_val(&original);
+        return;
+    }
+
+    ja_val *records = ja_get_obj_at(loaded, "records");
+    ja_val *first = ja_get_arr_at(records, 0);
+    ja_val *second = ja_get_arr_at(records, 1);
+    log_test_result("Shapes and strings are restored",
+        (first->flags & JA_FLAG_SHAPED) && __ja_obj_shape_of(first) == __ja_obj_shape_of(second) &&
+        ja_get_str(ja_get_obj_at(first, "role")) == ja_get_str(ja_get_obj_at(second, "role")) &&
+        ja_get_int(ja_get_obj_at(ja_get_arr_at(records, 2), "id")) == 3 &&
+        ja_get_double(ja_get_obj_at(loaded, "ratio")) == 0.75
+    );
+
+    ja_set_obj_at(first, "role", ja_new_str("owner"));
+    ja_arr_append(ja_get_obj_at(loaded, "ports"), ja_new_num(8080));
+    ja_obj_remove_at(loaded, "owner");
+    ja_set_obj_at(ja_get_obj_at(ja_get_obj_at(loaded, "empty"), "map"), "new", ja_new_bool(true));
+    char *str = ja_stringify(loaded);
+    log_test_result("Loaded documents can be modified", str && strcmp(str,
+        "{\"service\":\"api\",\"ports\":[80,443,8080],\"ratio\":0.75,\"debug\":false,"
+        "\"records\":[{\"id\":1,\"role\":\"owner\"},{\"id\":2,\"role\":\"admin\"},{\"role\":\"user\",\"id\":3}],"
+        "\"empty\":{\"list\":[],\"map\":{\"new\":true}}}") == 0);
+    free(str);
+
+    ja_val *copy = ja_copy(loaded);
+    ja_free_val(&loaded);
+    log_test_result("Copies outlive the snapshot", copy && ja_get_int(ja_get_obj_at(ja_get_arr_at(ja_get_obj_at(copy, "records"), 1), "id")) == 2);
+    ja_free_val(&copy);
+
+    ja_val *scalar = ja_new_str("just a string");
+    ja_save_snapshot(scalar, SNAPSHOT_FILE);
+    loaded = ja_load_snapshot(SNAPSHOT_FILE);
+    log_test_result("Scalars are saved too", loaded && strcmp(ja_get_str(loaded), "just a string") == 0);
+    ja_free_val(&loaded);
+    ja_free_val(&scalar);
+
+    ja_free_val(&original);
+}
+
+/**
+ * @brief Checks that repeated strings are stored once.
+ */
+static void run_pool_test(void) {
+    printf("\n> String pool\n");
+
+    ja_val *array = ja_new_arr();
+    for (int i = 0; i < 1000; i++) {
+        ja_arr_append(array, ja_new_str("a fairly long repeated string value"));
+    }
+    ja_save_snapshot(array, SNAPSHOT_FILE);
+
+    long size = file_size(SNAPSHOT_FILE);
+    log_test_result("Repeated strings are stored once", size > 0 && size < 1000 * ((long)sizeof(ja_val) + 16));
+
+    ja_val *loaded = ja_load_snapshot(SNAPSHOT_FILE);
+    log_test_result("Pooled strings load back", loaded && ja_size_of(loaded) == 1000 &&
+        ja_get_str(ja_get_arr_at(loaded, 0)) == ja_get_str(ja_get_arr_at(loaded, 999)));
+    ja_free_val(&loaded);
+    ja_free_val(&array);
+}
+
+/**
+ * @brief Writes a corrupted snapshot and tells whether it loads anyway.
+ */
+static bool corrupt_loads(const char *data, size_t length) {
+    FILE *file = fopen(CORRUPT_FILE, "wb");
+    if (!file) return false;
+    fwrite(data, 1, length, file);
+    fclose(file);
+
+    ja_val *loaded = ja_load_snapshot(CORRUPT_FILE);
+    bool rejected = loaded == NULL && ja_last_error()->code == JA_ERROR_INVALID_SNAPSHOT;
+    if (loaded) ja_free_val(&loaded);
+    return !rejected;
+}
+
+/**
+ * @brief Checks that bad files are rejected.
+ */
+static void run_invalid_test(void) {
+    printf("\n> Invalid files\n");
+
+    ja_val *original = ja_parse(SAMPLE_JSON);
+    ja_save_snapshot(original, SNAPSHOT_FILE);
+    ja_free_val(&original);
+
+    size_t length = 0;
+    char *data = __ja_read_file(SNAPSHOT_FILE, &length);
+    if (!data) {
+        log_test_result("Read snapshot", false);
+        return;
+    }
+
+    char *clean = malloc(length);
+    if (!clean) {
+        free(data);
+        return;
+    }
+    memcpy(clean, data, length);
+
+    FILE *file = fopen(CORRUPT_FILE, "wb");
+    fwrite(data, 1, length - 1, file);
+    fclose(file);
+    log_test_result("Truncated file is rejected",
+        ja_load_snapshot(CORRUPT_FILE) == NULL && ja_last_error()->code == JA_ERROR_INVALID_SNAPSHOT);
+
+    ja_val *root = (ja_val *)(void *)data + 1;
+    root->u.object.pairs = (ja_pair *)(uintptr_t)(length * 2); // Offset out of the file
+    file = fopen(CORRUPT_FILE, "wb");
+    fwrite(data, 1, length, file);
+    fclose(file);
+    log_test_result("Offsets out of bounds are rejected",
+        ja_load_snapshot(CORRUPT_FILE) == NULL && ja_last_error()->code == JA_ERROR_INVALID_SNAPSHOT);
+
+    // Inside the file, but past the section of the slots
+    root->u.object.pairs = (ja_pair *)(uintptr_t)(length - 2 * sizeof(ja_pair));
+    log_test_result("Offsets past their section are rejected", !corrupt_loads(data, length));
+    memcpy(data, clean, length);
+
+    // Second element of "ports" pointing at the first one
+    ja_val *nodes = (ja_val *)(void *)data;
+    ja_val *ports = NULL;
+    for (size_t i = 1; (char *)&nodes[i + 1] <= data + length && !ports; i++) {
+        if (nodes[i].type == JA_TYPE_ARRAY && nodes[i].u.array.size == 2) ports = &nodes[i];
+    }
+    if (ports) {
+        ja_val **slots = (ja_val **)(void *)(data + (uintptr_t)ports->u.array.items);
+        slots[1] = slots[0];
+    }
+    log_test_result("Nodes referenced twice are rejected", ports && !corrupt_loads(data, length));
+    memcpy(data, clean, length);
+
+    // Key count of the trailer (after the magic, four 32-bit fields and four counts) larger than the file
+    uint64_t key_count = (uint64_t)1 << 40;
+    memcpy(data + length - sizeof(uint64_t) * 8 + sizeof(uint64_t) * 4, &key_count, sizeof(key_count));
+    log_test_result("Counts larger than the file are rejected", !corrupt_loads(data, length));
+    memcpy(data, clean, length);
+
+    // Every bit flip must be rejected or give a document that can be read and freed
+    bool flips_ok = true;
+    for (size_t bit = 0; bit < length * 8 && flips_ok; bit++) {
+        data[bit / 8] ^= (char)(1 << (bit % 8));
+        file = fopen(CORRUPT_FILE, "wb");
+        fwrite(data, 1, length, file);
+        fclose(file);
+
+        ja_val *loaded = ja_load_snapshot(CORRUPT_FILE);
+        if (loaded) {
+            char *str = ja_stringify(loaded);
+            flips_ok = str != NULL;
+            free(str);
+            ja_free_val(&loaded);
+        } else {
+            flips_ok = ja_last_error()->code == JA_ERROR_INVALID_SNAPSHOT;
+        }
+        data[bit / 8] ^= (char)(1 << (bit % 8));
+    }
+    log_test_result("Single bit flips are rejected or load safely", flips_ok);
+
+    free(clean);
+    free(data);
+
+    log_test_result("Missing file is rejected",
+        ja_load_snapshot("build/data/missing.jasnap") == NULL && ja_last_error()->code == JA_ERROR_IO);
+}
+
+/**
+ * @brief Compares loading a snapshot of the big test file with parsing it.
+ */
+static void run_big_test(void) {
+    printf("\n> Big file\n");
+
+    ja_json *json = ja_json_init();
+    double start = now();
+    bool read = ja_read_json(json, BIG_FILE);
+    double parse_time = now() - start;
+    if (!read) {
+        log_test_result("Read " BIG_FILE, false);
+        ja_json_end(json);
+        return;
+    }
+
+    ja_save_snapshot(json->content, SNAPSHOT_FILE);
+    start = now();
+    ja_val *loaded = ja_load_snapshot(SNAPSHOT_FILE);
+    double load_time = now() - start;
+
+    log_test_result("Big file loads back equal", loaded && same_text(json->content, loaded));
+    printf("     Parsed in %.4f s, snapshot loaded in %.4f s\n", parse_time, load_time);
+
+    ja_free_val(&loaded);
+    ja_json_end(json);
+}
+
+/**
+ * @brief Entry point for the snapshot tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Snapshot Tests ===\n");
+
+    run_round_trip_test();
+    run_pool_test();
+    run_invalid_test();
+    run_big_test();
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "jajson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * This file tests ja_validate().
+ *
+ * It verifies:
+ *  - ✅ Valid documents are accepted (including UTF-8 and surrogate pairs).
+ *  - ✅ Malformed documents are rejected with the right code and byte offset.
+ *  - ✅ Line and column of the error are reported.
+ *  - ✅ Nesting deeper than JA_MAX_DEPTH is rejected.
+ *  - ✅ The text doesn't need to be null-terminated.
+ */
+
+#define TEST_OK   "\x1b[32mOK\x1b[0m"
+#define TEST_FAIL "\x1b[31mFAIL\x1b[0m"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+/**
+ * @brief Logs a single test result.
+ */
+static void log_test_result(const char *test_name, bool condition) {
+    printf("  %s  %s\n", condition ? TEST_OK : TEST_FAIL, test_name);
+    condition ? tests_passed++ : tests_failed++;
+}
+
+/**
+ * @brief Validates a string and checks the result, error code and offset.
+ */
+static void run_test(const char *json_str, ja_error_code expected_code, size_t expected_offset) {
+    ja_error error;
+    bool valid = ja_validate(json_str, strlen(json_str), &error);
+
+    bool condition = valid == (expected_code == JA_ERROR_NONE) && error.code == expected_code &&
+                     (valid || error.offset == expected_offset);
+
+    char name[160];
+    snprintf(name, sizeof(name), "%-40s -> %s", json_str, valid ? "valid" : error.reason);
+    log_test_result(name, condition);
+
+    if (!condition) {
+        printf("       got code %d at offset %zu\n", (int)error.code, error.offset);
+    }
+}
+
+/**
+ * @brief Entry point for the validation tests.
+ */
+int main(void) {
+    printf("\n=== jaJSON Validation Tests ===\n");
+
+    printf("\n> Valid documents\n");
+    run_test("{}",                                         JA_ERROR_NONE, 0);
+    run_test(" [1, -2.5, 3e10, 0, -0.0E-2] ",              JA_ERROR_NONE, 0);
+    run_test("{\"a\": {\"b\": [true, false, null]}}",      JA_ERROR_NONE, 0);
+    run_test("\"caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\"", JA_ERROR_NONE, 0);
+    run_test("\"\\u00e9 \\ud83d\\ude00 \\n\\t\\\"\\\\\\/\"",  JA_ERROR_NONE, 0);
+    run_test("\"a string longer than sixteen bytes, scanned in chunks\"", JA_ERROR_NONE, 0);
+
+    printf("\n> Invalid documents\n");
+    run_test("",                                JA_ERROR_UNEXPECTED_END, 0);
+    run_test("[1, 2",                           JA_ERROR_UNEXPECTED_END, 5);
+    run_test("[1, 2,]",                         JA_ERROR_UNEXPECTED_CHARACTER, 6);
+    run_test("{\"a\": 1,}",                     JA_ERROR_UNEXPECTED_CHARACTER, 8);
+    run_test("{\"a\" 1}",                       JA_ERROR_UNEXPECTED_CHARACTER, 5);
+    run_test("{a: 1}",                          JA_ERROR_UNEXPECTED_CHARACTER, 1);
+    run_test("[1 2]",                           JA_ERROR_UNEXPECTED_CHARACTER, 3);
+    run_test("[1}",                             JA_ERROR_UNEXPECTED_CHARACTER, 2);
+    run_test("01",                              JA_ERROR_INVALID_NUMBER, 1);
+    run_test("[1.]",                            JA_ERROR_INVALID_NUMBER, 3);
+    run_test("-",                               JA_ERROR_UNEXPECTED_END, 1);
+    run_test("1e+",                             JA_ERROR_UNEXPECTED_END, 3);
+    run_test("[tru]",                           JA_ERROR_INVALID_LITERAL, 4);
+    run_test("nul",                             JA_ERROR_UNEXPECTED_END, 3);
+    run_test("\"unterminated",                  JA_ERROR_UNEXPECTED_END, 13);
+    run_test("\"bad \\x escape\"",              JA_ERROR_INVALID_STRING, 5);
+    run_test("\"bad \\u12G4\"",                 JA_ERROR_INVALID_STRING, 5);
+    run_test("\"lone \\ud83d surrogate\"",      JA_ERROR_INVALID_STRING, 6);
+    run_test("\"tab\there\"",                   JA_ERROR_INVALID_STRING, 4);
+    run_test("\"overlong \xc0\xaf\"",           JA_ERROR_INVALID_UTF8, 10);
+    run_test("\"surrogate \xed\xa0\x80\"",      JA_ERROR_INVALID_UTF8, 11);
+    run_test("\"cut \xe2\x82\"",                JA_ERROR_INVALID_UTF8, 5);
+    run_test("{} []",                           JA_ERROR_TRAILING_CONTENT, 3);
+
+    printf("\n> Error position\n");
+    {
+        const char *json_str = "{\n  \"a\": 1,\n  \"b\": ?\n}";
+        ja_error error;
+        bool valid = ja_validate(json_str, strlen(json_str), &error);
+        log_test_result("Line and column point to the offending character",
+            !valid && error.line == 3 && error.column == 8 && error.offset == 19);
+    }
+
+    printf("\n> Limits\n");
+    {
+        size_t length = (JA_MAX_DEPTH + 1) * 2;
+        char *deep = malloc(length);
+        memset(deep, '[', length / 2);
+        memset(deep + length / 2, ']', length / 2);
+
+        ja_error error;
+        bool too_deep = !ja_validate(deep, length, &error) && error.code == JA_ERROR_DEPTH_LIMIT && error.offset == JA_MAX_DEPTH;
+        bool at_limit = ja_validate(deep + 1, length - 2, NULL);
+        log_test_result("Nesting deeper than JA_MAX_DEPTH is rejected", too_deep && at_limit);
+        free(deep);
+
+        const char buffer[] = { '[', '1', ']', 'x' }; // Not null-terminated
+        log_test_result("Only `length` bytes are read", ja_validate(buffer, 3, NULL) && !ja_validate(buffer, 4, NULL));
+    }
+
+    // 📊 Summary
+    printf("\n=================================\n");
+    printf("Summary: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("=================================\n\n");
+
+    return tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}